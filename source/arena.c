@@ -0,0 +1,171 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// arena.c -- per frame scratch memory
+//
+// Code that needs a buffer only until it returns takes it from a frame
+// arena, instead of the stack or a Hunk_LowMark / Hunk_FreeToLowMark pair:
+// Arena_Mark, Arena_Alloc as often as needed, then Arena_Release back to
+// the mark.  Marks nest, so a touch function that links another entity
+// can take its own.  The server and client each have one, emptied at the
+// end of their part of the frame.
+//
+// -svarena <kb> and -clarena <kb> set their sizes.  The server arena
+// always gets room for SV_TouchLinks on top: each touch function that
+// links another entity nests a list of every edict, and a touch is at
+// least one QC call deep, so MAX_STACK_DEPTH of them is the most there
+// can be before PR_RunError.
+
+#include "quakedef.h"
+#include "arena.h"
+
+#define	SV_ARENA_SIZE	(64*1024)
+#define	CL_ARENA_SIZE	(32*1024)
+
+// sv.max_edicts is always MAX_EDICTS, the arena is made before any map
+#define	SV_TOUCH_SIZE	((MAX_STACK_DEPTH + 1) * (((MAX_EDICTS * sizeof(edict_t *)) + 15) & ~15))
+
+#define	ARENA_SENTINEL	0x1df0a7e4
+
+arena_t	sv_arena = {"server"};
+arena_t	cl_arena = {"client"};
+
+/*
+=================
+Arena_Alloc
+=================
+*/
+void *Arena_Alloc (arena_t *a, int size)
+{
+	byte	*buf;
+
+	if (size < 0)
+		Sys_Error ("Arena_Alloc: bad size: %i", size);
+
+	size = (size + 15) & ~15;
+	if (a->used + size > a->size)
+		Sys_Error ("Arena_Alloc: %s arena overflowed on %i bytes, %i of %i used",
+			a->name, size, a->used, a->size);
+
+	buf = a->base + a->used;
+	a->used += size;
+	if (a->used > a->framepeak)
+	{
+		a->framepeak = a->used;
+		if (a->used > a->peak)
+			a->peak = a->used;
+	}
+
+	return buf;
+}
+
+/*
+=================
+Arena_Mark
+=================
+*/
+int Arena_Mark (arena_t *a)
+{
+	a->marks++;
+	return a->used;
+}
+
+/*
+=================
+Arena_Release
+=================
+*/
+void Arena_Release (arena_t *a, int mark)
+{
+	if (mark < 0 || mark > a->used || !a->marks)
+		Sys_Error ("Arena_Release: bad mark %i in the %s arena", mark, a->name);
+
+	a->marks--;
+	a->used = mark;
+}
+
+/*
+=================
+Arena_Reset
+
+The end of the arena's frame.  Anything still held is dropped, which is
+only expected after a Host_Error jumped out past its Release.
+=================
+*/
+void Arena_Reset (arena_t *a)
+{
+	if (*(int *)(a->base + a->size) != ARENA_SENTINEL)
+		Sys_Error ("Arena_Reset: %s arena trashed past its end", a->name);
+
+	if (a->marks)
+		Con_DPrintf ("Arena_Reset: %i marks still held in the %s arena\n", a->marks, a->name);
+
+	a->used = 0;
+	a->marks = 0;
+	a->lastframe = a->framepeak;
+	a->framepeak = 0;
+}
+
+/*
+=================
+Arena_Stats_f
+=================
+*/
+static void Arena_Stats_f (void)
+{
+	Con_Printf ("arena      size  frame   peak\n");
+	Con_Printf ("%-6s %8i %6i %6i\n", sv_arena.name, sv_arena.size, sv_arena.lastframe, sv_arena.peak);
+	Con_Printf ("%-6s %8i %6i %6i\n", cl_arena.name, cl_arena.size, cl_arena.lastframe, cl_arena.peak);
+}
+
+/*
+=================
+Arena_Create
+=================
+*/
+static void Arena_Create (arena_t *a, char *parm, int size, int reserve)
+{
+	int		p;
+
+	p = COM_CheckParm (parm);
+	if (p)
+	{
+		if (p < com_argc-1)
+			size = Q_atoi (com_argv[p+1]) * 1024;
+		else
+			Sys_Error ("Arena_Init: you must specify a size in KB after %s", parm);
+	}
+
+	a->size = ((size + 15) & ~15) + reserve;
+	a->base = Hunk_AllocName (a->size + 16, "arena");
+	*(int *)(a->base + a->size) = ARENA_SENTINEL;
+}
+
+/*
+=================
+Arena_Init
+=================
+*/
+void Arena_Init (void)
+{
+	Arena_Create (&sv_arena, "-svarena", SV_ARENA_SIZE, SV_TOUCH_SIZE);
+	Arena_Create (&cl_arena, "-clarena", CL_ARENA_SIZE, 0);
+
+	Cmd_AddCommand ("arenastats", Arena_Stats_f);
+}
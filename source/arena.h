@@ -0,0 +1,46 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// arena.h -- per frame scratch memory
+
+typedef struct
+{
+	char	*name;
+	byte	*base;
+	int		size;
+	int		used;
+	int		marks;			// Arena_Mark calls not yet released
+	int		framepeak;		// the most used in the frame so far
+	int		lastframe;		// the most used in the last frame
+	int		peak;			// the most ever used
+} arena_t;
+
+extern	arena_t	sv_arena;	// reset after each Host_ServerFrame
+extern	arena_t	cl_arena;	// reset after each SCR_UpdateScreen
+
+void Arena_Init (void);
+
+// 16 byte aligned and not cleared, an arena that runs out is a Sys_Error
+void *Arena_Alloc (arena_t *a, int size);
+
+// every Mark needs its Release, which gives back everything allocated since
+int Arena_Mark (arena_t *a);
+void Arena_Release (arena_t *a, int mark);
+
+void Arena_Reset (arena_t *a);
@@ -0,0 +1,533 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// bspcache.c -- processed brush models saved for the next load of the map
+//
+// Loading a bsp turns the lumps into the m*_t structures the engine runs
+// on, which costs the same every time the map is played.  Once that is
+// done the structures are written to cache/maps/<map>.bspc in the game
+// directory as one image, with every pointer turned into an offset.  The
+// next load of the same bsp reads the image onto the hunk in one piece and
+// a single walk over the model turns the offsets back into pointers.
+//
+// Textures and lighting are loaded from the bsp as usual, the image refers
+// to them as externals.  The cache is keyed on the crc of the bsp, the
+// engine version and the sizes of the structures, anything else means the
+// map is processed again and the cache rewritten.
+
+#include "quakedef.h"
+#include "bspcache.h"
+
+#include <stdint.h>
+
+#define	BSPCACHE_ALIGN		16
+#define	BSPCACHE_EXTERNAL	0x40000000	// offset is into the externals
+
+typedef struct
+{
+	byte	*base;			// where the data is now
+	int		size;
+	int		ofs;			// in the image, or in the externals
+	qboolean	external;
+} bspblock_t;
+
+struct bspcache_s
+{
+	bspblock_t	*blocks;
+	int			numblocks, maxblocks;
+	int			imagesize;
+
+	bspblock_t	*externals;
+	int			numexternals, maxexternals;
+	int			externalsize;
+
+	bspblock_t	**sorted;		// both kinds, by base, for the way out
+	int			numsorted;
+
+	qboolean	bad;
+};
+
+typedef struct
+{
+	char	id[4];
+	int		version;
+	int		engine;
+	int		layout;
+	int		bspsize;
+	int		bspcrc;
+	int		modelsize;
+	int		imagesize;
+	int		numexternals;
+} bspcachehdr_t;
+
+cvar_t	mod_bspcache = {"mod_bspcache", "1"};
+
+/*
+================
+BspCache_Init
+================
+*/
+void BspCache_Init (void)
+{
+	Cvar_RegisterVariable (&mod_bspcache);
+}
+
+/*
+================
+BspCache_MakeKey
+================
+*/
+void BspCache_MakeKey (bspkey_t *key, byte *bsp, int bspsize, int *sizes, int numsizes)
+{
+	key->layout = CRC_Block ((byte *)sizes, numsizes * sizeof(int));
+	key->bspsize = bspsize;
+	key->bspcrc = CRC_Block (bsp, bspsize);
+}
+
+/*
+================
+BspCache_Create
+================
+*/
+bspcache_t *BspCache_Create (void)
+{
+	bspcache_t	*c;
+
+	c = malloc (sizeof(bspcache_t));
+	if (!c)
+		Sys_Error ("BspCache_Create: out of memory");
+	memset (c, 0, sizeof(*c));
+
+	return c;
+}
+
+/*
+================
+BspCache_Free
+================
+*/
+void BspCache_Free (bspcache_t *c)
+{
+	free (c->blocks);
+	free (c->externals);
+	free (c->sorted);
+	free (c);
+}
+
+static bspblock_t *BspCache_NewBlock (bspblock_t **list, int *num, int *max)
+{
+	if (*num == *max)
+	{
+		*max = *max ? *max * 2 : 64;
+		*list = realloc (*list, *max * sizeof(bspblock_t));
+		if (!*list)
+			Sys_Error ("BspCache_NewBlock: out of memory");
+	}
+
+	return &(*list)[(*num)++];
+}
+
+/*
+================
+BspCache_AddBlock
+================
+*/
+void BspCache_AddBlock (bspcache_t *c, void *data, int size)
+{
+	bspblock_t	*b;
+
+	if (!data || size <= 0)
+		return;
+
+	b = BspCache_NewBlock (&c->blocks, &c->numblocks, &c->maxblocks);
+	b->base = data;
+	b->size = size;
+	b->ofs = c->imagesize;
+	b->external = false;
+
+	c->imagesize = (c->imagesize + size + BSPCACHE_ALIGN - 1) & ~(BSPCACHE_ALIGN - 1);
+}
+
+/*
+================
+BspCache_AddExternal
+================
+*/
+void BspCache_AddExternal (bspcache_t *c, void *data, int size)
+{
+	bspblock_t	*b;
+
+	b = BspCache_NewBlock (&c->externals, &c->numexternals, &c->maxexternals);
+	b->base = data;
+	b->size = data ? size : 0;
+	b->ofs = c->externalsize;
+	b->external = true;
+
+	c->externalsize += b->size;
+}
+
+static int BspCache_CompareBase (const void *a, const void *b)
+{
+	byte	*x, *y;
+
+	x = (*(bspblock_t **)a)->base;
+	y = (*(bspblock_t **)b)->base;
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+================
+BspCache_Sort
+================
+*/
+static void BspCache_Sort (bspcache_t *c)
+{
+	int		i;
+
+	free (c->sorted);
+	c->sorted = malloc ((c->numblocks + c->numexternals) * sizeof(bspblock_t *) + 1);
+	if (!c->sorted)
+		Sys_Error ("BspCache_Sort: out of memory");
+
+	c->numsorted = 0;
+	for (i=0 ; i<c->numblocks ; i++)
+		c->sorted[c->numsorted++] = &c->blocks[i];
+	for (i=0 ; i<c->numexternals ; i++)
+		if (c->externals[i].size)
+			c->sorted[c->numsorted++] = &c->externals[i];
+
+	qsort (c->sorted, c->numsorted, sizeof(bspblock_t *), BspCache_CompareBase);
+}
+
+/*
+================
+BspCache_FindBase
+
+The block holding p, a pointer just past the end of a block counts as in it
+================
+*/
+static bspblock_t *BspCache_FindBase (bspcache_t *c, byte *p)
+{
+	int			lo, hi, mid;
+	bspblock_t	*b;
+
+	lo = 0;
+	hi = c->numsorted - 1;
+	b = NULL;
+	while (lo <= hi)
+	{
+		mid = (lo + hi) / 2;
+		if (c->sorted[mid]->base <= p)
+		{
+			b = c->sorted[mid];
+			lo = mid + 1;
+		}
+		else
+			hi = mid - 1;
+	}
+
+	if (b && p <= b->base + b->size)
+		return b;
+
+	return NULL;
+}
+
+/*
+================
+BspCache_FindOffset
+================
+*/
+static bspblock_t *BspCache_FindOffset (bspblock_t *list, int num, int ofs)
+{
+	int		lo, hi, mid, found;
+
+	lo = 0;
+	hi = num - 1;
+	found = -1;
+	while (lo <= hi)
+	{
+		mid = (lo + hi) / 2;
+		if (list[mid].ofs <= ofs)
+		{
+			found = mid;
+			lo = mid + 1;
+		}
+		else
+			hi = mid - 1;
+	}
+
+	// empty externals share their offset with the next one and hold nothing
+	while (found >= 0 && !list[found].size)
+		found--;
+
+	if (found >= 0 && ofs <= list[found].ofs + list[found].size)
+		return &list[found];
+
+	return NULL;
+}
+
+/*
+================
+BspCache_Check
+================
+*/
+static void *BspCache_Check (bspcache_t *c, void **p)
+{
+	if (!c->sorted)
+		BspCache_Sort (c);
+
+	if (*p && !BspCache_FindBase (c, *p))
+		c->bad = true;
+
+	return *p;
+}
+
+/*
+================
+BspCache_Swizzle
+================
+*/
+static void *BspCache_Swizzle (bspcache_t *c, void **p)
+{
+	bspblock_t	*b;
+	byte		*ptr;
+	int			ofs;
+
+	ptr = *p;
+	if (!ptr)
+		return NULL;
+
+	b = BspCache_FindBase (c, ptr);
+	if (!b)
+	{
+		c->bad = true;		// BspCache_Check lets nothing like this through
+		return ptr;
+	}
+
+	ofs = b->ofs + (ptr - b->base) + 1;
+	if (b->external)
+		ofs |= BSPCACHE_EXTERNAL;
+	*p = (void *)(intptr_t)ofs;
+
+	return ptr;
+}
+
+/*
+================
+BspCache_Unswizzle
+================
+*/
+static void *BspCache_Unswizzle (bspcache_t *c, void **p)
+{
+	bspblock_t	*b;
+	int			ofs;
+
+	ofs = (intptr_t)*p;
+	if (!ofs)
+		return NULL;
+
+	if (ofs & BSPCACHE_EXTERNAL)
+	{
+		ofs = (ofs & ~BSPCACHE_EXTERNAL) - 1;
+		b = BspCache_FindOffset (c->externals, c->numexternals, ofs);
+	}
+	else
+	{
+		ofs = ofs - 1;
+		b = BspCache_FindOffset (c->blocks, c->numblocks, ofs);
+	}
+
+	if (!b)
+	{
+		c->bad = true;
+		*p = NULL;
+		return NULL;
+	}
+
+	*p = b->base + (ofs - b->ofs);
+
+	return *p;
+}
+
+/*
+================
+BspCache_Path
+================
+*/
+static void BspCache_Path (char *bspname, char *path, int size)
+{
+	char	name[MAX_QPATH];
+
+	COM_StripExtension (bspname, name);
+	snprintf (path, size, "%s/cache/%s.bspc", com_gamedir, name);
+}
+
+/*
+================
+BspCache_Write
+================
+*/
+qboolean BspCache_Write (bspcache_t *c, char *bspname, bspkey_t *key, void *model, int modelsize,
+	void (*walk) (void *model, bspcache_t *c, bspfix_t fix))
+{
+	static byte		pad[BSPCACHE_ALIGN];
+	char			path[MAX_OSPATH];
+	bspcachehdr_t	header;
+	bspblock_t		*b;
+	FILE			*f;
+	int				i, pos;
+	qboolean		ok;
+
+	if (!mod_bspcache.value)
+		return false;
+
+	c->bad = false;
+	walk (model, c, BspCache_Check);
+	if (c->bad)
+	{
+		Con_DPrintf ("%s points outside itself, not cached\n", bspname);
+		return false;
+	}
+
+	BspCache_Path (bspname, path, sizeof(path));
+	COM_CreatePath (path);
+	f = fopen (path, "wb");
+	if (!f)
+		return false;
+
+	memcpy (header.id, "BSPC", 4);
+	header.version = BSPCACHE_VERSION;
+	header.engine = (int)(VERSION * 100 + 0.5);
+	header.layout = key->layout;
+	header.bspsize = key->bspsize;
+	header.bspcrc = key->bspcrc;
+	header.modelsize = modelsize;
+	header.imagesize = c->imagesize;
+	header.numexternals = c->numexternals;
+
+	// the pointers are only offsets while the blocks are written
+	walk (model, c, BspCache_Swizzle);
+
+	ok = fwrite (&header, sizeof(header), 1, f) == 1;
+	for (i=0 ; i<c->numexternals && ok ; i++)
+		ok = fwrite (&c->externals[i].size, sizeof(int), 1, f) == 1;
+	if (ok)
+		ok = fwrite (model, modelsize, 1, f) == 1;
+
+	pos = 0;
+	for (i=0, b=c->blocks ; i<c->numblocks && ok ; i++, b++)
+	{
+		if (b->ofs > pos)
+			ok = fwrite (pad, b->ofs - pos, 1, f) == 1;
+		if (ok)
+			ok = fwrite (b->base, b->size, 1, f) == 1;
+		pos = b->ofs + b->size;
+	}
+	if (ok && c->imagesize > pos)
+		ok = fwrite (pad, c->imagesize - pos, 1, f) == 1;
+
+	walk (model, c, BspCache_Unswizzle);
+
+	if (fclose (f) || !ok)
+	{
+		remove (path);
+		return false;
+	}
+	COM_FileWritten (path + strlen(com_gamedir) + 1);
+
+	Con_DPrintf ("%s: wrote %iK processed image\n", bspname, c->imagesize / 1024);
+
+	return true;
+}
+
+/*
+================
+BspCache_Read
+================
+*/
+qboolean BspCache_Read (bspcache_t *c, char *bspname, bspkey_t *key, void *model, int modelsize,
+	void (*walk) (void *model, bspcache_t *c, bspfix_t fix))
+{
+	char			path[MAX_OSPATH];
+	bspcachehdr_t	header;
+	int				h, len, i, size, mark;
+	byte			*image;
+	qboolean		ok;
+
+	if (!mod_bspcache.value)
+		return false;
+
+	BspCache_Path (bspname, path, sizeof(path));
+	len = Sys_FileOpenRead (path, &h);
+	if (h == -1)
+		return false;
+
+	ok = Sys_FileRead (h, &header, sizeof(header)) == sizeof(header)
+		&& !memcmp (header.id, "BSPC", 4)
+		&& header.version == BSPCACHE_VERSION
+		&& header.engine == (int)(VERSION * 100 + 0.5)
+		&& header.layout == key->layout
+		&& header.bspsize == key->bspsize
+		&& header.bspcrc == key->bspcrc
+		&& header.modelsize == modelsize
+		&& header.numexternals == c->numexternals
+		&& header.imagesize > 0
+		&& len == sizeof(header) + header.numexternals * sizeof(int) + modelsize + header.imagesize;
+
+	// the textures and lighting loaded from the bsp must be what the
+	// image was made with
+	for (i=0 ; i<c->numexternals && ok ; i++)
+		ok = Sys_FileRead (h, &size, sizeof(int)) == sizeof(int) && size == c->externals[i].size;
+
+	if (ok)
+		ok = Sys_FileRead (h, model, modelsize) == modelsize;
+
+	if (!ok)
+	{
+		Sys_FileClose (h);
+		Con_DPrintf ("%s: cached image is stale\n", bspname);
+		return false;
+	}
+
+	mark = Hunk_LowMark ();
+	image = Hunk_AllocName (header.imagesize, "bspcache");
+	ok = Sys_FileRead (h, image, header.imagesize) == header.imagesize;
+	Sys_FileClose (h);
+
+	if (ok)
+	{
+		c->numblocks = 0;
+		c->imagesize = 0;
+		BspCache_AddBlock (c, image, header.imagesize);
+
+		c->bad = false;
+		walk (model, c, BspCache_Unswizzle);
+		ok = !c->bad;
+	}
+
+	if (!ok)
+	{
+		Hunk_FreeToLowMark (mark);
+		Con_Printf ("%s: cached image is corrupt\n", bspname);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,61 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// bspcache.h -- processed brush models saved for the next load of the map
+
+#define	BSPCACHE_VERSION	1
+
+typedef struct bspcache_s bspcache_t;
+
+// every pointer in the model goes through one of these: on the way out it
+// becomes an offset, on the way in the offset becomes a pointer again.
+// Either way the usable address is returned, so the walker can follow it.
+typedef void *(*bspfix_t) (bspcache_t *c, void **p);
+
+typedef struct
+{
+	int		layout;		// crc of the port's structure sizes
+	int		bspsize;
+	int		bspcrc;
+} bspkey_t;
+
+extern	cvar_t	mod_bspcache;
+
+void BspCache_Init (void);
+
+void BspCache_MakeKey (bspkey_t *key, byte *bsp, int bspsize, int *sizes, int numsizes);
+
+bspcache_t *BspCache_Create (void);
+void BspCache_Free (bspcache_t *c);
+
+// blocks are written into the image, externals are reloaded from the bsp
+// each time and only referred to; both must be added in the same order
+// when saving and loading
+void BspCache_AddBlock (bspcache_t *c, void *data, int size);
+void BspCache_AddExternal (bspcache_t *c, void *data, int size);
+
+// checks every pointer leads into a block or an external, then swizzles the
+// live data, writes it out and puts the pointers back
+qboolean BspCache_Write (bspcache_t *c, char *bspname, bspkey_t *key, void *model, int modelsize,
+	void (*walk) (void *model, bspcache_t *c, bspfix_t fix));
+
+// reads the image onto the hunk and relocates it in one pass over the
+// model, which the caller then copies fields from; false if it is stale
+qboolean BspCache_Read (bspcache_t *c, char *bspname, bspkey_t *key, void *model, int modelsize,
+	void (*walk) (void *model, bspcache_t *c, bspfix_t fix));
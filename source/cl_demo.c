@@ -19,9 +19,12 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "quakedef.h"
+#include "prof.h"
 
 void CL_FinishTimeDemo (void);
 
+static	qboolean	td_ended;			// the demo ran out rather than being stopped
+
 /*
 ==============================================================================
 
@@ -127,6 +130,7 @@ int CL_GetMessage (void)
 		r = Sys_FileRead(cls.demofile, net_message.data, net_message.cursize) / net_message.cursize;
 		if (r != 1)
 		{
+			td_ended = cls.timedemo;
 			CL_StopPlayback ();
 			return 0;
 		}
@@ -250,6 +254,7 @@ void CL_Record_f (void)
 		Con_Printf ("ERROR: couldn't open demo for writing.\n");
 		return;
 	}
+	COM_FileWritten (name + strlen(com_gamedir) + 1);
 
 	cls.forcetrack = track;
 	sprintf(forcetrack, "%i\n", cls.forcetrack);
@@ -278,21 +283,12 @@ static int CL_FileGetChar(int handle)
 	return c;
 }
 
-void CL_PlayDemo_f (void)
+static void CL_PlayDemo (char *demoname)
 {
 	char	name[256];
 	int c;
 	qboolean neg = false;
 
-	if (cmd_source != src_command)
-		return;
-
-	if (Cmd_Argc() != 2)
-	{
-		Con_Printf ("play <demoname> : plays a demo\n");
-		return;
-	}
-
 //
 // disconnect from server
 //
@@ -301,11 +297,15 @@ void CL_PlayDemo_f (void)
 //
 // open the demo file
 //
-	strcpy (name, Cmd_Argv(1));
+	Q_strncpyz (name, demoname, sizeof(name) - 4);
 	COM_DefaultExtension (name, ".dem");
 
 	Con_Printf ("Playing demo from %s.\n", name);
+#if defined(_3DS) || defined(__linux__)
+	COM_OpenFile (name, &cls.demofile);
+#else
 	COM_FOpenFile (name, &cls.demofile);
+#endif // _3DS, __linux__
 	if (cls.demofile < 0)
 	{
 		Con_Printf ("ERROR: couldn't open demo for reading.\n");
@@ -329,6 +329,367 @@ void CL_PlayDemo_f (void)
 //	fscanf (cls.demofile, "%i\n", &cls.forcetrack);
 }
 
+void CL_PlayDemo_f (void)
+{
+	if (cmd_source != src_command)
+		return;
+
+	if (Cmd_Argc() != 2)
+	{
+		Con_Printf ("play <demoname> : plays a demo\n");
+		return;
+	}
+
+	CL_PlayDemo (Cmd_Argv(1));
+}
+
+/*
+==============================================================================
+
+TIMEDEMO
+
+A timedemo plays a demo back as fast as frames can be drawn, a message a
+frame.  Every frame's time is kept, with what the profiler's zones took of
+it, so the report has percentiles, the worst frames and where the time
+went rather than an average alone.  The results go to <timedemo_output>.csv,
+a line a frame, and .json, the summary timedemo_compare reads.
+
+timedemo_warmup frames at the start of each run aren't counted, and
+"timedemo <demo> <runs>" plays it that many times into one set of results.
+==============================================================================
+*/
+
+#define	MAX_TDRUNS		32
+#define	TD_WORST		5			// frames listed by time
+#define	TD_SLOWER		5			// percent worse before compare flags it
+#define	TD_PARTS		7
+
+#ifdef __PSP__
+#define	TD_PLATFORM		"PSP"
+#elif _3DS
+#define	TD_PLATFORM		"3DS"
+#elif __WII__
+#define	TD_PLATFORM		"WII"
+#else
+#define	TD_PLATFORM		"Linux"
+#endif // __PSP__, _3DS, __WII__
+
+// the zones a frame is split into, and what the results call them
+static char *td_zones[TD_PARTS] =
+{
+	"CL_ParseServerMessage", "CL_RelinkEntities", "R_DrawWorld", "R_DrawEntitiesOnList",
+	"QMB_DrawParticles", "SCR_2D", "S_Update"
+};
+static char *td_parts[TD_PARTS] =
+{
+	"parse", "relink", "world", "entities", "particles", "2d", "sound"
+};
+
+typedef struct
+{
+	float	ms;
+	float	time;				// cl.time at its end
+	int		run;
+	float	parts[TD_PARTS];
+} tdframe_t;
+
+typedef struct
+{
+	int		frames;
+	float	fps;
+	float	min, avg, p50, p95, p99, max;
+	float	parts[TD_PARTS];	// ms a frame
+	int		worst[TD_WORST];
+	int		numworst;
+} tdsummary_t;
+
+cvar_t	timedemo_warmup = {"timedemo_warmup", "0"};			// frames of each run that aren't counted
+cvar_t	timedemo_output = {"timedemo_output", "timedemo"};	// <name>.csv and .json, "" for none
+
+static	tdframe_t	*td_frames;
+static	int			td_numframes;
+static	int			td_maxframes;
+static	int			td_dropped;			// no memory to keep them, the results are truncated
+
+static	char		td_demo[MAX_QPATH];
+static	int			td_runs;
+static	int			td_run;				// from 0
+static	float		td_runfps[MAX_TDRUNS];
+static	qboolean	td_again;			// the next run is in the command buffer
+
+static	int			td_seen;			// frames of this run so far
+static	double		td_lastrealtime;
+static	qboolean	td_haveparts;
+
+/*
+====================
+CL_TimeDemoFrame
+
+Keeps the frame that just ended, the profiler has just summed it
+====================
+*/
+void CL_TimeDemoFrame (void)
+{
+	tdframe_t	*f;
+	float		ms;
+	int			max;
+
+	ms = (realtime - td_lastrealtime) * 1000;
+	td_lastrealtime = realtime;
+
+// the first frame had the loading in it
+	if (!cls.timedemo || host_framecount <= cls.td_startframe + 1 || cls.signon != SIGNONS)
+		return;
+	if (td_seen++ < timedemo_warmup.value)
+		return;
+
+	if (td_numframes == td_maxframes)
+	{
+		max = td_maxframes ? td_maxframes * 2 : 4096;
+		f = realloc (td_frames, max * sizeof(tdframe_t));
+		if (!f)
+		{
+			if (!td_dropped++)
+				Con_Printf ("No memory for more than %i timedemo frames, the results will be truncated\n", td_numframes);
+			return;
+		}
+		td_frames = f;
+		td_maxframes = max;
+	}
+
+	f = &td_frames[td_numframes++];
+	f->ms = ms;
+	f->time = cl.time;
+	f->run = td_run;
+
+#ifdef PROF_ZONES
+	if (Prof_LastFrame (td_zones, TD_PARTS, f->parts))
+		return;
+#endif // PROF_ZONES
+	memset (f->parts, 0, sizeof(f->parts));
+	td_haveparts = false;
+}
+
+/*
+====================
+CL_TimeDemoCompareMs
+====================
+*/
+static int CL_TimeDemoCompareMs (const void *a, const void *b)
+{
+	float	x = *(float *)a, y = *(float *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/*
+====================
+CL_TimeDemoPercentile
+
+Nearest rank
+====================
+*/
+static float CL_TimeDemoPercentile (float *sorted, int count, float percent)
+{
+	int		i;
+
+	i = (int)ceil (percent * count / 100) - 1;
+	if (i < 0)
+		i = 0;
+	if (i > count - 1)
+		i = count - 1;
+
+	return sorted[i];
+}
+
+/*
+====================
+CL_TimeDemoSummary
+====================
+*/
+static qboolean CL_TimeDemoSummary (tdsummary_t *s)
+{
+	float	*sorted, total;
+	int		i, j, k;
+
+	memset (s, 0, sizeof(*s));
+	if (!td_numframes)
+		return false;
+
+	sorted = malloc (td_numframes * sizeof(float));
+	if (!sorted)
+		return false;
+
+	total = 0;
+	for (i=0 ; i<td_numframes ; i++)
+	{
+		sorted[i] = td_frames[i].ms;
+		total += td_frames[i].ms;
+		for (j=0 ; j<TD_PARTS ; j++)
+			s->parts[j] += td_frames[i].parts[j];
+	}
+	qsort (sorted, td_numframes, sizeof(float), CL_TimeDemoCompareMs);
+
+	s->frames = td_numframes;
+	s->fps = total > 0 ? td_numframes * 1000 / total : 0;
+	s->min = sorted[0];
+	s->avg = total / td_numframes;
+	s->p50 = CL_TimeDemoPercentile (sorted, td_numframes, 50);
+	s->p95 = CL_TimeDemoPercentile (sorted, td_numframes, 95);
+	s->p99 = CL_TimeDemoPercentile (sorted, td_numframes, 99);
+	s->max = sorted[td_numframes - 1];
+	for (j=0 ; j<TD_PARTS ; j++)
+		s->parts[j] /= td_numframes;
+	free (sorted);
+
+// the slowest few, slowest first
+	for (s->numworst=0 ; s->numworst<TD_WORST && s->numworst<td_numframes ; s->numworst++)
+	{
+		k = -1;
+		for (i=0 ; i<td_numframes ; i++)
+		{
+			for (j=0 ; j<s->numworst ; j++)
+				if (s->worst[j] == i)
+					break;
+			if (j == s->numworst && (k < 0 || td_frames[i].ms > td_frames[k].ms))
+				k = i;
+		}
+		s->worst[s->numworst] = k;
+	}
+
+	return true;
+}
+
+/*
+====================
+CL_TimeDemoWrite
+====================
+*/
+static void CL_TimeDemoWrite (tdsummary_t *s)
+{
+	char		path[MAX_OSPATH];
+	tdframe_t	*f;
+	FILE		*file;
+	int			i, j, frame;
+
+	snprintf (path, sizeof(path), "%s/%s.csv", com_gamedir, timedemo_output.string);
+	file = fopen (path, "w");
+	if (!file)
+	{
+		Con_Printf ("Couldn't write %s\n", path);
+		return;
+	}
+
+	fprintf (file, "run,frame,time,ms");
+	for (j=0 ; j<TD_PARTS ; j++)
+		fprintf (file, ",%s", td_parts[j]);
+	fprintf (file, "\n");
+
+	frame = 0;
+	for (i=0, f=td_frames ; i<td_numframes ; i++, f++)
+	{
+		frame = (i && f->run == f[-1].run) ? frame + 1 : 0;
+		fprintf (file, "%i,%i,%.3f,%.3f", f->run + 1, frame, f->time, f->ms);
+		for (j=0 ; j<TD_PARTS ; j++)
+			fprintf (file, ",%.3f", f->parts[j]);
+		fprintf (file, "\n");
+	}
+	fclose (file);
+
+	snprintf (path, sizeof(path), "%s/%s.json", com_gamedir, timedemo_output.string);
+	file = fopen (path, "w");
+	if (!file)
+	{
+		Con_Printf ("Couldn't write %s\n", path);
+		return;
+	}
+
+	fprintf (file, "{\n\"build\":\"%s NZP v%4.1f %s %s\",\n", TD_PLATFORM, (float)(VERSION), __DATE__, __TIME__);
+	fprintf (file, "\"demo\":\"%s\",\n\"runs\":%i,\n\"warmup\":%i,\n\"frames\":%i,\n\"dropped\":%i,\n",
+		td_demo, td_run, (int)timedemo_warmup.value, s->frames, td_dropped);
+	fprintf (file, "\"fps\":%.2f,\n\"min\":%.3f,\n\"avg\":%.3f,\n\"p50\":%.3f,\n\"p95\":%.3f,\n\"p99\":%.3f,\n\"max\":%.3f,\n",
+		s->fps, s->min, s->avg, s->p50, s->p95, s->p99, s->max);
+
+	if (td_haveparts)
+	{
+		fprintf (file, "\"parts\":{");
+		for (j=0 ; j<TD_PARTS ; j++)
+			fprintf (file, "%s\"%s\":%.3f", j ? "," : "", td_parts[j], s->parts[j]);
+		fprintf (file, "},\n");
+	}
+
+	fprintf (file, "\"runfps\":[");
+	for (i=0 ; i<td_run && i<MAX_TDRUNS ; i++)
+		fprintf (file, "%s%.2f", i ? "," : "", td_runfps[i]);
+	fprintf (file, "],\n");
+
+	fprintf (file, "\"worst\":[");
+	for (i=0 ; i<s->numworst ; i++)
+	{
+		f = &td_frames[s->worst[i]];
+		fprintf (file, "%s{\"ms\":%.3f,\"time\":%.3f,\"run\":%i}", i ? "," : "", f->ms, f->time, f->run + 1);
+	}
+	fprintf (file, "]\n}\n");
+	fclose (file);
+
+	Con_Printf ("Wrote %s/%s.csv and .json\n", com_gamedir, timedemo_output.string);
+}
+
+/*
+====================
+CL_TimeDemoDone
+
+Reports every run so far and lets go of them
+====================
+*/
+static void CL_TimeDemoDone (void)
+{
+	tdsummary_t	s;
+	tdframe_t	*f;
+	int			i;
+
+	if (CL_TimeDemoSummary (&s))
+	{
+		Con_Printf ("%i frames timed over %i run%s, %5.1f fps\n", s.frames, td_run, td_run == 1 ? "" : "s", s.fps);
+		Con_Printf ("    min    avg    p50    p95    p99    max ms\n");
+		Con_Printf ("%7.2f%7.2f%7.2f%7.2f%7.2f%7.2f\n", s.min, s.avg, s.p50, s.p95, s.p99, s.max);
+
+		for (i=0 ; i<s.numworst ; i++)
+		{
+			f = &td_frames[s.worst[i]];
+			Con_Printf ("%7.2f ms at %.2f seconds, run %i\n", f->ms, f->time, f->run + 1);
+		}
+
+		if (td_haveparts)
+		{
+			Con_Printf ("ms a frame:");
+			for (i=0 ; i<TD_PARTS ; i++)
+				Con_Printf (" %s %.2f", td_parts[i], s.parts[i]);
+			Con_Printf ("\n");
+		}
+
+		if (td_run > 1)
+			for (i=0 ; i<td_run && i<MAX_TDRUNS ; i++)
+				Con_Printf ("run %i %5.1f fps\n", i + 1, td_runfps[i]);
+
+		if (td_dropped)
+			Con_Printf ("TRUNCATED: %i frames weren't kept, there was no memory for them\n", td_dropped);
+
+		if (timedemo_output.string[0])
+			CL_TimeDemoWrite (&s);
+	}
+
+	free (td_frames);
+	td_frames = NULL;
+	td_numframes = td_maxframes = 0;
+	td_dropped = 0;
+	td_runs = 0;
+
+#ifdef PROF_ZONES
+	Prof_Hold (false);
+#endif // PROF_ZONES
+}
+
 /*
 ====================
 CL_FinishTimeDemo
@@ -339,8 +700,11 @@ void CL_FinishTimeDemo (void)
 {
 	int		frames;
 	double	time;
+	qboolean	ended;
 	
 	cls.timedemo = false; 
+	ended = td_ended;
+	td_ended = false;
 	
 // the first frame didn't count
 	frames = (host_framecount - cls.td_startframe) - 1;
@@ -348,13 +712,27 @@ void CL_FinishTimeDemo (void)
 	if (time < 1)
 		time = 1;
 	Con_Printf ("%i frames %5.1f seconds %5.1f fps\n", frames, time, frames/time);
+
+	if (td_run < MAX_TDRUNS)
+		td_runfps[td_run] = frames/time;
+	td_run++;
+
+// a stopped timedemo doesn't go round again
+	if (ended && td_run < td_runs)
+	{
+		td_again = true;
+		Cbuf_AddText (va("timedemo \"%s\"\n", td_demo));
+		return;
+	}
+
+	CL_TimeDemoDone ();
 }
 
 /*
 ====================
 CL_TimeDemo_f
 
-timedemo [demoname]
+timedemo [demoname] [runs]
 ====================
 */
 void CL_TimeDemo_f (void)
@@ -362,13 +740,41 @@ void CL_TimeDemo_f (void)
 	if (cmd_source != src_command)
 		return;
 
-	if (Cmd_Argc() != 2)
+	if (Cmd_Argc() != 2 && Cmd_Argc() != 3)
 	{
-		Con_Printf ("timedemo <demoname> : gets demo speeds\n");
+		Con_Printf ("timedemo <demoname> [runs] : gets demo speeds\n");
 		return;
 	}
 
-	CL_PlayDemo_f ();
+	if (td_again)
+	{
+		td_again = false;
+		CL_PlayDemo (td_demo);
+		if (!cls.demoplayback)
+		{
+			CL_TimeDemoDone ();
+			return;
+		}
+	}
+	else
+	{
+		td_runs = 0;		// one still going is reported as it stands
+		CL_PlayDemo (Cmd_Argv(1));
+		if (!cls.demoplayback)
+			return;
+
+		Q_strncpyz (td_demo, Cmd_Argv(1), sizeof(td_demo));
+		td_runs = Cmd_Argc() == 3 ? Q_atoi (Cmd_Argv(2)) : 1;
+		if (td_runs < 1)
+			td_runs = 1;
+		td_run = 0;
+		td_numframes = 0;
+		td_dropped = 0;
+		td_haveparts = true;
+#ifdef PROF_ZONES
+		Prof_Hold (true);
+#endif // PROF_ZONES
+	}
 	
 // cls.td_starttime will be grabbed at the second frame of the demo, so
 // all the loading time doesn't get counted
@@ -376,5 +782,150 @@ void CL_TimeDemo_f (void)
 	cls.timedemo = true;
 	cls.td_startframe = host_framecount;
 	cls.td_lastframe = -1;		// get a new message this frame
+	td_seen = 0;
+}
+
+/*
+====================
+CL_TimeDemoLoad
+
+A results file, in a buffer to free
+====================
+*/
+static char *CL_TimeDemoLoad (char *name)
+{
+	char	path[MAX_OSPATH];
+	char	*buf;
+	FILE	*f;
+	int		len;
+
+	snprintf (path, sizeof(path) - 5, "%s/%s", com_gamedir, name);
+	COM_DefaultExtension (path, ".json");
+
+	f = fopen (path, "rb");
+	if (!f)
+	{
+		Con_Printf ("Couldn't read %s\n", path);
+		return NULL;
+	}
+
+	fseek (f, 0, SEEK_END);
+	len = ftell (f);
+	fseek (f, 0, SEEK_SET);
+
+	buf = malloc (len + 1);
+	if (buf)
+	{
+		len = fread (buf, 1, len, f);
+		buf[len] = 0;
+	}
+	fclose (f);
+
+	return buf;
+}
+
+/*
+====================
+CL_TimeDemoNumber
+
+The value of a key in the results, they're all unique and none nest
+====================
+*/
+static qboolean CL_TimeDemoNumber (char *results, char *key, float *value)
+{
+	char	*s;
+
+	s = strstr (results, va("\"%s\":", key));
+	if (!s)
+		return false;
+
+	*value = atof (s + strlen(key) + 3);
+	return true;
+}
+
+/*
+====================
+CL_TimeDemoBuild
+====================
+*/
+static char *CL_TimeDemoBuild (char *results)
+{
+	static char	build[2][64];
+	static int	which;
+	char		*s;
+	int			i;
+
+	which ^= 1;
+	build[which][0] = 0;
+
+	s = strstr (results, "\"build\":\"");
+	if (s)
+	{
+		s += 9;
+		for (i=0 ; s[i] && s[i] != '"' && i<sizeof(build[0])-1 ; i++)
+			build[which][i] = s[i];
+		build[which][i] = 0;
+	}
+
+	return build[which];
 }
 
+/*
+====================
+CL_TimeDemoCompare_f
+
+timedemo_compare <base> <new>
+====================
+*/
+void CL_TimeDemoCompare_f (void)
+{
+	static char *frametimes[] = {"fps", "min", "avg", "p50", "p95", "p99", "max"};
+	char	*base, *test;
+	float	a, b, change;
+	int		i;
+
+	if (Cmd_Argc() != 3)
+	{
+		Con_Printf ("timedemo_compare <base> <new> : compares two timedemo results\n");
+		return;
+	}
+
+	base = CL_TimeDemoLoad (Cmd_Argv(1));
+	if (!base)
+		return;
+	test = CL_TimeDemoLoad (Cmd_Argv(2));
+	if (!test)
+	{
+		free (base);
+		return;
+	}
+
+	Con_Printf ("base %s\n", CL_TimeDemoBuild (base));
+	Con_Printf ("new  %s\n", CL_TimeDemoBuild (test));
+	if (CL_TimeDemoNumber (base, "dropped", &a) && a)
+		Con_Printf ("base is TRUNCATED, %i frames weren't kept\n", (int)a);
+	if (CL_TimeDemoNumber (test, "dropped", &b) && b)
+		Con_Printf ("new is TRUNCATED, %i frames weren't kept\n", (int)b);
+	Con_Printf ("            base      new  change\n");
+
+	for (i=0 ; i<sizeof(frametimes)/sizeof(frametimes[0]) ; i++)
+	{
+		if (!CL_TimeDemoNumber (base, frametimes[i], &a) || !CL_TimeDemoNumber (test, frametimes[i], &b) || !a)
+			continue;
+
+	// more fps is better, less of everything else
+		change = (b - a) * 100 / a;
+		Con_Printf ("%-6s %9.2f %8.2f %+6.1f%%%s\n", frametimes[i], a, b, change,
+			(i ? change : -change) > TD_SLOWER ? " slower" : "");
+	}
+
+	for (i=0 ; i<TD_PARTS ; i++)
+	{
+		if (!CL_TimeDemoNumber (base, td_parts[i], &a) || !CL_TimeDemoNumber (test, td_parts[i], &b))
+			continue;
+		Con_Printf ("%-9s %6.2f %8.2f %+6.2f ms\n", td_parts[i], a, b, b - a);
+	}
+
+	free (base);
+	free (test);
+}
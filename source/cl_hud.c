@@ -718,11 +718,11 @@ void HUD_MaxAmmo(void)
 	double start_time, end_time;
 
 	// For the first 0.5s, stay still while we fade in
-	if (hud_maxammo_endtime > sv.time + 1.5) {
+	if (hud_maxammo_endtime > cl.svtime + 1.5) {
 		start_time = hud_maxammo_starttime;
 		end_time = hud_maxammo_starttime + 0.5;
 
-		text_alpha = (sv.time - start_time) / (end_time - start_time);
+		text_alpha = (cl.svtime - start_time) / (end_time - start_time);
 		pos_y = start_y;
 	}
 	// For the remaining 1.5s, fade out while we fly upwards.
@@ -730,7 +730,7 @@ void HUD_MaxAmmo(void)
 		start_time = hud_maxammo_starttime + 0.5;
 		end_time = hud_maxammo_endtime;
 
-		float percent_time = (sv.time - start_time) / (end_time - start_time);
+		float percent_time = (cl.svtime - start_time) / (end_time - start_time);
 
 		pos_y = start_y + diff_y * percent_time;
 		text_alpha = 1 - percent_time;
@@ -1404,7 +1404,7 @@ void HUD_ProgressBar (void)
 
 	if (cl.progress_bar)
 	{
-		progressbar = 100 - ((cl.progress_bar-sv.time)*10);
+		progressbar = 100 - ((cl.progress_bar-cl.svtime)*10);
 		if (progressbar >= 100)
 			progressbar = 100;
 		Draw_FillByColor  ((vid.width)/2 - 51, vid.height*0.75 - 1, 102, 5, 0, 0, 0,100);
@@ -1612,7 +1612,7 @@ void HUD_Weapon (void)
 	x_value = vid.width;
 	y_value = vid.height - (40 * hud_scale_factor);
 
-	strcpy(str, pr_strings+sv_player->v.Weapon_Name);
+	strcpy(str, cl.weaponname);
 	l = strlen(str);
 
 	x_value = (vid.width - (55 * hud_scale_factor)) - getTextWidth(str, hud_scale_factor);
@@ -1683,8 +1683,8 @@ void HUD_PlayerName (void)
 {
 	int alpha = 255;
 
-	if (nameprint_time - sv.time < 1)
-		alpha = (int)((nameprint_time - sv.time)*255);
+	if (nameprint_time - cl.svtime < 1)
+		alpha = (int)((nameprint_time - cl.svtime)*255);
 
 	Draw_ColoredString(70 * hud_scale_factor, vid.height - (70 * hud_scale_factor), player_name, 255, 255, 255, alpha, hud_scale_factor);
 }
@@ -1770,7 +1770,7 @@ void HUD_Draw (void)
 
 	if (key_dest == key_menu_pause) {
 		// Make sure we still draw the screen flash.
-		if (screenflash_duration > sv.time)
+		if (screenflash_duration > cl.svtime)
 			HUD_Screenflash();
 		return;
 	}
@@ -1795,16 +1795,16 @@ void HUD_Draw (void)
 		HUD_EndScreen ();
 		
 		// Make sure we still draw the screen flash.
-		if (screenflash_duration > sv.time)
+		if (screenflash_duration > cl.svtime)
 			HUD_Screenflash();
 
 		return;
 	}
 
-	if (bettyprompt_time > sv.time)
+	if (bettyprompt_time > cl.svtime)
 		HUD_BettyPrompt();
 
-	if (nameprint_time > sv.time)
+	if (nameprint_time > cl.svtime)
 		HUD_PlayerName();
 
 	HUD_Blood();
@@ -1823,10 +1823,10 @@ void HUD_Draw (void)
 	HUD_Point_Change();
 	HUD_Achievement();
 
-	if (hud_maxammo_endtime > sv.time)
+	if (hud_maxammo_endtime > cl.svtime)
 		HUD_MaxAmmo();
 
 	// This should always come last!
-	if (screenflash_duration > sv.time)
+	if (screenflash_duration > cl.svtime)
 		HUD_Screenflash();
 }
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // rights reserved.
 
 #include "quakedef.h"
+#include "cl_pred.h"
 
 /*
 ===============================================================================
@@ -378,6 +379,7 @@ Send the intended movement message to the server
 */
 
 extern cvar_t waypoint_mode;
+extern cvar_t sv_maxspeed;
 qboolean in_game;
 float crosshair_opacity;
 void CL_BaseMove (usercmd_t *cmd)
@@ -392,7 +394,11 @@ void CL_BaseMove (usercmd_t *cmd)
 	Q_memset (cmd, 0, sizeof(*cmd));
 
 	// cypress - we handle movespeed in QC now.
-	cl_backspeed = cl_forwardspeed = cl_sidespeed = sv_player->v.maxspeed;
+	// a remote client has no sv_player, so it walks at the server's cap
+	if (sv.active)
+		cl_backspeed = cl_forwardspeed = cl_sidespeed = sv_player->v.maxspeed;
+	else
+		cl_backspeed = cl_forwardspeed = cl_sidespeed = sv_maxspeed.value;
 
 	// Throttle side and back speeds
 	cl_sidespeed *= 0.8;
@@ -583,6 +589,7 @@ extern cvar_t cl_crossx, cl_crossy;
 #endif
 void CL_SendMove (usercmd_t *cmd)
 {
+	int		i, sequence;
 	long int		bits;
 	sizebuf_t	buf;
 	byte	data[128];
@@ -712,6 +719,12 @@ void CL_SendMove (usercmd_t *cmd)
     MSG_WriteByte (&buf, in_impulse);
 	in_impulse = 0;
 
+// tag the move so the server can acknowledge it for prediction, if it
+// said it would when we connected
+	sequence = CL_StoreMove (cmd, tempv);
+	if (cls.netcon && (cls.netcon->servercaps & NETCAP_MOVESEQ))
+		MSG_WriteLong (&buf, sequence);
+
 //
 // deliver the message
 //
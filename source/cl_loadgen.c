@@ -0,0 +1,1041 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// cl_loadgen.c -- synthetic clients for server throughput testing
+//
+// Each bot is a protocol-compliant client opened with NET_Connect.  It only
+// reads past every command in the reliable stream to follow the signon
+// sequence, times the server datagrams, then plays a scripted movement
+// pattern.  The bots never learn where they are: the route is a fixed
+// square of headings from wherever they spawn, not the map's waypoints.
+//
+//   nzportable-server -port 26001 -dedicated 16 +loadgen 127.0.0.1:26000 16
+//
+// "local" connects a single bot over loopback to the server in this process.
+
+#include "quakedef.h"
+#include "cl_loadgen.h"
+#include "lz.h"
+
+#define	LOADGEN_SPEED		200		// forward and side move, units per second
+#define	LOADGEN_MOVES		64		// send times kept for svc_moveack, a power of two
+
+enum
+{
+	PATTERN_MIXED,		// round robin over the patterns below
+	PATTERN_ROUTE,		// walk a fixed square from the spawn point, firing at corners
+	PATTERN_STRAFE,		// strafe back and forth while tracking and firing
+	PATTERN_SHOOT,		// stand still, sweep the view, fire and reload
+	NUM_PATTERNS
+};
+
+typedef struct
+{
+	qsocket_t	*netcon;
+	sizebuf_t	message;			// pending clc_stringcmds
+	byte		message_buf[256];
+
+	int			signon;				// last svc_signonnum seen
+	int			pattern;
+	double		connecttime;
+	double		nextmove;
+	double		movesent;			// unanswered move, 0 when none
+	double		lastarrival;
+	float		servertime;			// last svc_time, echoed back for ping
+	int			movesequence;		// last clc_move sequence sent
+	int			moveacked;			// last one svc_moveack timed
+	double		movetimes[LOADGEN_MOVES];	// when each recent sequence went out
+	qboolean	moveseq;			// latency is ping, not time to the next datagram
+
+	int			packets_in, reliable_in, bytes_in, maxpacket;
+	int			packets_out, bytes_out;
+	int			latency_count;
+	double		latency_total, latency_max;
+	int			step_count;
+	double		step_total, step_max;		// server time between datagrams
+	double		arrival_total, arrival_max;	// wall time between datagrams
+} loadbot_t;
+
+static loadbot_t	loadbots[MAX_LOADBOTS];
+static int			loadgen_wanted;
+static char			loadgen_address[64];
+static double		loadgen_nextreport;
+
+cvar_t	loadgen_rate = {"loadgen_rate", "20"};			// moves per second per bot
+cvar_t	loadgen_pattern = {"loadgen_pattern", "0"};
+cvar_t	loadgen_interval = {"loadgen_interval", "0"};	// seconds between reports
+
+/*
+===============
+LoadGen_Drop
+===============
+*/
+static void LoadGen_Drop (loadbot_t *bot)
+{
+	sizebuf_t	buf;
+	byte		data[8];
+	int			i;
+
+	if (!bot->netcon)
+		return;
+
+	buf.maxsize = sizeof(data);
+	buf.cursize = 0;
+	buf.data = data;
+	MSG_WriteByte (&buf, clc_disconnect);
+	for (i=0 ; i<3 ; i++)
+		NET_SendUnreliableMessage (bot->netcon, &buf);
+
+	NET_Close (bot->netcon);
+	bot->netcon = NULL;
+}
+
+/*
+===============
+LoadGen_Connect
+
+NET_Connect blocks until the server answers, so at most one bot is brought
+up per frame
+===============
+*/
+static void LoadGen_Connect (int num)
+{
+	loadbot_t	*bot;
+	qsocket_t	*sock;
+
+	sock = NET_Connect (loadgen_address);
+	if (!sock)
+	{
+		Con_Printf ("loadgen: bot %i could not connect to %s\n", num, loadgen_address);
+		loadgen_wanted = num;
+		return;
+	}
+
+	bot = &loadbots[num];
+	memset (bot, 0, sizeof(*bot));
+	bot->netcon = sock;
+	bot->message.data = bot->message_buf;
+	bot->message.maxsize = sizeof(bot->message_buf);
+	bot->connecttime = realtime;
+	bot->nextmove = realtime;
+	bot->moveseq = (sock->servercaps & NETCAP_MOVESEQ) != 0;
+
+	if (loadgen_pattern.value > PATTERN_MIXED && loadgen_pattern.value < NUM_PATTERNS)
+		bot->pattern = (int)loadgen_pattern.value;
+	else
+		bot->pattern = PATTERN_ROUTE + num % (NUM_PATTERNS - 1);
+}
+
+/*
+===============
+LoadGen_SignonReply
+
+Same replies as CL_SignonReply
+===============
+*/
+static void LoadGen_SignonReply (loadbot_t *bot, int num)
+{
+	switch (bot->signon)
+	{
+	case 1:
+		MSG_WriteByte (&bot->message, clc_stringcmd);
+		MSG_WriteString (&bot->message, "prespawn");
+		break;
+
+	case 2:
+		MSG_WriteByte (&bot->message, clc_stringcmd);
+		MSG_WriteString (&bot->message, va("name \"bot%02i\"\n", num));
+		MSG_WriteByte (&bot->message, clc_stringcmd);
+		MSG_WriteString (&bot->message, "spawn ");
+		break;
+
+	case 3:
+		MSG_WriteByte (&bot->message, clc_stringcmd);
+		MSG_WriteString (&bot->message, "begin");
+		break;
+	}
+}
+
+/*
+===============
+LoadGen_SkipUpdate
+
+Reads past a fast entity update the way CL_ParseUpdate reads one
+===============
+*/
+static void LoadGen_SkipUpdate (int bits)
+{
+	if (bits & U_MOREBITS)
+		bits |= MSG_ReadByte () << 8;
+	if (bits & U_EXTEND1)
+	{
+		bits |= MSG_ReadByte () << 16;
+		if (bits & U_EXTEND2)
+			bits |= MSG_ReadByte () << 24;
+	}
+
+	if (bits & U_LONGENTITY)
+		MSG_ReadShort ();
+	else
+		MSG_ReadByte ();
+
+	if (bits & U_MODEL)
+		MSG_ReadShort ();
+	if (bits & U_FRAME)
+		MSG_ReadByte ();
+	if (bits & U_COLORMAP)
+		MSG_ReadByte ();
+	if (bits & U_SKIN)
+		MSG_ReadByte ();
+	if (bits & U_EFFECTS)
+		MSG_ReadShort ();
+
+	if (bits & U_ORIGIN1)
+		MSG_ReadCoord ();
+	if (bits & U_ANGLE1)
+		MSG_ReadAngle ();
+	if (bits & U_ORIGIN2)
+		MSG_ReadCoord ();
+	if (bits & U_ANGLE2)
+		MSG_ReadAngle ();
+	if (bits & U_ORIGIN3)
+		MSG_ReadCoord ();
+	if (bits & U_ANGLE3)
+		MSG_ReadAngle ();
+
+	if (bits & U_RENDERAMT)
+		MSG_ReadFloat ();
+	if (bits & U_RENDERMODE)
+		MSG_ReadFloat ();
+	if (bits & U_RENDERCOLOR1)
+		MSG_ReadFloat ();
+	if (bits & U_RENDERCOLOR2)
+		MSG_ReadFloat ();
+	if (bits & U_RENDERCOLOR3)
+		MSG_ReadFloat ();
+	if (bits & U_SCALE)
+		MSG_ReadByte ();
+}
+
+/*
+===============
+LoadGen_SkipClientdata
+
+Reads past an svc_clientdata the way CL_ParseClientdata reads one
+===============
+*/
+static void LoadGen_SkipClientdata (int bits)
+{
+	int		i;
+
+	if (bits & SU_VIEWHEIGHT)
+		MSG_ReadChar ();
+	if (bits & SU_IDEALPITCH)
+		MSG_ReadChar ();
+	if (bits & SU_PERKS)
+		MSG_ReadLong ();
+
+	for (i=0 ; i<3 ; i++)
+	{
+		if (bits & (SU_PUNCH1<<i))
+			MSG_ReadChar ();
+		if (bits & (SU_VELOCITY1<<i))
+			MSG_ReadChar ();
+	}
+
+	if (bits & SU_WEAPONFRAME)
+		MSG_ReadByte ();
+	if (bits & SU_WEAPONSKIN)
+		MSG_ReadByte ();
+	MSG_ReadShort ();		// weapon
+	if (bits & SU_GRENADES)
+		MSG_ReadLong ();
+
+	for (i=0 ; i<4 ; i++)	// primary and secondary grenades, health, ammo
+		MSG_ReadShort ();
+	for (i=0 ; i<8 ; i++)	// mag, zoom, active weapon, rounds, round change, x2, insta, progress bar
+		MSG_ReadByte ();
+
+	MSG_ReadShort ();		// second weapon, then its skin, frame and mag
+	MSG_ReadByte ();
+	MSG_ReadByte ();
+	MSG_ReadByte ();
+}
+
+/*
+===============
+LoadGen_SkipTEnt
+
+Reads past an svc_temp_entity the way CL_ParseTEnt reads one
+===============
+*/
+static qboolean LoadGen_SkipTEnt (void)
+{
+	int		i, count;
+
+	switch (MSG_ReadByte ())
+	{
+	case TE_LIGHTNING1:
+	case TE_LIGHTNING2:
+	case TE_LIGHTNING3:
+	case TE_BEAM:
+		MSG_ReadShort ();	// entity, then start and end
+		count = 6;
+		break;
+
+	case TE_EXPLOSION2:
+		for (i=0 ; i<3 ; i++)
+			MSG_ReadCoord ();
+		MSG_ReadByte ();	// color start and length
+		MSG_ReadByte ();
+		return true;
+
+	case TE_SPIKE:
+	case TE_SUPERSPIKE:
+	case TE_GUNSHOT:
+	case TE_EXPLOSION:
+	case TE_TAREXPLOSION:
+	case TE_WIZSPIKE:
+	case TE_KNIGHTSPIKE:
+	case TE_LAVASPLASH:
+	case TE_TELEPORT:
+	case TE_RAYSPLASHGREEN:
+	case TE_RAYSPLASHRED:
+		count = 3;
+		break;
+
+	default:
+		return false;
+	}
+
+	for (i=0 ; i<count ; i++)
+		MSG_ReadCoord ();
+	return true;
+}
+
+/*
+===============
+LoadGen_ParseReliable
+
+Walks a reliable message one command at a time, reading past everything
+the same way CL_ParseServerMessage does, and acts only on the signon
+stages and the reconnect a level change sends.  Returns false if the
+message can't be read, which would be a Host_Error for a real client.
+===============
+*/
+static qboolean LoadGen_ParseReliable (loadbot_t *bot, int num)
+{
+	int		cmd, i;
+	char	*str;
+
+	MSG_BeginReading ();
+
+	while (1)
+	{
+		if (msg_badread)
+		{
+			Con_Printf ("loadgen: bot %i got a bad server message\n", num);
+			return false;
+		}
+
+		cmd = MSG_ReadByte ();
+		if (cmd == -1)
+			return true;
+
+		if (cmd & 128)
+		{
+			LoadGen_SkipUpdate (cmd & 127);
+			continue;
+		}
+
+		switch (cmd)
+		{
+		default:
+			Con_Printf ("loadgen: bot %i got an illegible server message (%i)\n", num, cmd);
+			return false;
+
+		case svc_nop:
+		case svc_disconnect:
+		case svc_maxammo:
+		case svc_pulse:
+		case svc_bettyprompt:
+		case svc_intermission:
+		case svc_sellscreen:
+		case svc_hitmark:
+			break;
+
+		case svc_time:
+			MSG_ReadFloat ();
+			break;
+
+		case svc_clientdata:
+			LoadGen_SkipClientdata (MSG_ReadShort ());
+			break;
+
+		case svc_version:
+		case svc_moveack:
+			MSG_ReadLong ();
+			break;
+
+		case svc_print:
+		case svc_centerprint:
+		case svc_playername:
+		case svc_finale:
+		case svc_cutscene:
+		case svc_skybox:
+			MSG_ReadString ();
+			break;
+
+		case svc_stufftext:
+			str = MSG_ReadString ();
+			if (!strcmp (str, "reconnect\n"))
+			{
+				// a level change, the signon starts over
+				bot->signon = 0;
+				bot->movesent = 0;
+			}
+			break;
+
+		case svc_useprint:
+			MSG_ReadByte ();
+			MSG_ReadShort ();
+			MSG_ReadByte ();
+			break;
+
+		case svc_doubletap:
+		case svc_lockviewmodel:
+		case svc_setpause:
+		case svc_achievement:
+			MSG_ReadByte ();
+			break;
+
+		case svc_rumble:
+			MSG_ReadShort ();
+			MSG_ReadShort ();
+			MSG_ReadShort ();
+			break;
+
+		case svc_compressed:
+			if (!LZ_ExpandMessage ())
+			{
+				Con_Printf ("loadgen: bot %i got a corrupt svc_compressed\n", num);
+				return false;
+			}
+			break;
+
+		case svc_screenflash:
+			MSG_ReadByte ();
+			MSG_ReadByte ();
+			MSG_ReadByte ();
+			break;
+
+		case svc_serverinfo:
+			MSG_ReadLong ();		// protocol
+			MSG_ReadByte ();		// maxclients
+			MSG_ReadByte ();		// gametype
+			MSG_ReadString ();		// level name
+			while (!msg_badread && *MSG_ReadString ())
+				;					// model precaches
+			while (!msg_badread && *MSG_ReadString ())
+				;					// sound precaches
+			break;
+
+		case svc_setangle:
+			for (i=0 ; i<3 ; i++)
+				MSG_ReadAngle ();
+			break;
+
+		case svc_setview:
+		case svc_stopsound:
+			MSG_ReadShort ();
+			break;
+
+		case svc_lightstyle:
+		case svc_updatename:
+			MSG_ReadByte ();
+			MSG_ReadString ();
+			break;
+
+		case svc_sound:
+			i = MSG_ReadByte ();
+			if (i & SND_VOLUME)
+				MSG_ReadByte ();
+			if (i & SND_ATTENUATION)
+				MSG_ReadByte ();
+			MSG_ReadShort ();		// entity and channel
+			MSG_ReadByte ();		// sound
+			for (i=0 ; i<3 ; i++)
+				MSG_ReadCoord ();
+			break;
+
+		case svc_updatepoints:
+			MSG_ReadByte ();
+			MSG_ReadLong ();
+			break;
+
+		case svc_updatekills:
+			MSG_ReadByte ();
+			MSG_ReadShort ();
+			break;
+
+		case svc_particle:
+			for (i=0 ; i<3 ; i++)
+				MSG_ReadCoord ();
+			for (i=0 ; i<3 ; i++)
+				MSG_ReadChar ();
+			MSG_ReadByte ();		// count
+			MSG_ReadByte ();		// color
+			break;
+
+		case svc_spawnbaseline:
+			MSG_ReadShort ();		// entity, then as svc_spawnstatic
+			// fall through
+		case svc_spawnstatic:
+			MSG_ReadShort ();		// model
+			MSG_ReadByte ();		// frame
+			MSG_ReadByte ();		// colormap
+			MSG_ReadByte ();		// skin
+			for (i=0 ; i<3 ; i++)
+			{
+				MSG_ReadCoord ();
+				MSG_ReadAngle ();
+			}
+			break;
+
+		case svc_temp_entity:
+			if (!LoadGen_SkipTEnt ())
+			{
+				Con_Printf ("loadgen: bot %i got a bad temp entity\n", num);
+				return false;
+			}
+			break;
+
+		case svc_signonnum:
+			i = MSG_ReadByte ();
+			if (i == bot->signon + 1 && i < SIGNONS)
+			{
+				bot->signon = i;
+				LoadGen_SignonReply (bot, num);
+			}
+			break;
+
+		case svc_updatestat:
+			MSG_ReadByte ();
+			MSG_ReadLong ();
+			break;
+
+		case svc_spawnstaticsound:
+			for (i=0 ; i<3 ; i++)
+				MSG_ReadCoord ();
+			MSG_ReadByte ();		// sound
+			MSG_ReadByte ();		// volume
+			MSG_ReadByte ();		// attenuation
+			break;
+
+		case svc_cdtrack:
+			MSG_ReadByte ();
+			MSG_ReadByte ();
+			break;
+
+		case svc_fog:
+			for (i=0 ; i<5 ; i++)	// start, end, red, green, blue
+				MSG_ReadByte ();
+			MSG_ReadShort ();		// time
+			break;
+
+		case svc_weaponfire:
+			MSG_ReadLong ();
+			for (i=0 ; i<3 ; i++)
+				MSG_ReadCoord ();
+			break;
+
+		case svc_limbupdate:
+			MSG_ReadByte ();
+			MSG_ReadShort ();
+			MSG_ReadShort ();
+			break;
+
+		case svc_bspdecal:
+			MSG_ReadString ();
+			MSG_ReadByte ();
+			for (i=0 ; i<3 ; i++)
+				MSG_ReadCoord ();
+			break;
+		}
+	}
+}
+
+/*
+===============
+LoadGen_Latency
+===============
+*/
+static void LoadGen_Latency (loadbot_t *bot, double delta)
+{
+	bot->latency_total += delta;
+	if (delta > bot->latency_max)
+		bot->latency_max = delta;
+	bot->latency_count++;
+}
+
+/*
+===============
+LoadGen_MoveAck
+
+Times a move from when it was sent to the first datagram that says the
+server ran it; later datagrams repeat the sequence until the next move
+arrives
+===============
+*/
+static void LoadGen_MoveAck (loadbot_t *bot, int sequence, double now)
+{
+	if (sequence <= bot->moveacked || sequence > bot->movesequence)
+		return;
+
+	if (bot->movesequence - sequence < LOADGEN_MOVES)
+		LoadGen_Latency (bot, now - bot->movetimes[sequence & (LOADGEN_MOVES-1)]);
+	bot->moveacked = sequence;
+}
+
+/*
+===============
+LoadGen_ReadPackets
+===============
+*/
+static void LoadGen_ReadPackets (loadbot_t *bot, int num)
+{
+	double	now, delta;
+	float	servertime;
+	int		ret;
+
+	while (bot->netcon)
+	{
+		ret = NET_GetMessage (bot->netcon);
+		if (ret == 0)
+			break;
+		if (ret == -1)
+		{
+			Con_Printf ("loadgen: bot %i lost server connection\n", num);
+			LoadGen_Drop (bot);
+			break;
+		}
+
+		bot->packets_in++;
+		bot->bytes_in += net_message.cursize;
+		if (net_message.cursize > bot->maxpacket)
+			bot->maxpacket = net_message.cursize;
+
+		if (ret == 1)
+		{
+			// reliable message, may carry a signon stage or a level change
+			bot->reliable_in++;
+
+			if (!LoadGen_ParseReliable (bot, num))
+			{
+				LoadGen_Drop (bot);
+				break;
+			}
+			continue;
+		}
+
+		// unreliable datagrams always open with svc_time
+		MSG_BeginReading ();
+		if (MSG_ReadByte () != svc_time)
+			continue;
+		servertime = MSG_ReadFloat ();
+		now = Sys_FloatTime ();
+
+		if (bot->moveseq)
+		{
+			// svc_moveack follows, with the last move the server ran
+			if (MSG_ReadByte () == svc_moveack)
+				LoadGen_MoveAck (bot, MSG_ReadLong (), now);
+		}
+		else if (bot->movesent)
+		{
+			// without sequences, only the wait for the next update
+			LoadGen_Latency (bot, now - bot->movesent);
+			bot->movesent = 0;
+		}
+
+		if (bot->lastarrival && servertime > bot->servertime)
+		{
+			delta = servertime - bot->servertime;
+			bot->step_total += delta;
+			if (delta > bot->step_max)
+				bot->step_max = delta;
+
+			delta = now - bot->lastarrival;
+			bot->arrival_total += delta;
+			if (delta > bot->arrival_max)
+				bot->arrival_max = delta;
+
+			bot->step_count++;
+		}
+		bot->servertime = servertime;
+		bot->lastarrival = now;
+	}
+}
+
+/*
+===============
+LoadGen_BuildMove
+
+Fills in the scripted intentions for this bot at time t
+===============
+*/
+static void LoadGen_BuildMove (loadbot_t *bot, int num, double t, vec3_t angles, usercmd_t *cmd, int *bits)
+{
+	int		leg;
+	float	phase;
+
+	memset (cmd, 0, sizeof(*cmd));
+	VectorClear (angles);
+	*bits = 0;
+
+	// offset each bot so they do not move in lockstep
+	t += num * 0.37;
+
+	switch (bot->pattern)
+	{
+	case PATTERN_ROUTE:
+		// four fixed headings, two seconds each, so a square from the
+		// spawn point until a wall gets in the way
+		leg = (int)(t / 2.0);
+		phase = t - leg * 2.0;
+		angles[YAW] = anglemod (num * 45 + (leg & 3) * 90);
+		cmd->forwardmove = LOADGEN_SPEED;
+		if (phase > 1.75)
+			*bits |= 1;			// fire on arrival
+		break;
+
+	case PATTERN_STRAFE:
+		angles[YAW] = anglemod (num * 45 + t * 30);
+		cmd->sidemove = ((int)(t * 2) & 1) ? LOADGEN_SPEED : -LOADGEN_SPEED;
+		*bits |= 1;
+		break;
+
+	case PATTERN_SHOOT:
+		angles[YAW] = anglemod (num * 45 + t * 45);
+		angles[PITCH] = 10 * sin (t);
+		*bits |= 1 | 256;		// fire down the sights
+		if (((int)t % 5) == 4)
+			*bits = 32;			// reload
+		break;
+	}
+}
+
+/*
+===============
+LoadGen_SendMove
+
+Same wire format as CL_SendMove
+===============
+*/
+static void LoadGen_SendMove (loadbot_t *bot, int num)
+{
+	sizebuf_t	buf;
+	byte		data[128];
+	usercmd_t	cmd;
+	vec3_t		angles;
+	int			i, bits;
+
+	buf.maxsize = sizeof(data);
+	buf.cursize = 0;
+	buf.data = data;
+
+	LoadGen_BuildMove (bot, num, realtime - bot->connecttime, angles, &cmd, &bits);
+
+	MSG_WriteByte (&buf, clc_move);
+	MSG_WriteFloat (&buf, bot->servertime);	// so server can get ping times
+	for (i=0 ; i<3 ; i++)
+		MSG_WriteFloat (&buf, angles[i]);
+	MSG_WriteShort (&buf, cmd.forwardmove);
+	MSG_WriteShort (&buf, cmd.sidemove);
+	MSG_WriteShort (&buf, cmd.upmove);
+	MSG_WriteLong (&buf, bits);
+	MSG_WriteByte (&buf, 0);
+	if (bot->moveseq)
+		MSG_WriteLong (&buf, ++bot->movesequence);
+
+	if (NET_SendUnreliableMessage (bot->netcon, &buf) == -1)
+	{
+		Con_Printf ("loadgen: bot %i lost server connection\n", num);
+		LoadGen_Drop (bot);
+		return;
+	}
+
+	bot->packets_out++;
+	bot->bytes_out += buf.cursize;
+	if (bot->moveseq)
+		bot->movetimes[bot->movesequence & (LOADGEN_MOVES-1)] = Sys_FloatTime ();
+	else if (!bot->movesent)
+		bot->movesent = Sys_FloatTime ();
+}
+
+/*
+===============
+LoadGen_SendCmds
+===============
+*/
+static void LoadGen_SendCmds (loadbot_t *bot, int num)
+{
+	if (bot->signon == SIGNONS - 1 && realtime >= bot->nextmove)
+	{
+		LoadGen_SendMove (bot, num);
+		bot->nextmove = realtime + 1.0 / bound(1, loadgen_rate.value, 250);
+	}
+
+	if (!bot->netcon || !bot->message.cursize)
+		return;
+
+	if (!NET_CanSendMessage (bot->netcon))
+		return;
+
+	if (NET_SendMessage (bot->netcon, &bot->message) == -1)
+	{
+		Con_Printf ("loadgen: bot %i lost server connection\n", num);
+		LoadGen_Drop (bot);
+		return;
+	}
+
+	bot->packets_out++;
+	bot->bytes_out += bot->message.cursize;
+	SZ_Clear (&bot->message);
+}
+
+static void LoadGen_Report (qboolean perbot);
+
+/*
+===============
+LoadGen_Frame
+===============
+*/
+void LoadGen_Frame (void)
+{
+	loadbot_t	*bot;
+	int			i;
+
+	for (i=0, bot=loadbots ; i<loadgen_wanted ; i++, bot++)
+	{
+		if (!bot->netcon && !bot->connecttime)
+		{
+			LoadGen_Connect (i);
+			break;
+		}
+	}
+
+	for (i=0, bot=loadbots ; i<MAX_LOADBOTS ; i++, bot++)
+	{
+		if (!bot->netcon)
+			continue;
+		LoadGen_ReadPackets (bot, i);
+		if (bot->netcon)
+			LoadGen_SendCmds (bot, i);
+	}
+
+	if (loadgen_interval.value > 0 && loadgen_wanted && realtime >= loadgen_nextreport)
+	{
+		if (loadgen_nextreport)
+			LoadGen_Report (false);
+		loadgen_nextreport = realtime + loadgen_interval.value;
+	}
+}
+
+/*
+===============
+LoadGen_Report
+
+Prints total, and optionally per bot, statistics since the bots connected
+===============
+*/
+static void LoadGen_Report (qboolean perbot)
+{
+	loadbot_t	*bot;
+	int			i, count, spawned;
+	int			packets_in, bytes_in, packets_out, bytes_out, maxpacket;
+	int			latency_count, step_count;
+	double		latency_total, latency_max, step_total, step_max, arrival_total, arrival_max;
+	qboolean	ping;
+
+	ping = true;
+	count = spawned = 0;
+	packets_in = bytes_in = packets_out = bytes_out = maxpacket = 0;
+	latency_count = step_count = 0;
+	latency_total = latency_max = step_total = step_max = arrival_total = arrival_max = 0;
+
+	for (i=0, bot=loadbots ; i<MAX_LOADBOTS ; i++, bot++)
+	{
+		if (!bot->connecttime)
+			continue;
+		count++;
+		if (bot->netcon && bot->signon == SIGNONS - 1)
+			spawned++;
+
+		if (perbot)
+			Con_Printf ("bot%02i %s %s %5.1f/%5.1f ms step %5.1f/%5.1f ms in %6i pkts %8i b out %6i pkts %8i b\n",
+				i, bot->netcon ? "up  " : "down", bot->moveseq ? "ping  " : "update",
+				bot->latency_count ? bot->latency_total * 1000 / bot->latency_count : 0, bot->latency_max * 1000,
+				bot->step_count ? bot->step_total * 1000 / bot->step_count : 0, bot->step_max * 1000,
+				bot->packets_in, bot->bytes_in, bot->packets_out, bot->bytes_out);
+
+		packets_in += bot->packets_in;
+		bytes_in += bot->bytes_in;
+		packets_out += bot->packets_out;
+		bytes_out += bot->bytes_out;
+		if (bot->maxpacket > maxpacket)
+			maxpacket = bot->maxpacket;
+
+		if (!bot->moveseq)
+			ping = false;
+		latency_count += bot->latency_count;
+		latency_total += bot->latency_total;
+		if (bot->latency_max > latency_max)
+			latency_max = bot->latency_max;
+
+		step_count += bot->step_count;
+		step_total += bot->step_total;
+		arrival_total += bot->arrival_total;
+		if (bot->step_max > step_max)
+			step_max = bot->step_max;
+		if (bot->arrival_max > arrival_max)
+			arrival_max = bot->arrival_max;
+	}
+
+	if (!count)
+	{
+		Con_Printf ("loadgen: no bots\n");
+		return;
+	}
+
+	// a server without move sequences only gives the time to its next update
+	Con_Printf ("loadgen: %i/%i bots spawned, %s avg %.1f max %.1f ms\n", spawned, count,
+		ping ? "ping" : "time to next update",
+		latency_count ? latency_total * 1000 / latency_count : 0, latency_max * 1000);
+	Con_Printf ("loadgen: server step avg %.1f max %.1f ms, arrival avg %.1f max %.1f ms\n",
+		step_count ? step_total * 1000 / step_count : 0, step_max * 1000,
+		step_count ? arrival_total * 1000 / step_count : 0, arrival_max * 1000);
+	Con_Printf ("loadgen: in %i pkts %i bytes (%i avg, %i max), out %i pkts %i bytes\n",
+		packets_in, bytes_in, packets_in ? bytes_in / packets_in : 0, maxpacket,
+		packets_out, bytes_out);
+}
+
+/*
+===============
+LoadGen_Report_f
+
+loadgen_report [all]
+===============
+*/
+static void LoadGen_Report_f (void)
+{
+	LoadGen_Report (Cmd_Argc () > 1 && !strcmp (Cmd_Argv (1), "all"));
+}
+
+/*
+===============
+LoadGen_Stop_f
+===============
+*/
+static void LoadGen_Stop_f (void)
+{
+	int		i;
+
+	if (!loadgen_wanted)
+		return;
+
+	LoadGen_Report (true);
+
+	for (i=0 ; i<MAX_LOADBOTS ; i++)
+		LoadGen_Drop (&loadbots[i]);
+	memset (loadbots, 0, sizeof(loadbots));
+	loadgen_wanted = 0;
+	loadgen_nextreport = 0;
+}
+
+/*
+===============
+LoadGen_f
+
+loadgen <address> <count>
+===============
+*/
+static void LoadGen_f (void)
+{
+	char	address[64];
+	int		i, count;
+
+	if (Cmd_Argc () < 3)
+	{
+		Con_Printf ("usage: loadgen <address> <count>\n");
+		return;
+	}
+
+	// the tokenizer splits host:port, glue the pieces back together
+	address[0] = 0;
+	for (i=1 ; i<Cmd_Argc () - 1 ; i++)
+		strncat (address, Cmd_Argv (i), sizeof(address) - strlen(address) - 1);
+
+	count = Q_atoi (Cmd_Argv (Cmd_Argc () - 1));
+	if (count < 1 || count > MAX_LOADBOTS)
+	{
+		Con_Printf ("loadgen: count must be between 1 and %i\n", MAX_LOADBOTS);
+		return;
+	}
+	if (!Q_strcasecmp (address, "local") && count > 1)
+	{
+		Con_Printf ("loadgen: loopback only carries one client\n");
+		count = 1;
+	}
+
+	LoadGen_Stop_f ();
+
+	Q_strcpy (loadgen_address, address);
+	loadgen_wanted = count;
+	Con_Printf ("loadgen: connecting %i bots to %s\n", count, loadgen_address);
+}
+
+/*
+===============
+LoadGen_Init
+===============
+*/
+void LoadGen_Init (void)
+{
+	Cmd_AddCommand ("loadgen", LoadGen_f);
+	Cmd_AddCommand ("loadgen_stop", LoadGen_Stop_f);
+	Cmd_AddCommand ("loadgen_report", LoadGen_Report_f);
+
+	Cvar_RegisterVariable (&loadgen_rate);
+	Cvar_RegisterVariable (&loadgen_pattern);
+	Cvar_RegisterVariable (&loadgen_interval);
+}
+
+/*
+===============
+LoadGen_Shutdown
+===============
+*/
+void LoadGen_Shutdown (void)
+{
+	int		i;
+
+	for (i=0 ; i<MAX_LOADBOTS ; i++)
+		LoadGen_Drop (&loadbots[i]);
+}
@@ -21,6 +21,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 #include "cl_slist.h"
+#include "cl_pred.h"
+#include "prof.h"
 
 // we need to declare some mouse variables here, because the menu system
 // references them even when on a unix system.
@@ -100,6 +102,7 @@ void CL_ClearState (void)
 		Host_ClearMemory ();
 
 	CL_ClearTEnts ();
+	CL_ClearPrediction ();
 // wipe the entire cl structure
 	memset (&cl, 0, sizeof(cl));
 
@@ -608,6 +611,9 @@ void CL_RelinkEntities (void)
 	dlight_t	*dl;
     //vec3_t		smokeorg, smokeorg2;
 	//float		scale;
+
+	PROF_BEGIN (CL_RelinkEntities);
+
 // determine partial update time
 	frac = CL_LerpPoint ();
 
@@ -973,6 +979,8 @@ void CL_RelinkEntities (void)
 			cl_numvisedicts++;
 		}
 	}
+
+	PROF_END (CL_RelinkEntities);
 }
 
 /*
@@ -1016,6 +1024,7 @@ int CL_ReadFromServer (void)
 		Con_Printf ("\n");
 
 	CL_RelinkEntities ();
+	CL_PredictMove ();
 	CL_UpdateTEnts ();
 
 //
@@ -1086,6 +1095,7 @@ void CL_Init (void)
 
 	CL_InitInput ();
 	CL_InitTEnts ();
+	CL_InitPrediction ();
 //
 // register our commands
 //
@@ -1138,5 +1148,8 @@ void CL_Init (void)
 	Cmd_AddCommand ("stop", CL_Stop_f);
 	Cmd_AddCommand ("playdemo", CL_PlayDemo_f);
 	Cmd_AddCommand ("timedemo", CL_TimeDemo_f);
+	Cmd_AddCommand ("timedemo_compare", CL_TimeDemoCompare_f);
+	Cvar_RegisterVariable (&timedemo_warmup);
+	Cvar_RegisterVariable (&timedemo_output);
 }
 
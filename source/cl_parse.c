@@ -20,6 +20,11 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // cl_parse.c  -- parse a message received from the server
 
 #include "quakedef.h"
+#include "cl_pred.h"
+#include "lz.h"
+#include "prefetch.h"
+#include "loadtrace.h"
+#include "prof.h"
 
 extern double hud_maxammo_starttime;
 extern double hud_maxammo_endtime;
@@ -279,6 +284,7 @@ void CL_ParseServerInfo (void)
 	int		nummodels, numsounds;
 	char	model_precache[MAX_MODELS][MAX_QPATH];
 	char	sound_precache[MAX_SOUNDS][MAX_QPATH];
+	double	start;
 
 	//void R_PreMapLoad (char *);
 
@@ -398,15 +404,30 @@ void CL_ParseServerInfo (void)
    loading_num_step = loading_num_step +nummodels + numsounds;
    loading_step = 1;
 
+	// everything that will be read goes to the prefetch thread up front, in
+	// the order the loops below ask for it
+	Prefetch_Begin ();
+	for (i=1 ; i<nummodels ; i++)
+		if (!Mod_IsLoaded (model_precache[i]))
+			Prefetch_Add (model_precache[i]);
+	for (i=1 ; i<numsounds ; i++)
+		if (!S_IsLoaded (sound_precache[i]))
+			Prefetch_Add (sound_precache[i]);
+
 	//Con_Printf("Loaded Model: ");
 
 	for (i=1 ; i<nummodels ; i++)
 	{
+		start = Sys_FloatTime ();
+		LoadTrace_Begin ("Mod_ForName", model_precache[i]);
 		cl.model_precache[i] = Mod_ForName (model_precache[i], false);
+		LoadTrace_End ();
+		Prefetch_Loaded (model_precache[i], Sys_FloatTime () - start);
 		if (cl.model_precache[i] == NULL)
 		{
 			Con_Printf("Model %s not found\n", model_precache[i]);
 			loading_cur_step++;
+			Prefetch_End ();
 			return;
 		}
 		CL_KeepaliveMessage ();
@@ -430,7 +451,9 @@ void CL_ParseServerInfo (void)
 	//Con_Printf("Loaded Sounds: ");
 	for (i=1 ; i<numsounds ; i++)
 	{
+		start = Sys_FloatTime ();
 		cl.sound_precache[i] = S_PrecacheSound (sound_precache[i]);
+		Prefetch_Loaded (sound_precache[i], Sys_FloatTime () - start);
 		CL_KeepaliveMessage ();
 		loading_cur_step++;
 		//Con_Printf("%i,",i);
@@ -438,6 +461,7 @@ void CL_ParseServerInfo (void)
 		SCR_UpdateScreen ();
 	}
 	S_EndPrecaching ();
+	Prefetch_End ();
 
 	//Con_Printf("...\n");
 	//Con_Printf("Total Sounds Loaded: %i\n",numsounds);
@@ -448,7 +472,9 @@ void CL_ParseServerInfo (void)
 // local state
 	cl_entities[0].model = cl.worldmodel = cl.model_precache[1];
 
+	LoadTrace_Begin ("R_NewMap", NULL);
 	R_NewMap ();
+	LoadTrace_End ();
 
 	Hunk_Check ();		// make sure nothing is hurt
 	HUD_NewMap ();
@@ -1129,6 +1155,8 @@ void CL_ParseServerMessage (void)
 //
 // parse the message
 //
+	PROF_BEGIN (CL_ParseServerMessage);
+
 	MSG_BeginReading ();
 
 	while (1)
@@ -1141,6 +1169,7 @@ void CL_ParseServerMessage (void)
 		if (cmd == -1)
 		{
 			SHOWNET("END OF MESSAGE");
+			PROF_END (CL_ParseServerMessage);
 			return;		// end of message
 		}
 
@@ -1223,6 +1252,15 @@ void CL_ParseServerMessage (void)
 #endif
 			break;
 
+		case svc_moveack:
+			CL_AckMove (MSG_ReadLong ());
+			break;
+
+		case svc_compressed:
+			if (!LZ_ExpandMessage ())
+				Host_Error ("CL_ParseServerMessage: bad svc_compressed");
+			break;
+
 		case svc_screenflash:
 			screenflash_color = MSG_ReadByte();
 			screenflash_duration = sv.time + MSG_ReadByte();
@@ -1244,7 +1282,9 @@ void CL_ParseServerMessage (void)
 			Cbuf_AddText (MSG_ReadString ());
 			break;
 		case svc_serverinfo:
+			LoadTrace_Begin ("CL_ParseServerInfo", NULL);
 			CL_ParseServerInfo ();
+			LoadTrace_End ();
 			vid.recalc_refdef = true;	// leave intermission full screen
 			break;
 
@@ -0,0 +1,609 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// cl_pred.c -- local player movement prediction for remote servers
+//
+// When both ends set NETCAP_MOVESEQ on connecting, every clc_move carries a
+// sequence number and the server answers each datagram with the last one it
+// has run (svc_moveack); without it nothing is predicted.  The authoritative
+// origin in that datagram is the result of that move, so the client replays
+// every move it sent after it through a copy of the server walking code to
+// find where the player is now.  When the server disagrees with what was
+// predicted for an acknowledged move the difference is faded out instead of
+// snapping the view.
+//
+// Only walking and air movement against the world are predicted; water,
+// doors, other players and jump velocity are left to the server and show
+// up as corrections.
+
+#include "quakedef.h"
+#include "cl_pred.h"
+
+#define	PRED_BACKUP		64		// moves kept for replay, must be a power of two
+#define	PRED_MASK		(PRED_BACKUP - 1)
+
+#define	PRED_SNAPDIST	80		// errors larger than this are teleports
+
+#define	STOP_EPSILON	0.1
+#define	STEPSIZE		18
+#define	MAX_CLIP_PLANES	5
+
+cvar_t	cl_predict = {"cl_predict", "1", true};
+cvar_t	cl_predict_smooth = {"cl_predict_smooth", "0.1", true};
+
+extern	cvar_t	sv_friction;
+extern	cvar_t	sv_edgefriction;
+extern	cvar_t	sv_stopspeed;
+extern	cvar_t	sv_accelerate;
+extern	cvar_t	sv_maxspeed;
+extern	cvar_t	sv_gravity;
+extern	cvar_t	sv_nostep;
+
+int ClipVelocity (vec3_t in, vec3_t normal, vec3_t out, float overbounce);
+
+typedef struct
+{
+	int			sequence;
+	float		frametime;
+	vec3_t		angles;
+	float		forwardmove;
+	float		sidemove;
+	qboolean	predicted;
+	vec3_t		origin;			// where this move left the player, last replay
+} predmove_t;
+
+typedef struct
+{
+	vec3_t		origin;
+	vec3_t		velocity;
+	qboolean	onground;
+} pmove_t;
+
+static	predmove_t	pred_moves[PRED_BACKUP];
+static	int			pred_outgoing;		// next sequence to hand out
+static	int			pred_acked;			// last sequence the server has run
+static	int			pred_lastacked;		// pred_acked when the error was last updated
+
+static	vec3_t		pred_error;			// server minus prediction, faded out
+static	double		pred_errortime;
+
+static	vec3_t		player_mins = {-16, -16, -24};
+
+/*
+================
+CL_InitPrediction
+================
+*/
+void CL_InitPrediction (void)
+{
+	Cvar_RegisterVariable (&cl_predict);
+	Cvar_RegisterVariable (&cl_predict_smooth);
+}
+
+/*
+================
+CL_ClearPrediction
+================
+*/
+void CL_ClearPrediction (void)
+{
+	memset (pred_moves, 0, sizeof(pred_moves));
+	pred_outgoing = 1;
+	pred_acked = 0;
+	pred_lastacked = 0;
+	VectorClear (pred_error);
+	pred_errortime = 0;
+}
+
+/*
+================
+CL_StoreMove
+================
+*/
+int CL_StoreMove (usercmd_t *cmd, vec3_t angles)
+{
+	predmove_t	*move;
+
+	move = &pred_moves[pred_outgoing & PRED_MASK];
+	move->sequence = pred_outgoing;
+	move->frametime = host_frametime;
+	VectorCopy (angles, move->angles);
+	move->forwardmove = cmd->forwardmove;
+	move->sidemove = cmd->sidemove;
+	move->predicted = false;
+
+	return pred_outgoing++;
+}
+
+/*
+================
+CL_AckMove
+================
+*/
+void CL_AckMove (int sequence)
+{
+	// datagrams can arrive out of order
+	if (sequence > pred_acked && sequence < pred_outgoing)
+		pred_acked = sequence;
+}
+
+/*
+===============================================================================
+
+PLAYER MOVEMENT
+
+A copy of SV_ClientThink / SV_WalkMove that only clips against the world
+
+===============================================================================
+*/
+
+/*
+==================
+PM_Trace
+==================
+*/
+static trace_t PM_Trace (vec3_t start, vec3_t end, int hullnum)
+{
+	trace_t		trace;
+	hull_t		*hull;
+	vec3_t		offset, start_l, end_l;
+
+	memset (&trace, 0, sizeof(trace));
+	trace.fraction = 1;
+	trace.allsolid = true;
+	VectorCopy (end, trace.endpos);
+
+	hull = &cl.worldmodel->hulls[hullnum];
+	if (hullnum)
+	{
+		VectorSubtract (hull->clip_mins, player_mins, offset);
+	}
+	else
+	{
+		VectorClear (offset);
+	}
+
+	VectorSubtract (start, offset, start_l);
+	VectorSubtract (end, offset, end_l);
+
+	SV_RecursiveHullCheck (hull, hull->firstclipnode, start_l, end_l, &trace);
+
+	if (trace.fraction != 1)
+		VectorLerp (start, trace.fraction, end, trace.endpos);
+
+	return trace;
+}
+
+/*
+==================
+PM_NudgePosition
+
+Origins arrive rounded to 1/8 unit, which can leave them just inside a wall
+==================
+*/
+static qboolean PM_NudgePosition (pmove_t *pm)
+{
+	static float	sign[3] = {0, -1, 1};
+	vec3_t			base, test;
+	trace_t			trace;
+	int				x, y, z;
+
+	VectorCopy (pm->origin, base);
+
+	for (z=0 ; z<3 ; z++)
+		for (x=0 ; x<3 ; x++)
+			for (y=0 ; y<3 ; y++)
+			{
+				test[0] = base[0] + sign[x] * 0.125;
+				test[1] = base[1] + sign[y] * 0.125;
+				test[2] = base[2] + sign[z] * 0.125;
+				trace = PM_Trace (test, test, 1);
+				if (!trace.allsolid)
+				{
+					VectorCopy (test, pm->origin);
+					return true;
+				}
+			}
+
+	return false;
+}
+
+/*
+==================
+PM_Friction
+==================
+*/
+static void PM_Friction (pmove_t *pm, float frametime)
+{
+	float	speed, newspeed, control, friction;
+	vec3_t	start, stop;
+	trace_t	trace;
+
+	speed = sqrtf(pm->velocity[0]*pm->velocity[0] + pm->velocity[1]*pm->velocity[1]);
+	if (!speed)
+		return;
+
+// if the leading edge is over a dropoff, increase friction
+	start[0] = stop[0] = pm->origin[0] + pm->velocity[0]/speed*16;
+	start[1] = stop[1] = pm->origin[1] + pm->velocity[1]/speed*16;
+	start[2] = pm->origin[2] + player_mins[2];
+	stop[2] = start[2] - 34;
+
+	trace = PM_Trace (start, stop, 0);
+
+	if (trace.fraction == 1.0)
+		friction = sv_friction.value*sv_edgefriction.value;
+	else
+		friction = sv_friction.value;
+
+	control = speed < sv_stopspeed.value ? sv_stopspeed.value : speed;
+	newspeed = speed - frametime*control*friction;
+
+	if (newspeed < 0)
+		newspeed = 0;
+	newspeed /= speed;
+
+	VectorScale (pm->velocity, newspeed, pm->velocity);
+}
+
+/*
+==================
+PM_Accelerate
+==================
+*/
+static void PM_Accelerate (pmove_t *pm, vec3_t wishdir, float wishspeed, float frametime)
+{
+	int		i;
+	float	addspeed, accelspeed, currentspeed;
+
+	currentspeed = DotProduct (pm->velocity, wishdir);
+	addspeed = wishspeed - currentspeed;
+	if (addspeed <= 0)
+		return;
+	accelspeed = sv_accelerate.value*frametime*wishspeed;
+	if (accelspeed > addspeed)
+		accelspeed = addspeed;
+
+	for (i=0 ; i<3 ; i++)
+		pm->velocity[i] += accelspeed*wishdir[i];
+}
+
+/*
+==================
+PM_AirAccelerate
+==================
+*/
+static void PM_AirAccelerate (pmove_t *pm, vec3_t wishveloc, float wishspeed, float frametime)
+{
+	int		i;
+	float	addspeed, wishspd, accelspeed, currentspeed;
+
+	wishspd = VectorNormalize (wishveloc);
+	if (wishspd > 30)
+		wishspd = 30;
+	currentspeed = DotProduct (pm->velocity, wishveloc);
+	addspeed = wishspd - currentspeed;
+	if (addspeed <= 0)
+		return;
+	accelspeed = sv_accelerate.value*wishspeed*frametime;
+	if (accelspeed > addspeed)
+		accelspeed = addspeed;
+
+	for (i=0 ; i<3 ; i++)
+		pm->velocity[i] += accelspeed*wishveloc[i];
+}
+
+/*
+==================
+PM_FlyMove
+
+SV_FlyMove against the world hull, returns the same blocked flags
+==================
+*/
+static int PM_FlyMove (pmove_t *pm, float time)
+{
+	int			bumpcount, numplanes;
+	vec3_t		dir;
+	float		d;
+	vec3_t		planes[MAX_CLIP_PLANES];
+	vec3_t		primal_velocity, original_velocity, new_velocity;
+	int			i, j;
+	trace_t		trace;
+	vec3_t		end;
+	float		time_left;
+	int			blocked;
+
+	blocked = 0;
+	VectorCopy (pm->velocity, original_velocity);
+	VectorCopy (pm->velocity, primal_velocity);
+	numplanes = 0;
+
+	time_left = time;
+
+	for (bumpcount=0 ; bumpcount<4 ; bumpcount++)
+	{
+		if (!pm->velocity[0] && !pm->velocity[1] && !pm->velocity[2])
+			break;
+
+		for (i=0 ; i<3 ; i++)
+			end[i] = pm->origin[i] + time_left * pm->velocity[i];
+
+		trace = PM_Trace (pm->origin, end, 1);
+
+		if (trace.allsolid)
+		{
+			VectorClear (pm->velocity);
+			return 3;
+		}
+
+		if (trace.fraction > 0)
+		{
+			VectorCopy (trace.endpos, pm->origin);
+			VectorCopy (pm->velocity, original_velocity);
+			numplanes = 0;
+		}
+
+		if (trace.fraction == 1)
+			break;
+
+		if (trace.plane.normal[2] > 0.7)
+		{
+			blocked |= 1;
+			pm->onground = true;
+		}
+		if (!trace.plane.normal[2])
+			blocked |= 2;
+
+		time_left -= time_left * trace.fraction;
+
+		if (numplanes >= MAX_CLIP_PLANES)
+		{
+			VectorClear (pm->velocity);
+			return 3;
+		}
+
+		VectorCopy (trace.plane.normal, planes[numplanes]);
+		numplanes++;
+
+		for (i=0 ; i<numplanes ; i++)
+		{
+			ClipVelocity (original_velocity, planes[i], new_velocity, 1);
+			for (j=0 ; j<numplanes ; j++)
+				if (j != i && DotProduct (new_velocity, planes[j]) < 0)
+					break;
+			if (j == numplanes)
+				break;
+		}
+
+		if (i != numplanes)
+		{
+			VectorCopy (new_velocity, pm->velocity);
+		}
+		else
+		{
+			if (numplanes != 2)
+			{
+				VectorClear (pm->velocity);
+				return 7;
+			}
+			CrossProduct (planes[0], planes[1], dir);
+			d = DotProduct (dir, pm->velocity);
+			VectorScale (dir, d, pm->velocity);
+		}
+
+		if (DotProduct (pm->velocity, primal_velocity) <= 0)
+		{
+			VectorClear (pm->velocity);
+			return blocked;
+		}
+	}
+
+	return blocked;
+}
+
+/*
+==================
+PM_WalkMove
+
+SV_WalkMove, without the unstick and wall friction special cases
+==================
+*/
+static void PM_WalkMove (pmove_t *pm, float frametime)
+{
+	vec3_t		oldorg, oldvel, nosteporg, nostepvel, dest;
+	qboolean	oldonground;
+	trace_t		trace;
+
+	oldonground = pm->onground;
+	pm->onground = false;
+
+	VectorCopy (pm->origin, oldorg);
+	VectorCopy (pm->velocity, oldvel);
+
+	if (!(PM_FlyMove (pm, frametime) & 2))
+		return;		// move didn't block on a step
+
+	if (!oldonground || sv_nostep.value)
+		return;		// don't stair up while jumping
+
+	VectorCopy (pm->origin, nosteporg);
+	VectorCopy (pm->velocity, nostepvel);
+
+// try moving up and forward to go up a step
+	VectorCopy (oldorg, dest);
+	dest[2] += STEPSIZE;
+	trace = PM_Trace (oldorg, dest, 1);
+	VectorCopy (trace.endpos, pm->origin);
+
+	pm->velocity[0] = oldvel[0];
+	pm->velocity[1] = oldvel[1];
+	pm->velocity[2] = 0;
+	PM_FlyMove (pm, frametime);
+
+// move down
+	VectorCopy (pm->origin, dest);
+	dest[2] += -STEPSIZE + oldvel[2]*frametime;
+	trace = PM_Trace (pm->origin, dest, 1);
+	VectorCopy (trace.endpos, pm->origin);
+
+	if (trace.plane.normal[2] > 0.7)
+	{
+		pm->onground = true;
+	}
+	else
+	{
+		VectorCopy (nosteporg, pm->origin);
+		VectorCopy (nostepvel, pm->velocity);
+	}
+}
+
+/*
+==================
+PM_PlayerMove
+
+One usercmd, in the order SV_RunClients and SV_Physics_Client run it
+==================
+*/
+static void PM_PlayerMove (pmove_t *pm, predmove_t *move)
+{
+	int		i;
+	vec3_t	angles, forward, right, up;
+	vec3_t	wishvel, wishdir;
+	float	wishspeed;
+
+// show 1/3 the pitch angle, like SV_ClientThink
+	angles[PITCH] = -move->angles[PITCH]/3;
+	angles[YAW] = move->angles[YAW];
+	angles[ROLL] = 0;
+	AngleVectors (angles, forward, right, up);
+
+	for (i=0 ; i<3 ; i++)
+		wishvel[i] = forward[i]*move->forwardmove + right[i]*move->sidemove;
+	wishvel[2] = 0;
+
+	VectorCopy (wishvel, wishdir);
+	wishspeed = VectorNormalize (wishdir);
+	if (wishspeed > sv_maxspeed.value)
+	{
+		VectorScale (wishvel, sv_maxspeed.value/wishspeed, wishvel);
+		wishspeed = sv_maxspeed.value;
+	}
+
+	if (pm->onground)
+	{
+		PM_Friction (pm, move->frametime);
+		PM_Accelerate (pm, wishdir, wishspeed, move->frametime);
+	}
+	else
+	{
+		PM_AirAccelerate (pm, wishvel, wishspeed, move->frametime);
+	}
+
+	pm->velocity[2] -= sv_gravity.value * move->frametime;
+
+	PM_WalkMove (pm, move->frametime);
+}
+
+//=============================================================================
+
+/*
+==================
+CL_PredictMove
+==================
+*/
+void CL_PredictMove (void)
+{
+	entity_t	*ent;
+	predmove_t	*move;
+	pmove_t		pm;
+	vec3_t		delta;
+	float		frac;
+	int			i;
+
+	if (!cl_predict.value || sv.active || cls.demoplayback
+	|| cls.signon != SIGNONS || !cl.worldmodel || cl.intermission)
+		return;
+
+	if (!pred_acked || pred_outgoing - pred_acked > PRED_BACKUP)
+		return;		// server isn't acknowledging moves, or too far behind
+
+	ent = &cl_entities[cl.viewentity];
+	if (ent->msgtime != cl.mtime[0])
+		return;		// not in the last message
+
+	if (cl.stats[STAT_HEALTH] <= 0)
+		return;
+
+//
+// reconcile with the server's answer to the last acknowledged move
+//
+	if (pred_acked != pred_lastacked)
+	{
+		move = &pred_moves[pred_acked & PRED_MASK];
+		if (move->sequence == pred_acked && move->predicted)
+		{
+			VectorSubtract (ent->msg_origins[0], move->origin, delta);
+			if (Length (delta) > PRED_SNAPDIST)
+			{
+				VectorClear (pred_error);
+			}
+			else
+			{
+				// whatever hasn't faded out yet carries over
+				frac = 0;
+				if (cl_predict_smooth.value > 0)
+					frac = 1 - (realtime - pred_errortime) / cl_predict_smooth.value;
+				if (frac < 0)
+					frac = 0;
+				VectorMA (delta, frac, pred_error, pred_error);
+			}
+			pred_errortime = realtime;
+		}
+		pred_lastacked = pred_acked;
+	}
+
+//
+// replay everything the server hasn't run yet
+//
+	VectorCopy (ent->msg_origins[0], pm.origin);
+	VectorCopy (cl.mvelocity[0], pm.velocity);
+	pm.onground = cl.onground;
+
+	if (PM_Trace (pm.origin, pm.origin, 1).allsolid && !PM_NudgePosition (&pm))
+		return;
+
+	for (i=pred_acked+1 ; i<pred_outgoing ; i++)
+	{
+		move = &pred_moves[i & PRED_MASK];
+		PM_PlayerMove (&pm, move);
+		VectorCopy (pm.origin, move->origin);
+		move->predicted = true;
+	}
+
+//
+// fade the last correction out over cl_predict_smooth seconds
+//
+	frac = 0;
+	if (cl_predict_smooth.value > 0)
+		frac = 1 - (realtime - pred_errortime) / cl_predict_smooth.value;
+	if (frac < 0)
+		frac = 0;
+
+	VectorMA (pm.origin, -frac, pred_error, ent->origin);
+}
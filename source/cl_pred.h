@@ -0,0 +1,36 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+// cl_pred.h -- local player movement prediction for remote servers
+
+void CL_InitPrediction (void);
+
+// called at every signon, forgets all pending moves
+void CL_ClearPrediction (void);
+
+// remembers a move about to be sent, returns its sequence number
+int CL_StoreMove (usercmd_t *cmd, vec3_t angles);
+
+// svc_moveack, the last move the server has run
+void CL_AckMove (int sequence);
+
+// called after the entities are relinked, moves the view entity to
+// the predicted position
+void CL_PredictMove (void);
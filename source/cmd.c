@@ -24,15 +24,18 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 void Cmd_ForwardToServer (void);
 
 #define	MAX_ALIAS_NAME	32
+#define	CMD_HASHSIZE	256			// must be a power of two
 
 typedef struct cmdalias_s
 {
 	struct cmdalias_s	*next;
+	struct cmdalias_s	*hashnext;
 	char	name[MAX_ALIAS_NAME];
 	char	*value;
 } cmdalias_t;
 
 cmdalias_t	*cmd_alias;
+static	cmdalias_t	*cmd_aliashash[CMD_HASHSIZE];
 
 int trashtest;
 int *trashspot;
@@ -347,6 +350,7 @@ void Cmd_Alias_f (void)
 	cmdalias_t	*a;
 	char		cmd[1024];
 	int			i, c;
+	unsigned	h;
 	char		*s;
 
 	if (Cmd_Argc() == 1)
@@ -365,7 +369,8 @@ void Cmd_Alias_f (void)
 	}
 
 	// if the alias allready exists, reuse it
-	for (a = cmd_alias ; a ; a=a->next)
+	h = Cmd_HashName (s) & (CMD_HASHSIZE - 1);
+	for (a = cmd_aliashash[h] ; a ; a=a->hashnext)
 	{
 		if (!strcmp(s, a->name))
 		{
@@ -379,6 +384,8 @@ void Cmd_Alias_f (void)
 		a = Z_Malloc (sizeof(cmdalias_t));
 		a->next = cmd_alias;
 		cmd_alias = a;
+		a->hashnext = cmd_aliashash[h];
+		cmd_aliashash[h] = a;
 	}
 	strcpy (a->name, s);	
 
@@ -480,6 +487,7 @@ void Cmd_Maps_f (void)
 typedef struct cmd_function_s
 {
 	struct cmd_function_s	*next;
+	struct cmd_function_s	*hashnext;
 	char					*name;
 	xcommand_t				function;
 } cmd_function_t;
@@ -496,6 +504,7 @@ cmd_source_t	cmd_source;
 
 
 static	cmd_function_t	*cmd_functions;		// possible commands to execute
+static	cmd_function_t	*cmd_hash[CMD_HASHSIZE];
 
 // 2000-01-09 CmdList command by Maddes  start
 /*
@@ -661,6 +670,7 @@ Cmd_AddCommand
 void	Cmd_AddCommand (char *cmd_name, xcommand_t function)
 {
 	cmd_function_t	*cmd;
+	unsigned		h;
 	
 	if (host_initialized)	// because hunk allocation would get stomped
 		Sys_Error ("Cmd_AddCommand after host_initialized");
@@ -673,13 +683,10 @@ void	Cmd_AddCommand (char *cmd_name, xcommand_t function)
 	}
 	
 // fail if the command already exists
-	for (cmd=cmd_functions ; cmd ; cmd=cmd->next)
+	if (Cmd_Exists (cmd_name))
 	{
-		if (!strcmp (cmd_name, cmd->name))
-		{
-			Con_Printf ("Cmd_AddCommand: %s already defined\n", cmd_name);
-			return;
-		}
+		Con_Printf ("Cmd_AddCommand: %s already defined\n", cmd_name);
+		return;
 	}
 
 	cmd = Hunk_Alloc (sizeof(cmd_function_t));
@@ -687,6 +694,10 @@ void	Cmd_AddCommand (char *cmd_name, xcommand_t function)
 	cmd->function = function;
 	cmd->next = cmd_functions;
 	cmd_functions = cmd;
+
+	h = Cmd_HashName (cmd_name) & (CMD_HASHSIZE - 1);
+	cmd->hashnext = cmd_hash[h];
+	cmd_hash[h] = cmd;
 }
 
 /*
@@ -698,7 +709,7 @@ qboolean	Cmd_Exists (char *cmd_name)
 {
 	cmd_function_t	*cmd;
 
-	for (cmd=cmd_functions ; cmd ; cmd=cmd->next)
+	for (cmd=cmd_hash[Cmd_HashName (cmd_name) & (CMD_HASHSIZE - 1)] ; cmd ; cmd=cmd->hashnext)
 	{
 		if (!strcmp (cmd_name,cmd->name))
 			return true;
@@ -734,18 +745,41 @@ char *Cmd_CompleteCommand (char *partial)
 
 //===================================================================
 
+/*
+============
+Cmd_HashName
+
+Case folded, the tables keep their own case rules on top of it
+============
+*/
+unsigned Cmd_HashName (const char *name)
+{
+	unsigned	h;
+	int			c;
+
+	for (h = 0 ; *name ; name++)
+	{
+		c = *name;
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		h = h * 31 + c;
+	}
+
+	return h;
+}
+
 /*
 ============
 Cmd_ExecuteString
 
 A complete command line has been parsed, so try to execute it
-FIXME: lookupnoadd the token to speed search?
 ============
 */
 void	Cmd_ExecuteString (char *text, cmd_source_t src)
 {	
 	cmd_function_t	*cmd;
 	cmdalias_t		*a;
+	unsigned		h;
 
 	cmd_source = src;
 	Cmd_TokenizeString (text);
@@ -754,8 +788,10 @@ void	Cmd_ExecuteString (char *text, cmd_source_t src)
 	if (!Cmd_Argc())
 		return;		// no tokens
 
+	h = Cmd_HashName (cmd_argv[0]) & (CMD_HASHSIZE - 1);
+
 // check functions
-	for (cmd=cmd_functions ; cmd ; cmd=cmd->next)
+	for (cmd=cmd_hash[h] ; cmd ; cmd=cmd->hashnext)
 	{
 		if (!strcasecmp (cmd_argv[0],cmd->name))
 		{
@@ -765,7 +801,7 @@ void	Cmd_ExecuteString (char *text, cmd_source_t src)
 	}
 
 // check alias
-	for (a=cmd_alias ; a ; a=a->next)
+	for (a=cmd_aliashash[h] ; a ; a=a->hashnext)
 	{
 		if (!strcasecmp (cmd_argv[0], a->name))
 		{
@@ -91,6 +91,9 @@ void	Cmd_AddCommand (char *cmd_name, xcommand_t function);
 qboolean Cmd_Exists (char *cmd_name);
 // used by the cvar code to check for cvar / command name overlap
 
+unsigned Cmd_HashName (const char *name);
+// case insensitive, for the command, alias and cvar tables
+
 char 	*Cmd_CompleteCommand (char *partial);
 // attempts to match a partial command for automatic command line completion
 // returns NULL if nothing fits
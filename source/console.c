@@ -67,7 +67,14 @@ extern void M_Menu_Main_f (void);
 #define MAXGAMEDIRLEN	1000
 char debuglogfile[MAXGAMEDIRLEN + 1];
 
-#ifndef _3DS
+// what other threads printed, until the main thread flushes it
+#define	CON_DEFERSIZE	8192
+static char	con_deferred[CON_DEFERSIZE];
+static int	con_deferredlen;
+static int	con_deferreddropped;
+static void	*con_deferlock;
+
+#if !defined(_3DS) && !defined(__linux__)
 void M_OSK_Draw (void);
 void Con_OSK_f (char *input, char *output, int outlen);
 void Con_OSK_Key(int key);
@@ -253,6 +260,7 @@ void Con_Init (void)
 	Cmd_AddCommand ("messagemode", Con_MessageMode_f);
 	Cmd_AddCommand ("messagemode2", Con_MessageMode2_f);
 	Cmd_AddCommand ("clear", Con_Clear_f);
+	con_deferlock = Sys_CreateSemaphore (1);
 	con_initialized = true;
 }
 
@@ -384,17 +392,34 @@ Handles cursor positioning, line wrapping, etc
 ================
 */
 #define	MAXPRINTMSG	4096
+static void Con_PrintMsg (char *msg);
+static void Con_Defer (char *msg);
+
 // FIXME: make a buffer size safe vsprintf?
 void Con_Printf (char *fmt, ...)
 {
 	va_list		argptr;
 	char		msg[MAXPRINTMSG];
-	static qboolean	inupdate;
 	
 	va_start (argptr,fmt);
 	vsprintf (msg,fmt,argptr);
 	va_end (argptr);
-	
+
+	if (!Sys_MainThread ())
+		Con_Defer (msg);
+	else
+		Con_PrintMsg (msg);
+}
+
+/*
+================
+Con_PrintMsg
+================
+*/
+static void Con_PrintMsg (char *msg)
+{
+	static qboolean	inupdate;
+
 // also echo to debugging console
 	Sys_Printf ("%s", msg);	// also echo to debugging console
 
@@ -425,6 +450,62 @@ void Con_Printf (char *fmt, ...)
 	}
 }
 
+/*
+================
+Con_Defer
+
+Other threads can't touch the console or the screen, what they print waits
+for Con_FlushDeferred
+================
+*/
+static void Con_Defer (char *msg)
+{
+	int		len;
+
+	if (!con_deferlock)
+		return;
+
+	len = strlen (msg) + 1;
+	Sys_SemaphoreWait (con_deferlock);
+	if (con_deferredlen + len > CON_DEFERSIZE)
+		con_deferreddropped++;
+	else
+	{
+		memcpy (con_deferred + con_deferredlen, msg, len);
+		con_deferredlen += len;
+	}
+	Sys_SemaphorePost (con_deferlock);
+}
+
+/*
+================
+Con_FlushDeferred
+
+Prints what other threads have, in the order they printed it
+================
+*/
+void Con_FlushDeferred (void)
+{
+	static char	msgs[CON_DEFERSIZE];
+	int			i, len, dropped;
+
+	if (!con_deferredlen && !con_deferreddropped)
+		return;
+
+	Sys_SemaphoreWait (con_deferlock);
+	len = con_deferredlen;
+	memcpy (msgs, con_deferred, len);
+	dropped = con_deferreddropped;
+	con_deferredlen = 0;
+	con_deferreddropped = 0;
+	Sys_SemaphorePost (con_deferlock);
+
+	for (i=0 ; i<len ; i += strlen (msgs + i) + 1)
+		Con_PrintMsg (msgs + i);
+	if (dropped)
+		Con_Printf ("%i messages from other threads were dropped\n", dropped);
+}
+
 /*
 ================
 Con_DPrintf
@@ -465,6 +546,12 @@ void Con_SafePrintf (char *fmt, ...)
 	vsprintf (msg,fmt,argptr);
 	va_end (argptr);
 
+	if (!Sys_MainThread ())
+	{
+		Con_Defer (msg);
+		return;
+	}
+
 	temp = scr_disabled_for_loading;
 	scr_disabled_for_loading = true;
 	Con_Printf ("%s", msg);
@@ -627,12 +714,12 @@ void Con_DrawConsole (int lines, qboolean drawinput)
 		Con_DrawInput ();
 #endif // __WII__
 
-#ifndef _3DS
+#if !defined(_3DS) && !defined(__linux__)
 	Con_DrawOSK();	
 #endif // __PSP__, __WII__
 }
 
-#ifndef _3DS
+#if !defined(_3DS) && !defined(__linux__)
 static qboolean	scr_osk_active = false;
 
 
@@ -136,7 +136,7 @@ typedef struct
 	qboolean	demoplayback;
 	qboolean	timedemo;
 	int			forcetrack;			// -1 = use normal cd track
-	FILE		*demofile;
+	int			demofile;
 	int			td_lastframe;		// to meter out one message a frame
 	int			td_startframe;		// host_framecount at start
 	float		td_starttime;		// realtime at second frame of timedemo
@@ -228,6 +228,14 @@ typedef struct
 	int			maxclients;
 	int			gametype;
 
+// what the renderer reads of a local server, copied between its ticks
+	double		svtime;				// sv.time
+	char		weaponname[32];		// the player's Weapon_Name
+	char		touchname[32];		// and Weapon_Name_Touch
+	float		facingenemy;
+	float		viewofs;			// view_ofs[2]
+	vec3_t		adsoffset;
+
 // refresh related state
 	struct model_s	*worldmodel;	// cl_entitites[0].model
 	struct efrag_s	*free_efrags;
@@ -395,6 +403,13 @@ void CL_Stop_f (void);
 void CL_Record_f (void);
 void CL_PlayDemo_f (void);
 void CL_TimeDemo_f (void);
+void CL_TimeDemoCompare_f (void);
+
+// a timedemo's frame times, at the start of every host frame
+void CL_TimeDemoFrame (void);
+
+extern	cvar_t	timedemo_warmup;
+extern	cvar_t	timedemo_output;
 
 //
 // cl_parse.c
@@ -168,26 +168,51 @@ void COM_FileBase (char *in, char *out);
 void COM_DefaultExtension (char *path, char *extension);
 
 char	*va(char *format, ...);
+char *CopyString (char *in);
 // does a varargs printf into a temp buffer
 
 
 //============================================================================
 
 extern int com_filesize;
+extern int com_filepos;		// where the last file found starts in its handle
 struct cache_user_s;
 
 extern	char	com_gamedir[MAX_OSPATH];
 
 void COM_WriteFile (char *filename, void *data, int len);
+void COM_CreatePath (char *path);
+void COM_FileWritten (char *filename);	// for files written below com_gamedir by other means
 int COM_OpenFile (char *filename, int *hndl);
 int COM_FOpenFile (char *filename, FILE **file);
 void COM_CloseFile (int h);
+char *COM_FileExtension (char *in);
 
 byte *COM_LoadStackFile (char *path, void *buffer, int bufsize);
 byte *COM_LoadTempFile (char *path);
 byte *COM_LoadHunkFile (char *path);
+byte *COM_LoadMallocFile (char *path, int *len);	// thread safe, caller frees
 void COM_LoadCacheFile (char *path, struct cache_user_s *cu);
 
+// a file viewed in place where the platform can map it, otherwise read
+// into a malloc'd copy; data is not NUL terminated, and writes to it stay
+// private to the view
+typedef struct
+{
+	byte		*data;
+	int			len;
+	int			filepos;		// offset of data in the file it came from
+	qboolean	mapped;
+	qboolean	temp;			// the copy is on the temp hunk
+} filemap_t;
+
+qboolean COM_MapFile (char *path, filemap_t *map);
+// the copy goes on the temp hunk instead, for the main thread's loaders,
+// and is only good until the next temp or high hunk allocation
+qboolean COM_MapTempFile (char *path, filemap_t *map);
+qboolean COM_MapOSFile (char *netpath, filemap_t *map);
+void COM_UnmapFile (filemap_t *map);
+
 
 extern	struct cvar_s	registered;
 
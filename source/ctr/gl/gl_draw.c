@@ -22,6 +22,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // vid buffer
 
 #include "../../quakedef.h"
+#include "../../fs_index.h"
+#include "../../loadtrace.h"
+#include "../../jobs.h"
 
 #define GL_COLOR_INDEX8_EXT     0x80E5
 
@@ -1097,7 +1100,7 @@ void Draw_Crosshair (void)
 
 	if (cl.stats[STAT_ZOOM] == 2)
 		Draw_Pic (-39, -15, sniper_scope);
-   	if (Hitmark_Time > sv.time)
+   	if (Hitmark_Time > cl.svtime)
         Draw_Pic ((vid.width - hitmark->width)/2,(vid.height - hitmark->height)/2, hitmark);
 
 	// Make sure to do this after hitmark drawing.
@@ -1109,14 +1112,14 @@ void Draw_Crosshair (void)
 
 	float col;
 
-	if (sv_player->v.facingenemy == 1) {
+	if (cl.facingenemy == 1) {
 		col = 0;
 	} else {
 		col = 255;
 	}
 
 	// crosshair moving
-	if (crosshair_spread_time > sv.time && crosshair_spread_time)
+	if (crosshair_spread_time > cl.svtime && crosshair_spread_time)
     {
         cur_spread = cur_spread + 10;
 		crosshair_opacity = 128;
@@ -1125,7 +1128,7 @@ void Draw_Crosshair (void)
 			cur_spread = CrossHairMaxSpread();
     }
 	// crosshair not moving
-    else if (crosshair_spread_time < sv.time && crosshair_spread_time)
+    else if (crosshair_spread_time < cl.svtime && crosshair_spread_time)
     {
         cur_spread = cur_spread - 4;
 		crosshair_opacity = 255;
@@ -1145,9 +1148,9 @@ void Draw_Crosshair (void)
 		if (CrossHairMaxSpread() < crosshair_offset || croshhairmoving)
 			crosshair_offset = CrossHairMaxSpread();
 
-		if (sv_player->v.view_ofs[2] == 8) {
+		if (cl.viewofs == 8) {
 			crosshair_offset *= 0.80;
-		} else if (sv_player->v.view_ofs[2] == -10) {
+		} else if (cl.viewofs == -10) {
 			crosshair_offset *= 0.65;
 		}
 
@@ -1284,19 +1287,39 @@ int GL_FindTexture (char *identifier)
 	return -1;
 }
 
+typedef struct
+{
+	unsigned	*in;
+	int			inwidth, inheight;
+	unsigned	*out;
+	int			outwidth, outheight;
+} resample_t;
+
 /*
 ================
-GL_ResampleTexture
+GL_ResampleRows
+
+The output rows first up to last, a job
 ================
 */
-void GL_ResampleTexture (unsigned *in, int inwidth, int inheight, unsigned *out,  int outwidth, int outheight)
+static void GL_ResampleRows (void *data, int first, int last)
 {
+	resample_t	*r;
 	int		i, j;
-	unsigned	*inrow;
+	unsigned	*in, *inrow, *out;
+	int		inwidth, inheight, outwidth, outheight;
 	unsigned	frac, fracstep;
 
+	r = data;
+	in = r->in;
+	inwidth = r->inwidth;
+	inheight = r->inheight;
+	outwidth = r->outwidth;
+	outheight = r->outheight;
+	out = r->out + first*outwidth;
+
 	fracstep = inwidth*0x10000/outwidth;
-	for (i=0 ; i<outheight ; i++, out += outwidth)
+	for (i=first ; i<last ; i++, out += outwidth)
 	{
 		inrow = in + inwidth*(i*inheight/outheight);
 		frac = fracstep >> 1;
@@ -1314,6 +1337,26 @@ void GL_ResampleTexture (unsigned *in, int inwidth, int inheight, unsigned *out,
 	}
 }
 
+/*
+================
+GL_ResampleTexture
+
+Split by rows over the job threads, at least 16K texels to a job
+================
+*/
+void GL_ResampleTexture (unsigned *in, int inwidth, int inheight, unsigned *out,  int outwidth, int outheight)
+{
+	resample_t	r;
+
+	r.in = in;
+	r.inwidth = inwidth;
+	r.inheight = inheight;
+	r.out = out;
+	r.outwidth = outwidth;
+	r.outheight = outheight;
+	Jobs_ParallelFor ("GL_ResampleTexture", GL_ResampleRows, &r, outheight, 16384 / outwidth);
+}
+
 /*
 ================
 GL_Resample8BitTexture -- JACK
@@ -2272,12 +2315,15 @@ byte* LoadSTBI(FILE *f, int width, int height)
 	return image;
 }
 
+static char *image_exts[] = {"pcx", "tga", "png", "jpeg", "jpg", NULL};
+
 byte* loadimagepixels (char* filename, qboolean complain, int matchwidth, int matchheight)
 
 {
 	FILE	*f;
 	char	basename[128], name[132];
 	byte	*c;
+	int		ext;
 
 	if (complain == qfalse)
 		COM_StripExtension(filename, basename); // strip the extension to allow TGA
@@ -2292,47 +2338,36 @@ byte* loadimagepixels (char* filename, qboolean complain, int matchwidth, int ma
 		c++;
 	}
 
-	//Try PCX
-	sprintf (name, "%s.pcx", basename);
+	// one index probe finds the preferred format that exists
+	ext = FS_FindExtension (basename, image_exts, NULL);
+	if (ext < 0)
+		return NULL;
+
+	sprintf (name, "%s.%s", basename, image_exts[ext]);
 	COM_FOpenFile (name, &f);
-	if (f)
+	if (!f)
+		return NULL;
+
+	if (ext == 0)
 		return LoadPCX (f, matchwidth, matchheight);
-	//Try TGA
-	sprintf (name, "%s.tga", basename);
-	COM_FOpenFile (name, &f);
-	if (f)
+	if (ext == 1)
 		return LoadTGA (f, matchwidth, matchheight);
-	//Try PNG
-	sprintf (name, "%s.png", basename);
-	COM_FOpenFile (name, &f);
-	if (f)
-		return LoadSTBI (f, matchwidth, matchheight);
-	//Try JPEG
-	sprintf (name, "%s.jpeg", basename);
-	COM_FOpenFile (name, &f);
-	if (f)
-		return LoadSTBI (f, matchwidth, matchheight);
-	sprintf (name, "%s.jpg", basename);
-	COM_FOpenFile (name, &f);
-	if (f)
-		return LoadSTBI (f, matchwidth, matchheight);
-	
-	//if (complain)
-	//	Con_Printf ("Couldn't load %s.tga or %s.pcx \n", filename);
-	
-	return NULL;
+	return LoadSTBI (f, matchwidth, matchheight);
 }
 
 int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean complain, qboolean mipmap)
 {
 	int texnum;
 	byte *data;
+	LoadTrace_Begin ("loadtextureimage", filename);
 	if (!(data = loadimagepixels (filename, complain, matchwidth, matchheight))) { 
 		Con_DPrintf("Cannot load image %s\n", filename);
+		LoadTrace_End ();
 		return 0;
 	}
 	texnum = GL_LoadTexture (filename, image_width, image_height, data, mipmap, qtrue, 4);
 	free(data);
+	LoadTrace_End ();
 	return texnum;
 }
 // Tomaz || TGA End
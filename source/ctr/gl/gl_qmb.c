@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // gl_rpart.c
 
 #include "../../quakedef.h"
+#include "../../prof.h"
 
 //#define	DEFAULT_NUM_PARTICLES		8192
 #define	ABSOLUTE_MIN_PARTICLES      64
@@ -1364,6 +1365,8 @@ void QMB_DrawParticles (void)
 	if (!qmb_initialized)
 		return;
 
+	PROF_BEGIN (QMB_DrawParticles);
+
 	particle_time = cl.time;
 
 	if (!cl.paused)
@@ -1701,6 +1704,8 @@ void QMB_DrawParticles (void)
 	glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 	glShadeModel (GL_SMOOTH);
+
+	PROF_END (QMB_DrawParticles);
 }
 
 void QMB_Shockwave_Splash(vec3_t org, int radius)
@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_main.c
 
 #include "../../quakedef.h"
+#include "../../prof.h"
 
 entity_t	r_worldentity;
 
@@ -1231,6 +1232,8 @@ void R_DrawEntitiesOnList (void)
 	if (!r_drawentities.value)
 		return;
 
+	PROF_BEGIN (R_DrawEntitiesOnList);
+
 	int zHackCount = 0;
 	doZHack = 0;
 	char specChar;
@@ -1304,6 +1307,8 @@ void R_DrawEntitiesOnList (void)
 		default: break;
 		}
 	}
+
+	PROF_END (R_DrawEntitiesOnList);
 }
 
 /*
@@ -1839,6 +1844,8 @@ void R_RenderView (void)
 	if (r_norefresh.value)
 		return;
 
+	PROF_BEGIN (R_RenderView);
+
 	if (!r_worldentity.model || !cl.worldmodel)
 		Sys_Error ("R_RenderView: NULL worldmodel");
 
@@ -1879,4 +1886,6 @@ void R_RenderView (void)
 		time2 = Sys_FloatTime ();
 		Con_Printf ("%3i ms  %4i wpoly %4i epoly\n", (int)((time2-time1)*1000), c_brush_polys, c_alias_polys); 
 	}
+
+	PROF_END (R_RenderView);
 }
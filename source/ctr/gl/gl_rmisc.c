@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_misc.c
 
 #include "../../quakedef.h"
+#include "../../loadtrace.h"
 
 extern cvar_t r_flatlightstyles;
 
@@ -454,7 +455,9 @@ void R_NewMap (void)
 	r_viewleaf = NULL;
 	R_ClearParticles ();
 
+	LoadTrace_Begin ("GL_BuildLightmaps", NULL);
 	GL_BuildLightmaps ();
+	LoadTrace_End ();
 
 	Sky_NewMap (); //johnfitz -- skybox in worldspawn
 	Fog_NewMap (); // johnfitz -- global fog in worldspawn
@@ -20,6 +20,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_surf.c: surface-related refresh code
 
 #include "../../quakedef.h"
+#include "../../prof.h"
+#include "../../jobs.h"
 
 #ifndef GL_RGBA4
 #define	GL_RGBA4	0
@@ -65,7 +67,7 @@ void R_RenderDynamicLightmaps (msurface_t *fa);
 R_AddDynamicLights
 ===============
 */
-void R_AddDynamicLights (msurface_t *surf)
+void R_AddDynamicLights (msurface_t *surf, unsigned *blocklights)
 {
 	int			lnum;
 	int			sd, td;
@@ -148,12 +150,13 @@ void R_AddDynamicLights (msurface_t *surf)
 
 /*
 ===============
-R_BuildLightMap
+R_FillLightMap
 
-Combine and scale multiple lightmaps into the 8.8 format in blocklights
+Combine and scale multiple lightmaps into the 8.8 format in blocklights,
+which is the caller's so the lightmap jobs can each have their own
 ===============
 */
-void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
+static void R_FillLightMap (msurface_t *surf, byte *dest, int stride, unsigned *blocklights)
 {
 	int			blocksize, smax, tmax;
 	int			t;
@@ -217,7 +220,7 @@ void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
 	
 // add all the dynamic lights
 	if (surf->dlightframe == r_framecount)
-		R_AddDynamicLights (surf);
+		R_AddDynamicLights (surf, blocklights);
 
 // bound, invert, and shift
 store:
@@ -240,6 +243,18 @@ store:
 	
 }
 
+/*
+===============
+R_BuildLightMap
+
+Combine and scale multiple lightmaps into the 8.8 format in blocklights
+===============
+*/
+void R_BuildLightMap (msurface_t *surf, byte *dest, int stride)
+{
+	R_FillLightMap (surf, dest, stride, blocklights);
+}
+
 /*
 ===============
 R_TextureAnimation
@@ -1435,6 +1450,8 @@ void R_DrawWorld (void)
 	entity_t	ent;
 	int			i;
 
+	PROF_BEGIN (R_DrawWorld);
+
 	memset (&ent, 0, sizeof(ent));
 	ent.model = cl.worldmodel;
 
@@ -1458,6 +1475,8 @@ void R_DrawWorld (void)
 	Fog_SetupFrame (/*false*/); //johnfitz
 
 	R_BlendLightmaps();
+
+	PROF_END (R_DrawWorld);
 }
 
 
@@ -1692,7 +1711,6 @@ GL_CreateSurfaceLightmap
 void GL_CreateSurfaceLightmap (msurface_t *surf)
 {
 	int		smax, tmax, s, t, l, i;
-	byte	*base;
 
 	if (surf->flags & (SURF_DRAWSKY|SURF_DRAWTURB))
 		return;
@@ -1701,9 +1719,33 @@ void GL_CreateSurfaceLightmap (msurface_t *surf)
 	tmax = (surf->extents[1]>>4)+1;
 
 	surf->lightmaptexturenum = AllocBlock (smax, tmax, &surf->light_s, &surf->light_t);
-	base = lightmaps + surf->lightmaptexturenum*lightmap_bytes*BLOCK_WIDTH*BLOCK_HEIGHT;
-	base += (surf->light_t * BLOCK_WIDTH + surf->light_s) * lightmap_bytes;
-	R_BuildLightMap (surf, base, BLOCK_WIDTH*lightmap_bytes);
+}
+
+/*
+========================
+GL_FillSurfaceLightmaps
+
+The lightmaps of a model's surfaces first up to last, once they have all
+been placed.  A job, each surface writes only its own block.
+========================
+*/
+static void GL_FillSurfaceLightmaps (void *data, int first, int last)
+{
+	model_t		*m;
+	msurface_t	*surf;
+	byte		*base;
+	unsigned	bl[3*18*18];
+
+	m = data;
+	for (surf = m->surfaces + first ; surf < m->surfaces + last ; surf++)
+	{
+		if (surf->flags & (SURF_DRAWSKY|SURF_DRAWTURB))
+			continue;
+
+		base = lightmaps + surf->lightmaptexturenum*lightmap_bytes*BLOCK_WIDTH*BLOCK_HEIGHT;
+		base += (surf->light_t * BLOCK_WIDTH + surf->light_s) * lightmap_bytes;
+		R_FillLightMap (surf, base, BLOCK_WIDTH*lightmap_bytes, bl);
+	}
 }
 
 
@@ -1782,6 +1824,7 @@ void GL_BuildLightmaps (void)
 
 			BuildSurfaceDisplayList (m->surfaces + i);
 		}
+		Jobs_ParallelFor ("GL_FillSurfaceLightmaps", GL_FillSurfaceLightmaps, m, m->numsurfaces, 64);
 	}
 
  	if (!gl_texsort.value)
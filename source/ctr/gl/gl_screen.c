@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // screen.c -- master for refresh, status bar, console, chat, notify, etc
 
 #include "../../quakedef.h"
+#include "../../prof.h"
 
 /*
 
@@ -422,12 +423,12 @@ void SCR_UsePrint (int type, int cost, int weapon)
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
 		case 3://ammo
-			strcpy(s, va("Hold  %s  to buy Ammo for %s\n", GetUseButtonL(), pr_strings+sv_player->v.Weapon_Name_Touch));
+			strcpy(s, va("Hold  %s  to buy Ammo for %s\n", GetUseButtonL(), cl.touchname));
 			strcpy(c, va("[Cost: %i]\n", cost));
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
 		case 4://weapon
-			strcpy(s, va("Hold  %s  to buy %s\n", GetUseButtonL(), pr_strings+sv_player->v.Weapon_Name_Touch));
+			strcpy(s, va("Hold  %s  to buy %s\n", GetUseButtonL(), cl.touchname));
 			strcpy(c, va("[Cost: %i]\n", cost));
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
@@ -442,7 +443,7 @@ void SCR_UsePrint (int type, int cost, int weapon)
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
 		case 7://box take
-			strcpy(s, va("Hold  %s  for %s\n", GetUseButtonL(), pr_strings+sv_player->v.Weapon_Name_Touch));
+			strcpy(s, va("Hold  %s  for %s\n", GetUseButtonL(), cl.touchname));
 			strcpy(c, "");
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
@@ -1624,12 +1625,15 @@ void SCR_UpdateScreen (void)
 
 	V_RenderView ();
 
+	PROF_BEGIN (SCR_2D);
+
 	GL_Set2D ();
 
 	Draw_Crosshair ();
 
 	//muff - to show FPS on screen
 	SCR_DrawFPS ();
+	PROF_DRAWGRAPH ();
 	SCR_CheckDrawCenterString ();
 	SCR_CheckDrawUseString ();
 	HUD_Draw ();
@@ -1642,6 +1646,8 @@ void SCR_UpdateScreen (void)
 
 	Draw_LoadingFill();
 
+	PROF_END (SCR_2D);
+
 	V_UpdatePalette ();
 
 	GL_EndRendering ();
@@ -22,8 +22,16 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <windows.h>
 #endif
 
+#ifdef __linux__
+// the headless linux server links no GL, the model loader only needs these
+typedef unsigned int	GLenum;
+typedef float			GLfloat;
+#define GL_LINEAR					0x2601
+#define GL_LINEAR_MIPMAP_NEAREST	0x2701
+#else
 #include <GL/gl.h>
 #include <GL/glu.h>
+#endif // __linux__
 
 void GL_BeginRendering (int *x, int *y, int *width, int *height);
 void GL_EndRendering (void);
@@ -298,6 +306,8 @@ extern	const char *gl_extensions;
 
 void R_TranslatePlayerSkin (int playernum);
 void GL_Bind (int texnum);
+void GL_SubdivideSurface (msurface_t *fa);
+void GL_MakeAliasModelDisplayLists (model_t *m, aliashdr_t *hdr);
 
 // Multitexture
 #define    TEXTURE0_SGIS				0x835E
@@ -331,6 +341,7 @@ void Fog_Init (void);
 void Fog_SetupState (void);
 
 void Sky_Init (void);
+void Sky_LoadSkyBox (char *name);
 void Sky_NewMap (void);
 
 qboolean VID_Is8bit(void);
@@ -18,7 +18,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 */
 #include "../quakedef.h"
-#include <sys/dirent.h>
+#include <dirent.h>
 
 extern cvar_t	r_wateralpha;
 extern cvar_t	r_vsync;
@@ -993,11 +993,8 @@ void Map_Finder(void)
 	struct dirent *dp;
     DIR *dir = opendir(va("%s/maps", com_gamedir)); // Open the directory - dir contains a pointer to manage the dir
 
-	if(dir < 0)
-	{
-		Sys_Error ("Map_Finder");
-		return;
-	}
+	if(dir == NULL)
+		return;		// no maps/ directory, nothing to list
 
 	for (int i = 0; i < 50; i++) {
 		custom_maps[i].occupied = false;
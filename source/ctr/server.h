@@ -43,6 +43,8 @@ typedef struct
 	
 	int			lastcheck;			// used by PF_checkclient
 	double		lastchecktime;
+
+	int			round;				// pr_global_struct->rounds, for SV_CheckRound
 	
 	char		name[64];			// map name
 #ifdef QUAKE2
@@ -100,6 +102,7 @@ typedef struct client_s
 		
 	float			ping_times[NUM_PING_TIMES];
 	int				num_pings;			// ping_times[num_pings%NUM_PING_TIMES]
+	int				lastmove;			// clc_move sequence, echoed in svc_moveack
 
 // spawn parms are carried from level to level
 	float			spawn_parms[NUM_SPAWN_PARMS];
@@ -248,6 +251,7 @@ void SV_ClientPrintf (char *fmt, ...);
 void SV_BroadcastPrintf (char *fmt, ...);
 
 void SV_Physics (void);
+void SV_CheckRound (void);
 
 qboolean SV_CheckBottom (edict_t *ent);
 qboolean SV_movestep (edict_t *ent, vec3_t move, qboolean relink);
@@ -120,9 +120,16 @@ void Sys_FileSeek (int handle, int position)
 	fseek (sys_handles[handle], position, SEEK_SET);
 }
 
+int sys_bytesread;
+
 int Sys_FileRead (int handle, void *dest, int count)
 {
-	return fread (dest, 1, count, sys_handles[handle]);
+	int		r;
+
+	r = fread (dest, 1, count, sys_handles[handle]);
+	sys_bytesread += r;
+
+	return r;
 }
 
 int Sys_FileWrite (int handle, void *data, int count)
@@ -130,6 +137,160 @@ int Sys_FileWrite (int handle, void *data, int count)
 	return fwrite (data, 1, count, sys_handles[handle]);
 }
 
+/*
+================
+Sys_FileReadAt
+
+There is no pread here, so the seek and read are done under a lock
+================
+*/
+static LightLock	sys_filelock;	// made by Sys_Init
+
+int Sys_FileReadAt (int handle, int position, void *dest, int count)
+{
+	int		r;
+
+	LightLock_Lock (&sys_filelock);
+	fseek (sys_handles[handle], position, SEEK_SET);
+	r = fread (dest, 1, count, sys_handles[handle]);
+	sys_bytesread += r;
+	LightLock_Unlock (&sys_filelock);
+
+	return r;
+}
+
+void *Sys_FileMap (int handle, int position, int length)
+{
+	return NULL;
+}
+
+void Sys_FileUnmap (void *data, int position, int length)
+{
+}
+
+/*
+===============================================================================
+
+THREADS
+
+===============================================================================
+*/
+
+typedef struct
+{
+	void	(*func) (void *);
+	void	*arg;
+} threadstart_t;
+
+static void Sys_ThreadStart (void *data)
+{
+	threadstart_t	start;
+
+	start = *(threadstart_t *)data;
+	free (data);
+	start.func (start.arg);
+}
+
+void *Sys_CreateThread (void (*func) (void *), void *arg)
+{
+	threadstart_t	*start;
+	Thread			thread;
+	s32				prio;
+
+	start = malloc (sizeof(*start));
+	if (!start)
+		return NULL;
+	start->func = func;
+	start->arg = arg;
+
+	// above the main thread, so it gets to issue its next read as soon as
+	// the last one completes
+	svcGetThreadPriority (&prio, CUR_THREAD_HANDLE);
+	thread = threadCreate (Sys_ThreadStart, start, 64 * 1024, prio - 1, -2, true);
+	if (!thread)
+	{
+		free (start);
+		return NULL;
+	}
+
+	return thread;
+}
+
+void *Sys_CreateSemaphore (int count)
+{
+	LightSemaphore	*sem;
+
+	sem = malloc (sizeof(*sem));
+	if (!sem)
+		Sys_Error ("Sys_CreateSemaphore: out of memory");
+	LightSemaphore_Init (sem, count, 0x7fff);
+
+	return sem;
+}
+
+void Sys_SemaphoreWait (void *sem)
+{
+	LightSemaphore_Acquire (sem, 1);
+}
+
+void Sys_SemaphorePost (void *sem)
+{
+	LightSemaphore_Release (sem, 1);
+}
+
+void *Sys_CreateWorker (void (*func) (void *), void *arg)
+{
+	threadstart_t	*start;
+	Thread			thread;
+	s32				prio;
+
+	start = malloc (sizeof(*start));
+	if (!start)
+		return NULL;
+	start->func = func;
+	start->arg = arg;
+
+	// the New 3DS gives applications core 2, elsewhere the worker shares
+	// the main thread's core and only runs while it waits
+	svcGetThreadPriority (&prio, CUR_THREAD_HANDLE);
+	thread = threadCreate (Sys_ThreadStart, start, 256 * 1024, prio + 1, new3ds_flag ? 2 : -2, true);
+	if (!thread)
+	{
+		free (start);
+		return NULL;
+	}
+
+	return thread;
+}
+
+int Sys_NumCores (void)
+{
+	return new3ds_flag ? 2 : 1;
+}
+
+qboolean Sys_MainThread (void)
+{
+	// libctru only knows the threads it created
+	return threadGetCurrent () == NULL;
+}
+
+unsigned long Sys_ThreadId (void)
+{
+	return (unsigned long)threadGetCurrent ();
+}
+
+/*
+================
+Sys_Init
+
+Before any other thread is started
+================
+*/
+void Sys_Init (void)
+{
+	LightLock_Init (&sys_filelock);
+}
+
 int     Sys_FileTime (char *path)
 {
 	FILE    *f;
@@ -203,6 +364,16 @@ double Sys_FloatTime (void)
 	return (current_tick - initial_tick)/TICKS_PER_SEC;
 }
 
+unsigned long long Sys_Ticks (void)
+{
+	return svcGetSystemTick ();
+}
+
+double Sys_TickRate (void)
+{
+	return TICKS_PER_SEC;
+}
+
 char *Sys_ConsoleInput (void)
 {
 	return NULL;
@@ -318,6 +489,7 @@ int main (int argc, char **argv)
 	parms.basedir = ".";
 
 	COM_InitArgv (argc, argv);
+	Sys_Init ();
 
 	parms.argc = com_argc;
 	parms.argv = com_argv;
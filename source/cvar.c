@@ -23,7 +23,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 
-static cvar_t	*cvar_vars;
+#define	CVAR_HASHSIZE	256			// must be a power of two
+
+static cvar_t	*cvar_vars;				// in alphabetical order
+static cvar_t	*cvar_hash[CVAR_HASHSIZE];	// names are still case sensitive
 static char	cvar_null_string[] = "";
 
 //==============================================================================
@@ -249,7 +252,7 @@ cvar_t *Cvar_FindVar (const char *var_name)
 {
 	cvar_t	*var;
 
-	for (var = cvar_vars ; var ; var = var->next)
+	for (var = cvar_hash[Cmd_HashName (var_name) & (CVAR_HASHSIZE - 1)] ; var ; var = var->hashnext)
 	{
 		if (!strcmp(var_name, var->name))
 			return var;
@@ -534,6 +537,7 @@ void Cvar_RegisterVariable (cvar_t *variable)
 	char	value[512];
 	qboolean	set_rom;
 	cvar_t	*cursor,*prev; //johnfitz -- sorted list insert
+	unsigned	h;
 
 // first check to see if it has already been defined
 	if (Cvar_FindVar (variable->name))
@@ -570,6 +574,9 @@ void Cvar_RegisterVariable (cvar_t *variable)
 		prev->next = variable;
 	}
 	//johnfitz
+	h = Cmd_HashName (variable->name) & (CVAR_HASHSIZE - 1);
+	variable->hashnext = cvar_hash[h];
+	cvar_hash[h] = variable;
 	variable->flags |= CVAR_REGISTERED;
 
 // copy the value off, because future sets will Z_Free it
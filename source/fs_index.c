@@ -0,0 +1,321 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// fs_index.c -- hashed index of every file in the search path
+//
+// The pak directories and a single scan of each game directory are folded
+// into one table, so finding a file no longer walks the search path doing
+// a strcmp per pak entry and a failed open per directory.  Names hash with
+// case and slash direction folded, the way the memory card filesystems
+// match them.  Every file is also chained by its name without extension,
+// so a loader that accepts several image formats resolves in one probe.
+
+#include "quakedef.h"
+#include "fs_index.h"
+
+#include <dirent.h>
+#include <sys/stat.h>
+
+#define	FS_HASHSIZE		4096		// must be a power of two
+#define	FS_BLOCKSIZE	32768
+#define	FS_MAXDEPTH		16
+
+typedef struct fsblock_s
+{
+	struct fsblock_s	*next;
+	int					used;
+	byte				data[FS_BLOCKSIZE];
+} fsblock_t;
+
+static	fsentry_t	*fs_hash[FS_HASHSIZE];
+static	fsentry_t	*fs_stems[FS_HASHSIZE];
+static	fsblock_t	*fs_blocks;
+static	int			fs_count;
+
+static int FS_Fold (int c)
+{
+	if (c == '\\')
+		return '/';
+	if (c >= 'A' && c <= 'Z')
+		return c + ('a' - 'A');
+	return c;
+}
+
+static unsigned FS_Hash (char *s, int len)
+{
+	unsigned	h;
+
+	for (h = 0 ; len > 0 && *s ; s++, len--)
+		h = h * 31 + FS_Fold (*s);
+
+	return h & (FS_HASHSIZE - 1);
+}
+
+static qboolean FS_Match (char *a, char *b, int len)
+{
+	for ( ; len > 0 ; a++, b++, len--)
+	{
+		if (FS_Fold (*a) != FS_Fold (*b))
+			return false;
+		if (!*a)
+			return true;
+	}
+
+	return true;
+}
+
+static int FS_StemLength (char *name)
+{
+	char	*s, *dot;
+
+	dot = NULL;
+	for (s = name ; *s ; s++)
+	{
+		if (*s == '.')
+			dot = s;
+		else if (*s == '/' || *s == '\\')
+			dot = NULL;
+	}
+
+	return dot ? dot - name : s - name;
+}
+
+static void *FS_Alloc (int size)
+{
+	fsblock_t	*block;
+	void		*p;
+
+	size = (size + 7) & ~7;
+
+	if (!fs_blocks || fs_blocks->used + size > FS_BLOCKSIZE)
+	{
+		block = malloc (sizeof(fsblock_t));
+		if (!block)
+			Sys_Error ("FS_Alloc: out of memory after %i files", fs_count);
+		block->next = fs_blocks;
+		block->used = 0;
+		fs_blocks = block;
+	}
+
+	p = fs_blocks->data + fs_blocks->used;
+	fs_blocks->used += size;
+
+	return p;
+}
+
+/*
+================
+FS_ClearIndex
+================
+*/
+void FS_ClearIndex (void)
+{
+	fsblock_t	*block;
+
+	while (fs_blocks)
+	{
+		block = fs_blocks->next;
+		free (fs_blocks);
+		fs_blocks = block;
+	}
+
+	memset (fs_hash, 0, sizeof(fs_hash));
+	memset (fs_stems, 0, sizeof(fs_stems));
+	fs_count = 0;
+}
+
+/*
+================
+FS_IndexFile
+================
+*/
+void FS_IndexFile (void *source, char *name, int filepos, int filelen)
+{
+	fsentry_t	*e;
+	unsigned	h;
+	int			len;
+
+	len = strlen (name);
+	if (len >= FS_BLOCKSIZE / 2)
+		return;
+
+	e = FS_Alloc (sizeof(fsentry_t));
+	e->name = FS_Alloc (len + 1);
+	memcpy (e->name, name, len + 1);
+	e->source = source;
+	e->filepos = filepos;
+	e->filelen = filelen;
+	e->stemlen = FS_StemLength (name);
+
+	// in front, so it shadows whatever the older sources had
+	h = FS_Hash (name, len);
+	e->hashnext = fs_hash[h];
+	fs_hash[h] = e;
+
+	h = FS_Hash (name, e->stemlen);
+	e->stemnext = fs_stems[h];
+	fs_stems[h] = e;
+
+	fs_count++;
+}
+
+/*
+================
+FS_ScanDirectory
+================
+*/
+static int FS_ScanDirectory (void *source, char *root, char *rel, int depth)
+{
+	char			path[MAX_OSPATH], name[MAX_OSPATH], full[MAX_OSPATH];
+	DIR				*dir;
+	struct dirent	*de;
+	struct stat		st;
+	int				count;
+
+	if (rel[0])
+		snprintf (path, sizeof(path), "%s/%s", root, rel);
+	else
+		snprintf (path, sizeof(path), "%s", root);
+
+	dir = opendir (path);
+	if (!dir)
+		return 0;
+
+	count = 0;
+	while ((de = readdir (dir)) != NULL)
+	{
+		// skips . and .. along with hidden files
+		if (de->d_name[0] == '.')
+			continue;
+
+		if (rel[0])
+		{
+			if (snprintf (name, sizeof(name), "%s/%s", rel, de->d_name) >= sizeof(name))
+				continue;
+		}
+		else
+		{
+			if (snprintf (name, sizeof(name), "%s", de->d_name) >= sizeof(name))
+				continue;
+		}
+		if (snprintf (full, sizeof(full), "%s/%s", path, de->d_name) >= sizeof(full))
+			continue;
+
+		if (stat (full, &st) == -1)
+			continue;
+
+		if (S_ISDIR (st.st_mode))
+		{
+			if (depth < FS_MAXDEPTH)
+				count += FS_ScanDirectory (source, root, name, depth + 1);
+		}
+		else if (S_ISREG (st.st_mode))
+		{
+			FS_IndexFile (source, name, 0, st.st_size);
+			count++;
+		}
+	}
+
+	closedir (dir);
+
+	return count;
+}
+
+/*
+================
+FS_IndexDirectory
+================
+*/
+int FS_IndexDirectory (void *source, char *dir)
+{
+	return FS_ScanDirectory (source, dir, "", 0);
+}
+
+/*
+================
+FS_FindEntry
+================
+*/
+fsentry_t *FS_FindEntry (char *name, fsentry_t *after)
+{
+	fsentry_t	*e;
+	int			len;
+
+	len = strlen (name);
+
+	if (after)
+		e = after->hashnext;
+	else
+		e = fs_hash[FS_Hash (name, len)];
+
+	for ( ; e ; e = e->hashnext)
+		if (FS_Match (e->name, name, len + 1))
+			return e;
+
+	return NULL;
+}
+
+/*
+================
+FS_FindExtension
+================
+*/
+int FS_FindExtension (char *stem, char **exts, fsentry_t **entry)
+{
+	fsentry_t	*e, *best;
+	int			len, i, besti;
+
+	len = strlen (stem);
+	best = NULL;
+	besti = -1;
+
+	for (e = fs_stems[FS_Hash (stem, len)] ; e ; e = e->stemnext)
+	{
+		if (e->stemlen != len || e->name[len] != '.' || !FS_Match (e->name, stem, len))
+			continue;
+
+		// entries come newest source first, so only a better extension wins
+		for (i = 0 ; exts[i] && (besti == -1 || i < besti) ; i++)
+		{
+			if (FS_Match (e->name + len + 1, exts[i], strlen (exts[i]) + 1))
+			{
+				best = e;
+				besti = i;
+				break;
+			}
+		}
+		if (besti == 0)
+			break;
+	}
+
+	if (entry)
+		*entry = best;
+
+	return besti;
+}
+
+/*
+================
+FS_IndexCount
+================
+*/
+int FS_IndexCount (void)
+{
+	return fs_count;
+}
@@ -0,0 +1,50 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// fs_index.h -- hashed index of every file in the search path
+
+typedef struct fsentry_s
+{
+	struct fsentry_s	*hashnext;		// same name, case and slashes folded
+	struct fsentry_s	*stemnext;		// same name without the extension
+	void				*source;		// searchpath_t the file belongs to
+	int					filepos;		// offset in the pak, 0 for loose files
+	int					filelen;
+	int					stemlen;		// length of name without ".ext"
+	char				*name;			// as stored in the pak or on disk
+} fsentry_t;
+
+void FS_ClearIndex (void);
+
+// files added later take precedence over earlier ones with the same name,
+// so sources must be indexed from the back of the search path forwards
+void FS_IndexFile (void *source, char *name, int filepos, int filelen);
+
+// recursively adds every regular file below dir, returns the count
+int FS_IndexDirectory (void *source, char *dir);
+
+// a miss costs one hash probe, pass the previous result as after to reach
+// files it shadows
+fsentry_t *FS_FindEntry (char *name, fsentry_t *after);
+
+// looks for stem.ext for each ext in the NULL terminated list, in order,
+// with a single probe; returns the index of the extension found or -1
+int FS_FindExtension (char *stem, char **exts, fsentry_t **entry);
+
+int FS_IndexCount (void);
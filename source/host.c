@@ -19,6 +19,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // host.c -- coordinates spawning and killing of local servers
 
+#include <time.h>
+
 #include "quakedef.h"
 
 #ifdef __PSP__
@@ -28,6 +30,18 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <pspsysevent.h>
 #endif // __PSP__
 
+#include "net_vcr.h"
+
+#include "prefetch.h"
+#include "loadtrace.h"
+#include "arena.h"
+#include "jobs.h"
+#include "prof.h"
+
+#ifdef __linux__
+#include "cl_loadgen.h"
+#endif // __linux__
+
 /*
 
 A server can allways be started, even if the system started out as a client
@@ -65,6 +79,26 @@ cvar_t	host_speeds = {"host_speeds","0"};			// set for running times
 cvar_t	sys_ticrate = {"sys_ticrate","0.05"};
 cvar_t	serverprofile = {"serverprofile","0"};
 
+// With host_pipeline set a local server's tick runs on a thread of its own,
+// started once the client has read the last tick's messages off the
+// loopback and finished at the top of the next frame, so the next world
+// state is worked out while the client draws and mixes the one it has.
+// The client sees the world a frame later than it would otherwise.
+cvar_t	host_pipeline = {"host_pipeline","0"};
+
+static	void		*host_svthread;
+static	void		*host_svgo;			// posted to start a tick
+static	void		*host_svdone;		// posted when the tick has ended
+static	qboolean	host_svrunning;		// started and not yet waited for
+static	jmp_buf		host_svabort;
+static	char		host_sverror[1024];	// the Host_Error the tick ended with
+static	double		host_svstart, host_svend;
+static	double		host_svtick, host_svwaited;	// the last tick, for host_speeds
+static	void		(*host_svcall) (void);	// for the main thread to run, see Host_MainCall
+static	void		*host_svreply;		// posted when it has
+static	qboolean	host_svcalling;		// the main thread is running it
+static	jmp_buf		host_svcallabort;
+
 cvar_t	fraglimit = {"fraglimit","0",false,true};
 cvar_t	timelimit = {"timelimit","0",false,true};
 cvar_t	teamplay = {"teamplay","0",false,true};
@@ -141,11 +175,32 @@ void Host_Error (char *error, ...)
 	char		string[1024];
 	static	qboolean inerror = false;
 
+	// the server thread hands its errors to the main thread at the handoff
+	if (!Sys_MainThread ())
+	{
+		va_start (argptr,error);
+		vsnprintf (host_sverror,sizeof(host_sverror),error,argptr);
+		va_end (argptr);
+		longjmp (host_svabort, 1);
+	}
+
+	// as do the calls the main thread makes for it
+	if (host_svcalling)
+	{
+		va_start (argptr,error);
+		vsnprintf (host_sverror,sizeof(host_sverror),error,argptr);
+		va_end (argptr);
+		longjmp (host_svcallabort, 1);
+	}
+
 	if (inerror)
 		Sys_Error ("Host_Error: recursively entered");
 	inerror = true;
 
+	Host_WaitServerFrame ();
+
 	SCR_EndLoadingPlaque ();		// reenable screen updates
+	LoadTrace_Abort ();
 
 	va_start (argptr,error);
 	vsprintf (string,error,argptr);
@@ -234,6 +289,7 @@ void Host_InitLocal (void)
 
 	Cvar_RegisterVariable (&sys_ticrate);
 	Cvar_RegisterVariable (&serverprofile);
+	Cvar_RegisterVariable (&host_pipeline);
 
 #ifdef __PSP__
     Cvar_RegisterVariable (&show_bat); // Crow_bar battery info
@@ -292,6 +348,7 @@ void Host_WriteConfiguration (void)
 		Cvar_WriteVariables (f);
 
 		fclose (f);
+		COM_FileWritten ("config.cfg");
 	}
 }
 
@@ -441,6 +498,8 @@ void Host_ShutdownServer(qboolean crash)
 	char		message[4];
 	double	start;
 
+	Host_WaitServerFrame ();
+
 	if (!sv.active)
 		return;
 
@@ -559,7 +618,8 @@ qboolean Host_FilterTime (float time)
 	realtime += time;
 #ifndef __WII__
    if (cl_maxfps.value < 1) Cvar_SetValue("cl_maxfps", 30);
-   if (!cls.timedemo && realtime - oldrealtime < 1.0/cl_maxfps.value)
+   // dedicated servers are paced by sys_ticrate in the system loop
+   if (!cls.timedemo && cls.state != ca_dedicated && realtime - oldrealtime < 1.0/cl_maxfps.value)
 		return false;		// framerate is too high
 #else
 	if (!cls.timedemo && realtime - oldrealtime < 1.0f/72.0f)
@@ -595,7 +655,7 @@ void Host_GetConsoleCommands (void)
 
 	while (1)
 	{
-		cmd = Sys_ConsoleInput ();
+		cmd = VCR_ConsoleInput (Sys_ConsoleInput ());
 		if (!cmd)
 			break;
 		Cbuf_AddText (cmd);
@@ -611,25 +671,249 @@ Host_ServerFrame
 */
 void Host_ServerFrame (void)
 {
+	double	time1, time2, time3, time4;
+	double	times[VCR_NUM_TIMES];
+
+	PROF_BEGIN (Host_ServerFrame);
+
+	time1 = time2 = time3 = time4 = 0;
+
 // run the world state
 	pr_global_struct->frametime = host_frametime;
 
 // set the time and clear the general datagram
 	SV_ClearDatagram ();
 
+	if (vcr_playback)
+		time1 = Sys_FloatTime ();
+
 // check for new clients
 	SV_CheckForNewClients ();
 
 // read client messages
 	SV_RunClients ();
 
+	if (vcr_playback)
+		time2 = Sys_FloatTime ();
+
 // move things around and think
 // always pause in single player if in console or menus
 	if (!sv.paused && (svs.maxclients > 1 || key_dest == key_game) )
 		SV_Physics ();
 
+	if (vcr_playback)
+		time3 = Sys_FloatTime ();
+
 // send all messages to the clients
 	SV_SendClientMessages ();
+
+	if (vcr_playback)
+		time4 = Sys_FloatTime ();
+
+	Arena_Reset (&sv_arena);
+
+	times[VCR_TIME_NET] = time2 - time1;
+	times[VCR_TIME_PHYSICS] = time3 - time2;
+	times[VCR_TIME_SEND] = time4 - time3;
+	times[VCR_TIME_FRAME] = time4 - time1;
+	VCR_ServerFrame (times);
+
+	PROF_END (Host_ServerFrame);
+}
+
+/*
+==================
+Host_ServerThread
+==================
+*/
+static void Host_ServerThread (void *arg)
+{
+	while (1)
+	{
+		Sys_SemaphoreWait (host_svgo);
+
+		host_svstart = Sys_FloatTime ();
+		if (!setjmp (host_svabort))
+			Host_ServerFrame ();
+		host_svend = Sys_FloatTime ();
+
+		Sys_SemaphorePost (host_svdone);
+	}
+}
+
+/*
+==================
+Host_PipelineServer
+
+Whether this frame's server tick can run next to the client's drawing
+==================
+*/
+static qboolean Host_PipelineServer (void)
+{
+	if (!host_pipeline.value || !sv.active || cls.state == ca_dedicated)
+		return false;
+	if (vcr_playback || recording)
+		return false;		// the recordings are of one thread's order
+
+	if (!host_svthread)
+	{
+		if (!host_svgo)
+		{
+			host_svgo = Sys_CreateSemaphore (0);
+			host_svdone = Sys_CreateSemaphore (0);
+			host_svreply = Sys_CreateSemaphore (0);
+		}
+		Z_EnableLocking ();
+		host_svthread = Sys_CreateWorker (Host_ServerThread, NULL);
+		if (!host_svthread)
+		{
+			Con_Printf ("Couldn't start the server thread, host_pipeline is off\n");
+			Cvar_Set ("host_pipeline", "0");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+==================
+Host_StartServerFrame
+==================
+*/
+static void Host_StartServerFrame (void)
+{
+	host_sverror[0] = 0;
+	host_svrunning = true;
+	Sys_SemaphorePost (host_svgo);
+}
+
+/*
+==================
+Host_MainCall
+
+The files, the cvars, the command buffer and the model cache belong to the
+main thread. The tick hands what would touch them to it here and waits: the
+main thread runs func when it next waits for the tick, which is after it has
+drawn the frame, so a tick that does this doesn't overlap that frame.
+==================
+*/
+void Host_MainCall (void (*func) (void))
+{
+	if (Sys_MainThread ())
+	{
+		func ();
+		return;
+	}
+
+	host_svcall = func;
+	Sys_SemaphorePost (host_svdone);
+	Sys_SemaphoreWait (host_svreply);
+
+	if (host_sverror[0])
+		longjmp (host_svabort, 1);	// func hit a Host_Error
+}
+
+/*
+==================
+Host_RunMainCall
+==================
+*/
+static void Host_RunMainCall (void)
+{
+	host_svcalling = true;
+	if (!setjmp (host_svcallabort))
+		host_svcall ();
+	host_svcalling = false;
+	host_svcall = NULL;
+
+	Sys_SemaphorePost (host_svreply);
+}
+
+/*
+==================
+Host_WaitServerFrame
+
+Anything that changes the server from the main thread waits for the tick
+first
+==================
+*/
+void Host_WaitServerFrame (void)
+{
+	double	start;
+
+	if (!host_svrunning)
+		return;
+
+	start = Sys_FloatTime ();
+	while (1)
+	{
+		Sys_SemaphoreWait (host_svdone);
+		if (!host_svcall)
+			break;
+		Host_RunMainCall ();
+	}
+	host_svrunning = false;
+
+	host_svtick = host_svend - host_svstart;
+	host_svwaited = Sys_FloatTime () - start;
+}
+
+/*
+==================
+Host_CopyLocalServer
+
+What the renderer reads of the local server, taken between ticks so that a
+pipelined one can't free or rewrite it while the HUD draws
+==================
+*/
+static void Host_CopyLocalServer (void)
+{
+	edict_t	*ent;
+
+	cl.svtime = sv.time;
+	if (!sv.active || cls.state == ca_dedicated)
+		return;
+
+	ent = svs.clients[0].edict;		// the local client is always the first
+	if (!ent)
+		return;
+	Q_strncpyz (cl.weaponname, pr_strings + ent->v.Weapon_Name, sizeof(cl.weaponname));
+	Q_strncpyz (cl.touchname, pr_strings + ent->v.Weapon_Name_Touch, sizeof(cl.touchname));
+	cl.facingenemy = ent->v.facingenemy;
+	cl.viewofs = ent->v.view_ofs[2];
+	VectorCopy (ent->v.ADS_Offset, cl.adsoffset);
+}
+
+/*
+==================
+Host_FinishServerFrame
+
+The handoff, the main thread takes the server back at a message boundary:
+what the tick printed is shown, an error it hit is raised again here, and
+the cache work that has to happen on this thread is done
+==================
+*/
+static void Host_FinishServerFrame (void)
+{
+	char	error[sizeof(host_sverror)];
+
+	if (!host_svrunning)
+		return;
+
+	Host_WaitServerFrame ();
+	Con_FlushDeferred ();
+
+	if (host_sverror[0])
+	{
+		strlcpy (error, host_sverror, sizeof(error));
+		host_sverror[0] = 0;
+		Host_Error ("%s", error);
+	}
+
+	if (sv.active)
+		SV_CheckRound ();
+	Host_CopyLocalServer ();
 }
 
 /*
@@ -644,12 +928,17 @@ void _Host_Frame (float time)
 	static double		time1 = 0;
 	static double		time2 = 0;
 	static double		time3 = 0;
-	int			pass1, pass2, pass3;
+	int			pass1, pass2, pass3, tick, overlap;
+	qboolean	pipelined;
 
 	if (setjmp (host_abortserver) )
 	{
 		return;			// something bad happened, or the server disconnected
 	}
+
+// take the server back from last frame's tick
+	Host_FinishServerFrame ();
+	Con_FlushDeferred ();
 	
 // keep the random time dependent
 	rand ();
@@ -660,6 +949,10 @@ void _Host_Frame (float time)
 		return;			// don't run too fast, or packets will flood out
 	}
 
+// the profiler's frames start here, with the server thread idle
+	PROF_FRAME ();
+	CL_TimeDemoFrame ();
+
 // get new key events
 	Sys_SendKeyEvents ();
 
@@ -671,6 +964,11 @@ void _Host_Frame (float time)
 
 	NET_Poll();
 
+#ifdef __linux__
+// synthetic clients for load testing
+	LoadGen_Frame ();
+#endif // __linux__
+
 // if running the server locally, make intentions now
 	if (sv.active)
 		CL_SendCmd ();
@@ -683,8 +981,16 @@ void _Host_Frame (float time)
 
 // check for commands typed to the host
 	Host_GetConsoleCommands ();
-	if (sv.active)
+
+// a pipelined tick starts once the client has read the last one's messages
+	pipelined = Host_PipelineServer ();
+	if (sv.active && !pipelined)
+	{
 		Host_ServerFrame ();
+	// keep what the next round needs cached
+		SV_CheckRound ();
+		Host_CopyLocalServer ();
+	}
 //-------------------
 //
 // client operations
@@ -703,10 +1009,15 @@ void _Host_Frame (float time)
 	{
 		CL_ReadFromServer ();
 	}
+
+	if (pipelined)
+		Host_StartServerFrame ();
+
 // update video
 	if (host_speeds.value)
 		time1 = Sys_FloatTime ();
 	SCR_UpdateScreen ();
+	Arena_Reset (&cl_arena);
 	if (host_speeds.value)
 		time2 = Sys_FloatTime ();
 // update audio
@@ -724,12 +1035,21 @@ void _Host_Frame (float time)
 		time3 = Sys_FloatTime ();
 		pass2 = (time2 - time1)*1000;
 		pass3 = (time3 - time2)*1000;
-		Con_Printf ("%3i tot %3i server %3i gfx %3i snd\n",
-					pass1+pass2+pass3, pass1, pass2, pass3);
+		if (pipelined)
+		{
+		// the last tick, and how much of it the client didn't wait for
+			tick = host_svtick*1000;
+			overlap = (host_svtick - host_svwaited)*1000;
+			Con_Printf ("%3i tot %3i server %3i gfx %3i snd %3i tick %3i overlap\n",
+						pass1+pass2+pass3, pass1, pass2, pass3, tick, overlap > 0 ? overlap : 0);
+		}
+		else
+			Con_Printf ("%3i tot %3i server %3i gfx %3i snd\n",
+						pass1+pass2+pass3, pass1, pass2, pass3);
 	}
 
-	// Debug log free memory
-	// if ((host_framecount % 120) == 0) Con_Printf ("%.2fkB free \n", pspSdkTotalFreeUserMemSize()/1024.f);
+	// per frame allocation rates and mem_log
+	Memory_Frame ();
 
 	//frame speed counter
 	fps_count++;//muff
@@ -745,6 +1065,8 @@ void Host_Frame (float time)
 	static int		timecount;
 	int		i, c, m;
 
+	time = VCR_FrameTime (time);
+
 	if (!serverprofile.value)
 	{
 		_Host_Frame (time);
@@ -776,13 +1098,9 @@ void Host_Frame (float time)
 //============================================================================
 
 
-extern int vcrFile;
-#define	VCR_SIGNATURE	0x56435231
-// "VCR1"
-
 void Host_InitVCR (quakeparms_t *parms)
 {
-	int		i, len, n;
+	int		i, len, n, seed;
 	char	*p;
 
 	if (COM_CheckParm("-playback"))
@@ -799,7 +1117,7 @@ void Host_InitVCR (quakeparms_t *parms)
 			Sys_Error("Invalid signature in vcr file\n");
 
 		Sys_FileRead (vcrFile, &com_argc, sizeof(int));
-		com_argv = Q_malloc(com_argc * sizeof(char *));
+		com_argv = Q_malloc((com_argc + 1) * sizeof(char *));
 		com_argv[0] = parms->argv[0];
 		for (i = 0; i < com_argc; i++)
 		{
@@ -811,6 +1129,10 @@ void Host_InitVCR (quakeparms_t *parms)
 		com_argc++; /* add one for arg[0] */
 		parms->argc = com_argc;
 		parms->argv = com_argv;
+
+		// rand() drives QC random() and the physics, replay the same sequence
+		Sys_FileRead (vcrFile, &seed, sizeof(int));
+		srand (seed);
 	}
 
 	if ( (n = COM_CheckParm("-record")) != 0)
@@ -834,6 +1156,10 @@ void Host_InitVCR (quakeparms_t *parms)
 			Sys_FileWrite(vcrFile, &len, sizeof(int));
 			Sys_FileWrite(vcrFile, com_argv[i], len);
 		}
+
+		seed = time (NULL);
+		Sys_FileWrite (vcrFile, &seed, sizeof(int));
+		srand (seed);
 	}
 
 }
@@ -890,21 +1216,35 @@ void Host_Init (quakeparms_t *parms)
 	com_argc = parms->argc;
 	com_argv = parms->argv;
 
+	LoadTrace_Begin ("Host_Init", NULL);
+
 	Memory_Init (parms->membase, parms->memsize);
 	Cbuf_Init ();
 	Cmd_Init ();
 	V_Init ();
 	Chase_Init ();
 	Host_InitVCR (parms);
+	LoadTrace_Begin ("COM_Init", NULL);
 	COM_Init (parms->basedir);
+	LoadTrace_End ();
 	Host_InitLocal ();
 	Key_Init ();
 	Con_Init ();
 	M_Init ();
 	PR_Init ();
 	Mod_Init ();
+	Prefetch_Init ();
+	LoadTrace_Init ();
+	Arena_Init ();
+	Jobs_Init ();
+	PROF_INIT ();
+	LoadTrace_Begin ("NET_Init", NULL);
 	NET_Init ();
+	LoadTrace_End ();
 	SV_Init ();
+#ifdef __linux__
+	LoadGen_Init ();
+#endif // __linux__
 
 #ifdef __PSP__
 	Con_Printf ("PSP NZP v%4.1f (PBP: "__TIME__" "__DATE__")\n", (float)(VERSION));
@@ -927,7 +1267,9 @@ void Host_Init (quakeparms_t *parms)
 		Con_Printf ("3DS Model: Nintendo 3DS\n");
 #elif __WII__
 	Con_Printf ("WII NZP v%4.1f (DOL: "__TIME__" "__DATE__")\n", (float)(VERSION));
-#endif // __PSP__, _3DS
+#elif __linux__
+	Con_Printf ("Linux NZP dedicated server v%4.1f ("__TIME__" "__DATE__")\n", (float)(VERSION));
+#endif // __PSP__, _3DS, __WII__, __linux__
 
 	Con_Printf ("%4.1f megabyte Quake hunk \n",parms->memsize/ (1024*1024.0));
 
@@ -954,11 +1296,19 @@ void Host_Init (quakeparms_t *parms)
 #ifndef __WII__
 		IN_Init ();
 #endif
+		LoadTrace_Begin ("VID_Init", NULL);
 		VID_Init (host_basepal);
+		LoadTrace_End ();
+		LoadTrace_Begin ("Draw_Init", NULL);
 		Draw_Init ();
+		LoadTrace_End ();
 		SCR_Init ();
+		LoadTrace_Begin ("R_Init", NULL);
 		R_Init ();
+		LoadTrace_End ();
+		LoadTrace_Begin ("S_Init", NULL);
 		S_Init ();
+		LoadTrace_End ();
 		CDAudio_Init ();
 		HUD_Init ();
 		CL_Init ();
@@ -966,7 +1316,9 @@ void Host_Init (quakeparms_t *parms)
 		IN_Init ();
 #endif //the Wii requires initialization of input AFTER client is initializd 
 	}
+	LoadTrace_Begin ("Preload", NULL);
 	Preload();
+	LoadTrace_End ();
 	Cbuf_InsertText ("exec nzp.rc\n");
 
 	Hunk_AllocName (0, "-HOST_HUNKLEVEL-");
@@ -976,7 +1328,9 @@ void Host_Init (quakeparms_t *parms)
 #ifdef __WII__
 	VIDEO_SetBlack(false);
 #endif
-	M_Start_Menu_f();
+	if (cls.state != ca_dedicated)
+		M_Start_Menu_f();
+	LoadTrace_End ();
 	Sys_Printf ("========Nazi Zombies Portable Initialized=========\n");	
 }
 
@@ -1014,6 +1368,9 @@ void Host_Shutdown(void)
 #endif // __PSP__
 
 	CDAudio_Shutdown ();
+#ifdef __linux__
+	LoadGen_Shutdown ();
+#endif // __linux__
 	NET_Shutdown ();
 	S_Shutdown();
 	IN_Shutdown ();
@@ -392,6 +392,53 @@ LOAD / SAVE GAME
 
 #define	SAVEGAME_VERSION	5
 
+// the binary format, told apart from a text save by its first four bytes
+#define	SAVEGAME_MAGIC		(('S'<<24)+('P'<<16)+('Z'<<8)+'N')	// "NZPS"
+#define	SAVEGAME_SWAPPED	(('N'<<24)+('Z'<<16)+('P'<<8)+'S')	// written the other way round
+#define	SAVEGAME_BINARY		1
+#define	SAVEGAME_HASHSIZE	1024		// must be a power of two
+#define	SAVEGAME_MAXSLOTS	65536		// globals or fields, past it the header is garbage
+
+typedef struct
+{
+	int		magic;
+	int		version;
+	int		crc;					// of the progs the layout below is from
+	int		entityfields;
+	int		numglobals;				// the DEF_SAVEGLOBAL values
+	int		numedicts;
+	int		stringsize;
+	char	comment[SAVEGAME_COMMENT_LENGTH+1];
+	float	spawn_parms[NUM_SPAWN_PARMS];
+	int		skill;
+	char	mapname[MAX_QPATH];
+	float	time;
+	int		lightstyles[MAX_LIGHTSTYLES];	// offsets into the strings
+} savegame_t;
+
+// after the header come the globals, then each edict as its free flag and
+// its fields, then the strings.  A string is an offset into the progs'
+// strings when it is one of them, or -1 - its offset in the save's own, and
+// an entity is its number rather than a pointer.
+
+typedef struct
+{
+	int		*strings;				// field offsets
+	int		numstrings;
+	int		*entities;
+	int		numentities;
+	ddef_t	**globals;				// what a text save keeps
+	int		numglobals;
+} savelayout_t;
+
+typedef struct
+{
+	char	*data;
+	int		size, maxsize;
+	int		*hash;					// -1 ended chains of offsets into data
+	int		*next;					// by the offset the chain is at
+} savestrings_t;
+
 /*
 ===============
 Host_SavegameComment
@@ -425,6 +472,276 @@ void Host_SavegameComment (char *text)
 	text[SAVEGAME_COMMENT_LENGTH] = '\0';
 }
 
+/*
+===============
+Host_SaveLayout
+
+Where the strings and entities are in an edict's fields, and the globals a
+save keeps, from the loaded progs
+===============
+*/
+static qboolean Host_SaveLayout (savelayout_t *l)
+{
+	byte	*kind;
+	ddef_t	*d;
+	int		i, type;
+
+	memset (l, 0, sizeof(*l));
+	l->strings = malloc (progs->entityfields * sizeof(int) * 2);
+	l->globals = malloc (progs->numglobaldefs * sizeof(ddef_t *));
+	kind = malloc (progs->entityfields);
+	if (!l->strings || !l->globals || !kind)
+	{
+		free (l->strings);
+		free (l->globals);
+		free (kind);
+		return false;
+	}
+	l->entities = l->strings + progs->entityfields;
+
+// a vector's _x, _y and _z share its slots, the first def of a slot wins
+	memset (kind, ev_void, progs->entityfields);
+	for (i=1 ; i<progs->numfielddefs ; i++)
+	{
+		d = &pr_fielddefs[i];
+		type = d->type & ~DEF_SAVEGLOBAL;
+		if (d->ofs >= progs->entityfields || kind[d->ofs] != ev_void)
+			continue;
+		if (type == ev_string)
+			l->strings[l->numstrings++] = d->ofs;
+		else if (type == ev_entity)
+			l->entities[l->numentities++] = d->ofs;
+		else
+			continue;
+		kind[d->ofs] = type;
+	}
+	free (kind);
+
+	for (i=0 ; i<progs->numglobaldefs ; i++)
+	{
+		d = &pr_globaldefs[i];
+		if (!(d->type & DEF_SAVEGLOBAL))
+			continue;
+		type = d->type & ~DEF_SAVEGLOBAL;
+		if (type == ev_string || type == ev_float || type == ev_entity)
+			l->globals[l->numglobals++] = d;
+	}
+
+	return true;
+}
+
+static void Host_FreeLayout (savelayout_t *l)
+{
+	free (l->strings);
+	free (l->globals);
+}
+
+/*
+===============
+Host_SaveString
+
+The offset of s in the save's strings, each one kept once
+===============
+*/
+static int Host_SaveString (savestrings_t *st, char *s)
+{
+	unsigned	h;
+	int			i, len;
+	void		*p;
+
+	for (h = 0, i = 0 ; s[i] ; i++)
+		h = h * 31 + (byte)s[i];
+	h &= SAVEGAME_HASHSIZE - 1;
+	len = i + 1;
+
+	for (i = st->hash[h] ; i >= 0 ; i = st->next[i])
+		if (!strcmp (st->data + i, s))
+			return i;
+
+	if (st->size + len > st->maxsize)
+	{
+		st->maxsize = (st->size + len) * 2;
+		p = realloc (st->data, st->maxsize);
+		if (!p)
+			Sys_Error ("Host_SaveString: out of memory");
+		st->data = p;
+		p = realloc (st->next, st->maxsize * sizeof(int));
+		if (!p)
+			Sys_Error ("Host_SaveString: out of memory");
+		st->next = p;
+	}
+
+	i = st->size;
+	memcpy (st->data + i, s, len);
+	st->size += len;
+	st->next[i] = st->hash[h];
+	st->hash[h] = i;
+
+	return i;
+}
+
+/*
+===============
+Host_SaveStringRef
+===============
+*/
+static int Host_SaveStringRef (savestrings_t *st, string_t s)
+{
+	if (s >= 0 && s < progs->numstrings)
+		return s;
+	return -1 - Host_SaveString (st, pr_strings + s);
+}
+
+/*
+===============
+Host_LoadStringRef
+
+What Host_SaveStringRef wrote, back as an offset from pr_strings
+===============
+*/
+static string_t Host_LoadStringRef (int s, char *strings, int size)
+{
+	if (s >= 0)
+		return s < progs->numstrings ? s : 0;
+	if (-1 - s >= size)
+		return 0;
+	return strings + (-1 - s) - pr_strings;
+}
+
+/*
+===============
+Host_WriteTextSave
+
+The version 5 text format, every field by name
+===============
+*/
+static void Host_WriteTextSave (FILE *f)
+{
+	int		i;
+	char	comment[SAVEGAME_COMMENT_LENGTH+1];
+
+	fprintf (f, "%i\n", SAVEGAME_VERSION);
+	Host_SavegameComment (comment);
+	fprintf (f, "%s\n", comment);
+	for (i=0 ; i<NUM_SPAWN_PARMS ; i++)
+		fprintf (f, "%f\n", svs.clients->spawn_parms[i]);
+	fprintf (f, "%d\n", current_skill);
+	fprintf (f, "%s\n", sv.name);
+	fprintf (f, "%f\n",sv.time);
+
+// write the light styles
+
+	for (i=0 ; i<MAX_LIGHTSTYLES ; i++)
+	{
+		if (sv.lightstyles[i])
+			fprintf (f, "%s\n", sv.lightstyles[i]);
+		else
+			fprintf (f,"m\n");
+	}
+
+
+	ED_WriteGlobals (f);
+	for (i=0 ; i<sv.num_edicts ; i++)
+	{
+		ED_Write (f, EDICT_NUM(i));
+		fflush (f);
+	}
+}
+
+/*
+===============
+Host_WriteBinarySave
+
+The edicts' fields as they are, with their strings and entities made
+independent of where they were in memory
+===============
+*/
+static qboolean Host_WriteBinarySave (FILE *f)
+{
+	savegame_t		header;
+	savelayout_t	l;
+	savestrings_t	st;
+	edict_t			*ent;
+	int				*data, *v, *out;
+	int				i, j, count;
+	ddef_t			*d;
+
+	if (!Host_SaveLayout (&l))
+		return false;
+
+	count = l.numglobals + sv.num_edicts * (1 + progs->entityfields);
+	data = malloc (count * sizeof(int));
+	memset (&st, 0, sizeof(st));
+	st.hash = malloc (SAVEGAME_HASHSIZE * sizeof(int));
+	if (!data || !st.hash)
+	{
+		free (data);
+		free (st.hash);
+		Host_FreeLayout (&l);
+		return false;
+	}
+	for (i=0 ; i<SAVEGAME_HASHSIZE ; i++)
+		st.hash[i] = -1;
+
+	memset (&header, 0, sizeof(header));
+	header.magic = SAVEGAME_MAGIC;
+	header.version = SAVEGAME_BINARY;
+	header.crc = pr_crc;
+	header.entityfields = progs->entityfields;
+	header.numglobals = l.numglobals;
+	header.numedicts = sv.num_edicts;
+	Host_SavegameComment (header.comment);
+	for (i=0 ; i<NUM_SPAWN_PARMS ; i++)
+		header.spawn_parms[i] = svs.clients->spawn_parms[i];
+	header.skill = current_skill;
+	Q_strncpyz (header.mapname, sv.name, sizeof(header.mapname));
+	header.time = sv.time;
+	for (i=0 ; i<MAX_LIGHTSTYLES ; i++)
+		header.lightstyles[i] = Host_SaveString (&st, sv.lightstyles[i] ? sv.lightstyles[i] : "m");
+
+	out = data;
+	for (i=0 ; i<l.numglobals ; i++, out++)
+	{
+		d = l.globals[i];
+		*out = ((int *)pr_globals)[d->ofs];
+		if ((d->type & ~DEF_SAVEGLOBAL) == ev_string)
+			*out = Host_SaveStringRef (&st, *out);
+		else if ((d->type & ~DEF_SAVEGLOBAL) == ev_entity)
+			*out /= pr_edict_size;
+	}
+
+	for (i=0 ; i<sv.num_edicts ; i++)
+	{
+		ent = EDICT_NUM(i);
+		*out++ = ent->free;
+		v = out;
+		out += progs->entityfields;
+		if (ent->free)
+		{
+			memset (v, 0, progs->entityfields * 4);
+			continue;
+		}
+
+		memcpy (v, &ent->v, progs->entityfields * 4);
+		for (j=0 ; j<l.numstrings ; j++)
+			v[l.strings[j]] = Host_SaveStringRef (&st, v[l.strings[j]]);
+		for (j=0 ; j<l.numentities ; j++)
+			v[l.entities[j]] /= pr_edict_size;
+	}
+
+	header.stringsize = st.size;
+	fwrite (&header, sizeof(header), 1, f);
+	fwrite (data, sizeof(int), count, f);
+	fwrite (st.data, 1, st.size, f);
+
+	free (data);
+	free (st.data);
+	free (st.next);
+	free (st.hash);
+	Host_FreeLayout (&l);
+
+	return true;
+}
 
 /*
 ===============
@@ -436,7 +753,7 @@ void Host_Savegame_f (void)
 	char	name[256];
 	FILE	*f;
 	int		i;
-	char	comment[SAVEGAME_COMMENT_LENGTH+1];
+	qboolean	text;
 
 	if (cmd_source != src_command)
 		return;
@@ -459,9 +776,10 @@ void Host_Savegame_f (void)
 		return;
 	}
 
-	if (Cmd_Argc() != 2)
+	text = Cmd_Argc() == 3 && !Q_strcasecmp (Cmd_Argv(2), "text");
+	if (Cmd_Argc() != 2 && !text)
 	{
-		Con_Printf ("save <savename> : save a game\n");
+		Con_Printf ("save <savename> [text] : save a game, text for the old format\n");
 		return;
 	}
 
@@ -484,43 +802,140 @@ void Host_Savegame_f (void)
 	COM_DefaultExtension (name, ".sav");
 
 	Con_Printf ("Saving game to %s...\n", name);
-	f = fopen (name, "w");
+	f = fopen (name, text ? "w" : "wb");
 	if (!f)
 	{
 		Con_Printf ("ERROR: couldn't open save file for writing.\n");
 		return;
 	}
 
-	fprintf (f, "%i\n", SAVEGAME_VERSION);
-	Host_SavegameComment (comment);
-	fprintf (f, "%s\n", comment);
-	for (i=0 ; i<NUM_SPAWN_PARMS ; i++)
-		fprintf (f, "%f\n", svs.clients->spawn_parms[i]);
-	fprintf (f, "%d\n", current_skill);
-	fprintf (f, "%s\n", sv.name);
-	fprintf (f, "%f\n",sv.time);
+	if (text)
+		Host_WriteTextSave (f);
+	else if (!Host_WriteBinarySave (f))
+	{
+		fclose (f);
+		Con_Printf ("ERROR: not enough memory to save.\n");
+		return;
+	}
+	fclose (f);
+	COM_FileWritten (name + strlen(com_gamedir) + 1);
+	Con_Printf ("done.\n");
+}
 
-// write the light styles
+/*
+===============
+Host_LoadBinarySave
+
+data is the whole file, freed here.  Returns false if the game wasn't
+loaded.
+===============
+*/
+static qboolean Host_LoadBinarySave (byte *data, int len)
+{
+	savegame_t		header;
+	savelayout_t	l;
+	edict_t			*ent;
+	int				*in, *v;
+	char			*strings;
+	int				i, j, s;
+	ddef_t			*d;
+
+	memcpy (&header, data, sizeof(header));
+	in = (int *)(data + sizeof(header));
+
+	if (header.version != SAVEGAME_BINARY
+	|| header.numglobals < 0 || header.numglobals > SAVEGAME_MAXSLOTS
+	|| header.numedicts < 1 || header.numedicts > MAX_EDICTS
+	|| header.entityfields < 1 || header.entityfields > SAVEGAME_MAXSLOTS
+	|| header.stringsize < 0 || header.stringsize > len
+	|| sizeof(header) + 4.0 * (header.numglobals + header.numedicts * (1 + header.entityfields)) + header.stringsize > len)
+	{
+		free (data);
+		Con_Printf ("Savegame is damaged or of another version\n");
+		return false;
+	}
+
+	current_skill = header.skill;
+	Cvar_SetValue ("skill", (float)current_skill);
+	header.mapname[sizeof(header.mapname)-1] = 0;
+
+	CL_Disconnect_f ();
+
+	SV_SpawnServer (header.mapname);
+	if (!sv.active)
+	{
+		free (data);
+		Con_Printf ("Couldn't load map\n");
+		return false;
+	}
+
+	if (header.crc != pr_crc || header.entityfields != progs->entityfields || header.numedicts > sv.max_edicts
+	|| !Host_SaveLayout (&l))
+	{
+		free (data);
+		Host_Error ("Savegame is from other progs, a text save (save <name> text) would load");
+	}
+	if (header.numglobals != l.numglobals)
+	{
+		free (data);
+		Host_FreeLayout (&l);
+		Host_Error ("Savegame is from other progs, a text save (save <name> text) would load");
+	}
+
+	sv.paused = true;		// pause until all clients connect
+	sv.loadgame = true;
+
+// the strings in one block, everything that points into it is relocated
+	strings = Hunk_Alloc (header.stringsize + 1);
+	memcpy (strings, in + header.numglobals + header.numedicts * (1 + header.entityfields), header.stringsize);
 
 	for (i=0 ; i<MAX_LIGHTSTYLES ; i++)
 	{
-		if (sv.lightstyles[i])
-			fprintf (f, "%s\n", sv.lightstyles[i]);
-		else
-			fprintf (f,"m\n");
+		s = header.lightstyles[i];
+		sv.lightstyles[i] = (s >= 0 && s < header.stringsize) ? strings + s : "m";
 	}
 
+	for (i=0 ; i<l.numglobals ; i++, in++)
+	{
+		d = l.globals[i];
+		s = *in;
+		if ((d->type & ~DEF_SAVEGLOBAL) == ev_string)
+			s = Host_LoadStringRef (s, strings, header.stringsize);
+		else if ((d->type & ~DEF_SAVEGLOBAL) == ev_entity)
+			s *= pr_edict_size;
+		((int *)pr_globals)[d->ofs] = s;
+	}
 
-	ED_WriteGlobals (f);
-	for (i=0 ; i<sv.num_edicts ; i++)
+	for (i=0 ; i<header.numedicts ; i++)
 	{
-		ED_Write (f, EDICT_NUM(i));
-		fflush (f);
+		ent = EDICT_NUM(i);
+		ent->free = *in++;
+		v = (int *)&ent->v;
+		memcpy (v, in, progs->entityfields * 4);
+		in += progs->entityfields;
+		if (ent->free)
+			continue;
+
+		for (j=0 ; j<l.numstrings ; j++)
+			v[l.strings[j]] = Host_LoadStringRef (v[l.strings[j]], strings, header.stringsize);
+		for (j=0 ; j<l.numentities ; j++)
+			v[l.entities[j]] *= pr_edict_size;
+
+	// link it into the bsp tree
+		SV_LinkEdict (ent, false);
 	}
-	fclose (f);
-	Con_Printf ("done.\n");
-}
 
+	sv.num_edicts = header.numedicts;
+	sv.time = header.time;
+
+	for (i=0 ; i<NUM_SPAWN_PARMS ; i++)
+		svs.clients->spawn_parms[i] = header.spawn_parms[i];
+
+	free (data);
+	Host_FreeLayout (&l);
+
+	return true;
+}
 
 /*
 ===============
@@ -539,6 +954,8 @@ void Host_Loadgame_f (void)
 	int		entnum;
 	int		version;
 	float			spawn_parms[NUM_SPAWN_PARMS];
+	int		magic, len;
+	byte	*data;
 
 	if (cmd_source != src_command)
 		return;
@@ -559,13 +976,45 @@ void Host_Loadgame_f (void)
 //	SCR_BeginLoadingPlaque ();
 
 	Con_Printf ("Loading game from %s...\n", name);
-	f = fopen (name, "r");
+	f = fopen (name, "rb");
 	if (!f)
 	{
 		Con_Printf ("ERROR: couldn't open save file for reading.\n");
 		return;
 	}
 
+// a binary save is read in whole
+	magic = 0;
+	if (fread (&magic, 4, 1, f) == 1 && magic == SAVEGAME_MAGIC)
+	{
+		fseek (f, 0, SEEK_END);
+		len = ftell (f);
+		fseek (f, 0, SEEK_SET);
+		data = len >= sizeof(savegame_t) ? malloc (len) : NULL;
+		if (!data || fread (data, 1, len, f) != len)
+		{
+			free (data);
+			fclose (f);
+			Con_Printf ("ERROR: couldn't read the save file.\n");
+			return;
+		}
+		fclose (f);
+
+		if (Host_LoadBinarySave (data, len) && cls.state != ca_dedicated)
+		{
+			CL_EstablishConnection ("local");
+			Host_Reconnect_f ();
+		}
+		return;
+	}
+	if (magic == SAVEGAME_SWAPPED)
+	{
+		fclose (f);
+		Con_Printf ("Savegame is from a machine of the other byte order, a text save would load\n");
+		return;
+	}
+	rewind (f);
+
 	fscanf (f, "%i\n", &version);
 	if (version != SAVEGAME_VERSION)
 	{
@@ -32,9 +32,9 @@ void IN_Move (usercmd_t *cmd);
 void IN_ClearStates (void);
 // restores all button and position states to defaults
 
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 void IN_SwitchKeyboard (void);
-#endif // _3DS
+#endif // _3DS, __linux__
 
 #ifdef __WII__
 void Wiimote_Rumble (int low_frequency, int high_frequency, int duration);
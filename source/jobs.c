@@ -0,0 +1,656 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// jobs.c -- a pool of worker threads for bulk work that splits up
+//
+// Every thread that runs jobs, the main thread as number 0 and the workers
+// after it, has a deque of jobs that are ready.  A thread takes the newest
+// job from the bottom of its own deque, and once that is empty steals the
+// oldest from the top of another thread's.  Jobs_Run deals the jobs out
+// over the deques in turn and a job made ready by another finishing goes
+// on the deque of the thread that finished it, so each thread starts with
+// its own share and the stealing evens out what is left.  One thread other
+// than the main one, the pipelined server tick, can use them as well and
+// gets a deque past the workers' to wait on.  A job can wait for others it
+// started, the waiting thread runs what is ready meanwhile.
+//
+// One lock built from the sys semaphores guards it all.  The lock free
+// deques of the literature want compare and swap, which the PSP's Allegrex
+// doesn't have, and the jobs are meant to be big enough that the lock
+// isn't where the time goes.
+//
+// -jobs <n> sets the number of workers.  The default is one for each core
+// past the main thread's, so none on the PSP, the Wii and the old 3DS,
+// where the jobs run on the main thread when it waits for them.
+
+#include "quakedef.h"
+#include "jobs.h"
+
+#define	MAX_JOBS			512			// a power of two, the deques are rings this long
+#define	MAX_JOBTHREADS		8
+#define	MAX_DEPENDENTS		4
+#define	JOBTRACE_EVENTS		1024
+#define	MAX_JOBNAMES		32			// told apart by jobstats
+
+struct job_s
+{
+	char		*name;
+	jobfunc_t	func;
+	void		*data;
+	int			first, last;
+	job_t		*parent;
+	int			unfinished;				// itself and its children
+	int			waiting;				// jobs it depends on, and one until Jobs_Run
+	int			numdependents;
+	job_t		*dependents[MAX_DEPENDENTS];
+	void		*done;					// posted when it finishes, for Jobs_Wait
+	qboolean	blocked;				// its waiter is counted in jobs_blocked
+	job_t		*next;					// on the free list
+};
+
+typedef struct
+{
+	job_t		*jobs[MAX_JOBS];		// ready, top is the oldest
+	int			top, bottom;
+	unsigned long	id;					// the worker's Sys_ThreadId
+	int			depth;					// jobs it is running, more than one when they wait
+	void		*done;					// posted for it asleep in Jobs_Wait
+// since the last "jobstats clear"
+	int			run;
+	int			stolen;
+	int			sleeps;
+	double		busy;
+} jobthread_t;
+
+typedef struct
+{
+	char		*name;
+	int			thread;
+	double		start;
+	float		time;
+} jobevent_t;
+
+static	job_t		jobs[MAX_JOBS];
+static	job_t		*jobs_free;
+
+static	jobthread_t	jobs_threads[MAX_JOBTHREADS + 1];	// the other thread last
+static	int			jobs_numthreads = 1;
+static	int			jobs_next;			// the deque Jobs_Run deals to next
+static	int			jobs_running;		// taken and not yet finished
+static	int			jobs_blocked;		// of those, asleep in a Jobs_Wait of their own
+static	int			jobs_idle;			// workers waiting on jobs_work
+
+static	void		*jobs_lock;
+static	void		*jobs_work;			// posted for an idle worker when a job is ready
+
+// the last JOBTRACE_EVENTS jobs run
+static	jobevent_t	jobs_events[JOBTRACE_EVENTS];
+static	int			jobs_numevents;
+
+static void Jobs_Push (job_t *job, int thread);
+
+static void Jobs_Lock (void)
+{
+	if (jobs_lock)
+		Sys_SemaphoreWait (jobs_lock);
+}
+
+static void Jobs_Unlock (void)
+{
+	if (jobs_lock)
+		Sys_SemaphorePost (jobs_lock);
+}
+
+/*
+=================
+Jobs_Finish
+
+A job or one of its children is done, called locked
+=================
+*/
+static void Jobs_Finish (job_t *job, int thread)
+{
+	job_t	*parent;
+	int		i;
+
+	while (job)
+	{
+		if (--job->unfinished)
+			return;
+
+		for (i=0 ; i<job->numdependents ; i++)
+		{
+			if (!--job->dependents[i]->waiting)
+				Jobs_Push (job->dependents[i], thread);
+		}
+
+		parent = job->parent;
+		if (parent)
+		{
+			job->next = jobs_free;
+			jobs_free = job;
+		}
+		else if (job->done)
+		{
+			if (job->blocked)
+			{
+				jobs_blocked--;
+				job->blocked = false;
+			}
+			Sys_SemaphorePost (job->done);
+			job->done = NULL;
+		}
+		job = parent;
+	}
+}
+
+/*
+=================
+Jobs_Push
+
+A job is ready, called locked
+=================
+*/
+static void Jobs_Push (job_t *job, int thread)
+{
+	jobthread_t	*t;
+
+	if (!job->func)
+	{
+		Jobs_Finish (job, thread);
+		return;
+	}
+
+	t = &jobs_threads[thread];
+	t->jobs[t->bottom++ & (MAX_JOBS-1)] = job;
+
+	if (jobs_idle)
+	{
+		jobs_idle--;
+		Sys_SemaphorePost (jobs_work);
+	}
+}
+
+/*
+=================
+Jobs_Take
+
+The newest job of the thread's own, or the oldest of someone else's, called
+locked
+=================
+*/
+static job_t *Jobs_Take (int thread)
+{
+	jobthread_t	*t;
+	int			i;
+
+	t = &jobs_threads[thread];
+	if (t->bottom != t->top)
+		return t->jobs[--t->bottom & (MAX_JOBS-1)];
+
+	for (i=1 ; i<=jobs_numthreads ; i++)
+	{
+		t = &jobs_threads[(thread + i) % (jobs_numthreads + 1)];
+		if (t->bottom != t->top)
+		{
+			jobs_threads[thread].stolen++;
+			return t->jobs[t->top++ & (MAX_JOBS-1)];
+		}
+	}
+
+	return NULL;
+}
+
+/*
+=================
+Jobs_Execute
+
+Called locked, the lock is let go while the job runs
+=================
+*/
+static void Jobs_Execute (job_t *job, int thread)
+{
+	jobthread_t	*t;
+	jobevent_t	*e;
+	double		start, time;
+
+	t = &jobs_threads[thread];
+	t->depth++;
+	jobs_running++;
+	Jobs_Unlock ();
+
+	start = Sys_FloatTime ();
+	job->func (job->data, job->first, job->last);
+	time = Sys_FloatTime () - start;
+
+	Jobs_Lock ();
+	jobs_running--;
+	t->depth--;
+
+	t->run++;
+	t->busy += time;
+
+	e = &jobs_events[jobs_numevents++ % JOBTRACE_EVENTS];
+	e->name = job->name;
+	e->thread = thread;
+	e->start = start;
+	e->time = time;
+
+	Jobs_Finish (job, thread);
+}
+
+/*
+=================
+Jobs_Worker
+=================
+*/
+static void Jobs_Worker (void *arg)
+{
+	job_t	*job;
+	int		thread;
+
+	thread = (jobthread_t *)arg - jobs_threads;
+
+	Jobs_Lock ();
+	jobs_threads[thread].id = Sys_ThreadId ();
+	while (1)
+	{
+		job = Jobs_Take (thread);
+		if (job)
+		{
+			Jobs_Execute (job, thread);
+			continue;
+		}
+
+		jobs_idle++;
+		jobs_threads[thread].sleeps++;
+		Jobs_Unlock ();
+		Sys_SemaphoreWait (jobs_work);
+		Jobs_Lock ();
+	}
+}
+
+/*
+=================
+Jobs_Create
+=================
+*/
+job_t *Jobs_Create (char *name, jobfunc_t func, void *data, job_t *parent)
+{
+	job_t	*job;
+
+	Jobs_Lock ();
+
+	job = jobs_free;
+	if (!job)
+		Sys_Error ("Jobs_Create: more than %i jobs for %s", MAX_JOBS, name);
+	jobs_free = job->next;
+
+	job->name = name;
+	job->func = func;
+	job->data = data;
+	job->first = 0;
+	job->last = 1;
+	job->parent = parent;
+	job->unfinished = 1;
+	job->waiting = 1;
+	job->numdependents = 0;
+	job->done = NULL;
+	job->blocked = false;
+	if (parent)
+		parent->unfinished++;
+
+	Jobs_Unlock ();
+
+	return job;
+}
+
+/*
+=================
+Jobs_Depend
+=================
+*/
+void Jobs_Depend (job_t *job, job_t *on)
+{
+	Jobs_Lock ();
+
+	if (on->numdependents == MAX_DEPENDENTS)
+		Sys_Error ("Jobs_Depend: more than %i jobs wait for %s", MAX_DEPENDENTS, on->name);
+	on->dependents[on->numdependents++] = job;
+	job->waiting++;
+
+	Jobs_Unlock ();
+}
+
+/*
+=================
+Jobs_Run
+=================
+*/
+void Jobs_Run (job_t *job)
+{
+	Jobs_Lock ();
+
+	if (!--job->waiting)
+	{
+		Jobs_Push (job, jobs_next);
+		jobs_next = (jobs_next + 1) % jobs_numthreads;
+	}
+
+	Jobs_Unlock ();
+}
+
+/*
+=================
+Jobs_Thread
+
+The calling thread's deque, called locked
+=================
+*/
+static int Jobs_Thread (void)
+{
+	unsigned long	id;
+	int				i;
+
+	if (Sys_MainThread ())
+		return 0;
+
+	id = Sys_ThreadId ();
+	for (i=1 ; i<jobs_numthreads ; i++)
+		if (jobs_threads[i].id == id)
+			return i;
+
+	return jobs_numthreads;
+}
+
+/*
+=================
+Jobs_Wait
+=================
+*/
+void Jobs_Wait (job_t *job)
+{
+	jobthread_t	*t;
+	job_t	*run;
+	int		thread, nested;
+
+	if (job->parent)
+		Sys_Error ("Jobs_Wait: %s has a parent", job->name);
+
+	Jobs_Lock ();
+
+	thread = Jobs_Thread ();
+	t = &jobs_threads[thread];
+	nested = t->depth > 0;		// called by a job, which waits with it
+
+	while (job->unfinished)
+	{
+		run = Jobs_Take (thread);
+		if (run)
+		{
+			Jobs_Execute (run, thread);
+			continue;
+		}
+
+		// nothing ready and nothing running that could make something ready,
+		// a job asleep in a wait of its own can't
+		if (jobs_running - jobs_blocked - nested <= 0)
+			Sys_Error ("Jobs_Wait: %s can never finish", job->name);
+
+		job->done = t->done;
+		if (nested)
+		{
+			job->blocked = true;
+			jobs_blocked++;
+		}
+		t->sleeps++;
+		Jobs_Unlock ();
+		Sys_SemaphoreWait (t->done);
+		Jobs_Lock ();
+	}
+
+	job->next = jobs_free;
+	jobs_free = job;
+
+	Jobs_Unlock ();
+}
+
+/*
+=================
+Jobs_ParallelFor
+=================
+*/
+void Jobs_ParallelFor (char *name, jobfunc_t func, void *data, int count, int grain)
+{
+	job_t	*all, *job;
+	int		i, runs, maxruns;
+
+	if (count <= 0)
+		return;
+	if (grain < 1)
+		grain = 1;
+
+	// a few runs for each thread, so the stealing has something to even out
+	runs = (count + grain - 1) / grain;
+	maxruns = jobs_numthreads > 1 ? jobs_numthreads * 4 : 1;
+	if (runs > maxruns)
+		runs = maxruns;
+
+	all = Jobs_Create (name, NULL, NULL, NULL);
+	for (i=0 ; i<runs ; i++)
+	{
+		job = Jobs_Create (name, func, data, all);
+		job->first = count / runs * i + (i < count % runs ? i : count % runs);
+		job->last = job->first + count / runs + (i < count % runs);
+		Jobs_Run (job);
+	}
+	Jobs_Run (all);
+	Jobs_Wait (all);
+}
+
+/*
+=================
+Jobs_NumThreads
+=================
+*/
+int Jobs_NumThreads (void)
+{
+	return jobs_numthreads;
+}
+
+static char *Jobs_ThreadName (int thread)
+{
+	if (!thread)
+		return "main";
+	if (thread == jobs_numthreads)
+		return "other";
+	return va("worker%i", thread);
+}
+
+/*
+=================
+Jobs_Stats_f
+=================
+*/
+static void Jobs_Stats_f (void)
+{
+	jobthread_t	*t;
+	jobevent_t	*e;
+	char		*names[MAX_JOBNAMES];
+	int			counts[MAX_JOBNAMES];
+	double		times[MAX_JOBNAMES];
+	float		longest[MAX_JOBNAMES];
+	int			i, j, numnames, first;
+
+	if (Cmd_Argc () > 1 && !Q_strcasecmp (Cmd_Argv (1), "clear"))
+	{
+		Jobs_Lock ();
+		for (i=0, t=jobs_threads ; i<=jobs_numthreads ; i++, t++)
+		{
+			t->run = t->stolen = t->sleeps = 0;
+			t->busy = 0;
+		}
+		jobs_numevents = 0;
+		Jobs_Unlock ();
+		return;
+	}
+
+	Jobs_Lock ();
+
+	Con_Printf ("thread     run stolen sleeps  busy ms\n");
+	for (i=0, t=jobs_threads ; i<=jobs_numthreads ; i++, t++)
+	{
+		if (i == jobs_numthreads && !t->run && !t->sleeps)
+			continue;
+		Con_Printf ("%-8s %5i  %5i  %5i %8.1f\n", Jobs_ThreadName (i),
+			t->run, t->stolen, t->sleeps, t->busy * 1000);
+	}
+
+	// the logged jobs by name
+	numnames = 0;
+	first = jobs_numevents > JOBTRACE_EVENTS ? jobs_numevents - JOBTRACE_EVENTS : 0;
+	for (i=first ; i<jobs_numevents ; i++)
+	{
+		e = &jobs_events[i % JOBTRACE_EVENTS];
+		for (j=0 ; j<numnames ; j++)
+			if (names[j] == e->name)
+				break;
+		if (j == numnames)
+		{
+			if (numnames == MAX_JOBNAMES)
+				continue;
+			names[j] = e->name;
+			counts[j] = 0;
+			times[j] = 0;
+			longest[j] = 0;
+			numnames++;
+		}
+		counts[j]++;
+		times[j] += e->time;
+		if (e->time > longest[j])
+			longest[j] = e->time;
+	}
+
+	if (numnames)
+	{
+		Con_Printf ("the last %i jobs:\n", jobs_numevents - first);
+		Con_Printf (" count  total ms longest ms name\n");
+		for (j=0 ; j<numnames ; j++)
+			Con_Printf ("%6i %9.1f %10.2f %s\n", counts[j], times[j] * 1000, longest[j] * 1000, names[j]);
+	}
+
+	Jobs_Unlock ();
+}
+
+/*
+=================
+Jobs_Trace_f
+
+The logged jobs as a Chrome trace, a track for each thread
+=================
+*/
+static void Jobs_Trace_f (void)
+{
+	char		path[MAX_OSPATH];
+	jobevent_t	*e;
+	FILE		*f;
+	int			i, first;
+	double		base;
+
+	if (!jobs_numevents)
+	{
+		Con_Printf ("no jobs have run\n");
+		return;
+	}
+
+	snprintf (path, sizeof(path), "%s/%s", com_gamedir, Cmd_Argc () > 1 ? Cmd_Argv (1) : "jobtrace.json");
+	f = fopen (path, "w");
+	if (!f)
+	{
+		Con_Printf ("Couldn't write %s\n", path);
+		return;
+	}
+
+	Jobs_Lock ();
+
+	fprintf (f, "{\"traceEvents\":[\n");
+	for (i=0 ; i<=jobs_numthreads ; i++)
+		fprintf (f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"%s\"}},\n",
+			i + 1, Jobs_ThreadName (i));
+
+	first = jobs_numevents > JOBTRACE_EVENTS ? jobs_numevents - JOBTRACE_EVENTS : 0;
+	base = jobs_events[first % JOBTRACE_EVENTS].start;
+	for (i=first ; i<jobs_numevents ; i++)
+	{
+		e = &jobs_events[i % JOBTRACE_EVENTS];
+		fprintf (f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.0f,\"dur\":%.0f}",
+			i > first ? ",\n" : "", e->name, e->thread + 1, (e->start - base) * 1000000.0, e->time * 1000000.0);
+	}
+	fprintf (f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose (f);
+
+	Con_Printf ("Wrote %i jobs to %s\n", jobs_numevents - first, path);
+
+	Jobs_Unlock ();
+}
+
+/*
+=================
+Jobs_Init
+=================
+*/
+void Jobs_Init (void)
+{
+	int		i, workers;
+
+	for (i=0 ; i<MAX_JOBS-1 ; i++)
+		jobs[i].next = &jobs[i+1];
+	jobs_free = jobs;
+
+	Cmd_AddCommand ("jobstats", Jobs_Stats_f);
+	Cmd_AddCommand ("jobtrace", Jobs_Trace_f);
+
+	i = COM_CheckParm ("-jobs");
+	if (i && i < com_argc - 1)
+		workers = Q_atoi (com_argv[i+1]);
+	else
+		workers = Sys_NumCores () - 1;
+	if (workers > MAX_JOBTHREADS - 1)
+		workers = MAX_JOBTHREADS - 1;
+
+	jobs_lock = Sys_CreateSemaphore (1);
+	jobs_work = Sys_CreateSemaphore (0);
+
+	// the workers wait for the lock until they are all counted
+	Jobs_Lock ();
+	for (i=0 ; i<workers ; i++)
+	{
+		if (!Sys_CreateWorker (Jobs_Worker, &jobs_threads[jobs_numthreads]))
+		{
+			Con_Printf ("Couldn't start job worker %i\n", i + 1);
+			break;
+		}
+		jobs_numthreads++;
+	}
+	for (i=0 ; i<=jobs_numthreads ; i++)
+		jobs_threads[i].done = Sys_CreateSemaphore (0);
+	Jobs_Unlock ();
+
+	Con_DPrintf ("%i job workers\n", jobs_numthreads - 1);
+}
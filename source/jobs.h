@@ -0,0 +1,51 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// jobs.h -- a pool of worker threads for bulk work that splits up
+
+typedef struct job_s job_t;
+
+// does the items first up to last-1, a plain job gets 0 and 1
+typedef void (*jobfunc_t) (void *data, int first, int last);
+
+void Jobs_Init (void);
+
+// the main thread and the workers
+int Jobs_NumThreads (void);
+
+// Jobs are created, run and waited on by the main thread, by at most one
+// other thread at a time, the pipelined server tick, and by jobs, which can
+// split their own work up with Jobs_ParallelFor.
+//
+// name must stay valid, a string literal.  A job with a parent is freed
+// when it finishes and the parent doesn't finish before it; one without
+// has to be given to Jobs_Wait.  func may be NULL for a job that only
+// gathers its children.
+job_t *Jobs_Create (char *name, jobfunc_t func, void *data, job_t *parent);
+
+// job won't start before on has finished, both must not have been run yet
+void Jobs_Depend (job_t *job, job_t *on);
+
+void Jobs_Run (job_t *job);
+
+// runs jobs until job and its children have finished, then frees it
+void Jobs_Wait (job_t *job);
+
+// splits count items in runs of at least grain and waits for them all
+void Jobs_ParallelFor (char *name, jobfunc_t func, void *data, int count, int grain);
@@ -0,0 +1,108 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// main_linux.c -- the headless dedicated server's main loop
+
+#include "../quakedef.h"
+#include "../net_vcr.h"
+
+#include <signal.h>
+#include <unistd.h>
+
+#define DEFAULT_MEMSIZE_MB	32
+
+extern bool	game_running;
+
+static void Sys_QuitSignal (int sig)
+{
+	game_running = false;
+}
+
+//=============================================================================
+
+int main (int argc, char **argv)
+{
+	static quakeparms_t	parms;
+	static char			*dedargv[MAX_NUM_ARGVS];
+	double				time, oldtime, newtime;
+	int					i, j;
+
+	Sys_Init ();
+
+	// this build has no client, always run as a dedicated server; a vcr
+	// playback takes its arguments from the recording, which already has it
+	for (i = j = 0 ; i < argc && j < MAX_NUM_ARGVS - 1 ; i++)
+		dedargv[j++] = argv[i];
+	for (i = 1 ; i < argc ; i++)
+		if (!strcmp (argv[i], "-dedicated") || !strcmp (argv[i], "-playback"))
+			break;
+	if (i == argc && j < MAX_NUM_ARGVS)
+		dedargv[j++] = "-dedicated";
+
+	COM_InitArgv (j, dedargv);
+
+	parms.argc = com_argc;
+	parms.argv = com_argv;
+
+	parms.memsize = DEFAULT_MEMSIZE_MB * 1024 * 1024;
+	i = COM_CheckParm ("-mem");
+	if (i && i < com_argc - 1)
+		parms.memsize = Q_atoi (com_argv[i+1]) * 1024 * 1024;
+
+	parms.membase = malloc (parms.memsize);
+	if (!parms.membase)
+		Sys_Error ("Not enough memory free; check disk space\n");
+
+	parms.basedir = ".";
+	i = COM_CheckParm ("-basedir");
+	if (i && i < com_argc - 1)
+		parms.basedir = com_argv[i+1];
+
+	isDedicated = true;
+
+	signal (SIGPIPE, SIG_IGN);
+	signal (SIGINT, Sys_QuitSignal);
+	signal (SIGTERM, Sys_QuitSignal);
+	setvbuf (stdout, NULL, _IOLBF, 0);
+
+	Host_Init (&parms);
+
+	oldtime = Sys_FloatTime () - sys_ticrate.value;
+
+	game_running = true;
+	while (game_running)
+	{
+		newtime = Sys_FloatTime ();
+		time = newtime - oldtime;
+
+		// sleep off the rest of the tic so several servers can share a core,
+		// playback replays the recorded frame times as fast as it can
+		if (time < sys_ticrate.value && !vcr_playback)
+		{
+			usleep ((sys_ticrate.value - time) * 1000000);
+			continue;
+		}
+
+		Host_Frame (time);
+		oldtime = newtime;
+	}
+
+	Sys_Quit ();
+	return 0;
+}
@@ -0,0 +1,199 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// r_null.c -- null refresh for the headless server
+//
+// the client, menu and hud code is linked in unchanged, so everything it
+// expects from the renderer exists here and does nothing.  only the
+// pieces the model loader needs to build collision data do real work.
+
+#include "../quakedef.h"
+
+//
+// view origin
+//
+vec3_t		vup;
+vec3_t		vpn;
+vec3_t		vright;
+vec3_t		r_origin;
+
+refdef_t	r_refdef;
+texture_t	*r_notexture_mip;
+
+int			texture_mode = GL_LINEAR;
+
+qboolean	qmb_initialized = qfalse;
+int			decal_blood1, decal_blood2, decal_blood3, decal_q3blood, decal_burn, decal_mark, decal_glow;
+
+cvar_t	gl_polyblend = {"gl_polyblend","1"};
+cvar_t	r_part_trails		= {"r_part_trails",      "1",qtrue};
+cvar_t	r_part_spikes		= {"r_part_spikes",      "1",qtrue};
+cvar_t	r_part_gunshots	    = {"r_part_gunshots",    "1",qtrue};
+cvar_t	r_part_telesplash	= {"r_part_telesplash",  "1",qtrue};
+cvar_t	r_part_flames		= {"r_part_flames",      "1",qtrue};
+cvar_t	r_part_lightning	= {"r_part_lightning",   "1",qtrue};
+cvar_t	r_part_muzzleflash  = {"r_part_muzzleflash", "1",qtrue};
+cvar_t	r_decal_bullets	    = {"r_decal_bullets","1",qtrue};
+cvar_t	r_decal_explosions	= {"r_decal_explosions","1",qtrue};
+
+//
+// screen
+//
+int			scr_copytop;
+int			scr_copyeverything;
+int			scr_fullupdate;
+int			clearnotify;
+float		scr_con_current;
+float		scr_centertime_off;
+qboolean	scr_disabled_for_loading;
+
+cvar_t		scr_viewsize = {"viewsize","100", true};
+cvar_t		scr_fov = {"fov","90"};	// 10 - 170
+
+int			loadingScreen;
+qboolean	loadscreeninit;
+char		*loadname2;
+char		*loadnamespec;
+
+float		loading_cur_step;
+float		loading_num_step;
+int			loading_step;
+char		loading_name[32];
+
+double		Hitmark_Time, crosshair_spread_time;
+float		cur_spread;
+float		crosshair_offset_step;
+
+/*
+==================
+R_InitTextures
+
+the model loader points missing brush textures at this
+==================
+*/
+void	R_InitTextures (void)
+{
+	int		x,y, m;
+	byte	*dest;
+
+// create a simple checkerboard texture for the default
+	r_notexture_mip = Hunk_AllocName (sizeof(texture_t) + 16*16+8*8+4*4+2*2, "notexture");
+
+	r_notexture_mip->width = r_notexture_mip->height = 16;
+	r_notexture_mip->offsets[0] = sizeof(texture_t);
+	r_notexture_mip->offsets[1] = r_notexture_mip->offsets[0] + 16*16;
+	r_notexture_mip->offsets[2] = r_notexture_mip->offsets[1] + 8*8;
+	r_notexture_mip->offsets[3] = r_notexture_mip->offsets[2] + 4*4;
+
+	for (m=0 ; m<4 ; m++)
+	{
+		dest = (byte *)r_notexture_mip + r_notexture_mip->offsets[m];
+		for (y=0 ; y< (16>>m) ; y++)
+			for (x=0 ; x< (16>>m) ; x++)
+			{
+				if (  (y< (8>>m) ) ^ (x< (8>>m) ) )
+					*dest++ = 0;
+				else
+					*dest++ = 0xff;
+			}
+	}
+}
+
+void R_Init (void) {}
+void R_InitSky (struct miptex_s *mt) {}
+void R_NewMap (void) {}
+void R_RenderView (void) {}
+void R_AddEfrags (entity_t *ent) {}
+void R_RemoveEfrags (entity_t *ent) {}
+void R_PushDlights (void) {}
+
+void R_ParseParticleEffect (void) {}
+void R_RunParticleEffect (vec3_t org, vec3_t dir, int color, int count) {}
+void R_RocketTrail (vec3_t start, vec3_t end, int type) {}
+void R_ParticleExplosion (vec3_t org) {}
+void R_ParticleExplosion2 (vec3_t org, int colorStart, int colorLength) {}
+void R_BlobExplosion (vec3_t org) {}
+void R_LavaSplash (vec3_t org) {}
+void R_TeleportSplash (vec3_t org) {}
+void R_SpawnDecalStatic (vec3_t org, int tex, int size) {}
+void QMB_LightningBeam (vec3_t start, vec3_t end) {}
+void QMB_MuzzleFlash (vec3_t org) {}
+
+void Fog_ParseServerMessage (void)
+{
+	// keep the message stream in sync
+	MSG_ReadByte ();
+	MSG_ReadByte ();
+	MSG_ReadByte ();
+	MSG_ReadByte ();
+	MSG_ReadByte ();
+	MSG_ReadShort ();
+}
+
+void Sky_LoadSkyBox (char *name) {}
+
+//
+// textures, model display lists
+//
+int GL_LoadTexture (char *identifier, int width, int height, byte *data, qboolean mipmap, qboolean alpha, int bytesperpixel) { return 0; }
+int GL_LoadTexture32 (char *identifier, int width, int height, byte *data, qboolean mipmap, qboolean alpha) { return 0; }
+int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean complain, qboolean mipmap) { return 0; }
+void GL_SubdivideSurface (msurface_t *fa) {}
+void GL_MakeAliasModelDisplayLists (model_t *m, aliashdr_t *hdr) {}
+
+//
+// 2d drawing
+//
+static qpic_t	null_pic;
+
+void Draw_Init (void) {}
+void Draw_Character (int x, int y, int num) {}
+void Draw_String (int x, int y, char *str) {}
+void Draw_ColoredString (int x, int y, char *text, float r, float g, float b, float a, float scale) {}
+void Draw_ColoredStringCentered (int y, char *text, float r, float g, float b, float a, float scale) {}
+void Draw_Pic (int x, int y, qpic_t *pic) {}
+void Draw_AlphaPic (int x, int y, qpic_t *pic, float alpha) {}
+void Draw_StretchPic (int x, int y, qpic_t *pic, int x_value, int y_value) {}
+void Draw_ColoredStretchPic (int x, int y, qpic_t *pic, int x_value, int y_value, int r, int g, int b, int a) {}
+void Draw_TransPic (int x, int y, qpic_t *pic) {}
+void Draw_TransPicTranslate (int x, int y, qpic_t *pic, byte *translation) {}
+void Draw_ConsoleBackground (int lines) {}
+void Draw_FillByColor (int x, int y, int w, int h, int r, int g, int b, int a) {}
+void Draw_FadeScreen (void) {}
+qpic_t *Draw_CachePic (char *path) { return &null_pic; }
+int getTextWidth (char *str, float scale) { return 0; }
+
+void SCR_Init (void) {}
+
+// a listen server still works out the view and the hud, so the tests run
+// what a port's renderer reads of the client while a pipelined tick runs
+void SCR_UpdateScreen (void)
+{
+	if (cls.state != ca_connected || cls.signon != SIGNONS)
+		return;
+
+	V_RenderView ();
+	HUD_Draw ();
+}
+
+void SCR_CenterPrint (char *str) {}
+void SCR_UsePrint (int type, int cost, int weapon) {}
+void SCR_BeginLoadingPlaque (void) {}
+void SCR_EndLoadingPlaque (void) {}
+void Clear_LoadingFill (void) {}
@@ -0,0 +1,440 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sys_linux.c -- POSIX system layer for the headless dedicated server
+
+#include "../quakedef.h"
+#include "../net_vcr.h"
+
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+qboolean	isDedicated;
+bool		game_running;
+
+static qboolean	stdin_closed;
+static pthread_t	sys_mainthread;
+
+/*
+===============================================================================
+
+FILE IO
+
+===============================================================================
+*/
+
+#define MAX_HANDLES             32
+FILE    *sys_handles[MAX_HANDLES];
+
+int             findhandle (void)
+{
+	int             i;
+
+	for (i=1 ; i<MAX_HANDLES ; i++)
+		if (!sys_handles[i])
+			return i;
+	Sys_Error ("out of handles");
+	return -1;
+}
+
+/*
+================
+filelength
+================
+*/
+int filelength (FILE *f)
+{
+	int             pos;
+	int             end;
+
+	pos = ftell (f);
+	fseek (f, 0, SEEK_END);
+	end = ftell (f);
+	fseek (f, pos, SEEK_SET);
+
+	return end;
+}
+
+int Sys_FileOpenRead (char *path, int *hndl)
+{
+	FILE    *f;
+	int             i;
+
+	i = findhandle ();
+
+	f = fopen(path, "rb");
+	if (!f)
+	{
+		*hndl = -1;
+		return -1;
+	}
+	sys_handles[i] = f;
+	*hndl = i;
+
+	return filelength(f);
+}
+
+int Sys_FileOpenWrite (char *path)
+{
+	FILE    *f;
+	int             i;
+
+	i = findhandle ();
+
+	f = fopen(path, "wb");
+	if (!f)
+		Sys_Error ("Error opening %s: %s", path,strerror(errno));
+	sys_handles[i] = f;
+
+	return i;
+}
+
+void Sys_FileClose (int handle)
+{
+	fclose (sys_handles[handle]);
+	sys_handles[handle] = NULL;
+}
+
+void Sys_FileSeek (int handle, int position)
+{
+	fseek (sys_handles[handle], position, SEEK_SET);
+}
+
+int sys_bytesread;
+
+int Sys_FileRead (int handle, void *dest, int count)
+{
+	int		r;
+
+	r = fread (dest, 1, count, sys_handles[handle]);
+	sys_bytesread += r;
+
+	return r;
+}
+
+int Sys_FileWrite (int handle, void *data, int count)
+{
+	return fwrite (data, 1, count, sys_handles[handle]);
+}
+
+int Sys_FileReadAt (int handle, int position, void *dest, int count)
+{
+	ssize_t	r;
+
+	r = pread (fileno (sys_handles[handle]), dest, count, position);
+	if (r < 0)
+		return 0;
+	sys_bytesread += r;
+
+	return r;
+}
+
+/*
+================
+Sys_FileMap
+
+Mapped copy-on-write, so a loader that byte swaps a header in place only
+dirties its own copy of that page
+================
+*/
+void *Sys_FileMap (int handle, int position, int length)
+{
+	long	page;
+	int		skip;
+	byte	*base;
+
+	if (length <= 0)
+		return NULL;
+
+	page = sysconf (_SC_PAGESIZE);
+	skip = position & (page - 1);
+
+	base = mmap (NULL, length + skip, PROT_READ|PROT_WRITE, MAP_PRIVATE,
+		fileno (sys_handles[handle]), position - skip);
+	if (base == MAP_FAILED)
+		return NULL;
+	sys_bytesread += length;
+
+	return base + skip;
+}
+
+void Sys_FileUnmap (void *data, int position, int length)
+{
+	int		skip;
+
+	skip = position & (sysconf (_SC_PAGESIZE) - 1);
+	munmap ((byte *)data - skip, length + skip);
+}
+
+/*
+===============================================================================
+
+THREADS
+
+===============================================================================
+*/
+
+typedef struct
+{
+	void	(*func) (void *);
+	void	*arg;
+} threadstart_t;
+
+static void *Sys_ThreadStart (void *data)
+{
+	threadstart_t	start;
+
+	start = *(threadstart_t *)data;
+	free (data);
+	start.func (start.arg);
+
+	return NULL;
+}
+
+void *Sys_CreateThread (void (*func) (void *), void *arg)
+{
+	threadstart_t	*start;
+	pthread_t		thread;
+
+	start = malloc (sizeof(*start));
+	if (!start)
+		return NULL;
+	start->func = func;
+	start->arg = arg;
+
+	if (pthread_create (&thread, NULL, Sys_ThreadStart, start))
+	{
+		free (start);
+		return NULL;
+	}
+	pthread_detach (thread);
+
+	return (void *)thread;
+}
+
+void *Sys_CreateSemaphore (int count)
+{
+	sem_t	*sem;
+
+	sem = malloc (sizeof(*sem));
+	if (!sem || sem_init (sem, 0, count))
+		Sys_Error ("Sys_CreateSemaphore: %s", strerror (errno));
+
+	return sem;
+}
+
+void Sys_SemaphoreWait (void *sem)
+{
+	while (sem_wait (sem) && errno == EINTR)
+		;
+}
+
+void Sys_SemaphorePost (void *sem)
+{
+	sem_post (sem);
+}
+
+void *Sys_CreateWorker (void (*func) (void *), void *arg)
+{
+	return Sys_CreateThread (func, arg);
+}
+
+int Sys_NumCores (void)
+{
+	long	cores;
+
+	cores = sysconf (_SC_NPROCESSORS_ONLN);
+
+	return cores > 0 ? cores : 1;
+}
+
+/*
+================
+Sys_Init
+
+Before anything else; the thread that calls it is the main thread
+================
+*/
+void Sys_Init (void)
+{
+	sys_mainthread = pthread_self ();
+
+	// string_t fields are 32-bit offsets from pr_strings, so keep every
+	// allocation in the brk heap next to the image instead of in far mmaps
+	mallopt (M_MMAP_MAX, 0);
+}
+
+qboolean Sys_MainThread (void)
+{
+	return pthread_equal (pthread_self (), sys_mainthread);
+}
+
+unsigned long Sys_ThreadId (void)
+{
+	return (unsigned long)pthread_self ();
+}
+
+int     Sys_FileTime (char *path)
+{
+	struct stat	buf;
+
+	if (stat (path, &buf) == -1)
+		return -1;
+
+	return buf.st_mtime;
+}
+
+void Sys_mkdir (char *path)
+{
+	mkdir (path, 0777);
+}
+
+void Sys_MakeCodeWriteable (unsigned long startaddr, unsigned long length)
+{
+}
+
+/*
+===============================================================================
+
+SYSTEM IO
+
+===============================================================================
+*/
+
+void Sys_Error (char *error, ...)
+{
+	va_list		argptr;
+
+	fprintf (stderr, "Sys_Error: ");
+	va_start (argptr,error);
+	vfprintf (stderr,error,argptr);
+	va_end (argptr);
+	fprintf (stderr, "\n");
+
+	Host_Shutdown();
+	exit (1);
+}
+
+void Sys_Printf (char *fmt, ...)
+{
+	va_list         argptr;
+
+	va_start (argptr,fmt);
+	vprintf (fmt,argptr);
+	va_end (argptr);
+}
+
+void Sys_Quit (void)
+{
+	Host_Shutdown();
+	fflush (stdout);
+	exit (0);
+}
+
+double Sys_FloatTime (void)
+{
+	static time_t	secbase;
+	struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	if (!secbase)
+	{
+		secbase = ts.tv_sec;
+		return ts.tv_nsec / 1000000000.0;
+	}
+
+	return (ts.tv_sec - secbase) + ts.tv_nsec / 1000000000.0;
+}
+
+unsigned long long Sys_Ticks (void)
+{
+	struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+double Sys_TickRate (void)
+{
+	return 1000000000.0;
+}
+
+/*
+================
+Sys_ConsoleInput
+
+Returns one line typed on stdin, without blocking the frame
+================
+*/
+char *Sys_ConsoleInput (void)
+{
+	static char		text[256];
+	int				len;
+	fd_set			fdset;
+	struct timeval	timeout;
+
+	if (stdin_closed)
+		return NULL;
+
+	FD_ZERO (&fdset);
+	FD_SET (0, &fdset);
+	timeout.tv_sec = 0;
+	timeout.tv_usec = 0;
+	if (select (1, &fdset, NULL, NULL, &timeout) == -1 || !FD_ISSET (0, &fdset))
+		return NULL;
+
+	len = read (0, text, sizeof(text) - 1);
+	if (len < 1)
+	{
+		// detached from a terminal, keep serving without a console
+		stdin_closed = true;
+		return NULL;
+	}
+	text[len] = 0;
+
+	return text;
+}
+
+void Sys_Sleep (void)
+{
+	usleep (1000);
+}
+
+void Sys_SendKeyEvents (void)
+{
+}
+
+void Sys_HighFPPrecision (void)
+{
+}
+
+void Sys_LowFPPrecision (void)
+{
+}
@@ -0,0 +1,344 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// jobs_stress.c -- the job system against serial runs of the same work
+//
+//   make -f Makefile.linux jobs_stress
+//   ./build/linux/jobs_stress [-jobs n] [-rounds n]
+//
+// Each round runs a flat and a nested Jobs_ParallelFor and chains of jobs
+// tied with Jobs_Depend, from the main thread and from a second thread at
+// the same time, and checks every result against a serial run.  Jobs that
+// depend on each other in a ring must end in the "can never finish"
+// Sys_Error, from the main thread's wait and from a job's; those run in
+// child processes.
+
+#include "../../quakedef.h"
+#include "../../jobs.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define	FLAT_COUNT		5000
+#define	NEST_ROWS		24
+#define	NEST_COLS		700
+#define	CHAINS			8
+#define	CHAIN_LENGTH	12
+
+typedef struct
+{
+	unsigned int	flat[FLAT_COUNT];
+	unsigned int	nest[NEST_ROWS][NEST_COLS];
+	int				chain[CHAINS][CHAIN_LENGTH];	// the order the links ran in
+	int				chainpos[CHAINS];
+} work_t;
+
+typedef struct
+{
+	work_t	*work;
+	int		chain, link;
+} chainlink_t;
+
+static work_t	serial;
+static work_t	mainwork, otherwork;
+
+// something that takes a while and can't be guessed
+static unsigned int Stress_Hash (unsigned int x)
+{
+	int		i;
+
+	for (i=0 ; i<64 ; i++)
+	{
+		x ^= x >> 16;
+		x *= 0x7feb352d;
+		x ^= x >> 15;
+	}
+	return x;
+}
+
+static void Stress_Flat (void *data, int first, int last)
+{
+	work_t	*w = data;
+	int		i;
+
+	for (i=first ; i<last ; i++)
+		w->flat[i] = Stress_Hash (i);
+}
+
+typedef struct
+{
+	work_t	*work;
+	int		row;
+} row_t;
+
+static void Stress_Cols (void *data, int first, int last)
+{
+	row_t	*r = data;
+	int		i;
+
+	for (i=first ; i<last ; i++)
+		r->work->nest[r->row][i] = Stress_Hash (r->row * NEST_COLS + i);
+}
+
+// each row splits itself up again
+static void Stress_Rows (void *data, int first, int last)
+{
+	row_t	r;
+	int		i;
+
+	r.work = data;
+	for (i=first ; i<last ; i++)
+	{
+		r.row = i;
+		Jobs_ParallelFor ("Stress_Cols", Stress_Cols, &r, NEST_COLS, 50);
+	}
+}
+
+static void Stress_Link (void *data, int first, int last)
+{
+	chainlink_t	*l = data;
+	work_t		*w = l->work;
+
+	Stress_Hash (l->link);
+	w->chain[l->chain][w->chainpos[l->chain]++] = l->link;
+}
+
+/*
+=================
+Stress_Chains
+
+Each chain's links run one after another, released by the one before
+finishing; a join job waits for the last link of every chain
+=================
+*/
+static void Stress_Chains (work_t *w)
+{
+	static chainlink_t	links[2][CHAINS][CHAIN_LENGTH];
+	chainlink_t		(*l)[CHAIN_LENGTH];
+	job_t			*root, *join, *job[CHAIN_LENGTH];
+	int				c, i, order[CHAIN_LENGTH];
+
+	l = links[w == &otherwork];
+	memset (w->chainpos, 0, sizeof(w->chainpos));
+
+	root = Jobs_Create ("Stress_Chains", NULL, NULL, NULL);
+	join = Jobs_Create ("Stress_Join", NULL, NULL, root);
+	for (c=0 ; c<CHAINS ; c++)
+	{
+		// the links are created and run in a scrambled order
+		for (i=0 ; i<CHAIN_LENGTH ; i++)
+			order[i] = (i * 5 + c) % CHAIN_LENGTH;
+		for (i=0 ; i<CHAIN_LENGTH ; i++)
+		{
+			l[c][i].work = w;
+			l[c][i].chain = c;
+			l[c][i].link = i;
+			job[i] = Jobs_Create ("Stress_Link", Stress_Link, &l[c][i], root);
+		}
+		for (i=1 ; i<CHAIN_LENGTH ; i++)
+			Jobs_Depend (job[i], job[i-1]);
+		Jobs_Depend (join, job[CHAIN_LENGTH-1]);
+		for (i=0 ; i<CHAIN_LENGTH ; i++)
+			Jobs_Run (job[order[i]]);
+	}
+	Jobs_Run (join);
+	Jobs_Run (root);
+	Jobs_Wait (root);
+}
+
+static void Stress_Work (work_t *w)
+{
+	memset (w, 0, sizeof(*w));
+	Jobs_ParallelFor ("Stress_Flat", Stress_Flat, w, FLAT_COUNT, 64);
+	Jobs_ParallelFor ("Stress_Rows", Stress_Rows, w, NEST_ROWS, 1);
+	Stress_Chains (w);
+}
+
+static void Stress_Serial (work_t *w)
+{
+	row_t	r;
+	int		c, i;
+
+	memset (w, 0, sizeof(*w));
+	Stress_Flat (w, 0, FLAT_COUNT);
+	r.work = w;
+	for (r.row=0 ; r.row<NEST_ROWS ; r.row++)
+		Stress_Cols (&r, 0, NEST_COLS);
+	for (c=0 ; c<CHAINS ; c++)
+	{
+		for (i=0 ; i<CHAIN_LENGTH ; i++)
+			w->chain[c][i] = i;
+		w->chainpos[c] = CHAIN_LENGTH;
+	}
+}
+
+static void Stress_Compare (work_t *w, char *who, int round)
+{
+	if (memcmp (w, &serial, sizeof(serial)))
+		Sys_Error ("round %i: the %s thread's results differ from the serial run", round, who);
+}
+
+/*
+=================
+Stress_Other
+
+The second thread, the way the pipelined server tick uses the jobs
+=================
+*/
+static void		*other_go, *other_done;
+static int		other_rounds;
+
+static void Stress_Other (void *arg)
+{
+	int		i;
+
+	for (i=0 ; i<other_rounds ; i++)
+	{
+		Sys_SemaphoreWait (other_go);
+		Stress_Work (&otherwork);
+		Sys_SemaphorePost (other_done);
+	}
+}
+
+/*
+=================
+Stress_Ring
+
+Jobs that wait for each other in a ring, which no thread can ever start
+=================
+*/
+static void Stress_RingJob (void *data, int first, int last)
+{
+}
+
+static void Stress_Ring (void)
+{
+	job_t	*root, *a, *b, *c;
+
+	root = Jobs_Create ("Stress_Ring", NULL, NULL, NULL);
+	a = Jobs_Create ("Stress_RingA", Stress_RingJob, NULL, root);
+	b = Jobs_Create ("Stress_RingB", Stress_RingJob, NULL, root);
+	c = Jobs_Create ("Stress_RingC", Stress_RingJob, NULL, root);
+	Jobs_Depend (b, a);
+	Jobs_Depend (c, b);
+	Jobs_Depend (a, c);
+	Jobs_Run (a);
+	Jobs_Run (b);
+	Jobs_Run (c);
+	Jobs_Run (root);
+	Jobs_Wait (root);
+}
+
+static void Stress_NestedRing (void *data, int first, int last)
+{
+	Stress_Ring ();
+}
+
+/*
+=================
+Stress_Expect
+
+Runs func in a child process, which must end in a Sys_Error saying error
+=================
+*/
+static void Stress_Expect (char *name, void (*func) (void), char *error)
+{
+	char	out[1024];
+	int		pipes[2], status, len, n;
+	pid_t	pid;
+
+	if (pipe (pipes))
+		Sys_Error ("%s: no pipe", name);
+
+	fflush (stdout);
+	pid = fork ();
+	if (!pid)
+	{
+		close (pipes[0]);
+		dup2 (pipes[1], 2);
+		alarm (20);		// a hang is a failure too
+		func ();
+		exit (0);
+	}
+	close (pipes[1]);
+
+	len = 0;
+	while (len < (int)sizeof(out) - 1 && (n = read (pipes[0], out + len, sizeof(out) - 1 - len)) > 0)
+		len += n;
+	out[len] = 0;
+	close (pipes[0]);
+	waitpid (pid, &status, 0);
+
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 1 || !strstr (out, error))
+		Sys_Error ("%s: expected \"%s\", the child ended with status %i and said:\n%s", name, error, status, out);
+	printf ("jobs_stress: %s ended in \"%s\"\n", name, error);
+}
+
+static void Stress_RingMain (void)
+{
+	Jobs_Init ();
+	Stress_Ring ();
+}
+
+static void Stress_RingNested (void)
+{
+	Jobs_Init ();
+	Jobs_ParallelFor ("Stress_NestedRing", Stress_NestedRing, NULL, 1, 1);
+}
+
+int main (int argc, char **argv)
+{
+	static byte	hunk[1024*1024];
+	int			i, rounds;
+
+	Sys_Init ();
+	COM_InitArgv (argc, argv);
+	Memory_Init (hunk, sizeof(hunk));
+
+	rounds = 200;
+	if ((i = COM_CheckParm ("-rounds")) && i < com_argc-1)
+		rounds = Q_atoi (com_argv[i+1]);
+
+	// before any thread is started, so the children fork clean
+	Stress_Expect ("a ring from the main thread", Stress_RingMain, "Stress_Ring can never finish");
+	Stress_Expect ("a ring from a job", Stress_RingNested, "Stress_Ring can never finish");
+
+	Jobs_Init ();
+	Stress_Serial (&serial);
+
+	other_rounds = rounds;
+	other_go = Sys_CreateSemaphore (0);
+	other_done = Sys_CreateSemaphore (0);
+	if (!Sys_CreateThread (Stress_Other, NULL))
+		Sys_Error ("Couldn't start the second thread");
+
+	for (i=0 ; i<rounds ; i++)
+	{
+		Sys_SemaphorePost (other_go);
+		Stress_Work (&mainwork);
+		Sys_SemaphoreWait (other_done);
+
+		Stress_Compare (&mainwork, "main", i);
+		Stress_Compare (&otherwork, "second", i);
+	}
+
+	printf ("jobs_stress: %i rounds on %i threads and a second one matched the serial run\n",
+		rounds, Jobs_NumThreads ());
+	return 0;
+}
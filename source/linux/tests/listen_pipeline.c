@@ -0,0 +1,209 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// listen_pipeline.c -- a listen server with host_pipeline 0 and 1
+//
+//   make -f Makefile.linux listen_pipeline
+//   ./build/linux/listen_pipeline [-frames n] [-keep]
+//
+// Starts a listen server on the game directory testgame.c makes, with the
+// null renderer still running the view and the hud, and plays the map for
+// the same number of fixed length frames with the tick in line and then
+// pipelined.  Entities thrown at the start fall under gravity, and the
+// player's progs set the strings and fields the hud reads.  Both runs must
+// end with every edict the same and with the hud's copies of the player's
+// fields filled in.
+
+#include "../../quakedef.h"
+#include "testgame.h"
+
+#define	FRAME_TIME		0.05
+
+static char	listen_entities[] =
+	"{\n\"classname\" \"worldspawn\"\n}\n"
+	"{\n\"classname\" \"info_test\"\n\"origin\" \"16 -32 48\"\n\"movetype\" \"6\"\n\"velocity\" \"40 0 200\"\n}\n"
+	"{\n\"classname\" \"info_test\"\n\"origin\" \"-8 8 0\"\n\"movetype\" \"6\"\n\"velocity\" \"-5 75 -10\"\n}\n"
+	"{\n\"classname\" \"info_test\"\n\"origin\" \"100 100 100\"\n}\n";
+
+#define	G_NAMEFIELD		(sizeof(globalvars_t) / 4)	// the Weapon_Name field's offset
+#define	G_TOUCHFIELD	(G_NAMEFIELD + 1)			// Weapon_Name_Touch's
+#define	G_ADSFIELD		(G_NAMEFIELD + 2)			// ADS_Offset's
+#define	G_ENEMYFIELD	(G_NAMEFIELD + 3)			// facingenemy's
+#define	G_NAME			(G_NAMEFIELD + 4)			// "Colt"
+#define	G_ADS			(G_NAMEFIELD + 5)			// a vector
+#define	G_ONE			(G_NAMEFIELD + 8)
+#define	G_POINTER		(G_NAMEFIELD + 9)
+#define	G_NAMETEMP		(G_NAMEFIELD + 10)
+#define	NUM_GLOBALS		(G_NAMEFIELD + 11)
+
+#define	SELF			TEST_GLOBALOFS(self)
+
+static testdef_t	listen_fields[] =
+{
+	TEST_FIELD(ev_float, modelindex),
+	TEST_FIELD(ev_float, movetype),
+	TEST_FIELD(ev_float, solid),
+	TEST_FIELD(ev_vector, origin),
+	TEST_FIELD(ev_vector, velocity),
+	TEST_FIELD(ev_vector, angles),
+	TEST_FIELD(ev_string, classname),
+	TEST_FIELD(ev_string, Weapon_Name),
+	TEST_FIELD(ev_string, Weapon_Name_Touch),
+	TEST_FIELD(ev_vector, ADS_Offset),
+	TEST_FIELD(ev_float, facingenemy),
+};
+
+static testdef_t	listen_globals[] =
+{
+	TEST_GLOBAL(ev_string, mapname),
+	TEST_GLOBAL(ev_float, serverflags),
+};
+
+static dstatement_t	listen_statements[] =
+{
+	{0},
+	{OP_DONE},
+// PutClientInServer: self.Weapon_Name = "Colt", self.ADS_Offset = G_ADS,
+// self.facingenemy = 1
+	{OP_ADDRESS, SELF, G_NAMEFIELD, G_POINTER},
+	{OP_STOREP_S, G_NAME, G_POINTER, 0},
+	{OP_ADDRESS, SELF, G_ADSFIELD, G_POINTER},
+	{OP_STOREP_V, G_ADS, G_POINTER, 0},
+	{OP_ADDRESS, SELF, G_ENEMYFIELD, G_POINTER},
+	{OP_STOREP_F, G_ONE, G_POINTER, 0},
+	{OP_DONE},
+// PlayerPreThink: self.Weapon_Name_Touch = self.Weapon_Name
+	{OP_LOAD_S, SELF, G_NAMEFIELD, G_NAMETEMP},
+	{OP_ADDRESS, SELF, G_TOUCHFIELD, G_POINTER},
+	{OP_STOREP_S, G_NAMETEMP, G_POINTER, 0},
+	{OP_DONE},
+};
+
+static testfunc_t	listen_functions[] =
+{
+	{"done", 1},
+	{"worldspawn", 1},
+	{"info_test", 1},
+	{"PutClientInServer", 2},
+	{"PlayerPreThink", 9},
+};
+
+static char *Listen_MakeGame (void)
+{
+	static int		globals[NUM_GLOBALS];
+	testprogs_t		p;
+	int				i;
+
+	globals[TEST_GLOBALOFS(StartFrame)] = 1;
+	globals[TEST_GLOBALOFS(PlayerPostThink)] = 1;
+	globals[TEST_GLOBALOFS(ClientConnect)] = 1;
+	globals[TEST_GLOBALOFS(ClientDisconnect)] = 1;
+	globals[TEST_GLOBALOFS(SetNewParms)] = 1;
+	globals[TEST_GLOBALOFS(SetChangeParms)] = 1;
+	globals[TEST_GLOBALOFS(ClientKill)] = 1;
+	globals[TEST_GLOBALOFS(PutClientInServer)] = 4;
+	globals[TEST_GLOBALOFS(PlayerPreThink)] = 5;
+
+	globals[G_NAMEFIELD] = offsetof(entvars_t, Weapon_Name) / 4;
+	globals[G_TOUCHFIELD] = offsetof(entvars_t, Weapon_Name_Touch) / 4;
+	globals[G_ADSFIELD] = offsetof(entvars_t, ADS_Offset) / 4;
+	globals[G_ENEMYFIELD] = offsetof(entvars_t, facingenemy) / 4;
+	globals[G_NAME] = Test_String ("Colt");
+	for (i=0 ; i<3 ; i++)
+		globals[G_ADS+i] = *(int *)&(float){i * 10 + 5};
+	globals[G_ONE] = *(int *)&(float){1};
+
+	p.fields = listen_fields;
+	p.numfields = sizeof(listen_fields)/sizeof(listen_fields[0]);
+	p.globaldefs = listen_globals;
+	p.numglobaldefs = sizeof(listen_globals)/sizeof(listen_globals[0]);
+	p.functions = listen_functions;
+	p.numfunctions = sizeof(listen_functions)/sizeof(listen_functions[0]);
+	p.statements = listen_statements;
+	p.numstatements = sizeof(listen_statements)/sizeof(listen_statements[0]);
+	p.globals = globals;
+	p.numglobals = NUM_GLOBALS;
+
+	return Test_MakeGame ("listen_pipeline", listen_entities, &p);
+}
+
+/*
+=================
+Listen_Run
+
+Plays the map from the start with host_pipeline set to pipeline, and
+returns the server's state at the end of it
+=================
+*/
+static char *Listen_Run (int pipeline, int frames)
+{
+	int		i;
+
+	Cvar_SetValue ("host_pipeline", pipeline);
+	Cbuf_AddText ("map " TEST_MAP "\n");
+
+	for (i=0 ; i<frames ; i++)
+	{
+		key_dest = key_game;		// single player physics stop in the menus
+		Host_Frame (FRAME_TIME);
+	}
+	Host_WaitServerFrame ();
+
+	if (!sv.active || cls.state != ca_connected || cls.signon != SIGNONS)
+		Sys_Error ("host_pipeline %i: the client never got into the game", pipeline);
+	if (strcmp (cl.weaponname, "Colt") || strcmp (cl.touchname, "Colt")
+		|| cl.adsoffset[0] != 5 || cl.adsoffset[1] != 15 || cl.adsoffset[2] != 25 || cl.facingenemy != 1)
+		Sys_Error ("host_pipeline %i: the hud has \"%s\" \"%s\" %g %g %g %g", pipeline, cl.weaponname,
+			cl.touchname, cl.adsoffset[0], cl.adsoffset[1], cl.adsoffset[2], cl.facingenemy);
+
+	return Test_Snapshot ();
+}
+
+int main (int argc, char **argv)
+{
+	char	*dir, *serial, *pipelined;
+	int		i, frames, keep;
+
+	frames = 200;
+	keep = 0;
+	for (i=1 ; i<argc ; i++)
+	{
+		if (!strcmp (argv[i], "-keep"))
+			keep = 1;
+		else if (!strcmp (argv[i], "-frames") && i < argc-1)
+			frames = atoi (argv[++i]);
+	}
+
+	Sys_Init ();
+	dir = Listen_MakeGame ();
+	Test_StartHost (dir, false);
+	Cvar_SetValue ("host_framerate", FRAME_TIME);
+
+	serial = Listen_Run (0, frames);
+	pipelined = Listen_Run (1, frames);
+	if (strcmp (serial, pipelined))
+		Test_Differ ("the runs differ", "host_pipeline 0", serial, "host_pipeline 1", pipelined);
+
+	printf ("listen_pipeline: %i frames with the tick in line and pipelined ended the same\n", frames);
+	Test_RemoveGame (dir, keep);
+
+	free (serial);
+	free (pipelined);
+	return 0;
+}
@@ -0,0 +1,202 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// save_roundtrip.c -- binary saves against themselves and against text saves
+//
+//   make -f Makefile.linux save_roundtrip
+//   ./build/linux/save_roundtrip [-keep]
+//
+// Builds a game directory (testgame.c) with a progs whose spawn functions
+// only link their edicts, the way a game's do, then starts the dedicated
+// server on it and runs the real save and load commands:
+//
+//   save a, save t text	the same state in both formats
+//   load a, save b			a and b must be byte for byte the same
+//   load t					every field the progs defines, on every edict,
+//							and the saved globals must match what load a gave
+//
+// -keep leaves the game directory in /tmp to look at.
+
+#include "../../quakedef.h"
+#include "testgame.h"
+
+// the entities are where the edict fields come from: strings from the
+// map, a repeated one, an entity reference, and an entity without a spawn
+// function that leaves a free edict behind
+static char	save_entities[] =
+	"{\n\"classname\" \"worldspawn\"\n\"message\" \"save round trip\"\n}\n"
+	"{\n\"classname\" \"info_test\"\n\"origin\" \"16 -32 48.5\"\n\"angles\" \"0 90 0\"\n"
+		"\"health\" \"100.25\"\n\"netname\" \"first\"\n\"targetname\" \"door\"\n}\n"
+	"{\n\"classname\" \"info_gone\"\n\"netname\" \"never spawned\"\n}\n"
+	"{\n\"classname\" \"info_test\"\n\"origin\" \"-8 8 0\"\n\"netname\" \"first\"\n"
+		"\"owner\" \"2\"\n\"enemy\" \"0\"\n\"health\" \"-3.5\"\n}\n"
+	"{\n\"classname\" \"info_test\"\n\"netname\" \"second\"\n\"target\" \"door\"\n\"owner\" \"4\"\n}\n";
+
+#define	G_PROGSTRING	(sizeof(globalvars_t) / 4)
+#define	G_PROGENTITY	(G_PROGSTRING + 1)
+#define	G_PROGFLOAT		(G_PROGSTRING + 2)
+#define	G_ORIGIN		(G_PROGSTRING + 3)	// the origin field's offset
+#define	G_SETORIGIN		(G_PROGSTRING + 4)	// the setorigin function
+#define	G_PLAYER		(G_PROGSTRING + 5)	// edict 1
+#define	NUM_GLOBALS		(G_PROGSTRING + 6)
+
+static testdef_t	save_fields[] =
+{
+	TEST_FIELD(ev_float, modelindex),
+	TEST_FIELD(ev_float, movetype),
+	TEST_FIELD(ev_float, solid),
+	TEST_FIELD(ev_vector, origin),
+	TEST_FIELD(ev_vector, angles),
+	TEST_FIELD(ev_string, classname),
+	TEST_FIELD(ev_string, model),
+	TEST_FIELD(ev_float, health),
+	TEST_FIELD(ev_string, netname),
+	TEST_FIELD(ev_entity, enemy),
+	TEST_FIELD(ev_entity, owner),
+	TEST_FIELD(ev_string, target),
+	TEST_FIELD(ev_string, targetname),
+	TEST_FIELD(ev_string, message),
+};
+
+static testdef_t	save_globals[] =
+{
+	TEST_GLOBAL(ev_string, mapname),
+	TEST_GLOBAL(ev_float, serverflags),
+	TEST_GLOBAL(ev_float, rounds),
+	{ev_string | DEF_SAVEGLOBAL, G_PROGSTRING, "save_progstring"},
+	{ev_entity | DEF_SAVEGLOBAL, G_PROGENTITY, "save_entity"},
+	{ev_float | DEF_SAVEGLOBAL, G_PROGFLOAT, "save_float"},
+};
+
+// setorigin (ent, ent.origin), which links ent
+#define	SETORIGIN(ent)	\
+	{OP_STORE_ENT, ent, OFS_PARM0, 0},	\
+	{OP_LOAD_V, ent, G_ORIGIN, OFS_PARM1},	\
+	{OP_CALL2, G_SETORIGIN, 0, 0}
+
+static dstatement_t	save_statements[] =
+{
+	{0},
+	{OP_DONE},							// StartFrame
+	SETORIGIN(G_PLAYER), {OP_DONE},		// worldspawn, for the player a game would spawn
+	SETORIGIN(TEST_GLOBALOFS(self)), {OP_DONE},	// info_test
+};
+
+static testfunc_t	save_functions[] =
+{
+	{"StartFrame", 1},
+	{"worldspawn", 2},
+	{"info_test", 6},
+	{"setorigin", -2},
+};
+
+static char *Save_MakeGame (void)
+{
+	static int		globals[NUM_GLOBALS];
+	testprogs_t		p;
+
+	globals[TEST_GLOBALOFS(StartFrame)] = 1;
+	globals[TEST_GLOBALOFS(rounds)] = *(int *)&(float){7};
+	globals[G_PROGSTRING] = Test_String ("a progs string");
+	globals[G_PROGENTITY] = TEST_EDICT(3);
+	globals[G_PROGFLOAT] = *(int *)&(float){2.5};
+	globals[G_ORIGIN] = offsetof(entvars_t, origin) / 4;
+	globals[G_SETORIGIN] = sizeof(save_functions)/sizeof(save_functions[0]);
+	globals[G_PLAYER] = TEST_EDICT(1);
+
+	p.fields = save_fields;
+	p.numfields = sizeof(save_fields)/sizeof(save_fields[0]);
+	p.globaldefs = save_globals;
+	p.numglobaldefs = sizeof(save_globals)/sizeof(save_globals[0]);
+	p.functions = save_functions;
+	p.numfunctions = sizeof(save_functions)/sizeof(save_functions[0]);
+	p.statements = save_statements;
+	p.numstatements = sizeof(save_statements)/sizeof(save_statements[0]);
+	p.globals = globals;
+	p.numglobals = NUM_GLOBALS;
+
+	return Test_MakeGame ("save_roundtrip", save_entities, &p);
+}
+
+static byte *Save_Load (char *dir, char *name, int *len)
+{
+	char	path[MAX_OSPATH];
+	byte	*data;
+	FILE	*f;
+
+	snprintf (path, sizeof(path), "%s/%s/%s.sav", dir, GAMENAME, name);
+	f = fopen (path, "rb");
+	if (!f)
+		Sys_Error ("%s wasn't written", path);
+	fseek (f, 0, SEEK_END);
+	*len = ftell (f);
+	fseek (f, 0, SEEK_SET);
+	data = malloc (*len);
+	if (!data || fread (data, 1, *len, f) != *len)
+		Sys_Error ("couldn't read %s", path);
+	fclose (f);
+	return data;
+}
+
+int main (int argc, char **argv)
+{
+	char			*dir, *snapshot, *textsnapshot;
+	byte			*a, *b;
+	int				alen, blen, i, keep;
+
+	keep = 0;
+	for (i=1 ; i<argc ; i++)
+		if (!strcmp (argv[i], "-keep"))
+			keep = 1;
+
+	Sys_Init ();
+	dir = Save_MakeGame ();
+	Test_StartHost (dir, true);
+
+	Test_Command ("map " TEST_MAP);
+	Test_Command ("save a");
+	Test_Command ("save t text");
+
+	// a binary save of a loaded binary save is the same file
+	Test_Command ("load a");
+	snapshot = Test_Snapshot ();
+	Test_Command ("save b");
+	a = Save_Load (dir, "a", &alen);
+	b = Save_Load (dir, "b", &blen);
+	if (alen != blen)
+		Sys_Error ("save b is %i bytes, save a %i", blen, alen);
+	for (i=0 ; i<alen ; i++)
+		if (a[i] != b[i])
+			Sys_Error ("saves a and b differ at byte %i of %i", i, alen);
+
+	// and the text save of the same state loads the same edicts
+	Test_Command ("load t");
+	textsnapshot = Test_Snapshot ();
+	if (strcmp (snapshot, textsnapshot))
+		Test_Differ ("after load t", "binary", snapshot, "text", textsnapshot);
+
+	printf ("save_roundtrip: a %i byte binary save loaded and saved again unchanged, and matched the text save\n", alen);
+	Test_RemoveGame (dir, keep);
+
+	free (a);
+	free (b);
+	free (snapshot);
+	free (textsnapshot);
+	return 0;
+}
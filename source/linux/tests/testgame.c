@@ -0,0 +1,453 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// testgame.c -- a game directory of its own for the tests that start a
+// server, so they need no game data
+
+#include "../../quakedef.h"
+#include "testgame.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+int Test_Append (testbuf_t *b, void *data, int size)
+{
+	int		ofs;
+
+	while (b->size + size + 4 > b->maxsize)
+	{
+		b->maxsize = b->maxsize ? b->maxsize * 2 : 4096;
+		b->data = realloc (b->data, b->maxsize);
+		if (!b->data)
+			Sys_Error ("Test_Append: out of memory");
+	}
+	ofs = b->size;
+	if (data)
+		memcpy (b->data + ofs, data, size);
+	else
+		memset (b->data + ofs, 0, size);
+	b->size += size;
+
+	while (b->size & 3)
+		b->data[b->size++] = 0;
+	return ofs;
+}
+
+void Test_Print (testbuf_t *b, char *fmt, ...)
+{
+	va_list	argptr;
+	char	line[256];
+	int		len;
+
+	va_start (argptr, fmt);
+	len = vsnprintf (line, sizeof(line), fmt, argptr);
+	va_end (argptr);
+
+	if (b->size + len + 1 > b->maxsize)
+	{
+		b->maxsize = (b->size + len + 1) * 2;
+		b->data = realloc (b->data, b->maxsize);
+		if (!b->data)
+			Sys_Error ("Test_Print: out of memory");
+	}
+	memcpy (b->data + b->size, line, len + 1);
+	b->size += len;
+}
+
+static void Test_WriteFile (char *path, void *data, int size)
+{
+	FILE	*f;
+
+	f = fopen (path, "wb");
+	if (!f || fwrite (data, 1, size, f) != size || fclose (f))
+		Sys_Error ("couldn't write %s", path);
+}
+
+/*
+==============================================================================
+
+THE GAME DIRECTORY
+
+==============================================================================
+*/
+
+/*
+=================
+Test_MakeMap
+
+One node on one plane with the empty leaf on both sides, and no faces
+=================
+*/
+static void Test_MakeMap (char *path, char *entities)
+{
+	testbuf_t	b;
+	dheader_t	header;
+	dplane_t	plane;
+	dnode_t		node;
+	dclipnode_t	clipnode;
+	dleaf_t		leafs[2];
+	dmodel_t	model;
+	lump_t		*l;
+	int			i;
+
+	memset (&b, 0, sizeof(b));
+	memset (&header, 0, sizeof(header));
+	header.version = BSPVERSION;
+	Test_Append (&b, &header, sizeof(header));
+
+	l = &header.lumps[LUMP_ENTITIES];
+	l->filelen = strlen(entities) + 1;
+	l->fileofs = Test_Append (&b, entities, l->filelen);
+
+	memset (&plane, 0, sizeof(plane));
+	plane.normal[0] = 1;
+	plane.type = PLANE_X;
+	l = &header.lumps[LUMP_PLANES];
+	l->filelen = sizeof(plane);
+	l->fileofs = Test_Append (&b, &plane, l->filelen);
+
+	memset (&node, 0, sizeof(node));
+	node.children[0] = node.children[1] = -2;	// leaf 1
+	for (i=0 ; i<3 ; i++)
+	{
+		node.mins[i] = -4096;
+		node.maxs[i] = 4096;
+	}
+	l = &header.lumps[LUMP_NODES];
+	l->filelen = sizeof(node);
+	l->fileofs = Test_Append (&b, &node, l->filelen);
+
+	memset (&clipnode, 0, sizeof(clipnode));
+	clipnode.children[0] = clipnode.children[1] = CONTENTS_EMPTY;
+	l = &header.lumps[LUMP_CLIPNODES];
+	l->filelen = sizeof(clipnode);
+	l->fileofs = Test_Append (&b, &clipnode, l->filelen);
+
+	memset (leafs, 0, sizeof(leafs));
+	leafs[0].contents = CONTENTS_SOLID;
+	leafs[0].visofs = -1;
+	leafs[1].contents = CONTENTS_EMPTY;
+	leafs[1].visofs = -1;
+	for (i=0 ; i<3 ; i++)
+	{
+		leafs[1].mins[i] = -4096;
+		leafs[1].maxs[i] = 4096;
+	}
+	l = &header.lumps[LUMP_LEAFS];
+	l->filelen = sizeof(leafs);
+	l->fileofs = Test_Append (&b, leafs, l->filelen);
+
+	memset (&model, 0, sizeof(model));
+	for (i=0 ; i<3 ; i++)
+	{
+		model.mins[i] = -4096;
+		model.maxs[i] = 4096;
+	}
+	model.visleafs = 1;
+	l = &header.lumps[LUMP_MODELS];
+	l->filelen = sizeof(model);
+	l->fileofs = Test_Append (&b, &model, l->filelen);
+
+	// the empty lumps still need somewhere to be
+	for (i=0 ; i<HEADER_LUMPS ; i++)
+		if (!header.lumps[i].filelen)
+			header.lumps[i].fileofs = b.size;
+
+	memcpy (b.data, &header, sizeof(header));
+	Test_WriteFile (path, b.data, b.size);
+	free (b.data);
+}
+
+static testbuf_t	test_strings;
+
+int Test_String (char *s)
+{
+	if (!test_strings.size)
+		Test_Append (&test_strings, "", 1);
+	return Test_Append (&test_strings, s, strlen(s) + 1);
+}
+
+static void Test_Defs (ddef_t *out, testdef_t *in, int count)
+{
+	int		i;
+
+	memset (out, 0, sizeof(*out));		// def 0 is the null one
+	for (i=0 ; i<count ; i++)
+	{
+		out[i+1].type = in[i].type;
+		out[i+1].ofs = in[i].ofs;
+		out[i+1].s_name = Test_String (in[i].name);
+	}
+}
+
+/*
+=================
+Test_MakeProgs
+=================
+*/
+static void Test_MakeProgs (char *path, testprogs_t *p)
+{
+	testbuf_t		b;
+	dprograms_t		progs;
+	dfunction_t		*functions;
+	ddef_t			*fields, *globaldefs;
+	int				i;
+
+	functions = calloc (p->numfunctions + 1, sizeof(*functions));
+	fields = calloc (p->numfields + 1, sizeof(*fields));
+	globaldefs = calloc (p->numglobaldefs + 1, sizeof(*globaldefs));
+	if (!functions || !fields || !globaldefs)
+		Sys_Error ("Test_MakeProgs: out of memory");
+
+	for (i=0 ; i<p->numfunctions ; i++)
+	{
+		functions[i+1].first_statement = p->functions[i].first_statement;
+		functions[i+1].parm_start = p->numglobals;
+		functions[i+1].s_name = Test_String (p->functions[i].name);
+	}
+	Test_Defs (fields, p->fields, p->numfields);
+	Test_Defs (globaldefs, p->globaldefs, p->numglobaldefs);
+
+	memset (&b, 0, sizeof(b));
+	memset (&progs, 0, sizeof(progs));
+	Test_Append (&b, &progs, sizeof(progs));
+	progs.version = PROG_VERSION;
+	progs.numstatements = p->numstatements;
+	progs.ofs_statements = Test_Append (&b, p->statements, p->numstatements * sizeof(dstatement_t));
+	progs.numfunctions = p->numfunctions + 1;
+	progs.ofs_functions = Test_Append (&b, functions, progs.numfunctions * sizeof(*functions));
+	progs.numfielddefs = p->numfields + 1;
+	progs.ofs_fielddefs = Test_Append (&b, fields, progs.numfielddefs * sizeof(*fields));
+	progs.numglobaldefs = p->numglobaldefs + 1;
+	progs.ofs_globaldefs = Test_Append (&b, globaldefs, progs.numglobaldefs * sizeof(*globaldefs));
+	progs.numglobals = p->numglobals;
+	progs.ofs_globals = Test_Append (&b, p->globals, p->numglobals * 4);
+	progs.numstrings = test_strings.size;
+	progs.ofs_strings = Test_Append (&b, test_strings.data, test_strings.size);
+	progs.entityfields = sizeof(entvars_t) / 4;
+	memcpy (b.data, &progs, sizeof(progs));
+
+	Test_WriteFile (path, b.data, b.size);
+	free (b.data);
+	free (functions);
+	free (fields);
+	free (globaldefs);
+}
+
+/*
+=================
+Test_MakeGame
+
+A client starts with a palette and a colormap, all black will do
+=================
+*/
+char *Test_MakeGame (char *name, char *entities, testprogs_t *progs)
+{
+	static byte	black[256*64];
+	char		path[MAX_OSPATH];
+	char		*dir;
+
+	dir = malloc (strlen(name) + 16);
+	if (!dir)
+		Sys_Error ("Test_MakeGame: out of memory");
+	sprintf (dir, "/tmp/%sXXXXXX", name);
+	if (!mkdtemp (dir))
+		Sys_Error ("couldn't make a game directory");
+
+	snprintf (path, sizeof(path), "%s/%s", dir, GAMENAME);
+	mkdir (path, 0777);
+	snprintf (path, sizeof(path), "%s/%s/maps", dir, GAMENAME);
+	mkdir (path, 0777);
+	snprintf (path, sizeof(path), "%s/%s/gfx", dir, GAMENAME);
+	mkdir (path, 0777);
+
+	snprintf (path, sizeof(path), "%s/%s/progs.dat", dir, GAMENAME);
+	Test_MakeProgs (path, progs);
+	snprintf (path, sizeof(path), "%s/%s/maps/%s.bsp", dir, GAMENAME, TEST_MAP);
+	Test_MakeMap (path, entities);
+	snprintf (path, sizeof(path), "%s/%s/gfx/palette.lmp", dir, GAMENAME);
+	Test_WriteFile (path, black, 768);
+	snprintf (path, sizeof(path), "%s/%s/gfx/colormap.lmp", dir, GAMENAME);
+	Test_WriteFile (path, black, sizeof(black));
+
+	return dir;
+}
+
+void Test_RemoveGame (char *dir, qboolean keep)
+{
+	char	cmd[MAX_OSPATH + 16];
+
+	if (keep)
+	{
+		printf ("the game is in %s\n", dir);
+		return;
+	}
+	snprintf (cmd, sizeof(cmd), "rm -rf %s", dir);
+	system (cmd);
+}
+
+/*
+==============================================================================
+
+THE HOST
+
+==============================================================================
+*/
+
+void Test_StartHost (char *dir, qboolean dedicated)
+{
+	static quakeparms_t	parms;
+	static char			*args[8];
+	int					i;
+
+	i = 0;
+	args[i++] = "test";
+	if (dedicated)
+	{
+		args[i++] = "-dedicated";
+		args[i++] = "1";
+	}
+	args[i++] = "-nosound";
+	args[i++] = "-noudp";
+	args[i++] = "-basedir";
+	args[i++] = dir;
+	COM_InitArgv (i, args);
+
+	parms.argc = com_argc;
+	parms.argv = com_argv;
+	parms.basedir = dir;
+	parms.memsize = 16 * 1024 * 1024;
+	parms.membase = malloc (parms.memsize);
+	if (!parms.membase)
+		Sys_Error ("no memory for the hunk");
+	isDedicated = dedicated;
+
+	Host_Init (&parms);
+}
+
+void Test_Command (char *cmd)
+{
+	Cmd_ExecuteString (cmd, src_command);
+	if (!sv.active)
+		Sys_Error ("\"%s\" left no server running", cmd);
+}
+
+/*
+=================
+Test_Value
+
+A def's value as text, floats by their bits so nothing is rounded away
+=================
+*/
+static void Test_Value (testbuf_t *b, int type, int *v)
+{
+	switch (type & ~DEF_SAVEGLOBAL)
+	{
+	case ev_string:
+		Test_Print (b, "\"%s\"\n", pr_strings + *v);
+		break;
+	case ev_entity:
+		Test_Print (b, "entity %i\n", NUM_FOR_EDICT(PROG_TO_EDICT(*v)));
+		break;
+	case ev_vector:
+		Test_Print (b, "%08x %08x %08x\n", v[0], v[1], v[2]);
+		break;
+	default:
+		Test_Print (b, "%08x\n", *v);
+		break;
+	}
+}
+
+/*
+=================
+Test_Snapshot
+
+Everything a text save keeps: the saved globals, the light styles and
+every defined field of every edict.  A text save can't tell an edict
+with nothing set from a free one, so both read as free.
+=================
+*/
+char *Test_Snapshot (void)
+{
+	testbuf_t	b;
+	edict_t		*ent;
+	ddef_t		*d;
+	int			e, i, *v;
+	qboolean	used;
+
+	memset (&b, 0, sizeof(b));
+	Test_Print (&b, "%i edicts, time %08x\n", sv.num_edicts, *(int *)&sv.time);
+
+	for (i=0 ; i<progs->numglobaldefs ; i++)
+	{
+		d = &pr_globaldefs[i];
+		if (!(d->type & DEF_SAVEGLOBAL))
+			continue;
+		Test_Print (&b, "global %s ", pr_strings + d->s_name);
+		Test_Value (&b, d->type, (int *)pr_globals + d->ofs);
+	}
+
+	for (i=0 ; i<MAX_LIGHTSTYLES ; i++)
+		Test_Print (&b, "lightstyle %i \"%s\"\n", i, sv.lightstyles[i] ? sv.lightstyles[i] : "m");
+
+	for (e=0 ; e<sv.num_edicts ; e++)
+	{
+		ent = EDICT_NUM(e);
+		used = false;
+		for (i=1 ; i<progs->numfielddefs && !ent->free ; i++)
+		{
+			d = &pr_fielddefs[i];
+			v = (int *)&ent->v + d->ofs;
+			if (v[0] || (d->type == ev_vector && (v[1] || v[2])))
+				used = true;
+		}
+		if (!used)
+		{
+			Test_Print (&b, "edict %i free\n", e);
+			continue;
+		}
+
+		for (i=1 ; i<progs->numfielddefs ; i++)
+		{
+			d = &pr_fielddefs[i];
+			Test_Print (&b, "edict %i %s ", e, pr_strings + d->s_name);
+			Test_Value (&b, d->type, (int *)&ent->v + d->ofs);
+		}
+	}
+
+	return (char *)b.data;
+}
+
+void Test_Differ (char *what, char *aname, char *a, char *bname, char *b)
+{
+	char	*la, *lb;
+
+	for (la = a, lb = b ; *a && *a == *b ; a++, b++)
+		if (*a == '\n')
+		{
+			la = a + 1;
+			lb = b + 1;
+		}
+
+	a = strchr (la, '\n');
+	b = strchr (lb, '\n');
+	Sys_Error ("%s:\n  %s: %.*s\n  %s: %.*s", what,
+		aname, a ? (int)(a - la) : (int)strlen(la), la,
+		bname, b ? (int)(b - lb) : (int)strlen(lb), lb);
+}
@@ -0,0 +1,88 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// testgame.h -- a game directory of its own for the tests that start a
+// server: a one leaf map, a progs put together from tables, and what a
+// client needs to start
+
+#include <stddef.h>
+
+#define	TEST_MAP		"testmap"
+
+typedef struct
+{
+	byte	*data;
+	int		size, maxsize;
+} testbuf_t;
+
+// every lump starts on a long, so this pads to one
+int Test_Append (testbuf_t *b, void *data, int size);
+// text, left without a pad or a terminator counted in size
+void Test_Print (testbuf_t *b, char *fmt, ...);
+
+typedef struct
+{
+	int		type;
+	int		ofs;
+	char	*name;
+} testdef_t;
+
+#define	TEST_FIELD(t,n)		{t, offsetof(entvars_t, n) / 4, #n}
+#define	TEST_GLOBAL(t,n)	{t | DEF_SAVEGLOBAL, offsetof(globalvars_t, n) / 4, #n}
+#define	TEST_GLOBALOFS(n)	(offsetof(globalvars_t, n) / 4)
+
+// the entity global for edict n, with entityfields sizeof(entvars_t) / 4
+#define	TEST_EDICT(n)		((n) * (int)sizeof(edict_t))
+
+typedef struct
+{
+	char	*name;
+	int		first_statement;	// negative for a builtin
+} testfunc_t;
+
+typedef struct
+{
+	testdef_t		*fields;
+	int				numfields;
+	testdef_t		*globaldefs;
+	int				numglobaldefs;
+	testfunc_t		*functions;		// function 1 on, 0 is the null one
+	int				numfunctions;
+	dstatement_t	*statements;
+	int				numstatements;
+	int				*globals;
+	int				numglobals;
+} testprogs_t;
+
+// the offset of s in the progs' strings, for a string global
+int Test_String (char *s);
+
+// a new directory in /tmp with the game in it, name is the prefix
+char *Test_MakeGame (char *name, char *entities, testprogs_t *progs);
+void Test_RemoveGame (char *dir, qboolean keep);
+
+// Sys_Init has been called, a listen server if !dedicated
+void Test_StartHost (char *dir, qboolean dedicated);
+// runs cmd, which has to leave a server running
+void Test_Command (char *cmd);
+
+// everything a text save keeps, in a buffer to free
+char *Test_Snapshot (void);
+// Sys_Errors with the first line two snapshots differ on
+void Test_Differ (char *what, char *aname, char *a, char *bname, char *b);
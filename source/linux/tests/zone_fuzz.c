@@ -0,0 +1,443 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// zone_fuzz.c -- random Z_Malloc / Z_Free / Z_Realloc runs against the
+// original first fit zone
+//
+//   make -f Makefile.linux zone_fuzz
+//   ./build/linux/zone_fuzz [-seeds n] [-ops n] [-zone kb] [-zonelarge kb]
+//
+// Every seed drives the same operations through both zones.  After each
+// one both heaps are checked, and every live block in either must still
+// hold the bytes written to it.  Once everything is freed, each zone must
+// hand out its whole free space in one block again.  A small -zone fills
+// the large blocks' share, so they are split from the rest of it too.
+
+#include "../../quakedef.h"
+
+#define	MAX_SLOTS	256
+
+/*
+==============================================================================
+
+THE BASELINE ZONE
+
+The zone as it was before the size class lists and the large blocks: one
+list of blocks, first fit from a rover
+
+==============================================================================
+*/
+
+#define	BZONEID	0x1d4a11
+#define	BMINFRAGMENT	64
+
+typedef struct bblock_s
+{
+	int	size;
+	int	tag;
+	int	id;
+	int	pad;
+	struct	bblock_s	*next, *prev;
+} bblock_t;
+
+typedef struct
+{
+	int		size;
+	bblock_t	blocklist;
+	bblock_t	*rover;
+} bzone_t;
+
+static bzone_t	*bzone;
+
+static void BZ_ClearZone (bzone_t *zone, int size)
+{
+	bblock_t	*block;
+
+	zone->blocklist.next = zone->blocklist.prev = block =
+		(bblock_t *)( (byte *)zone + sizeof(bzone_t) );
+	zone->blocklist.tag = 1;
+	zone->blocklist.id = 0;
+	zone->blocklist.size = 0;
+	zone->rover = block;
+
+	block->prev = block->next = &zone->blocklist;
+	block->tag = 0;
+	block->id = BZONEID;
+	block->size = size - sizeof(bzone_t);
+}
+
+static void BZ_Free (void *ptr)
+{
+	bblock_t	*block, *other;
+
+	block = (bblock_t *) ( (byte *)ptr - sizeof(bblock_t));
+	if (block->id != BZONEID || !block->tag)
+		Sys_Error ("BZ_Free: bad pointer");
+
+	block->tag = 0;
+
+	other = block->prev;
+	if (!other->tag)
+	{
+		other->size += block->size;
+		other->next = block->next;
+		other->next->prev = other;
+		if (block == bzone->rover)
+			bzone->rover = other;
+		block = other;
+	}
+
+	other = block->next;
+	if (!other->tag)
+	{
+		block->size += other->size;
+		block->next = other->next;
+		block->next->prev = block;
+		if (other == bzone->rover)
+			bzone->rover = block;
+	}
+}
+
+static void *BZ_TagMalloc (int size, int tag)
+{
+	int		extra;
+	bblock_t	*start, *rover, *newblock, *base;
+
+	size += sizeof(bblock_t);
+	size += 4;
+	size = (size + 7) & ~7;
+
+	base = rover = bzone->rover;
+	start = base->prev;
+
+	do
+	{
+		if (rover == start)
+			return NULL;
+		if (rover->tag)
+			base = rover = rover->next;
+		else
+			rover = rover->next;
+	} while (base->tag || base->size < size);
+
+	extra = base->size - size;
+	if (extra > BMINFRAGMENT)
+	{
+		newblock = (bblock_t *) ((byte *)base + size );
+		newblock->size = extra;
+		newblock->tag = 0;
+		newblock->prev = base;
+		newblock->id = BZONEID;
+		newblock->next = base->next;
+		newblock->next->prev = newblock;
+		base->next = newblock;
+		base->size = size;
+	}
+
+	base->tag = tag;
+	bzone->rover = base->next;
+	base->id = BZONEID;
+	*(int *)((byte *)base + base->size - 4) = BZONEID;
+
+	return (void *) ((byte *)base + sizeof(bblock_t));
+}
+
+// the baseline freed first and then took a block, so a failure loses the
+// data; it was a Sys_Error there
+static void *BZ_Realloc (void *ptr, int size, int keep)
+{
+	void	*p;
+	byte	save[16384];
+
+	if (keep > (int)sizeof(save))
+		keep = sizeof(save);
+	memcpy (save, ptr, keep);
+	BZ_Free (ptr);
+	p = BZ_TagMalloc (size, 1);
+	if (p)
+		memcpy (p, save, keep);
+	return p;
+}
+
+static void BZ_CheckHeap (void)
+{
+	bblock_t	*block;
+
+	for (block = bzone->blocklist.next ; ; block = block->next)
+	{
+		if (block->next == &bzone->blocklist)
+			break;
+		if ( (byte *)block + block->size != (byte *)block->next)
+			Sys_Error ("BZ_CheckHeap: block size does not touch the next block");
+		if ( block->next->prev != block)
+			Sys_Error ("BZ_CheckHeap: next block doesn't have proper back link");
+		if (!block->tag && !block->next->tag)
+			Sys_Error ("BZ_CheckHeap: two consecutive free blocks");
+		if (block->tag && *(int *)((byte *)block + block->size - 4) != BZONEID)
+			Sys_Error ("BZ_CheckHeap: memory trashed past the end of a block");
+	}
+}
+
+static int BZ_LargestFree (void)
+{
+	bblock_t	*block;
+	int			largest;
+
+	largest = 0;
+	for (block = bzone->blocklist.next ; block != &bzone->blocklist ; block = block->next)
+		if (!block->tag && block->size > largest)
+			largest = block->size;
+	return largest;
+}
+
+/*
+==============================================================================
+
+THE RUNS
+
+==============================================================================
+*/
+
+typedef struct
+{
+	byte	*z, *b;		// the block in each zone, or NULL
+	int		size;
+	byte	fill;
+} slot_t;
+
+static slot_t	slots[MAX_SLOTS];
+static int		fuzz_seed;
+static int		fuzz_zonesize;
+static int		zfails, bfails;
+
+static unsigned int	fuzz_rand;
+
+static int Fuzz_Rand (int n)
+{
+	fuzz_rand = fuzz_rand * 1103515245 + 12345;
+	return (fuzz_rand >> 8) % n;
+}
+
+// mostly strings and small structures, now and then a file
+static int Fuzz_Size (void)
+{
+	int		r;
+
+	r = Fuzz_Rand (100);
+	if (r < 70)
+		return 1 + Fuzz_Rand (256);
+	if (r < 92)
+		return 256 + Fuzz_Rand (2048);
+	return 2048 + Fuzz_Rand (14336);
+}
+
+static void Fuzz_Fill (byte *p, int start, int end, byte fill)
+{
+	int		i;
+
+	for (i=start ; i<end ; i++)
+		p[i] = (byte)(fill + i);
+}
+
+static void Fuzz_Verify (slot_t *s, int op)
+{
+	int		i;
+
+	for (i=0 ; i<s->size ; i++)
+	{
+		if (s->z && s->z[i] != (byte)(s->fill + i))
+			Sys_Error ("seed %i op %i: zone block of %i bytes changed at %i", fuzz_seed, op, s->size, i);
+		if (s->b && s->b[i] != (byte)(s->fill + i))
+			Sys_Error ("seed %i op %i: baseline block of %i bytes changed at %i", fuzz_seed, op, s->size, i);
+	}
+}
+
+// Z_Realloc can't fail softly, so it is only asked for what the zone can
+// clearly give it
+static qboolean Fuzz_CanRealloc (int size)
+{
+	int		i, live;
+
+	live = 0;
+	for (i=0 ; i<MAX_SLOTS ; i++)
+		if (slots[i].z)
+			live += slots[i].size + 64;
+	return live + size < fuzz_zonesize / 4;
+}
+
+static void Fuzz_Run (int ops)
+{
+	slot_t	*s;
+	int		op, i, size;
+	byte	*p;
+
+	fuzz_rand = fuzz_seed;
+
+	for (op=0 ; op<ops ; op++)
+	{
+		s = &slots[Fuzz_Rand (MAX_SLOTS)];
+
+		if (!s->z && !s->b)
+		{
+			// Z_Malloc
+			s->size = Fuzz_Size ();
+			s->fill = Fuzz_Rand (256);
+			s->z = Z_TagMalloc (s->size, 1);
+			s->b = BZ_TagMalloc (s->size, 1);
+			if (!s->z)
+				zfails++;
+			if (!s->b)
+				bfails++;
+			if (s->z)
+				Fuzz_Fill (s->z, 0, s->size, s->fill);
+			if (s->b)
+				Fuzz_Fill (s->b, 0, s->size, s->fill);
+		}
+		else if (Fuzz_Rand (3))
+		{
+			// Z_Free
+			Fuzz_Verify (s, op);
+			if (s->z)
+				Z_Free (s->z);
+			if (s->b)
+				BZ_Free (s->b);
+			s->z = s->b = NULL;
+		}
+		else
+		{
+			// Z_Realloc, larger or smaller
+			Fuzz_Verify (s, op);
+			size = Fuzz_Size ();
+			if (s->z && Fuzz_CanRealloc (size))
+			{
+				s->z = Z_Realloc (s->z, size);
+			}
+			else if (s->z)
+			{
+				Z_Free (s->z);
+				s->z = NULL;
+			}
+			if (s->b)
+			{
+				s->b = BZ_Realloc (s->b, size, MIN(s->size, size));
+				if (!s->b)
+					bfails++;
+			}
+			p = s->z ? s->z : s->b;
+			if (p)
+			{
+				if (s->z)
+					Fuzz_Fill (s->z, s->size, size, s->fill);
+				if (s->b)
+					Fuzz_Fill (s->b, s->size, size, s->fill);
+			}
+			s->size = size;
+		}
+
+		Z_CheckHeap ();
+		BZ_CheckHeap ();
+	}
+
+	for (i=0 ; i<MAX_SLOTS ; i++)
+	{
+		s = &slots[i];
+		Fuzz_Verify (s, ops);
+		if (s->z)
+			Z_Free (s->z);
+		if (s->b)
+			BZ_Free (s->b);
+		s->z = s->b = NULL;
+	}
+	Z_CheckHeap ();
+	BZ_CheckHeap ();
+}
+
+// the largest block the zone can give, and the largest after that one is
+// taken, which comes from the large blocks' share when there is one
+static int Fuzz_LargestFree (void)
+{
+	void	*p[2];
+	int		i, size, total;
+
+	total = 0;
+	for (i=0 ; i<2 ; i++)
+	{
+		for (size = fuzz_zonesize ; size > 0 ; size -= 8)
+			if ((p[i] = Z_TagMalloc (size, 1)))
+				break;
+		total += size;
+	}
+	for (i=0 ; i<2 ; i++)
+		if (p[i])
+			Z_Free (p[i]);
+	return total;
+}
+
+// with nothing live, each zone is one free block again
+static void Fuzz_CheckEmpty (int zonefree)
+{
+	if (Fuzz_LargestFree () != zonefree)
+		Sys_Error ("seed %i: the zone didn't come back together", fuzz_seed);
+
+	if (BZ_LargestFree () != fuzz_zonesize - (int)sizeof(bzone_t))
+		Sys_Error ("seed %i: the baseline zone didn't come back together", fuzz_seed);
+}
+
+int main (int argc, char **argv)
+{
+	static byte	hunk[4*1024*1024];
+	int			i, seeds, ops, zonefree;
+
+	Sys_Init ();
+	COM_InitArgv (argc, argv);
+
+	seeds = 64;
+	ops = 20000;
+	fuzz_zonesize = 256 * 1024;
+	if ((i = COM_CheckParm ("-seeds")) && i < com_argc-1)
+		seeds = Q_atoi (com_argv[i+1]);
+	if ((i = COM_CheckParm ("-ops")) && i < com_argc-1)
+		ops = Q_atoi (com_argv[i+1]);
+	if ((i = COM_CheckParm ("-zone")) && i < com_argc-1)
+		fuzz_zonesize = Q_atoi (com_argv[i+1]) * 1024;
+	else
+	{
+		// Memory_Init takes the zone's size from the command line
+		static char	*zoneargv[] = {"zone_fuzz", "-zone", "256"};
+		COM_InitArgv (3, zoneargv);
+	}
+
+	Memory_Init (hunk, sizeof(hunk));
+	bzone = malloc (fuzz_zonesize);
+	BZ_ClearZone (bzone, fuzz_zonesize);
+
+	zonefree = Fuzz_LargestFree ();
+	if (zonefree <= 0)
+		Sys_Error ("the empty zone has no room");
+
+	for (fuzz_seed=1 ; fuzz_seed<=seeds ; fuzz_seed++)
+	{
+		Fuzz_Run (ops);
+		Fuzz_CheckEmpty (zonefree);
+	}
+
+	printf ("zone_fuzz: %i seeds of %i operations in a %iK zone, %i failed allocations against %i in the baseline\n",
+		seeds, ops, fuzz_zonesize / 1024, zfails, bfails);
+	return 0;
+}
@@ -0,0 +1,506 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// texcook.cpp -- converts a game directory's images into what the PSP and
+// Wii upload, ahead of time
+//
+//   nzportable-texcook -psp [-texcompr n] [-noscaledown] [-phat] [-resample n] <gamedir>
+//   nzportable-texcook -wii [-maxsize n] <gamedir>
+//
+// Every image loadtextureimage would pick is run through the same
+// conversion code the port builds and written to
+// <gamedir>/cooked/<platform>/<name>.ctx.  The options have to match the
+// cvars the console runs with; a cooked file made for other settings is
+// noticed at load time and the source is converted as before.
+//
+// Only sources that decode to the same pixels here as on the console are
+// cooked.  The Wii decodes everything but pcx with this same stb_image, so
+// tga, png and jpg are cooked.  The PSP decodes with libpng, libjpeg and
+// its own tga reader: png and true colour tga give the same pixels, jpg
+// does not and is left alone, as are pcx and bmp, which are paletted or
+// rare.  Only loose files are cooked, not the contents of paks.
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "texcook_host.h"
+#include "../psp/gu/gu_texconv.h"
+#include "../wii/gx/gx_texconv.h"
+
+extern "C"
+{
+#include "../texcook.h"
+}
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_FAILURE_USERMSG
+#define STBI_ONLY_JPEG
+#define STBI_ONLY_PNG
+#define STBI_ONLY_TGA
+#define STBI_ONLY_PIC
+#include "../stb_image.h"
+
+#define	MAX_DEPTH				16
+#define	IMAGE_MAX_DIMENSIONS	4096		// the PSP's loaders refuse larger
+#define	GX_SCALED_MAX			(640*480)	// GL_Upload32's buffer
+
+static const char	*psp_exts[] = TEXCOOK_PSP_EXTS;
+static const char	*wii_exts[] = TEXCOOK_WII_EXTS;
+
+static int			platform;
+static const char	**exts;
+static gutexopts_t	psp_opts = {5, true, false, 0};
+static int			wii_maxsize = 1024;
+
+static char			gamedir[1024];
+
+// stem -> the index of every extension it has
+static std::map<std::string, std::vector<int> >	images;
+
+static int			numcooked, numskipped;
+
+extern "C" void Sys_Error (const char *error, ...)
+{
+	va_list		argptr;
+
+	fprintf (stderr, "Error: ");
+	va_start (argptr, error);
+	vfprintf (stderr, error, argptr);
+	va_end (argptr);
+	fprintf (stderr, "\n");
+
+	exit (1);
+}
+
+extern "C" void *Q_malloc (size_t size)
+{
+	void	*p;
+
+	p = malloc (size);
+	if (!p)
+		Sys_Error ("Q_malloc: failed on allocation of %i bytes", (int)size);
+
+	return p;
+}
+
+/*
+=================
+FindImages
+=================
+*/
+static void FindImages (const char *rel, int depth)
+{
+	char			path[2048], name[1024];
+	DIR				*dir;
+	struct dirent	*de;
+	struct stat		st;
+	const char		*ext;
+	int				i;
+
+	if (rel[0])
+		snprintf (path, sizeof(path), "%s/%s", gamedir, rel);
+	else
+		snprintf (path, sizeof(path), "%s", gamedir);
+
+	dir = opendir (path);
+	if (!dir)
+		return;
+
+	while ((de = readdir (dir)) != NULL)
+	{
+		if (de->d_name[0] == '.')
+			continue;
+
+		if (rel[0])
+			snprintf (name, sizeof(name), "%s/%s", rel, de->d_name);
+		else
+			snprintf (name, sizeof(name), "%s", de->d_name);
+		snprintf (path, sizeof(path), "%s/%s", gamedir, name);
+
+		if (stat (path, &st) == -1)
+			continue;
+
+		if (S_ISDIR (st.st_mode))
+		{
+			if (depth < MAX_DEPTH && strcmp (name, "cooked"))
+				FindImages (name, depth + 1);
+			continue;
+		}
+
+		ext = strrchr (name, '.');
+		if (!ext || strchr (ext, '/'))
+			continue;
+
+		for (i=0 ; exts[i] ; i++)
+		{
+			if (!strcmp (ext + 1, exts[i]))
+			{
+				images[std::string (name, ext - name)].push_back (i);
+				break;
+			}
+		}
+	}
+
+	closedir (dir);
+}
+
+/*
+=================
+LoadFile
+=================
+*/
+static byte *LoadFile (const char *path, int *len)
+{
+	FILE	*f;
+	byte	*buf;
+
+	f = fopen (path, "rb");
+	if (!f)
+		return NULL;
+
+	fseek (f, 0, SEEK_END);
+	*len = ftell (f);
+	fseek (f, 0, SEEK_SET);
+
+	buf = (byte *)Q_malloc (*len + 1);
+	if (fread (buf, 1, *len, f) != (size_t)*len)
+	{
+		free (buf);
+		buf = NULL;
+	}
+	fclose (f);
+
+	return buf;
+}
+
+/*
+=================
+CreatePath
+=================
+*/
+static void CreatePath (char *path)
+{
+	char	*ofs;
+
+	for (ofs = path+1 ; *ofs ; ofs++)
+	{
+		if (*ofs == '/')
+		{
+			*ofs = 0;
+			mkdir (path, 0777);
+			*ofs = '/';
+		}
+	}
+}
+
+/*
+=================
+PSP_Decodes
+
+Whether the PSP's own loader gives the pixels stb_image does
+=================
+*/
+static bool PSP_Decodes (const char *ext, const byte *file, int len)
+{
+	if (!strcmp (ext, "tga"))
+	{
+		// true colour, not interleaved; 15 and 16 bit and the colour
+		// mapped kinds are expanded differently
+		if (len < 18 || (file[2] != 2 && file[2] != 10))
+			return false;
+		if (file[16] != 24 && file[16] != 32)
+			return false;
+		return (file[17] & 0xC0) == 0;
+	}
+
+	if (!strcmp (ext, "png"))
+	{
+		// every kind is expanded alike, interlaced ones are left to libpng
+		return len >= 29 && file[28] == 0;
+	}
+
+	return false;
+}
+
+/*
+=================
+CookPSP
+=================
+*/
+static int CookPSP (const char *identifier, byte *pixels, int width, int height, texcookhdr_t *hdr, byte **out)
+{
+	gutexdesc_t	desc;
+	byte		*scratch;
+	int			size;
+
+	if (width > IMAGE_MAX_DIMENSIONS || height > IMAGE_MAX_DIMENSIONS)
+		return 0;
+
+	GL_DescribeImage (&desc, &psp_opts, identifier, width, height, true, 0, 4);
+
+	// GL_Upload16 only takes two bytes a texel
+	if (desc.format == GU_PSM_4444)
+		return 0;
+
+	size = GL_ImageSize (&desc);
+	*out = (byte *)Q_malloc (size);
+	scratch = (byte *)Q_malloc (desc.width * desc.height * 4);
+
+	if (desc.swizzle)
+		GL_ConvertSwizzled (&desc, 4, psp_opts.resample, pixels, width, height, *out, scratch);
+	else
+		GL_ConvertDXT (&desc, 4, psp_opts.resample, pixels, width, height, *out, scratch);
+
+	free (scratch);
+
+	hdr->format = desc.format;
+	hdr->scaled_width = desc.width;
+	hdr->scaled_height = desc.height;
+	hdr->mipmaps = desc.mipmaps;
+	hdr->swizzle = desc.swizzle;
+	hdr->resample = psp_opts.resample;
+
+	return size;
+}
+
+/*
+=================
+CookWii
+=================
+*/
+static int CookWii (byte *pixels, int width, int height, texcookhdr_t *hdr, byte **out)
+{
+	int			i, s, sw, sh, lhcsum, lhcsumtable[256];
+	unsigned	*texels, *scaled;
+	u16			*tiled;
+
+	GX_ScaledSize (width, height, wii_maxsize, &sw, &sh);
+	if (sw * sh > GX_SCALED_MAX)
+		return 0;
+
+	// GL_LoadTexture's checksum over the decoded bytes
+	lhcsum = 0;
+	s = width * height * 4;
+	for (i = 0;i < 256;i++) lhcsumtable[i] = i + 1;
+	for (i = 0;i < s;i++) lhcsum += (lhcsumtable[pixels[i] & 255]++);
+
+	// the console reads the bytes as big endian words
+	texels = (unsigned *)Q_malloc (width * height * 4);
+	for (i=0 ; i<width*height ; i++)
+		texels[i] = (pixels[i*4] << 24) | (pixels[i*4+1] << 16) | (pixels[i*4+2] << 8) | pixels[i*4+3];
+
+	scaled = (unsigned *)Q_malloc (sw * sh * 4);
+	if (sw != width || sh != height)
+		GL_ResampleTexture (texels, width, height, scaled, sw, sh);
+	else
+		memcpy (scaled, texels, sw * sh * 4);
+
+	tiled = (u16 *)Q_malloc (sw * sh * 2);
+	GX_CopyRGBA8_To_RGB5A3 (tiled, scaled, 0, 0, sw, sh, sw, false);
+
+	*out = (byte *)tiled;
+	for (i=0 ; i<sw*sh ; i++)
+	{
+		s = tiled[i];
+		(*out)[i*2] = s >> 8;
+		(*out)[i*2+1] = s & 0xff;
+	}
+
+	free (scaled);
+	free (texels);
+
+	hdr->format = GX_TF_RGB5A3;
+	hdr->scaled_width = sw;
+	hdr->scaled_height = sh;
+	hdr->checksum = lhcsum;
+
+	return sw * sh * 2;
+}
+
+/*
+=================
+CookImage
+=================
+*/
+static void CookImage (const std::string &stem, int ext)
+{
+	char			path[2048];
+	byte			*file, *pixels, *data;
+	int				i, len, width, height, comp, datasize;
+	texcookhdr_t	hdr;
+	FILE			*f;
+
+	snprintf (path, sizeof(path), "%s/%s.%s", gamedir, stem.c_str (), exts[ext]);
+	file = LoadFile (path, &len);
+	if (!file)
+	{
+		fprintf (stderr, "couldn't read %s\n", path);
+		numskipped++;
+		return;
+	}
+
+	if (platform == TEXCOOK_PSP && !PSP_Decodes (exts[ext], file, len))
+	{
+		free (file);
+		numskipped++;
+		return;
+	}
+
+	pixels = stbi_load_from_memory (file, len, &width, &height, &comp, 4);
+	if (!pixels)
+	{
+		fprintf (stderr, "%s: %s\n", path, stbi_failure_reason ());
+		free (file);
+		numskipped++;
+		return;
+	}
+
+	memset (&hdr, 0, sizeof(hdr));
+	memcpy (hdr.id, "NZTC", 4);
+	hdr.version = TEXCOOK_VERSION;
+	hdr.platform = platform;
+	hdr.srcext = ext;
+	hdr.srcsize = len;
+	hdr.width = width;
+	hdr.height = height;
+
+	data = NULL;
+	if (platform == TEXCOOK_PSP)
+		datasize = CookPSP (stem.c_str (), pixels, width, height, &hdr, &data);
+	else
+		datasize = CookWii (pixels, width, height, &hdr, &data);
+	hdr.datasize = datasize;
+
+	stbi_image_free (pixels);
+	free (file);
+
+	if (!datasize)
+	{
+		numskipped++;
+		return;
+	}
+
+	// the header is little endian whatever it is read on
+	for (i=1 ; i<sizeof(texcookhdr_t)/4 ; i++)
+	{
+		unsigned	v = ((unsigned *)&hdr)[i];
+		byte		*b = (byte *)&((unsigned *)&hdr)[i];
+
+		b[0] = v & 0xff;
+		b[1] = (v >> 8) & 0xff;
+		b[2] = (v >> 16) & 0xff;
+		b[3] = v >> 24;
+	}
+
+	snprintf (path, sizeof(path), "%s/cooked/%s/%s.ctx", gamedir,
+		platform == TEXCOOK_PSP ? "psp" : "wii", stem.c_str ());
+	CreatePath (path);
+
+	f = fopen (path, "wb");
+	if (!f)
+		Sys_Error ("couldn't write %s: %s", path, strerror (errno));
+	fwrite (&hdr, 1, sizeof(hdr), f);
+	fwrite (data, 1, datasize, f);
+	fclose (f);
+
+	free (data);
+	numcooked++;
+}
+
+/*
+=================
+Usage
+=================
+*/
+static void Usage (void)
+{
+	fprintf (stderr,
+		"usage: nzportable-texcook -psp [-texcompr n] [-noscaledown] [-phat] [-resample n] <gamedir>\n"
+		"       nzportable-texcook -wii [-maxsize n] <gamedir>\n");
+	exit (1);
+}
+
+/*
+=================
+main
+=================
+*/
+int main (int argc, char **argv)
+{
+	std::map<std::string, std::vector<int> >::iterator	it;
+	int			i, best;
+
+	for (i=1 ; i<argc ; i++)
+	{
+		if (!strcmp (argv[i], "-psp"))
+			platform = TEXCOOK_PSP;
+		else if (!strcmp (argv[i], "-wii"))
+			platform = TEXCOOK_WII;
+		else if (!strcmp (argv[i], "-texcompr") && i+1 < argc)
+			psp_opts.texcompr = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-noscaledown"))
+			psp_opts.scale_down = false;
+		else if (!strcmp (argv[i], "-phat"))
+			psp_opts.phat = true;
+		else if (!strcmp (argv[i], "-resample") && i+1 < argc)
+			psp_opts.resample = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-maxsize") && i+1 < argc)
+			wii_maxsize = atoi (argv[++i]);
+		else if (argv[i][0] == '-' || gamedir[0])
+			Usage ();
+		else
+			snprintf (gamedir, sizeof(gamedir), "%s", argv[i]);
+	}
+
+	if (!platform || !gamedir[0])
+		Usage ();
+
+	exts = platform == TEXCOOK_PSP ? psp_exts : wii_exts;
+	FindImages ("", 0);
+
+	for (it = images.begin () ; it != images.end () ; ++it)
+	{
+		// the one the port's loader picks
+		best = -1;
+		for (i=0 ; i<(int)it->second.size () ; i++)
+			if (best == -1 || it->second[i] < best)
+				best = it->second[i];
+
+		// pcx goes through the palette on both
+		if (!strcmp (exts[best], "pcx") || !strcmp (exts[best], "bmp"))
+		{
+			numskipped++;
+			continue;
+		}
+
+		CookImage (it->first, best);
+	}
+
+	printf ("%i textures cooked, %i left to load from source\n", numcooked, numskipped);
+
+	return 0;
+}
@@ -0,0 +1,53 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// texcook_host.h -- the little of quakedef.h the ports' texture conversions
+// need, for building them into texcook
+
+#ifndef __TEXCOOK_HOST_H__
+#define __TEXCOOK_HOST_H__
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+typedef unsigned char	byte;
+typedef unsigned short	u16;
+typedef unsigned int	u32;
+typedef bool			qboolean;
+
+// the PSP's vfpu copy, for gu_resample
+#define memcpy_vfpu		memcpy
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+void Sys_Error (const char *error, ...);
+void *Q_malloc (size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __TEXCOOK_HOST_H__
@@ -0,0 +1,383 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// loadtrace.c -- timed scopes around the stages of startup and map loading
+//
+// host_speeds only splits a running frame.  The loaders mark their stages
+// with LoadTrace_Begin / LoadTrace_End, and each scope records its wall
+// time, the bytes the sys layer read and what the hunk, zone and cache
+// handed out while it was open.  "loadtimes" prints the scopes as a tree,
+// with siblings of the same name added together, and "loadtrace" writes
+// them as a Chrome trace (chrome://tracing, or ui.perfetto.dev).
+//
+// The log keeps the most recent top level scopes (Host_Init,
+// SV_SpawnServer, CL_ParseServerInfo...) in a fixed number of events,
+// -loadtrace <events> on the command line, 0 to turn it off.
+
+#include "quakedef.h"
+#include "loadtrace.h"
+
+#define	LOADTRACE_EVENTS	1024
+#define	MAX_LOADDEPTH		16
+
+typedef struct
+{
+	char	*name;
+	char	detail[24];
+	int		depth;
+	int		next;				// the event after this one's children, -1 while open
+	double	start;
+	float	time;
+// the totals when the scope began, what it added once it has ended
+	int		read;
+	int		hunk;
+	int		zone;
+	int		cache;
+} loadevent_t;
+
+cvar_t	host_loadtimes = {"host_loadtimes", "0"};	// print each top level scope as it ends
+
+static	loadevent_t	*lt_events;
+static	int			lt_max = -1;		// -1 until the first scope reads -loadtrace
+static	int			lt_count;
+static	int			lt_dropped;
+
+static	int			lt_stack[MAX_LOADDEPTH];
+static	int			lt_depth;
+static	int			lt_skipped;			// open scopes that weren't logged
+
+static void LoadTrace_Print (int first, int last);
+
+/*
+=================
+LoadTrace_Trim
+
+Drops the oldest top level scopes until the log is at most half full
+=================
+*/
+static void LoadTrace_Trim (void)
+{
+	int		i, first;
+
+	first = 0;
+	while (lt_count - first > lt_max / 2)
+		first = lt_events[first].next;
+	if (!first)
+		return;
+
+	memmove (lt_events, lt_events + first, (lt_count - first) * sizeof(*lt_events));
+	lt_count -= first;
+	for (i=0 ; i<lt_count ; i++)
+		lt_events[i].next -= first;
+}
+
+/*
+=================
+LoadTrace_Begin
+=================
+*/
+void LoadTrace_Begin (char *name, char *detail)
+{
+	loadevent_t	*e;
+	int			i;
+
+	if (lt_max < 0)
+	{
+		i = COM_CheckParm ("-loadtrace");
+		if (i && i < com_argc - 1)
+			lt_max = Q_atoi (com_argv[i+1]);
+		else
+			lt_max = LOADTRACE_EVENTS;
+		if (lt_max > 0)
+			lt_events = malloc (lt_max * sizeof(*lt_events));
+		if (!lt_events)
+			lt_max = 0;
+	}
+
+	if (!lt_events)
+		return;
+
+	if (!lt_depth && !lt_skipped)
+		LoadTrace_Trim ();
+
+	if (lt_skipped || lt_depth == MAX_LOADDEPTH || lt_count == lt_max)
+	{
+		lt_skipped++;
+		lt_dropped++;
+		return;
+	}
+
+	e = &lt_events[lt_count];
+	e->name = name;
+	Q_strncpyz (e->detail, detail ? detail : "", sizeof(e->detail));
+	e->depth = lt_depth;
+	e->next = -1;
+	e->read = sys_bytesread;
+	e->hunk = alloc_stats.hunk;
+	e->zone = alloc_stats.zone;
+	e->cache = alloc_stats.cache;
+	e->start = Sys_FloatTime ();
+
+	lt_stack[lt_depth++] = lt_count++;
+}
+
+/*
+=================
+LoadTrace_End
+=================
+*/
+void LoadTrace_End (void)
+{
+	loadevent_t	*e;
+
+	if (lt_skipped)
+	{
+		lt_skipped--;
+		return;
+	}
+	if (!lt_depth)
+		return;
+
+	e = &lt_events[lt_stack[--lt_depth]];
+	e->time = Sys_FloatTime () - e->start;
+	e->read = sys_bytesread - e->read;
+	e->hunk = alloc_stats.hunk - e->hunk;
+	e->zone = alloc_stats.zone - e->zone;
+	e->cache = alloc_stats.cache - e->cache;
+	e->next = lt_count;
+
+	if (!lt_depth && host_loadtimes.value)
+		LoadTrace_Print (e - lt_events, lt_count);
+}
+
+/*
+=================
+LoadTrace_Abort
+=================
+*/
+void LoadTrace_Abort (void)
+{
+	while (lt_skipped || lt_depth)
+		LoadTrace_End ();
+}
+
+/*
+=================
+LoadTrace_PrintGroup
+
+nodes are siblings with the same name, printed as one line with their
+children grouped the same way below it
+=================
+*/
+static void LoadTrace_PrintGroup (int *nodes, int count, int depth)
+{
+	loadevent_t	*e;
+	int			i, j, c, numkids, numgroup;
+	int			*kids, *group;
+	byte		*done;
+	double		time;
+	int			read, hunk, zone, cache;
+
+	time = 0;
+	read = hunk = zone = cache = 0;
+	numkids = 0;
+	for (i=0 ; i<count ; i++)
+	{
+		e = &lt_events[nodes[i]];
+		time += e->time;
+		read += e->read;
+		hunk += e->hunk;
+		zone += e->zone;
+		cache += e->cache;
+		numkids += e->next - nodes[i] - 1;
+	}
+
+	e = &lt_events[nodes[0]];
+	if (count > 1)
+		Con_Printf ("%8.1f %6i %6i %5i %6i %*s%s x%i\n", time * 1000, read / 1024, hunk / 1024,
+			zone / 1024, cache / 1024, depth * 2, "", e->name, count);
+	else if (e->detail[0])
+		Con_Printf ("%8.1f %6i %6i %5i %6i %*s%s %s\n", time * 1000, read / 1024, hunk / 1024,
+			zone / 1024, cache / 1024, depth * 2, "", e->name, e->detail);
+	else
+		Con_Printf ("%8.1f %6i %6i %5i %6i %*s%s\n", time * 1000, read / 1024, hunk / 1024,
+			zone / 1024, cache / 1024, depth * 2, "", e->name);
+
+	if (!numkids)
+		return;
+
+	// the direct children of every node in the group
+	kids = malloc (numkids * sizeof(int) * 2 + numkids);
+	if (!kids)
+		return;
+	group = kids + numkids;
+	done = (byte *)(group + numkids);
+
+	numkids = 0;
+	for (i=0 ; i<count ; i++)
+		for (c=nodes[i]+1 ; c<lt_events[nodes[i]].next ; c=lt_events[c].next)
+			kids[numkids++] = c;
+	memset (done, 0, numkids);
+
+	for (i=0 ; i<numkids ; i++)
+	{
+		if (done[i])
+			continue;
+
+		numgroup = 0;
+		for (j=i ; j<numkids ; j++)
+		{
+			if (!done[j] && !strcmp (lt_events[kids[j]].name, lt_events[kids[i]].name))
+			{
+				group[numgroup++] = kids[j];
+				done[j] = true;
+			}
+		}
+		LoadTrace_PrintGroup (group, numgroup, depth + 1);
+	}
+
+	free (kids);
+}
+
+/*
+=================
+LoadTrace_Print
+
+Every ended top level scope from first up to last
+=================
+*/
+static void LoadTrace_Print (int first, int last)
+{
+	int		i;
+
+	Con_Printf ("      ms  readK  hunkK zoneK cacheK\n");
+	for (i=first ; i<last && lt_events[i].next >= 0 ; i=lt_events[i].next)
+		LoadTrace_PrintGroup (&i, 1, 0);
+}
+
+/*
+=================
+LoadTrace_Times_f
+=================
+*/
+static void LoadTrace_Times_f (void)
+{
+	if (Cmd_Argc () > 1 && !Q_strcasecmp (Cmd_Argv (1), "clear"))
+	{
+		if (!lt_depth && !lt_skipped)
+			lt_count = 0;
+		lt_dropped = 0;
+		return;
+	}
+
+	if (!lt_count)
+	{
+		Con_Printf ("nothing has been traced, see -loadtrace\n");
+		return;
+	}
+
+	LoadTrace_Print (0, lt_count);
+	if (lt_dropped)
+		Con_Printf ("%i scopes weren't logged, -loadtrace %i is the limit\n", lt_dropped, lt_max);
+}
+
+/*
+=================
+LoadTrace_Escape
+
+Leaves nothing in a name that would end a json string early
+=================
+*/
+static char *LoadTrace_Escape (char *s)
+{
+	static char	buf[64];
+	int			i;
+
+	for (i=0 ; s[i] && i<sizeof(buf)-1 ; i++)
+	{
+		if (s[i] == '"' || s[i] == '\\')
+			buf[i] = '/';
+		else if ((byte)s[i] < ' ')
+			buf[i] = ' ';
+		else
+			buf[i] = s[i];
+	}
+	buf[i] = 0;
+
+	return buf;
+}
+
+/*
+=================
+LoadTrace_Write_f
+
+Complete ("X") events in the Chrome trace event format, microseconds from
+the first logged scope
+=================
+*/
+static void LoadTrace_Write_f (void)
+{
+	char		path[MAX_OSPATH];
+	loadevent_t	*e;
+	FILE		*f;
+	int			i, written;
+
+	if (!lt_count)
+	{
+		Con_Printf ("nothing has been traced, see -loadtrace\n");
+		return;
+	}
+
+	snprintf (path, sizeof(path), "%s/%s", com_gamedir, Cmd_Argc () > 1 ? Cmd_Argv (1) : "loadtrace.json");
+	f = fopen (path, "w");
+	if (!f)
+	{
+		Con_Printf ("Couldn't write %s\n", path);
+		return;
+	}
+
+	fprintf (f, "{\"traceEvents\":[\n");
+	written = 0;
+	for (i=0, e=lt_events ; i<lt_count ; i++, e++)
+	{
+		if (e->next < 0)
+			continue;		// still open
+		fprintf (f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.0f,\"dur\":%.0f,",
+			written ? ",\n" : "", e->name, (e->start - lt_events[0].start) * 1000000.0, e->time * 1000000.0);
+		fprintf (f, "\"args\":{\"detail\":\"%s\",\"read\":%i,\"hunk\":%i,\"zone\":%i,\"cache\":%i}}",
+			LoadTrace_Escape (e->detail), e->read, e->hunk, e->zone, e->cache);
+		written++;
+	}
+	fprintf (f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose (f);
+
+	Con_Printf ("Wrote %i scopes to %s\n", written, path);
+}
+
+/*
+=================
+LoadTrace_Init
+=================
+*/
+void LoadTrace_Init (void)
+{
+	Cvar_RegisterVariable (&host_loadtimes);
+	Cmd_AddCommand ("loadtimes", LoadTrace_Times_f);
+	Cmd_AddCommand ("loadtrace", LoadTrace_Write_f);
+}
@@ -0,0 +1,265 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* lz.c */
+
+#include "quakedef.h"
+#include "lz.h"
+
+// The stream is groups of a flag byte followed by up to eight items.  A
+// clear flag bit (lowest first) is a literal byte, a set one is a match:
+//
+//		short	distance back from the current output byte
+//		byte	length - LZ_MINMATCH
+//
+// Matches may reach back past the start of the output into lz_dictionary,
+// which both ends place in front of every message.  It holds the strings
+// the signon precache lists are made of, so even the first names in a
+// message compress.  Changing it breaks the protocol.
+
+#define	LZ_MINMATCH		4
+#define	LZ_MAXMATCH		(LZ_MINMATCH + 255)
+#define	LZ_MAXDIST		65535
+
+#define	LZ_HASHBITS		12
+#define	LZ_HASHSIZE		(1 << LZ_HASHBITS)
+#define	LZ_MAXCHAIN		32			// candidates tried per position
+
+static const char lz_dictionary[] =
+	"progs/player.mdl" "progs/s_bubble.spr" "progs/s_explod.spr"
+	"progs/flame.mdl" "progs/flame2.mdl" "progs/bolt.mdl" "progs/VModels/"
+	"maps/" ".bsp" ".spr32" ".spr" ".wav" ".mdl" "_left.mdl" "_right.mdl"
+	"sprites/" "sprites/flame.spr" "sprites/lightning.spr"
+	"models/props/" "models/misc/" "models/pu/" "models/ai/"
+	"models/ai/zfull.mdl" "models/ai/zcfull.mdl" "models/player.mdl"
+	"models/weapons/knife/" "models/weapons/m1911/" "models/weapons/"
+	"/v_" "/g_" "sounds/menu/" "sounds/misc/" "sounds/music/"
+	"sounds/pu/" "sounds/player/" "sounds/zombie/" "sounds/weapons/"
+	"sounds/null.wav" "sounds/rounds/" "sounds/perks/" "sounds/machines/";
+
+#define	LZ_DICTSIZE		((int)sizeof(lz_dictionary) - 1)
+
+// the compressor's tables, about 100K, allocated by the first message a
+// server compresses; a client only ever decompresses
+typedef struct
+{
+	byte	window[LZ_DICTSIZE + NET_MAXMESSAGE];
+	int		head[LZ_HASHSIZE];
+	int		prev[LZ_DICTSIZE + NET_MAXMESSAGE];
+} lzstate_t;
+
+static lzstate_t	*lz;
+
+static int LZ_Hash (const byte *p)
+{
+	unsigned	v;
+
+	v = p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned)p[3] << 24);
+	return (v * 2654435761u) >> (32 - LZ_HASHBITS);
+}
+
+static void LZ_Insert (int pos)
+{
+	int		h;
+
+	h = LZ_Hash (lz->window + pos);
+	lz->prev[pos] = lz->head[h];
+	lz->head[h] = pos;
+}
+
+/*
+==================
+LZ_Compress
+
+Greedy parse with hash chains.  Only messages that fit a client's
+net_message can be compressed.
+==================
+*/
+int LZ_Compress (const byte *in, int inlen, byte *out, int outmax)
+{
+	int		pos, end, cand, chain, len, maxlen;
+	int		bestlen, bestdist;
+	int		outpos, flagpos, bit;
+	int		i;
+
+	if (inlen > NET_MAXMESSAGE || inlen <= LZ_MINMATCH)
+		return 0;
+
+	if (!lz)
+	{
+		lz = malloc (sizeof(*lz));
+		if (!lz)
+			return 0;		// sent as it is
+	}
+
+	memcpy (lz->window, lz_dictionary, LZ_DICTSIZE);
+	memcpy (lz->window + LZ_DICTSIZE, in, inlen);
+	end = LZ_DICTSIZE + inlen;
+
+	memset (lz->head, 0xff, sizeof(lz->head));
+	for (pos = 0 ; pos < LZ_DICTSIZE ; pos++)
+		LZ_Insert (pos);
+
+	outpos = 0;
+	flagpos = 0;
+	bit = 8;
+
+	while (pos < end)
+	{
+		if (bit == 8)
+		{
+			if (outpos >= outmax)
+				return 0;
+			flagpos = outpos++;
+			out[flagpos] = 0;
+			bit = 0;
+		}
+
+	// find the longest earlier match
+		bestlen = bestdist = 0;
+		if (end - pos >= LZ_MINMATCH)
+		{
+			maxlen = end - pos;
+			if (maxlen > LZ_MAXMATCH)
+				maxlen = LZ_MAXMATCH;
+
+			cand = lz->head[LZ_Hash (lz->window + pos)];
+			for (chain = 0 ; cand >= 0 && chain < LZ_MAXCHAIN ; cand = lz->prev[cand], chain++)
+			{
+				if (pos - cand > LZ_MAXDIST)
+					break;
+				for (len = 0 ; len < maxlen && lz->window[cand + len] == lz->window[pos + len] ; len++)
+					;
+				if (len > bestlen)
+				{
+					bestlen = len;
+					bestdist = pos - cand;
+					if (len == maxlen)
+						break;
+				}
+			}
+		}
+
+		if (bestlen >= LZ_MINMATCH)
+		{
+			if (outpos + 3 > outmax)
+				return 0;
+			out[flagpos] |= 1 << bit;
+			out[outpos++] = bestdist & 255;
+			out[outpos++] = bestdist >> 8;
+			out[outpos++] = bestlen - LZ_MINMATCH;
+
+			for (i = 0 ; i < bestlen ; i++, pos++)
+				if (pos + LZ_MINMATCH <= end)
+					LZ_Insert (pos);
+		}
+		else
+		{
+			if (outpos >= outmax)
+				return 0;
+			out[outpos++] = lz->window[pos];
+			if (pos + LZ_MINMATCH <= end)
+				LZ_Insert (pos);
+			pos++;
+		}
+
+		bit++;
+	}
+
+	if (outpos >= inlen)
+		return 0;
+
+	return outpos;
+}
+
+/*
+==================
+LZ_Decompress
+==================
+*/
+int LZ_Decompress (const byte *in, int inlen, byte *out, int outmax)
+{
+	int		inpos, outpos;
+	int		flags, bit;
+	int		dist, len, src;
+
+	inpos = outpos = 0;
+
+	while (inpos < inlen)
+	{
+		flags = in[inpos++];
+
+		for (bit = 0 ; bit < 8 && inpos < inlen ; bit++)
+		{
+			if (flags & (1 << bit))
+			{
+				if (inpos + 3 > inlen)
+					return -1;
+				dist = in[inpos] | (in[inpos+1] << 8);
+				len = in[inpos+2] + LZ_MINMATCH;
+				inpos += 3;
+
+				if (!dist || dist > outpos + LZ_DICTSIZE || outpos + len > outmax)
+					return -1;
+
+				// byte at a time, matches may overlap their own output
+				for ( ; len > 0 ; len--, outpos++)
+				{
+					src = outpos - dist;
+					out[outpos] = src < 0 ? lz_dictionary[LZ_DICTSIZE + src] : out[src];
+				}
+			}
+			else
+			{
+				if (outpos >= outmax)
+					return -1;
+				out[outpos++] = in[inpos++];
+			}
+		}
+	}
+
+	return outpos;
+}
+
+/*
+==================
+LZ_ExpandMessage
+==================
+*/
+qboolean LZ_ExpandMessage (void)
+{
+	static byte	packed[NET_MAXMESSAGE];
+	int			size, len;
+
+	size = MSG_ReadLong ();
+	len = net_message.cursize - msg_readcount;
+
+	if (msg_badread || len <= 0 || size < 0 || size > net_message.maxsize)
+		return false;
+
+	memcpy (packed, net_message.data + msg_readcount, len);
+
+	if (LZ_Decompress (packed, len, net_message.data, net_message.maxsize) != size)
+		return false;
+
+	net_message.cursize = size;
+	msg_readcount = 0;
+
+	return true;
+}
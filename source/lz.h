@@ -0,0 +1,30 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/* lz.h -- LZ77 codec for reliable server messages */
+
+// returns the compressed length, or 0 if the data didn't get smaller
+int LZ_Compress (const byte *in, int inlen, byte *out, int outmax);
+
+// returns the decompressed length, or -1 if the data is corrupt
+int LZ_Decompress (const byte *in, int inlen, byte *out, int outmax);
+
+// replaces the rest of net_message after an svc_compressed with its
+// contents, so parsing continues at the first decompressed command
+qboolean LZ_ExpandMessage (void);
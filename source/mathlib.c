@@ -78,7 +78,7 @@ SinCos
 void SinCos( float radians, float *sine, float *cosine )
 {
 #ifndef __PSP__
-	sincos(radians, sine, cosine);
+	sincosf(radians, sine, cosine);
 #else
 
 #ifdef PSP_VFPU
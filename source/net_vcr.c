@@ -19,22 +19,35 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // net_vcr.c
 
+#include <stdint.h>
+
 #include "quakedef.h"
 #include "net_vcr.h"
 
-extern int vcrFile;
-
 // This is the playback portion of the VCR.  It reads the file produced
 // by the recorder and plays it back to the host.  The recording contains
 // everything necessary (events, timestamps, and data) to duplicate the game
 // from the viewpoint of everything above the network layer.
+//
+// Host frame times and a hash of the server state are recorded along with
+// the network traffic, so a playback runs at full speed, stops at the first
+// frame that diverges, and reports where the server spent its time.
 
-static struct
-{
-	double	time;
-	int		op;
-	long	session;
-}	next;
+qboolean	vcr_playback;
+
+static vcrop_t	next;
+
+static int		vcr_frames;
+static double	vcr_starttime;
+
+// log scale histograms, four buckets per doubling of microseconds
+#define	VCR_BUCKETS		80
+
+static int		vcr_histogram[VCR_NUM_TIMES][VCR_BUCKETS];
+static double	vcr_total[VCR_NUM_TIMES];
+static double	vcr_max[VCR_NUM_TIMES];
+
+static char		*vcr_timenames[VCR_NUM_TIMES] = {"net", "physics", "send", "frame"};
 
 int VCR_Init (void)
 {
@@ -49,16 +62,69 @@ int VCR_Init (void)
 	net_drivers[0].Close = VCR_Close;
 	net_drivers[0].Shutdown = VCR_Shutdown;
 
+	vcr_playback = true;
+	vcr_starttime = Sys_FloatTime ();
+
 	Sys_FileRead(vcrFile, &next, sizeof(next));
 	return 0;
 }
 
+/*
+================
+VCR_Percentile
+
+Upper bound of the histogram bucket holding the given fraction of frames
+================
+*/
+static double VCR_Percentile (int *histogram, float fraction)
+{
+	int		i, count, wanted;
+
+	wanted = vcr_frames * fraction;
+	for (i=0, count=0 ; i<VCR_BUCKETS-1 ; i++)
+	{
+		count += histogram[i];
+		if (count > wanted)
+			break;
+	}
+
+	return pow (2, (i + 1) / 4.0) / 1000.0;
+}
+
+/*
+================
+VCR_Report
+================
+*/
+static void VCR_Report (void)
+{
+	double	elapsed;
+	int		i;
+
+	elapsed = Sys_FloatTime () - vcr_starttime;
+
+	Con_Printf ("%i server frames verified, %.1f seconds of game in %.2f seconds\n",
+		vcr_frames, host_time, elapsed);
+	if (!vcr_frames)
+		return;
+
+	Con_Printf ("           avg      p50      p95      p99      max (ms)\n");
+	for (i=0 ; i<VCR_NUM_TIMES ; i++)
+		Con_Printf ("%-8s %7.3f  %7.3f  %7.3f  %7.3f  %7.3f\n", vcr_timenames[i],
+			vcr_total[i] * 1000 / vcr_frames,
+			VCR_Percentile (vcr_histogram[i], 0.50),
+			VCR_Percentile (vcr_histogram[i], 0.95),
+			VCR_Percentile (vcr_histogram[i], 0.99),
+			vcr_max[i] * 1000);
+}
+
 void VCR_ReadNext (void)
 {
 	if (Sys_FileRead(vcrFile, &next, sizeof(next)) == 0)
 	{
 		next.op = 255;
-		Sys_Error ("=== END OF PLAYBACK===\n");
+		Con_Printf ("=== END OF PLAYBACK ===\n");
+		Sys_Quit ();
 	}
 	if (next.op < 1 || next.op > VCR_MAX_MESSAGE)
 		Sys_Error ("VCR_ReadNext: bad op");
@@ -72,6 +138,7 @@ void VCR_Listen (qboolean state)
 
 void VCR_Shutdown (void)
 {
+	VCR_Report ();
 }
 
 
@@ -79,11 +146,11 @@ int VCR_GetMessage (qsocket_t *sock)
 {
 	int	ret;
 	
-	if (host_time != next.time || next.op != VCR_OP_GETMESSAGE || next.session != *(long *)(&sock->driverdata))
+	if (host_time != next.time || next.op != VCR_OP_GETMESSAGE || next.session != (int)(intptr_t)sock->driverdata)
 		Sys_Error ("VCR missmatch");
 
 	Sys_FileRead(vcrFile, &ret, sizeof(int));
-	if (ret != 1)
+	if (ret < 1)
 	{
 		VCR_ReadNext ();
 		return ret;
@@ -94,7 +161,7 @@ int VCR_GetMessage (qsocket_t *sock)
 
 	VCR_ReadNext ();
 
-	return 1;
+	return ret;
 }
 
 
@@ -102,7 +169,7 @@ int VCR_SendMessage (qsocket_t *sock, sizebuf_t *data)
 {
 	int	ret;
 
-	if (host_time != next.time || next.op != VCR_OP_SENDMESSAGE || next.session != *(long *)(&sock->driverdata))
+	if (host_time != next.time || next.op != VCR_OP_SENDMESSAGE || next.session != (int)(intptr_t)sock->driverdata)
 		Sys_Error ("VCR missmatch");
 
 	Sys_FileRead(vcrFile, &ret, sizeof(int));
@@ -115,9 +182,9 @@ int VCR_SendMessage (qsocket_t *sock, sizebuf_t *data)
 
 qboolean VCR_CanSendMessage (qsocket_t *sock)
 {
-	qboolean	ret;
+	int		ret;
 
-	if (host_time != next.time || next.op != VCR_OP_CANSENDMESSAGE || next.session != *(long *)(&sock->driverdata))
+	if (host_time != next.time || next.op != VCR_OP_CANSENDMESSAGE || next.session != (int)(intptr_t)sock->driverdata)
 		Sys_Error ("VCR missmatch");
 
 	Sys_FileRead(vcrFile, &ret, sizeof(int));
@@ -158,10 +225,182 @@ qsocket_t *VCR_CheckNewConnections (void)
 	}
 
 	sock = NET_NewQSocket ();
-	*(long *)(&sock->driverdata) = next.session;
+	sock->driverdata = (void *)(intptr_t)next.session;
 
 	Sys_FileRead (vcrFile, sock->address, NET_NAMELEN);
 	VCR_ReadNext ();
 
 	return sock;
 }
+
+//============================================================================
+
+/*
+================
+VCR_WriteOp
+
+Starts a record in the recording.  Sockets are named by the low bits of
+their address, which stay unique because all of them live in the hunk.
+================
+*/
+void VCR_WriteOp (int op, qsocket_t *sock)
+{
+	vcrop_t	rec;
+
+	rec.time = host_time;
+	rec.op = op;
+	rec.session = (int)(intptr_t)sock;
+	Sys_FileWrite (vcrFile, &rec, sizeof(rec));
+}
+
+/*
+================
+VCR_FrameTime
+
+Records the time passed to Host_Frame, or replaces it with the recorded
+one so playback does not depend on the wall clock
+================
+*/
+float VCR_FrameTime (float time)
+{
+	if (recording)
+	{
+		VCR_WriteOp (VCR_OP_FRAME, NULL);
+		Sys_FileWrite (vcrFile, &time, sizeof(time));
+	}
+	else if (vcr_playback)
+	{
+		if (host_time != next.time || next.op != VCR_OP_FRAME)
+			Sys_Error ("VCR missmatch");
+
+		Sys_FileRead (vcrFile, &time, sizeof(time));
+		VCR_ReadNext ();
+	}
+
+	return time;
+}
+
+/*
+================
+VCR_ConsoleInput
+
+Console commands typed at the server are part of the match, so they are
+recorded and replayed too
+================
+*/
+char *VCR_ConsoleInput (char *text)
+{
+	static char	line[256];
+	int			len;
+
+	if (recording)
+	{
+		len = text ? Q_strlen (text) + 1 : 0;
+		VCR_WriteOp (VCR_OP_CONSOLE, NULL);
+		Sys_FileWrite (vcrFile, &len, sizeof(int));
+		if (len)
+			Sys_FileWrite (vcrFile, text, len);
+	}
+	else if (vcr_playback)
+	{
+		if (host_time != next.time || next.op != VCR_OP_CONSOLE)
+			Sys_Error ("VCR missmatch");
+
+		Sys_FileRead (vcrFile, &len, sizeof(int));
+		if (len < 0 || len > sizeof(line))
+			Sys_Error ("VCR_ConsoleInput: bad length");
+		text = NULL;
+		if (len)
+		{
+			Sys_FileRead (vcrFile, line, len);
+			line[len - 1] = 0;
+			text = line;
+		}
+		VCR_ReadNext ();
+	}
+
+	return text;
+}
+
+/*
+================
+VCR_StateHash
+
+FNV-1a over the progs globals and every edict's fields.  Links and other
+pointers are left out because they move between runs.
+================
+*/
+static unsigned VCR_StateHash (void)
+{
+	unsigned	hash;
+	int			*data;
+	int			i, j, count;
+	edict_t		*ent;
+
+	hash = 2166136261u;
+
+	data = (int *)pr_globals;
+	for (i=0 ; i<progs->numglobals ; i++)
+		hash = (hash ^ data[i]) * 16777619u;
+
+	for (i=0 ; i<sv.num_edicts ; i++)
+	{
+		ent = EDICT_NUM(i);
+		hash = (hash ^ ent->free) * 16777619u;
+		if (ent->free)
+			continue;
+
+		data = (int *)&ent->v;
+		count = progs->entityfields;
+		for (j=0 ; j<count ; j++)
+			hash = (hash ^ data[j]) * 16777619u;
+	}
+
+	return hash;
+}
+
+/*
+================
+VCR_ServerFrame
+
+Called at the end of each server frame.  Records the state hash, or checks
+it and accumulates the phase times during playback.
+================
+*/
+void VCR_ServerFrame (double *times)
+{
+	unsigned	hash, recorded;
+	int			i, bucket;
+
+	if (!recording && !vcr_playback)
+		return;
+
+	hash = VCR_StateHash ();
+
+	if (recording)
+	{
+		VCR_WriteOp (VCR_OP_STATE, NULL);
+		Sys_FileWrite (vcrFile, &hash, sizeof(hash));
+		return;
+	}
+
+	if (host_time != next.time || next.op != VCR_OP_STATE)
+		Sys_Error ("VCR missmatch");
+
+	Sys_FileRead (vcrFile, &recorded, sizeof(recorded));
+	if (hash != recorded)
+		Sys_Error ("VCR state missmatch at frame %i, server time %f", vcr_frames, sv.time);
+
+	for (i=0 ; i<VCR_NUM_TIMES ; i++)
+	{
+		vcr_total[i] += times[i];
+		if (times[i] > vcr_max[i])
+			vcr_max[i] = times[i];
+
+		bucket = times[i] > 0.000001 ? (int)(log (times[i] * 1000000) / log (2) * 4) : 0;
+		vcr_histogram[i][bound(0, bucket, VCR_BUCKETS-1)]++;
+	}
+	vcr_frames++;
+
+	VCR_ReadNext ();
+}
@@ -19,11 +19,39 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 // net_vcr.h
 
+#define	VCR_SIGNATURE	0x56435232
+// "VCR2"
+
 #define VCR_OP_CONNECT					1
 #define VCR_OP_GETMESSAGE				2
 #define VCR_OP_SENDMESSAGE				3
 #define VCR_OP_CANSENDMESSAGE			4
-#define VCR_MAX_MESSAGE					4
+#define VCR_OP_FRAME					5
+#define VCR_OP_STATE					6
+#define VCR_OP_CONSOLE					7
+#define VCR_MAX_MESSAGE					7
+
+// every record starts with this, the same size on 32 and 64 bit hosts
+typedef struct
+{
+	double	time;
+	int		op;
+	int		session;
+} vcrop_t;
+
+// server frame phases timed during playback
+enum
+{
+	VCR_TIME_NET,
+	VCR_TIME_PHYSICS,
+	VCR_TIME_SEND,
+	VCR_TIME_FRAME,
+	VCR_NUM_TIMES
+};
+
+extern int		vcrFile;
+extern qboolean	recording;
+extern qboolean	vcr_playback;
 
 int			VCR_Init (void);
 void		VCR_Listen (qboolean state);
@@ -35,3 +63,8 @@ int			VCR_SendMessage (qsocket_t *sock, sizebuf_t *data);
 qboolean	VCR_CanSendMessage (qsocket_t *sock);
 void		VCR_Close (qsocket_t *sock);
 void		VCR_Shutdown (void);
+
+void		VCR_WriteOp (int op, qsocket_t *sock);
+float		VCR_FrameTime (float time);
+char		*VCR_ConsoleInput (char *text);
+void		VCR_ServerFrame (double *times);
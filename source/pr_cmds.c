@@ -19,6 +19,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "quakedef.h"
+#include "prefetch.h"
+#include "arena.h"
+#include "jobs.h"
+#include "prof.h"
 
 #ifdef _3DS
 extern bool new3ds_flag;
@@ -1054,6 +1058,12 @@ void PF_localcmd (void)
 {
 	char	*str;
 
+	if (!Sys_MainThread ())
+	{
+		Host_MainCall (PF_localcmd);	// the command buffer is the main thread's
+		return;
+	}
+
 	str = G_STRING(OFS_PARM0);
 	Cbuf_AddText (str);
 }
@@ -1085,12 +1095,83 @@ void PF_cvar_set (void)
 {
 	char	*var, *val;
 
+	if (!Sys_MainThread ())
+	{
+		Host_MainCall (PF_cvar_set);	// Cvar_Set frees what the client may be reading
+		return;
+	}
+
 	var = G_STRING(OFS_PARM0);
 	val = G_STRING(OFS_PARM1);
 
 	Cvar_Set (var, val);
 }
 
+#define	MAX_CVARHANDLES	256
+
+static	cvar_t	*pr_cvarhandles[MAX_CVARHANDLES];
+static	int		pr_numcvarhandles;
+
+/*
+=================
+PF_cvar_handle
+
+Looks a cvar up once for cvar_byhandle, 0 if there is no such cvar.  The
+handles last as long as the cvars, past a change of map or progs.
+
+float cvar_handle (string) = #510
+=================
+*/
+void PF_cvar_handle (void)
+{
+	cvar_t	*var;
+	int		i;
+
+	G_FLOAT(OFS_RETURN) = 0;
+
+	var = Cvar_FindVar (G_STRING(OFS_PARM0));
+	if (!var)
+		return;
+
+	for (i=0 ; i<pr_numcvarhandles ; i++)
+		if (pr_cvarhandles[i] == var)
+			break;
+	if (i == pr_numcvarhandles)
+	{
+		if (pr_numcvarhandles == MAX_CVARHANDLES)
+		{
+			Con_DPrintf ("cvar_handle: more than %i cvars\n", MAX_CVARHANDLES);
+			return;
+		}
+		pr_cvarhandles[pr_numcvarhandles++] = var;
+	}
+
+	G_FLOAT(OFS_RETURN) = i + 1;
+}
+
+/*
+=================
+PF_cvar_byhandle
+
+What cvar () would return, without the name lookup
+
+float cvar_byhandle (float) = #511
+=================
+*/
+void PF_cvar_byhandle (void)
+{
+	int		i;
+
+	i = (int)G_FLOAT(OFS_PARM0) - 1;
+	if (i < 0 || i >= pr_numcvarhandles)
+	{
+		G_FLOAT(OFS_RETURN) = 0;
+		return;
+	}
+
+	G_FLOAT(OFS_RETURN) = pr_cvarhandles[i]->value;	// Cvar_SetQuick keeps it in step
+}
+
 /*
 =================
 PF_findradius
@@ -1483,6 +1564,8 @@ This is where the magic happens
 #define MaxZombies 18
 #elif __WII__
 #define MaxZombies 24
+#else
+#define MaxZombies 64	// headless servers, sv_maxai raises the live count
 #endif //__PSP__, _3DS, __WII__
 
 
@@ -1892,12 +1975,35 @@ qboolean ofs_tracebox(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int ty
 
 
 
+typedef struct {
+	edict_t *ent;
+	argsort_entry_t *sorted;	// every waypoint, closest first
+	int waypoint;				// the result, -1 if none can be reached
+} closest_waypoint_t;
+
 //
-// Returns the clsoest waypoint to an entity that the entity can walk to
-// Sorts all waypoints by distance, returns first waypoint we can tracebox to
+// Sorts all waypoints by distance to an entity, into the server frame arena
 //
-int get_closest_waypoint(int entnum) {
-	edict_t *ent = EDICT_NUM(entnum);
+void sort_closest_waypoints(closest_waypoint_t *search, int entnum) {
+	search->ent = EDICT_NUM(entnum);
+	search->waypoint = -1;
+
+	search->sorted = Arena_Alloc(&sv_arena, n_waypoints * sizeof(argsort_entry_t));
+	for(int i = 0; i < n_waypoints; i++) {
+		search->sorted[i].index = i;
+		search->sorted[i].value = VectorDistanceSquared(waypoints[i].origin, search->ent->v.origin);
+	}
+	qsort(search->sorted, n_waypoints, sizeof(argsort_entry_t), argsort_comparator);
+}
+
+//
+// Finds the closest waypoint the entity can walk to, the first of the sorted
+// ones it can tracebox to.  A job: MOVE_NOMONSTERS traces only read the world
+// and the brush models, so two searches can run at once.
+//
+void find_closest_waypoint(void *data, int first, int last) {
+	closest_waypoint_t *search = data;
+	edict_t *ent = search->ent;
 
 	vec3_t ent_mins;
 	vec3_t ent_maxs;
@@ -1906,28 +2012,15 @@ int get_closest_waypoint(int entnum) {
 	VectorCopy(ai_hull_mins, ent_mins);
 	VectorCopy(ai_hull_maxs, ent_maxs);
 
-	// Get all waypoint indices sorted by distance to ent
-	argsort_entry_t waypoint_sort_values[MAX_WAYPOINTS];
-	for(int i = 0; i < n_waypoints; i++) {
-		waypoint_sort_values[i].index = i;
-		waypoint_sort_values[i].value = VectorDistanceSquared(waypoints[i].origin, ent->v.origin);
-	}
-	qsort(waypoint_sort_values, n_waypoints, sizeof(argsort_entry_t), argsort_comparator);
-
-	
-
-	int best_waypoint_idx = -1;
 	// Sweep through waypoints from closest to farthest, stop when we can tracebox to one
 	for(int i = 0; i < n_waypoints; i++) {
-		int waypoint_idx = waypoint_sort_values[i].index;
+		int waypoint_idx = search->sorted[i].index;
 
 		if(ofs_tracebox(ent->v.origin, ent_mins, ent_maxs, waypoints[waypoint_idx].origin, MOVE_NOMONSTERS, ent)) {
-			best_waypoint_idx = waypoint_idx;
+			search->waypoint = waypoint_idx;
 			break;
 		}
 	}
-
-	return best_waypoint_idx;
 }
 
 
@@ -1938,6 +2031,8 @@ void Do_Pathfind (void) {
 	sceRtcGetCurrentTick(&t1);
 	#endif
 
+	PROF_BEGIN (Do_Pathfind);
+
 	int i, s;
 	trace_t   trace;
 
@@ -1951,17 +2046,28 @@ void Do_Pathfind (void) {
 	edict_t * ent = G_EDICT(OFS_PARM1);
 
 	if(developer.value == 3) {
-		Con_Printf("Finding start waypoint\n");
-	}
-	int start_waypoint = get_closest_waypoint(zombie_entnum);
-	if(developer.value == 3) {
-		Con_Printf("Finding goal waypoint\n");
+		Con_Printf("Finding start and goal waypoints\n");
 	}
-	int goal_waypoint = get_closest_waypoint(target_entnum);
+	// Both searches go to the job threads together
+	closest_waypoint_t start_search, goal_search;
+	int mark = Arena_Mark(&sv_arena);
+	sort_closest_waypoints(&start_search, zombie_entnum);
+	sort_closest_waypoints(&goal_search, target_entnum);
+
+	job_t *searches = Jobs_Create("find_closest_waypoint", NULL, NULL, NULL);
+	Jobs_Run(Jobs_Create("find_closest_waypoint", find_closest_waypoint, &start_search, searches));
+	Jobs_Run(Jobs_Create("find_closest_waypoint", find_closest_waypoint, &goal_search, searches));
+	Jobs_Run(searches);
+	Jobs_Wait(searches);
+	Arena_Release(&sv_arena, mark);
+
+	int start_waypoint = start_search.waypoint;
+	int goal_waypoint = goal_search.waypoint;
 
 	if(start_waypoint == -1 || goal_waypoint == -1) {
 		Con_DPrintf("Pathfind failure. Invalid start or goal waypoint. (Start: %d, Goal: %d)\n", start_waypoint, goal_waypoint);
 		G_FLOAT(OFS_RETURN) = 0;
+		PROF_END (Do_Pathfind);
 		return;
 	}
 
@@ -2036,6 +2142,7 @@ void Do_Pathfind (void) {
 				Con_DPrintf("\tPath found!\n");
 				G_FLOAT(OFS_RETURN) = 1;
 			}
+			PROF_END (Do_Pathfind);
 			return;
 		}
 	}
@@ -2048,6 +2155,8 @@ void Do_Pathfind (void) {
 
 	Con_DPrintf("Pathfind failure. Goal waypoint not reachable.\n");
 	G_FLOAT(OFS_RETURN) = 0;
+
+	PROF_END (Do_Pathfind);
 }
 
 //
@@ -2463,6 +2572,12 @@ void PF_fopen (void)
 	int fmode = G_FLOAT(OFS_PARM1);
 	int h = 0, fsize = 0;
 
+	if (!Sys_MainThread ())
+	{
+		Host_MainCall (PF_fopen);		// the file handles are the main thread's
+		return;
+	}
+
 	switch (fmode)
 	{
 		case 0: // read
@@ -2509,6 +2624,13 @@ void fclose (float)
 void PF_fclose (void)
 {
 	int h = (int)G_FLOAT(OFS_PARM0);
+
+	if (!Sys_MainThread ())
+	{
+		Host_MainCall (PF_fclose);
+		return;
+	}
+
 	if (h > 0) { // stop crashing on Wii HW
 		Sys_FileClose(h);
 	}
@@ -2529,6 +2651,12 @@ void PF_fgets (void)
 	int		count;
 	char	buffer;
 
+	if (!Sys_MainThread ())
+	{
+		Host_MainCall (PF_fgets);
+		return;
+	}
+
 	h = (int)G_FLOAT(OFS_PARM0);
 
 	count = Sys_FileRead(h, &buffer, 1);
@@ -2574,7 +2702,15 @@ void PF_fputs (void)
 {
 	// writes to file, like bprint
 	float handle = G_FLOAT(OFS_PARM0);
-	char *str = PF_VarString(1);
+	char *str;
+
+	if (!Sys_MainThread ())
+	{
+		Host_MainCall (PF_fputs);
+		return;
+	}
+
+	str = PF_VarString(1);
 	Sys_FileWrite (handle, str, strlen(str));
 }
 // 2001-09-20 QuakeC file access by FrikaC/Maddes  end
@@ -2683,6 +2819,7 @@ void PF_precache_model (void)
 {
 	char	*s;
 	int		i;
+	double	start;
 
 	if (sv.state != ss_loading)
 		PR_RunError ("PF_Precache_*: Precache can only be done in spawn functions");
@@ -2696,7 +2833,9 @@ void PF_precache_model (void)
 		if (!sv.model_precache[i])
 		{
 			sv.model_precache[i] = s;
+			start = Sys_FloatTime ();
 			sv.models[i] = Mod_ForName (s, true);
+			Prefetch_Loaded (s, Sys_FloatTime () - start);
 			return;
 		}
 		if (!strcmp(sv.model_precache[i], s))
@@ -3062,25 +3201,29 @@ void PF_GetSoundLen (void)
 	name = G_STRING(OFS_PARM0);
 
     char	namebuffer[256];
-	byte	*data;
+	filemap_t	map;
 	wavinfo_t	info;
-	byte	stackbuf[1*1024];		// avoid dirtying the cache heap
 
-//Con_Printf ("S_LoadSound: %x\n", (int)stackbuf);
-// load it in
+	if (!Sys_MainThread ())
+	{
+		Host_MainCall (PF_GetSoundLen);	// the file system is the main thread's
+		return;
+	}
+
+// only the header is needed, so view the file rather than load it
     Q_strcpy(namebuffer, "");
     Q_strcat(namebuffer, name);
 
-	data = COM_LoadStackFile(namebuffer, stackbuf, sizeof(stackbuf));
-
-	if (!data)
+	if (!COM_MapTempFile (namebuffer, &map))
 	{
 		Con_Printf ("Couldn't load %s\n", namebuffer);
 		G_FLOAT(OFS_RETURN) = -1;
 		return;
 	}
 
-	info = GetWavinfo (name, data, com_filesize);
+	info = GetWavinfo (name, map.data, map.len);
+	COM_UnmapFile (&map);
+
 	if (info.channels != 1)
 	{
 		Con_Printf ("%s is a stereo sample\n",name);
@@ -3302,6 +3445,12 @@ void PF_changelevel (void)
 {
 	char	*s;
 
+	if (!Sys_MainThread ())
+	{
+		Host_MainCall (PF_changelevel);
+		return;
+	}
+
 // make sure we don't issue two changelevels
 	if (svs.changelevel_issued)
 		return;
@@ -3346,7 +3495,13 @@ songegg(trackname)
 void PF_SongEgg (void)
 {
 	char *s;
-	
+
+	if (!Sys_MainThread ())
+	{
+		Host_MainCall (PF_SongEgg);
+		return;
+	}
+
 	s = G_STRING(OFS_PARM0);
 	Cbuf_AddText (va("cd playstring %s 0\n",s));
 }
@@ -3573,21 +3728,32 @@ void PF_SetPlayerName(void)
 PF_MaxZombies
 
 Returns the total number of zombies
-the platform can have out at once.
+the platform can have out at once,
+or sv_maxai when it is set.
 
 nzp_maxai()
 =================
 */
 void PF_MaxZombies(void)
 {
+	int		maxai;
+
 #ifdef _3DS
 	if (new3ds_flag)
-		G_FLOAT(OFS_RETURN) = MaxZombies;
+		maxai = MaxZombies;
 	else
-		G_FLOAT(OFS_RETURN) = 12;
+		maxai = 12;
+#elif __linux__
+	maxai = 24;
 #else
-	G_FLOAT(OFS_RETURN) = MaxZombies;
+	maxai = MaxZombies;
 #endif
+
+	// sv_maxai overrides the platform default, for load testing
+	if (sv_maxai.value >= 1)
+		maxai = sv_maxai.value < MaxZombies ? (int)sv_maxai.value : MaxZombies;
+
+	G_FLOAT(OFS_RETURN) = maxai;
 }
 
 /*
@@ -3934,7 +4100,9 @@ ebfs_builtin_t pr_ebfs_builtins[] =
   { 506, "nzp_setdoubletapver", PF_SetDoubleTapVersion },
   { 507, "nzp_screenflash", PF_ScreenFlash },
   { 508, "nzp_lockviewmodel", PF_LockViewmodel },
-  { 509, "nzp_rumble", PF_Rumble }
+  { 509, "nzp_rumble", PF_Rumble },
+  { 510, "cvar_handle", PF_cvar_handle },
+  { 511, "cvar_byhandle", PF_cvar_byhandle }
 
 // 2001-11-15 DarkPlaces general builtin functions by Lord Havoc  end
 
@@ -19,6 +19,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "quakedef.h"
+#include "prof.h"
 
 /*
 
@@ -30,7 +31,6 @@ typedef struct
 	dfunction_t		*f;
 } prstack_t;
 
-#define	MAX_STACK_DEPTH		32
 prstack_t	pr_stack[MAX_STACK_DEPTH];
 int			pr_depth;
 
@@ -380,6 +380,8 @@ void PR_ExecuteProgram (func_t fnum)
 		Host_Error ("PR_ExecuteProgram: NULL function");
 	}
 
+	PROF_BEGIN (PR_ExecuteProgram);
+
 	f = &pr_functions[fnum];
 
 	runaway = 400000;
@@ -650,7 +652,10 @@ while (1)
 
 		s = PR_LeaveFunction ();
 		if (pr_depth == exitdepth)
+		{
+			PROF_END (PR_ExecuteProgram);
 			return;		// all done
+		}
 		break;
 
 	case OP_STATE:
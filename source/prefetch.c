@@ -0,0 +1,420 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// prefetch.c -- reads the files a map load will want ahead of the loaders
+//
+// When the precache lists arrive every file the load is going to open is
+// known, but the loaders take them one at a time and the card sits idle
+// while each one is parsed and uploaded.  The lists are handed to an i/o
+// thread that reads the files in the same order into malloc'd staging
+// buffers, and COM_LoadFile / COM_MapFile take the buffer instead of going
+// to the disk.  The staged bytes are capped by prefetch_size; when the
+// thread is held up by it, or hasn't reached a file yet, the loader simply
+// reads the file itself, so a slow or full prefetch never stalls the load
+// for longer than the read it is in the middle of.
+
+#include "quakedef.h"
+#include "prefetch.h"
+#include "fs_index.h"
+
+#define	MAX_PREFETCH	1024
+
+typedef enum
+{
+	pf_queued,
+	pf_reading,
+	pf_ready,
+	pf_taken,
+	pf_skipped		// the loader got there first, or it wasn't read in time
+} pfstate_t;
+
+typedef struct
+{
+	char		name[MAX_QPATH];
+	pfstate_t	state;
+	int			size;			// from the index, counted against the budget
+	byte		*data;
+	int			len;
+
+// for loadreport
+	double		readtime;		// on the i/o thread
+	double		waittime;		// the loader blocked on the read
+	double		loadtime;		// the loader's own time, including the wait
+} pfitem_t;
+
+cvar_t	prefetch = {"prefetch", "1"};
+cvar_t	prefetch_size = {"prefetch_size", "2048"};		// KB staged at once
+
+static	pfitem_t	pf_items[MAX_PREFETCH];
+static	int			pf_count;
+static	int			pf_next;		// first item the i/o thread hasn't looked at
+static	int			pf_staged;		// bytes read and not yet taken
+static	int			pf_budget;
+static	qboolean	pf_active;
+static	qboolean	pf_waiting;		// the loader wants pf_done posted
+
+static	void		*pf_thread;
+static	void		*pf_lock;		// held around every change to the above
+static	void		*pf_work;		// posted when there may be something to read
+static	void		*pf_done;		// posted when a read the loader waits on ends
+
+static	double		pf_begintime, pf_endtime;
+
+/*
+=================
+Prefetch_NextItem
+
+Called with the lock held
+=================
+*/
+static pfitem_t *Prefetch_NextItem (void)
+{
+	pfitem_t	*it;
+
+	if (!pf_active)
+		return NULL;
+
+	for ( ; pf_next < pf_count ; pf_next++)
+	{
+		it = &pf_items[pf_next];
+		if (it->state != pf_queued)
+			continue;
+
+		// one file larger than the whole budget is still read on its own
+		if (pf_staged && pf_staged + it->size > pf_budget)
+			return NULL;
+
+		return it;
+	}
+
+	return NULL;
+}
+
+/*
+=================
+Prefetch_Thread
+=================
+*/
+static void Prefetch_Thread (void *arg)
+{
+	pfitem_t	*it;
+	char		name[MAX_QPATH];
+	byte		*data;
+	int			len;
+	double		start, readtime;
+
+	while (1)
+	{
+		Sys_SemaphoreWait (pf_lock);
+		it = Prefetch_NextItem ();
+		if (!it)
+		{
+			Sys_SemaphorePost (pf_lock);
+			Sys_SemaphoreWait (pf_work);
+			continue;
+		}
+		it->state = pf_reading;
+		pf_staged += it->size;
+		strcpy (name, it->name);
+		Sys_SemaphorePost (pf_lock);
+
+		start = Sys_FloatTime ();
+		data = COM_LoadMallocFile (name, &len);
+		readtime = Sys_FloatTime () - start;
+
+		Sys_SemaphoreWait (pf_lock);
+		it->readtime = readtime;
+		if (data)
+		{
+			it->data = data;
+			it->len = len;
+			it->state = pf_ready;
+		}
+		else
+		{
+			it->state = pf_skipped;
+			pf_staged -= it->size;
+		}
+		if (pf_waiting)
+		{
+			pf_waiting = false;
+			Sys_SemaphorePost (pf_done);
+		}
+		Sys_SemaphorePost (pf_lock);
+	}
+}
+
+/*
+=================
+Prefetch_Find
+=================
+*/
+static pfitem_t *Prefetch_Find (char *path)
+{
+	int		i;
+
+	for (i=0 ; i<pf_count ; i++)
+		if (!strcmp (pf_items[i].name, path))
+			return &pf_items[i];
+
+	return NULL;
+}
+
+/*
+=================
+Prefetch_WaitReading
+
+Called with the lock held, returns with it held
+=================
+*/
+static void Prefetch_WaitReading (pfitem_t *it)
+{
+	while (it->state == pf_reading)
+	{
+		pf_waiting = true;
+		Sys_SemaphorePost (pf_lock);
+		Sys_SemaphoreWait (pf_done);
+		Sys_SemaphoreWait (pf_lock);
+	}
+}
+
+/*
+=================
+Prefetch_Begin
+=================
+*/
+void Prefetch_Begin (void)
+{
+	int		i;
+
+	if (pf_active)
+		Prefetch_End ();
+
+	if (!pf_thread)
+		return;
+
+	// whatever the last report held goes
+	Sys_SemaphoreWait (pf_lock);
+	for (i=0 ; i<pf_count ; i++)
+		free (pf_items[i].data);
+	memset (pf_items, 0, sizeof(pfitem_t) * pf_count);
+
+	pf_count = 0;
+	pf_next = 0;
+	pf_staged = 0;
+	pf_budget = (int)prefetch_size.value * 1024;
+	pf_begintime = Sys_FloatTime ();
+	pf_endtime = 0;
+
+	pf_active = prefetch.value != 0;
+	Sys_SemaphorePost (pf_lock);
+}
+
+/*
+=================
+Prefetch_Add
+=================
+*/
+void Prefetch_Add (char *path)
+{
+	fsentry_t	*entry;
+	pfitem_t	*it;
+
+	if (!pf_active || pf_count == MAX_PREFETCH)
+		return;
+	if (strlen (path) >= MAX_QPATH || Prefetch_Find (path))
+		return;
+
+	entry = FS_FindEntry (path, NULL);
+	if (!entry)
+		return;		// the loader will complain about it
+
+	Sys_SemaphoreWait (pf_lock);
+	it = &pf_items[pf_count];
+	strcpy (it->name, path);
+	it->size = entry->filelen;
+	it->state = pf_queued;
+	pf_count++;
+	Sys_SemaphorePost (pf_lock);
+
+	Sys_SemaphorePost (pf_work);
+}
+
+/*
+=================
+Prefetch_Take
+=================
+*/
+byte *Prefetch_Take (char *path, int *len)
+{
+	pfitem_t	*it;
+	byte		*data;
+	double		start;
+
+	if (!pf_active)
+		return NULL;
+
+	it = Prefetch_Find (path);
+	if (!it)
+		return NULL;
+
+	Sys_SemaphoreWait (pf_lock);
+
+	if (it->state == pf_reading)
+	{
+		start = Sys_FloatTime ();
+		Prefetch_WaitReading (it);
+		it->waittime = Sys_FloatTime () - start;
+	}
+
+	data = NULL;
+	if (it->state == pf_ready)
+	{
+		data = it->data;
+		*len = it->len;
+		it->data = NULL;
+		it->state = pf_taken;
+		pf_staged -= it->size;
+	}
+	else if (it->state == pf_queued)
+		it->state = pf_skipped;		// quicker to read it here than to wait
+
+	Sys_SemaphorePost (pf_lock);
+
+	// the space it held may let the thread go on
+	if (data)
+		Sys_SemaphorePost (pf_work);
+
+	return data;
+}
+
+/*
+=================
+Prefetch_Loaded
+=================
+*/
+void Prefetch_Loaded (char *path, double seconds)
+{
+	pfitem_t	*it;
+
+	it = Prefetch_Find (path);
+	if (it)
+		it->loadtime = seconds;
+}
+
+/*
+=================
+Prefetch_End
+
+Stops the thread after its current read, anything not taken is freed
+=================
+*/
+void Prefetch_End (void)
+{
+	int		i;
+
+	if (!pf_active)
+		return;
+
+	Sys_SemaphoreWait (pf_lock);
+	pf_active = false;
+	for (i=0 ; i<pf_count ; i++)
+	{
+		Prefetch_WaitReading (&pf_items[i]);
+		if (pf_items[i].state == pf_ready)
+		{
+			free (pf_items[i].data);
+			pf_items[i].data = NULL;
+		}
+	}
+	pf_staged = 0;
+	Sys_SemaphorePost (pf_lock);
+
+	pf_endtime = Sys_FloatTime ();
+}
+
+/*
+=================
+Prefetch_Report_f
+=================
+*/
+static void Prefetch_Report_f (void)
+{
+	static const char *states[] = {"queued", "reading", "unused", "hit", "missed"};
+	pfitem_t	*it;
+	int			i, hits, hitbytes, wasted;
+	double		readtime, waittime, loadtime;
+	qboolean	files;
+
+	if (!pf_count)
+	{
+		Con_Printf ("no files prefetched since the last map load\n");
+		return;
+	}
+
+	files = Cmd_Argc () > 1 && !Q_strcasecmp (Cmd_Argv (1), "files");
+
+	hits = hitbytes = wasted = 0;
+	readtime = waittime = loadtime = 0;
+	for (i=0, it=pf_items ; i<pf_count ; i++, it++)
+	{
+		if (it->state == pf_taken)
+		{
+			hits++;
+			hitbytes += it->size;
+		}
+		else if (it->state == pf_ready)
+			wasted += it->size;
+		readtime += it->readtime;
+		waittime += it->waittime;
+		loadtime += it->loadtime;
+
+		if (files)
+			Con_Printf ("%-6s %6iK read %5.1f wait %5.1f load %6.1f %s\n", states[it->state],
+				it->size / 1024, it->readtime * 1000, it->waittime * 1000, it->loadtime * 1000, it->name);
+	}
+
+	Con_Printf ("%i files, %i prefetched (%iK), %iK read for nothing\n", pf_count, hits, hitbytes / 1024, wasted / 1024);
+	Con_Printf ("%.1f ms reading on the i/o thread, %.1f ms of it waited on\n", readtime * 1000, waittime * 1000);
+	Con_Printf ("%.1f ms in the loaders, %.1f ms for the whole load\n", loadtime * 1000,
+		((pf_endtime ? pf_endtime : Sys_FloatTime ()) - pf_begintime) * 1000);
+}
+
+/*
+=================
+Prefetch_Init
+=================
+*/
+void Prefetch_Init (void)
+{
+	Cvar_RegisterVariable (&prefetch);
+	Cvar_RegisterVariable (&prefetch_size);
+	Cmd_AddCommand ("loadreport", Prefetch_Report_f);
+
+	if (COM_CheckParm ("-noprefetch"))
+		return;
+
+	pf_lock = Sys_CreateSemaphore (1);
+	pf_work = Sys_CreateSemaphore (0);
+	pf_done = Sys_CreateSemaphore (0);
+
+	pf_thread = Sys_CreateThread (Prefetch_Thread, NULL);
+	if (!pf_thread)
+		Con_Printf ("Couldn't start the prefetch thread, files load as they are needed\n");
+}
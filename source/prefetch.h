@@ -0,0 +1,35 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// prefetch.h -- reads the files a map load will want ahead of the loaders
+
+void Prefetch_Init (void);
+
+// the search path must not change between Begin and End, the i/o thread
+// finds files through the index
+void Prefetch_Begin (void);
+void Prefetch_Add (char *path);
+void Prefetch_End (void);
+
+// the file's contents if they have been staged, the caller owns the
+// malloc'd buffer, which has a 0 byte after the end
+byte *Prefetch_Take (char *path, int *len);
+
+// for loadreport, how long the loader spent on the file in all
+void Prefetch_Loaded (char *path, double seconds);
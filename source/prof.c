@@ -0,0 +1,647 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// prof.c -- timed zones on the hot paths, kept for the last few frames
+//
+// host_speeds splits a frame three ways and serverprofile averages the
+// server over a thousand of them.  The zones in prof.h time the functions
+// the frame is spent in with Sys_Ticks, each platform's fastest counter,
+// into a ring of events for the main thread and one for the pipelined
+// server tick, and Prof_Frame marks where each frame began.
+//
+// Nothing is kept while prof_capture, prof_graph and prof_spike are all
+// off and nothing holds the zones for Prof_LastFrame, as a timedemo does.
+// prof_graph draws the zones each frame ran at the top level as a bar for
+// each of the last frames, "profstats" prints what every zone took on
+// average, and "profdump" writes the frames still in the rings as a
+// Chrome trace (chrome://tracing, or ui.perfetto.dev).  With prof_spike
+// set, a frame that takes longer than that many milliseconds dumps the
+// frames before it by itself.
+//
+// -profframes <n> and -profevents <n> size the rings, the events of a
+// frame that doesn't fit drop the oldest frames out of the trace.
+
+#include "quakedef.h"
+#include "prof.h"
+
+#ifdef PROF_ZONES
+
+#define	MAX_PROFZONES		64
+#define	MAX_PROFDEPTH		32
+#define	PROF_TRACKS			2			// the main thread and the server tick
+#define	PROF_FRAMES			64
+#define	PROF_EVENTS			16384		// for each track, a power of two
+#define	PROF_GRAPHMS		50			// the top of the graph
+
+typedef struct
+{
+	unsigned short		zone;
+	byte				depth;
+	byte				nested;			// inside another of the same zone
+	unsigned int		length;			// ticks, 0 while open
+	unsigned long long	start;
+} profevent_t;
+
+typedef struct
+{
+	profevent_t		*events;			// a ring of prof_maxevents
+	unsigned int	count;				// begun since the capture started
+	unsigned int	stack[MAX_PROFDEPTH];	// the open events
+	unsigned short	zones[MAX_PROFDEPTH];
+	int				depth;
+	int				skipped;			// open zones past MAX_PROFDEPTH
+} proftrack_t;
+
+typedef struct
+{
+	unsigned long long	start, end;
+	unsigned int		first[PROF_TRACKS];		// the events of the frame
+	unsigned int		last[PROF_TRACKS];
+	int					framecount;
+} profframe_t;
+
+cvar_t	prof_capture = {"prof_capture", "0"};
+cvar_t	prof_graph = {"prof_graph", "0"};
+cvar_t	prof_spike = {"prof_spike", "0"};		// ms, dump the frames before one this long
+
+static	profzone_t	*prof_zones[MAX_PROFZONES + 1];	// 0 isn't used
+static	int			prof_numzones;
+static	void		*prof_lock;			// for the zones registering
+
+static	qboolean	prof_active;		// latched by Prof_Frame
+static	int			prof_held;			// Prof_Hold, as good as prof_capture
+static	proftrack_t	prof_tracks[PROF_TRACKS];
+static	int			prof_maxevents;
+
+static	profframe_t	*prof_frames;
+static	int			prof_maxframes;
+static	int			prof_numframes;		// ended since the capture started
+static	int			prof_lastspike;
+
+// ms for each frame and zone, all of it and what it ran at the top level
+static	float		*prof_totals;
+static	float		*prof_tops;
+
+static	double		prof_tickrate;
+
+static int Prof_WriteTrace (char *name);
+
+/*
+=================
+Prof_Register
+=================
+*/
+static void Prof_Register (profzone_t *zone)
+{
+	Sys_SemaphoreWait (prof_lock);
+
+	if (!zone->index)
+	{
+		if (prof_numzones == MAX_PROFZONES)
+			Sys_Error ("Prof_Begin: more than %i zones", MAX_PROFZONES);
+		prof_zones[++prof_numzones] = zone;
+		zone->index = prof_numzones;
+	}
+
+	Sys_SemaphorePost (prof_lock);
+}
+
+/*
+=================
+Prof_Begin
+=================
+*/
+void Prof_Begin (profzone_t *zone)
+{
+	proftrack_t	*t;
+	profevent_t	*e;
+	int			i;
+
+	if (!prof_active)
+		return;
+	if (!zone->index)
+		Prof_Register (zone);
+
+	t = &prof_tracks[!Sys_MainThread ()];
+	if (t->skipped || t->depth == MAX_PROFDEPTH)
+	{
+		t->skipped++;
+		return;
+	}
+
+	e = &t->events[t->count & (prof_maxevents - 1)];
+	e->zone = zone->index;
+	e->depth = t->depth;
+	e->nested = false;
+	for (i=0 ; i<t->depth ; i++)
+		if (t->zones[i] == zone->index)
+			e->nested = true;
+	e->length = 0;
+
+	t->stack[t->depth] = t->count++;
+	t->zones[t->depth++] = zone->index;
+
+	e->start = Sys_Ticks ();
+}
+
+/*
+=================
+Prof_End
+=================
+*/
+void Prof_End (profzone_t *zone)
+{
+	unsigned long long	now;
+	proftrack_t	*t;
+	profevent_t	*e;
+	unsigned int	n;
+
+	now = Sys_Ticks ();
+
+	t = &prof_tracks[!Sys_MainThread ()];
+	if (t->skipped)
+	{
+		t->skipped--;
+		return;
+	}
+
+	// begun before the capture, or an error unwound past its end
+	if (!t->depth || t->zones[t->depth - 1] != zone->index)
+		return;
+
+	n = t->stack[--t->depth];
+	if (t->count - n > prof_maxevents)
+		return;			// the ring has come round past it
+
+	e = &t->events[n & (prof_maxevents - 1)];
+	e->length = now - e->start;
+	if (!e->length)
+		e->length = 1;
+}
+
+/*
+=================
+Prof_FrameValid
+
+Whether every event of the frame is still in the rings
+=================
+*/
+static qboolean Prof_FrameValid (profframe_t *f)
+{
+	int		i;
+
+	for (i=0 ; i<PROF_TRACKS ; i++)
+	{
+		if (prof_tracks[i].count - f->first[i] > prof_maxevents)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+=================
+Prof_SumFrame
+
+The totals for the graph and profstats
+=================
+*/
+static void Prof_SumFrame (profframe_t *f, float *totals, float *tops)
+{
+	proftrack_t	*t;
+	profevent_t	*e;
+	unsigned int	n;
+	float		ms;
+	int			i;
+
+	memset (totals, 0, (MAX_PROFZONES + 1) * sizeof(float));
+	memset (tops, 0, (MAX_PROFZONES + 1) * sizeof(float));
+
+	if (!Prof_FrameValid (f))
+		return;
+
+	for (i=0, t=prof_tracks ; i<PROF_TRACKS ; i++, t++)
+	{
+		for (n=f->first[i] ; n != f->last[i] ; n++)
+		{
+			e = &t->events[n & (prof_maxevents - 1)];
+			if (!e->length || e->nested)
+				continue;
+			ms = e->length * 1000.0 / prof_tickrate;
+			totals[e->zone] += ms;
+			if (!e->depth)
+				tops[e->zone] += ms;
+		}
+	}
+}
+
+/*
+=================
+Prof_Start
+
+Sets the rings up the first time and empties them
+=================
+*/
+static qboolean Prof_Start (void)
+{
+	int		i;
+
+	if (!prof_frames)
+	{
+		prof_maxframes = PROF_FRAMES;
+		i = COM_CheckParm ("-profframes");
+		if (i && i < com_argc - 1)
+			prof_maxframes = Q_atoi (com_argv[i+1]);
+		if (prof_maxframes < 2)
+			prof_maxframes = 2;
+
+		prof_maxevents = PROF_EVENTS;
+		i = COM_CheckParm ("-profevents");
+		if (i && i < com_argc - 1)
+			prof_maxevents = Q_atoi (com_argv[i+1]);
+		for (i=256 ; i<prof_maxevents ; i<<=1)
+			;
+		prof_maxevents = i;
+
+		prof_frames = malloc (prof_maxframes * sizeof(profframe_t));
+		prof_totals = malloc (prof_maxframes * (MAX_PROFZONES + 1) * sizeof(float) * 2);
+		for (i=0 ; i<PROF_TRACKS ; i++)
+			prof_tracks[i].events = malloc (prof_maxevents * sizeof(profevent_t));
+		if (!prof_frames || !prof_totals || !prof_tracks[0].events || !prof_tracks[1].events)
+		{
+			free (prof_frames);
+			free (prof_totals);
+			for (i=0 ; i<PROF_TRACKS ; i++)
+			{
+				free (prof_tracks[i].events);
+				prof_tracks[i].events = NULL;
+			}
+			prof_frames = NULL;
+			Con_Printf ("Not enough memory for the profiler\n");
+			return false;
+		}
+		prof_tops = prof_totals + prof_maxframes * (MAX_PROFZONES + 1);
+	}
+
+	for (i=0 ; i<PROF_TRACKS ; i++)
+		prof_tracks[i].count = 0;
+	prof_numframes = 0;
+	prof_lastspike = -prof_maxframes;
+
+	return true;
+}
+
+/*
+=================
+Prof_Frame
+=================
+*/
+void Prof_Frame (void)
+{
+	profframe_t	*f;
+	float		ms;
+	int			i, slot;
+
+	if (prof_active)
+	{
+		slot = prof_numframes % prof_maxframes;
+		f = &prof_frames[slot];
+		f->end = Sys_Ticks ();
+		for (i=0 ; i<PROF_TRACKS ; i++)
+			f->last[i] = prof_tracks[i].count;
+		Prof_SumFrame (f, prof_totals + slot * (MAX_PROFZONES + 1), prof_tops + slot * (MAX_PROFZONES + 1));
+		prof_numframes++;
+
+		ms = (f->end - f->start) * 1000.0 / prof_tickrate;
+		if (prof_spike.value > 0 && ms > prof_spike.value && prof_numframes - prof_lastspike >= prof_maxframes)
+		{
+			prof_lastspike = prof_numframes;
+			Con_Printf ("%.1f ms frame, ", ms);
+			Prof_WriteTrace (va("profspike%i.json", host_framecount));
+		}
+	}
+
+	// nothing is open between frames, anything still open was left there by an error
+	for (i=0 ; i<PROF_TRACKS ; i++)
+	{
+		prof_tracks[i].depth = 0;
+		prof_tracks[i].skipped = 0;
+	}
+
+	if (prof_held || prof_capture.value || prof_graph.value || prof_spike.value > 0)
+	{
+		if (!prof_active)
+		{
+			prof_active = Prof_Start ();
+			if (!prof_active)
+			{
+				Cvar_Set ("prof_capture", "0");
+				Cvar_Set ("prof_graph", "0");
+				Cvar_Set ("prof_spike", "0");
+			}
+		}
+	}
+	else
+		prof_active = false;
+
+	if (!prof_active)
+		return;
+
+	f = &prof_frames[prof_numframes % prof_maxframes];
+	f->framecount = host_framecount;
+	for (i=0 ; i<PROF_TRACKS ; i++)
+		f->first[i] = prof_tracks[i].count;
+	f->start = Sys_Ticks ();
+}
+
+/*
+=================
+Prof_Hold
+=================
+*/
+void Prof_Hold (qboolean hold)
+{
+	if (hold)
+		prof_held++;
+	else if (prof_held)
+		prof_held--;
+}
+
+/*
+=================
+Prof_LastFrame
+=================
+*/
+qboolean Prof_LastFrame (char **names, int count, float *ms)
+{
+	float	*totals;
+	int		i, j;
+
+	if (!prof_active || !prof_numframes)
+		return false;
+	if (!Prof_FrameValid (&prof_frames[(prof_numframes - 1) % prof_maxframes]))
+		return false;
+
+	totals = prof_totals + ((prof_numframes - 1) % prof_maxframes) * (MAX_PROFZONES + 1);
+	for (i=0 ; i<count ; i++)
+	{
+		ms[i] = 0;
+		for (j=1 ; j<=prof_numzones ; j++)
+		{
+			if (!strcmp (prof_zones[j]->name, names[i]))
+			{
+				ms[i] = totals[j];
+				break;
+			}
+		}
+	}
+
+	return true;
+}
+
+/*
+=================
+Prof_DrawGraph
+
+A bar for each of the last frames, split into what its zones took at the
+top level, over lines at 1/60 and 1/30 of a second
+=================
+*/
+static const byte prof_colors[8][3] =
+{
+	{255, 96, 96}, {96, 255, 96}, {96, 160, 255}, {255, 224, 64},
+	{255, 96, 255}, {64, 255, 255}, {255, 160, 64}, {192, 192, 192}
+};
+
+void Prof_DrawGraph (void)
+{
+	int		i, j, x, y, h, top, left, frames, slot;
+	int		shown[MAX_PROFZONES + 1];
+	float	*tops;
+	const byte	*c;
+
+	if (!prof_active || !prof_graph.value || !prof_numframes)
+		return;
+
+	frames = prof_numframes < prof_maxframes ? prof_numframes : prof_maxframes;
+	left = 8;
+	top = vid.height - 24 - PROF_GRAPHMS;
+
+	Draw_FillByColor (left - 1, top - 1, frames * 2 + 2, PROF_GRAPHMS + 2, 0, 0, 0, 128);
+
+	memset (shown, 0, sizeof(shown));
+	for (i=0 ; i<frames ; i++)
+	{
+		slot = (prof_numframes - frames + i) % prof_maxframes;
+		tops = prof_tops + slot * (MAX_PROFZONES + 1);
+		x = left + i * 2;
+		y = top + PROF_GRAPHMS;
+		for (j=1 ; j<=prof_numzones && y > top ; j++)
+		{
+			h = (int)(tops[j] + 0.5);
+			if (!h)
+				continue;
+			if (h > y - top)
+				h = y - top;
+			y -= h;
+			c = prof_colors[j & 7];
+			Draw_FillByColor (x, y, 2, h, c[0], c[1], c[2], 255);
+			shown[j] = true;
+		}
+	}
+
+	Draw_FillByColor (left, top + PROF_GRAPHMS - 17, frames * 2, 1, 255, 255, 255, 96);
+	Draw_FillByColor (left, top + PROF_GRAPHMS - 33, frames * 2, 1, 255, 255, 255, 96);
+
+	// what the colours are
+	x = left + frames * 2 + 8;
+	y = top;
+	for (j=1 ; j<=prof_numzones && y < top + PROF_GRAPHMS ; j++)
+	{
+		if (!shown[j])
+			continue;
+		c = prof_colors[j & 7];
+		Draw_FillByColor (x, y, 6, 6, c[0], c[1], c[2], 255);
+		Draw_String (x + 10, y, prof_zones[j]->name);
+		y += 9;
+	}
+}
+
+/*
+=================
+Prof_Stats_f
+=================
+*/
+static void Prof_Stats_f (void)
+{
+	profframe_t	*f;
+	float		*totals;
+	float		sum[MAX_PROFZONES + 1], most[MAX_PROFZONES + 1];
+	float		ms, framesum, framemost;
+	int			i, j, frames, slot;
+
+	if (!prof_active || !prof_numframes)
+	{
+		Con_Printf ("nothing has been captured, see prof_capture\n");
+		return;
+	}
+
+	frames = prof_numframes < prof_maxframes ? prof_numframes : prof_maxframes;
+	memset (sum, 0, sizeof(sum));
+	memset (most, 0, sizeof(most));
+	framesum = framemost = 0;
+
+	for (i=0 ; i<frames ; i++)
+	{
+		slot = (prof_numframes - frames + i) % prof_maxframes;
+		f = &prof_frames[slot];
+		ms = (f->end - f->start) * 1000.0 / prof_tickrate;
+		framesum += ms;
+		if (ms > framemost)
+			framemost = ms;
+
+		totals = prof_totals + slot * (MAX_PROFZONES + 1);
+		for (j=1 ; j<=prof_numzones ; j++)
+		{
+			sum[j] += totals[j];
+			if (totals[j] > most[j])
+				most[j] = totals[j];
+		}
+	}
+
+	Con_Printf ("the last %i frames:\n", frames);
+	Con_Printf ("  avg ms   max ms name\n");
+	Con_Printf ("%8.2f %8.2f frame\n", framesum / frames, framemost);
+	for (j=1 ; j<=prof_numzones ; j++)
+		Con_Printf ("%8.2f %8.2f %s\n", sum[j] / frames, most[j], prof_zones[j]->name);
+}
+
+/*
+=================
+Prof_WriteTrace
+
+The frames still in the rings as complete ("X") events, a track for each
+thread and one for the frames
+=================
+*/
+static int Prof_WriteTrace (char *name)
+{
+	char		path[MAX_OSPATH];
+	profframe_t	*fr, *first;
+	profevent_t	*e;
+	proftrack_t	*t;
+	FILE		*f;
+	unsigned int	n;
+	int			i, j, frames, written;
+	double		base, scale;
+
+	frames = prof_numframes < prof_maxframes ? prof_numframes : prof_maxframes;
+	first = NULL;
+	for (i=0 ; i<frames ; i++)
+	{
+		fr = &prof_frames[(prof_numframes - frames + i) % prof_maxframes];
+		if (Prof_FrameValid (fr))
+		{
+			first = fr;
+			break;
+		}
+	}
+	if (!first)
+	{
+		Con_Printf ("no whole frames have been captured, see -profevents\n");
+		return 0;
+	}
+
+	snprintf (path, sizeof(path), "%s/%s", com_gamedir, name);
+	f = fopen (path, "w");
+	if (!f)
+	{
+		Con_Printf ("Couldn't write %s\n", path);
+		return 0;
+	}
+
+	base = first->start;
+	scale = 1000000.0 / prof_tickrate;
+
+	fprintf (f, "{\"traceEvents\":[\n");
+	fprintf (f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"frames\"}},\n");
+	fprintf (f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"main\"}},\n");
+	fprintf (f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,\"args\":{\"name\":\"server\"}}");
+
+	written = 0;
+	for ( ; i<frames ; i++)
+	{
+		fr = &prof_frames[(prof_numframes - frames + i) % prof_maxframes];
+		fprintf (f, ",\n{\"name\":\"frame %i\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.1f,\"dur\":%.1f}",
+			fr->framecount, (fr->start - base) * scale, (fr->end - fr->start) * scale);
+
+		for (j=0, t=prof_tracks ; j<PROF_TRACKS ; j++, t++)
+		{
+			for (n=fr->first[j] ; n != fr->last[j] ; n++)
+			{
+				e = &t->events[n & (prof_maxevents - 1)];
+				if (!e->length)
+					continue;
+				fprintf (f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%.1f,\"dur\":%.1f}",
+					prof_zones[e->zone]->name, j + 2, (e->start - base) * scale, e->length * scale);
+				written++;
+			}
+		}
+	}
+	fprintf (f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+	fclose (f);
+
+	Con_Printf ("Wrote %i zones to %s\n", written, path);
+	return written;
+}
+
+/*
+=================
+Prof_Dump_f
+=================
+*/
+static void Prof_Dump_f (void)
+{
+	if (!prof_active || !prof_numframes)
+	{
+		Con_Printf ("nothing has been captured, see prof_capture\n");
+		return;
+	}
+
+	Prof_WriteTrace (Cmd_Argc () > 1 ? Cmd_Argv (1) : "prof.json");
+}
+
+/*
+=================
+Prof_Init
+=================
+*/
+void Prof_Init (void)
+{
+	prof_lock = Sys_CreateSemaphore (1);
+	prof_tickrate = Sys_TickRate ();
+
+	Cvar_RegisterVariable (&prof_capture);
+	Cvar_RegisterVariable (&prof_graph);
+	Cvar_RegisterVariable (&prof_spike);
+	Cmd_AddCommand ("profstats", Prof_Stats_f);
+	Cmd_AddCommand ("profdump", Prof_Dump_f);
+}
+
+#endif // PROF_ZONES
@@ -0,0 +1,69 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// prof.h -- timed zones on the hot paths, kept for the last few frames
+//
+// PROF_BEGIN (name) and PROF_END (name) bracket a zone, name is a bare
+// identifier that also names a static the zone registers itself through on
+// its first run.  Every return between the two needs its PROF_END.  Zones
+// are timed on the main thread and the pipelined server tick only.
+//
+// Without PROF_ZONES, set in quakedef.h, all of it compiles to nothing.
+
+#ifdef PROF_ZONES
+
+typedef struct
+{
+	char	*name;
+	int		index;				// 0 until the first Prof_Begin
+} profzone_t;
+
+void Prof_Init (void);
+void Prof_Begin (profzone_t *zone);
+void Prof_End (profzone_t *zone);
+
+// the main thread between frames, with a pipelined tick handed back
+void Prof_Frame (void);
+
+// the bar graph, drawn with the rest of the 2D
+void Prof_DrawGraph (void);
+
+// keeps the zones captured for a caller of Prof_LastFrame, Prof_Hold (false)
+// to let them go
+void Prof_Hold (qboolean hold);
+
+// ms the frame Prof_Frame just ended spent in each of the named zones,
+// false if it wasn't captured
+qboolean Prof_LastFrame (char **names, int count, float *ms);
+
+#define	PROF_BEGIN(name)	static profzone_t prof_##name = {#name}; Prof_Begin (&prof_##name)
+#define	PROF_END(name)		Prof_End (&prof_##name)
+#define	PROF_INIT()			Prof_Init ()
+#define	PROF_FRAME()		Prof_Frame ()
+#define	PROF_DRAWGRAPH()	Prof_DrawGraph ()
+
+#else
+
+#define	PROF_BEGIN(name)
+#define	PROF_END(name)
+#define	PROF_INIT()
+#define	PROF_FRAME()
+#define	PROF_DRAWGRAPH()
+
+#endif // PROF_ZONES
@@ -67,6 +67,8 @@ extern	int				pr_edict_size;	// in bytes
 
 //============================================================================
 
+#define	MAX_STACK_DEPTH		32		// QC calls, nested PR_ExecuteProgram calls included
+
 void PR_Init (void);
 
 void PR_ExecuteProgram (func_t fnum);
@@ -137,6 +139,7 @@ extern int				pr_ebfs_numbuiltins;
 
 extern cvar_t	pr_builtin_find;
 extern cvar_t	pr_builtin_remap;
+extern cvar_t	sv_maxai;
 
 #define PR_DEFAULT_FUNCNO_EXTENSION_FIND	99	// 2001-10-20 Extension System by Lord Havoc/Maddes
 // 2001-09-14 Enhanced BuiltIn Function System (EBFS) by Maddes  end
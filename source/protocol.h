@@ -161,6 +161,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define svc_screenflash		50		// [byte] color [byte] duration [byte] type
 #define svc_lockviewmodel	51
 #define svc_rumble			52 		// [short] low frequency [short] high frequency [short] duration (ms)
+#define svc_moveack			53		// [long] last clc_move sequence the server has run, NETCAP_MOVESEQ only
+#define svc_compressed		54		// [long] size, then lz data to the end of the message
 
 //
 // client to server
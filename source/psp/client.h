@@ -231,6 +231,14 @@ typedef struct
 	int			maxclients;
 	int			gametype;
 
+// what the renderer reads of a local server, copied between its ticks
+	double		svtime;				// sv.time
+	char		weaponname[32];		// the player's Weapon_Name
+	char		touchname[32];		// and Weapon_Name_Touch
+	float		facingenemy;
+	float		viewofs;			// view_ofs[2]
+	vec3_t		adsoffset;
+
 	lerpents_t	*lerpents;
 
 // refresh related state
@@ -408,6 +416,13 @@ void CL_Stop_f (void);
 void CL_Record_f (void);
 void CL_PlayDemo_f (void);
 void CL_TimeDemo_f (void);
+void CL_TimeDemoCompare_f (void);
+
+// a timedemo's frame times, at the start of every host frame
+void CL_TimeDemoFrame (void);
+
+extern	cvar_t	timedemo_warmup;
+extern	cvar_t	timedemo_output;
 
 //
 // cl_parse.c
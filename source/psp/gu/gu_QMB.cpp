@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 extern "C"
 {
 #include "../../quakedef.h"
+#include "../../prof.h"
 //entity_t *CL_NewTempEntity (void);
 }
 
@@ -1413,6 +1414,8 @@ void QMB_DrawParticles (void)
 	if (!qmb_initialized)
 		return;
 
+	PROF_BEGIN (QMB_DrawParticles);
+
 	particle_time = cl.time;
 
 	if (!cl.paused)
@@ -1749,6 +1752,8 @@ void QMB_DrawParticles (void)
 	sceGuBlendFunc (GU_ADD, GU_SRC_ALPHA, GU_ONE_MINUS_SRC_ALPHA, 0, 0);
 	sceGuTexFunc(GU_TFX_REPLACE, GU_TCC_RGBA);
 	sceGuShadeModel (GU_FLAT);
+
+	PROF_END (QMB_DrawParticles);
 }
 
 void QMB_Shockwave_Splash(vec3_t org, int radius)
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 extern "C"
 {
 #include "../../quakedef.h"
+#include "../../arena.h"
 }
 #include <pspgu.h>
 
@@ -483,8 +484,8 @@ const double decalEpsilon = 0.001;
 
 void DecalClipLeaf (decal_t *dec, mleaf_t *leaf)
 {
- 	int			c;
-	vec3_t		newVertex[64], t3;
+ 	int			c, mark;
+	vec3_t		*newVertex, t3;
 	msurface_t	**surf;
 
 	c = leaf->nummarksurfaces;
@@ -497,6 +498,10 @@ void DecalClipLeaf (decal_t *dec, mleaf_t *leaf)
 		glpoly_t *poly;
 
 		poly = (*surf)->polys;
+
+		// each of the six clip planes can add a vertex
+		mark = Arena_Mark (&cl_arena);
+		newVertex = (vec3_t *) Arena_Alloc (&cl_arena, (poly->numverts + 6) * sizeof(vec3_t));
 		for (i = 0 ; i < poly->numverts ; i++)
 		{
 			newVertex[i][0] = poly->verts[i].xyz[0];
@@ -514,14 +519,22 @@ void DecalClipLeaf (decal_t *dec, mleaf_t *leaf)
 		{
 			count = DecalClipPolygon (poly->numverts, newVertex, newVertex);
 			if (count != 0 && !DecalAddPolygon(dec, count, newVertex))
+			{
+				Arena_Release (&cl_arena, mark);
 				break;
+			}
 		}
+		Arena_Release (&cl_arena, mark);
 	}
 }
 
 int DecalClipPolygon (int vertexCount, vec3_t *vertices, vec3_t *newVertex)
 {
-	vec3_t	tempVertex[64];
+	vec3_t	*tempVertex;
+	int		mark;
+
+	mark = Arena_Mark (&cl_arena);
+	tempVertex = (vec3_t *) Arena_Alloc (&cl_arena, (vertexCount + 6) * sizeof(vec3_t));
 
 	// Clip against all six planes
 	int count = DecalClipPolygonAgainstPlane (&leftPlane, vertexCount, vertices, tempVertex);
@@ -546,6 +559,7 @@ int DecalClipPolygon (int vertexCount, vec3_t *vertices, vec3_t *newVertex)
 		}
 	}
 
+	Arena_Release (&cl_arena, mark);
 	return count;
 }
 
@@ -553,8 +567,12 @@ int DecalClipPolygonAgainstPlane (plane_t *plane, int vertexCount, vec3_t *verte
 {
 	int		a, b, c, count, negativeCount = 0;
 	float	t;
-	bool negative[65];
+	bool	*negative;
 	vec3_t	v1, v2;
+	int		mark;
+
+	mark = Arena_Mark (&cl_arena);
+	negative = (bool *) Arena_Alloc (&cl_arena, vertexCount * sizeof(bool));
 
 	// Classify vertices
 	for (a = 0 ; a < vertexCount ; a++)
@@ -566,7 +584,10 @@ int DecalClipPolygonAgainstPlane (plane_t *plane, int vertexCount, vec3_t *verte
 
 	// Discard this polygon if it's completely culled
 	if (negativeCount == vertexCount)
+	{
+		Arena_Release (&cl_arena, mark);
 		return 0;
+	}
 
 	count = 0;
 	for (b = 0 ; b < vertexCount ; b++)
@@ -618,6 +639,8 @@ int DecalClipPolygonAgainstPlane (plane_t *plane, int vertexCount, vec3_t *verte
 		}
 	}
 
+	Arena_Release (&cl_arena, mark);
+
 	// Return number of vertices in clipped polygon
 	return count;
 }
@@ -39,6 +39,12 @@ extern "C"
 
 #include "gu_dxtn.h"
 #include "gu_resample.h"
+#include "gu_texconv.h"
+
+extern "C"
+{
+#include "../../texcook.h"
+}
 
 #include "../vram.hpp"
 
@@ -103,6 +109,19 @@ bool 		gltextures_used[MAX_GLTEXTURES];
 bool 		gltextures_is_permanent[MAX_GLTEXTURES];
 int			numgltextures;
 
+// Textures are found by identifier through a hash, and a texture loaded
+// for the last map stays resident until the next one has loaded, so the
+// ones both use (weapons, zombies, sprites) are taken over instead of
+// decoded and swizzled again.  The content checksum tells two different
+// images that share a name apart; 0 means the name alone identifies it.
+#define	TEXTURE_HASH_SIZE	256
+int			gltextures_refcount[MAX_GLTEXTURES];
+unsigned int gltextures_checksum[MAX_GLTEXTURES];
+static int	gltextures_hashnext[MAX_GLTEXTURES];
+static int	gltextures_hash[TEXTURE_HASH_SIZE];
+static int	gltextures_free[MAX_GLTEXTURES];	// stack of unused slots
+static int	gltextures_numfree;
+
 typedef struct
 {
 	int			index;	// index into gltextures[].
@@ -132,42 +151,16 @@ void GL_InitTextureUsage ()
 	for (int i=0; i<MAX_GLTEXTURES; i++) {
 		gltextures_used[i] = false;
 		gltextures_is_permanent[i] = false;
+		gltextures_refcount[i] = 0;
+		// lowest slot on top, so they are handed out in order
+		gltextures_free[i] = MAX_GLTEXTURES - 1 - i;
 	}
-	numgltextures = 0;
-}
+	gltextures_numfree = MAX_GLTEXTURES;
 
-//Crow_bar.
-int GL_GetTexSize(int format, int w, int h, int bpp)
-{
-	int size = 0;
-	if(bpp == 0 && (format != -1))
-	{
-		switch(format)
-		{
-			case GU_PSM_T4:
-			case GU_PSM_DXT1:
-				size = w*h/2;
-				break;
-			case GU_PSM_T8:
-			case GU_PSM_DXT3:
-			case GU_PSM_DXT5:
-				size = w*h;
-				break;
-			case GU_PSM_5650:
-			case GU_PSM_5551:
-			case GU_PSM_4444:
-				size = w*h*2;
-				break;
-			case GU_PSM_8888:
-				size = w*h*4;
-				break;
-		}
-	}
-	else
-	{
-		size = w*h*bpp;
-	}
-	return size;
+	for (int i=0; i<TEXTURE_HASH_SIZE; i++)
+		gltextures_hash[i] = -1;
+
+	numgltextures = 0;
 }
 
 void GL_Copy(int texture_index, int dx, int dy, int sx, int sy, int w, int h)
@@ -1418,7 +1411,7 @@ void Draw_Crosshair (void)
 		Draw_FillByColor(368, 7, 112, 256, 0, 0, 0, 255); // Right
 	}
 		
-   	if (Hitmark_Time > sv.time)
+   	if (Hitmark_Time > cl.svtime)
         Draw_Pic ((vid.width - hitmark->width)/2,(vid.height - hitmark->height)/2, hitmark);
 
 	// Make sure to do this after hitmark drawing.
@@ -1430,14 +1423,14 @@ void Draw_Crosshair (void)
 
 	float col;
 
-	if (sv_player->v.facingenemy == 1) {
+	if (cl.facingenemy == 1) {
 		col = 0;
 	} else {
 		col = 255;
 	}
 
 	// crosshair moving
-	if (crosshair_spread_time > sv.time && crosshair_spread_time)
+	if (crosshair_spread_time > cl.svtime && crosshair_spread_time)
     {
         cur_spread = cur_spread + 10;
 		crosshair_opacity = 128;
@@ -1446,7 +1439,7 @@ void Draw_Crosshair (void)
 			cur_spread = CrossHairMaxSpread();
     }
 	// crosshair not moving
-    else if (crosshair_spread_time < sv.time && crosshair_spread_time)
+    else if (crosshair_spread_time < cl.svtime && crosshair_spread_time)
     {
         cur_spread = cur_spread - 4;
 		crosshair_opacity = 255;
@@ -1470,9 +1463,9 @@ void Draw_Crosshair (void)
 		if (CrossHairMaxSpread() < crosshair_offset || croshhairmoving)
 			crosshair_offset = CrossHairMaxSpread();
 
-		if (sv_player->v.view_ofs[2] == 8) {
+		if (cl.viewofs == 8) {
 			crosshair_offset *= 0.80;
-		} else if (sv_player->v.view_ofs[2] == -10) {
+		} else if (cl.viewofs == -10) {
 			crosshair_offset *= 0.65;
 		}
 
@@ -1890,45 +1883,6 @@ void swizzle(u8* out, const u8* in, unsigned int width, unsigned int height)
    }
 }
 
-/*
-================
-swizzle_fast
-================
-*/
-void swizzle_fast(u8* out, const u8* in, unsigned int width, unsigned int height)
-{
-	unsigned int blockx, blocky;
-	unsigned int j;
-
-	unsigned int width_blocks = (width / 16);
-	unsigned int height_blocks = (height / 8);
-
-	unsigned int src_pitch = (width-16)/4;
-	unsigned int src_row = width * 8;
-
-	const u8* ysrc = in;
-	u32* dst = (u32*)out;
-
-	for (blocky = 0; blocky < height_blocks; ++blocky)
-	{
-		const u8* xsrc = ysrc;
-		for (blockx = 0; blockx < width_blocks; ++blockx)
-		{
-			const u32* src = (u32*)xsrc;
-			for (j = 0; j < 8; ++j)
-			{
-				*(dst++) = *(src++);
-				*(dst++) = *(src++);
-				*(dst++) = *(src++);
-				*(dst++) = *(src++);
-				src += src_pitch;
-			}
-			xsrc += 16;
-		}
-		ysrc += src_row;
-	}
-}
-
 
 
 /*
@@ -1950,6 +1904,21 @@ void GL_ResampleTexture(const byte *in, int inwidth, int inheight, unsigned char
 	}
 }
 
+/*
+================
+GL_TextureDesc
+================
+*/
+static void GL_TextureDesc(const gltexture_t& texture, gutexdesc_t *desc)
+{
+	desc->format	= texture.format;
+	desc->width		= texture.width;
+	desc->height	= texture.height;
+	desc->mipmaps	= texture.mipmaps;
+	desc->swizzle	= texture.swizzle;
+	desc->stretch	= texture.stretch_to_power_of_two;
+}
+
 /*
 ================
 GL_Upload8
@@ -2489,59 +2458,15 @@ void GL_Upload32(int texture_index, const byte *data, int width, int height)
 		Sys_Error("Attempting to upload a texture which doesn't match the destination");
 	}
 
+	gutexdesc_t desc;
+	GL_TextureDesc(texture, &desc);
+
 	// Create a temporary buffer to use as a source for swizzling.
-	std::size_t buffer_size = GL_GetTexSize(texture.format, texture.width, texture.height, 0);
+	std::size_t buffer_size = GL_ImageSize(&desc);
 	int start = Hunk_LowMark ();
-	byte* unswizzled = static_cast<byte*>(Hunk_Alloc(buffer_size));
+	byte* unswizzled = static_cast<byte*>(Hunk_Alloc(GL_GetTexSize(texture.format, texture.width, texture.height, 0)));
 
-	if (texture.mipmaps > 0)
-	{
-		int size_incr = buffer_size/4;
-
-		for (int i= 1;i <= texture.mipmaps;i++)
-		{
-			buffer_size += size_incr;
-			size_incr = size_incr/4;
-		}
-	}
-
-	//32BIT resize and swizzler by Crow_bar PSP port
-	// Do we need to resize?
-	if (texture.stretch_to_power_of_two)
-	{
-	  // Resize.
-	  Image_Resample ((void*)data, width, height, &unswizzled[0], texture.width, texture.height, texture.bpp, int(r_restexf.value));
-  	}
-	else
-	{
-		// Straight copy.
-		for (int y = 0; y < height; ++y)
-		{
-			const byte* const	src	= data + (y * width * texture.bpp);
-			byte* const			dst = &unswizzled[y * texture.width * texture.bpp];
-			memcpy(dst, src, width * texture.bpp);
-		}
-	}
-
-	// Swizzle to system RAM.
-	swizzle_fast(texture.ram, &unswizzled[0], texture.width * texture.bpp, texture.height);
-
-
-    if (texture.mipmaps > 0)
-	{
-		int size = GL_GetTexSize(texture.format, texture.width, texture.height, 0);
-		int offset = size;
-		int div = 2;
-
-		for (int i = 1; i <= texture.mipmaps;i++)
-		{
-			Image_Resample((void*)data, width, height, &unswizzled[0],
-			texture.width/div, texture.height/div, texture.bpp, int(r_restexf.value));
-			swizzle_fast(texture.ram+offset, &unswizzled[0], (texture.width/div) * texture.bpp, texture.height/div);
-			offset += size/(div*div);
-			div *=2;
-		}
-	}
+	GL_ConvertSwizzled(&desc, texture.bpp, int(r_restexf.value), data, width, height, texture.ram, unswizzled);
 
 	Hunk_FreeToLowMark(start);
 
@@ -2579,6 +2504,9 @@ void GL_UploadDXT(int texture_index, const byte *data, int width, int height)
 		Sys_Error("Attempting to upload a texture which doesn't match the destination");
 	}
 	
+	gutexdesc_t desc;
+	GL_TextureDesc(texture, &desc);
+
 	// Create a temporary buffer to use as a source for swizzling.
 	std::size_t buffer_sizesrc = GL_GetTexSize(-1, texture.width, texture.height, texture.bpp);
 	int start = Hunk_LowMark ();
@@ -2587,27 +2515,8 @@ void GL_UploadDXT(int texture_index, const byte *data, int width, int height)
     // New compressed texture
 	std::size_t buffer_sizedst = GL_GetTexSize(texture.format, texture.width, texture.height, 0);
 
-	if (texture.stretch_to_power_of_two)
-	{
-		// Resize.
-		Image_Resample ((void*)data, width, height, &unswizzled[0], texture.width, texture.height, texture.bpp, int(r_restexf.value));
-  	}
-	else
-	{
-		// Straight copy.
-		for (int y = 0; y < height; ++y)
-		{
-			const byte* const	src	= data + (y * width * texture.bpp);
-			byte* const			dst = &unswizzled[y * texture.width * texture.bpp];
-			memcpy(dst, src, width * texture.bpp);
-		}
-	}
-
-	if (texture.vram) {
-		tx_compress_dxtn(texture.bpp, texture.width, texture.height,(const unsigned char *)&unswizzled[0], texture.format, (unsigned char *)texture.vram);
-	} else {
-		tx_compress_dxtn(texture.bpp, texture.width, texture.height,(const unsigned char *)&unswizzled[0], texture.format, (unsigned char *)texture.ram);
-	}
+	GL_ConvertDXT(&desc, texture.bpp, int(r_restexf.value), data, width, height,
+		texture.vram ? texture.vram : texture.ram, unswizzled);
 
 	Hunk_FreeToLowMark (start);
 
@@ -2622,35 +2531,53 @@ void GL_UploadDXT(int texture_index, const byte *data, int width, int height)
 	}
 }
 
-static std::size_t round_up(std::size_t size)
+static unsigned int GL_TextureHash (const char *identifier)
 {
-	static const float	denom	= 1.0f / logf(2.0f);
-	const float			logged	= logf(size) * denom;
-	const float			ceiling	= ceilf(logged);
-	return 1 << static_cast<int>(ceiling);
+	unsigned int h = 0;
+
+	for ( ; *identifier; identifier++)
+		h = h * 31 + *identifier;
+
+	return h & (TEXTURE_HASH_SIZE - 1);
 }
 
+/*
+================
+GL_TextureChecksum
 
-static std::size_t round_down(std::size_t size)
+Samples at most a few thousand bytes, it only has to tell two images
+loaded under one name apart
+================
+*/
+static unsigned int GL_TextureChecksum (const byte *data, int size)
 {
-	static const float	denom	= 1.0f / logf(2.0f);
-	const float			logged	= logf(size) * denom;
-	const float			floor	= floorf(logged);
-	return 1 << static_cast<int>(floor);
+	unsigned int h = 2166136261u ^ size;
+	int step = (size >> 12) | 1;
+
+	for (int i = 0; i < size; i += step)
+	{
+		h ^= data[i];
+		h *= 16777619u;
+	}
+
+	return h ? h : 1;
 }
 
 /*
 ================
-GL_UnloadTexture
+GL_FreeTexture
 ================
 */
-void GL_UnloadTexture(int texture_index)
+static void GL_FreeTexture(int texture_index)
 {
-	if (gltextures_used[texture_index] == false) return;
-	if (gltextures_is_permanent[texture_index]) return;
-
 	gltexture_t& texture = gltextures[texture_index];
 
+	// Unlink it from the hash.
+	int *link = &gltextures_hash[GL_TextureHash(texture.identifier)];
+	while (*link != texture_index)
+		link = &gltextures_hashnext[*link];
+	*link = gltextures_hashnext[texture_index];
+
 	// Con_Printf("Unloading: %s,%d\n",texture.identifier, texture.bpp);
 	// Source.
 	strcpy(texture.identifier,"");
@@ -2705,13 +2632,113 @@ void GL_UnloadTexture(int texture_index)
 	}
 
 	gltextures_used[texture_index] = false;
+	gltextures_refcount[texture_index] = 0;
+	gltextures_free[gltextures_numfree++] = texture_index;
 	numgltextures--;
 }
 
+/*
+================
+GL_EvictTexture
+
+Frees a texture nothing holds any more, one in VRAM if vram is set;
+false if there is none
+================
+*/
+static bool GL_EvictTexture(bool vram)
+{
+	for (int i = 0; i < MAX_GLTEXTURES; i++)
+	{
+		if (gltextures_used[i] && !gltextures_is_permanent[i] && !gltextures_refcount[i]
+			&& (!vram || gltextures[i].vram))
+		{
+			GL_FreeTexture(i);
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+================
+GL_AllocVRAM
+
+What the last map left behind gives way to the textures of this one
+================
+*/
+static texel* GL_AllocVRAM(std::size_t size)
+{
+	void *vram = vramalloc(size);
+
+	while (!vram && GL_EvictTexture(true))
+		vram = vramalloc(size);
+
+	return static_cast<texel*>(vram);
+}
+
+/*
+================
+GL_UnloadTexture
+
+Drops a reference, the texture goes with the last one
+================
+*/
+void GL_UnloadTexture(int texture_index)
+{
+	if (gltextures_used[texture_index] == false) return;
+	if (gltextures_is_permanent[texture_index]) return;
+
+	if (gltextures_refcount[texture_index] > 1)
+	{
+		gltextures_refcount[texture_index]--;
+		return;
+	}
+
+	GL_FreeTexture(texture_index);
+}
+
 void GL_UnloadAllTextures() {
 	for (int i = 0; i < MAX_GLTEXTURES; i++) {
-		GL_UnloadTexture(i);
+		if (gltextures_used[i] && !gltextures_is_permanent[i])
+			GL_FreeTexture(i);
+	}
+}
+
+/*
+================
+GL_ReleaseTextures
+
+The models let go of everything they loaded.  The textures stay until
+GL_PurgeTextures in case the next map takes them over
+================
+*/
+void GL_ReleaseTextures(void)
+{
+	for (int i = 0; i < MAX_GLTEXTURES; i++)
+		gltextures_refcount[i] = 0;
+}
+
+/*
+================
+GL_PurgeTextures
+
+Frees what the new map did not take over
+================
+*/
+void GL_PurgeTextures(void)
+{
+	int freed = 0;
+
+	for (int i = 0; i < MAX_GLTEXTURES; i++)
+	{
+		if (gltextures_used[i] && !gltextures_is_permanent[i] && !gltextures_refcount[i])
+		{
+			GL_FreeTexture(i);
+			freed++;
+		}
 	}
+
+	Con_DPrintf("Textures: %d freed, %d kept\n", freed, numgltextures);
 }
 
 /*
@@ -2726,49 +2753,97 @@ void GL_MarkTextureAsPermanent(int texture_index) {
 	gltextures_is_permanent[texture_index] = true;
 }
 
-int GL_TextureForName(const char * identifier) {
-	// See if the texture is already present.
-	if (identifier[0])
+/*
+================
+GL_FindTexture
+
+The texture under the identifier, if its checksum matches.  One an
+earlier map left behind with other contents is freed on the way
+================
+*/
+static int GL_FindTexture(const char * identifier, unsigned int checksum) {
+	if (!identifier[0])
+		return -1;
+
+	int next;
+	for (int i = gltextures_hash[GL_TextureHash(identifier)]; i >= 0; i = next)
 	{
-		for (int i = 0; i < MAX_GLTEXTURES; ++i)
-		{
-			if (gltextures_used[i] == true)
-			{
-				const gltexture_t& texture = gltextures[i];
-				if (!strcmp (identifier, texture.identifier))
-				{
-					return i;
-				}
-			}
-		}
+		next = gltextures_hashnext[i];
+
+		if (strcmp(identifier, gltextures[i].identifier))
+			continue;
+
+		if (!checksum || !gltextures_checksum[i] || gltextures_checksum[i] == checksum
+			|| gltextures_refcount[i] || gltextures_is_permanent[i])
+			return i;
+
+		GL_FreeTexture(i);
 	}
 	return -1;
 }
 
-int GL_GetTextureIndex() {
+int GL_TextureForName(const char * identifier) {
+	return GL_FindTexture(identifier, 0);
+}
+
+static int GL_ReferenceTexture(int texture_index) {
+	gltextures_refcount[texture_index]++;
+	return texture_index;
+}
+
+/*
+================
+GL_ReuseTexture
+
+The texture loaded under the identifier with one more reference, or -1,
+so a loader can skip decoding an image it already has
+================
+*/
+int GL_ReuseTexture(const char * identifier) {
+	int texture_index = GL_TextureForName(identifier);
+	if (texture_index >= 0)
+		GL_ReferenceTexture(texture_index);
+	return texture_index;
+}
+
+/*
+================
+GL_TextureBytes
+
+What the texture takes up in VRAM or RAM, mipmaps included
+================
+*/
+int GL_TextureBytes(int texture_index) {
+	const gltexture_t& texture = gltextures[texture_index];
+	gutexdesc_t desc;
+
+	desc.format		= texture.format;
+	desc.width		= texture.width;
+	desc.height		= texture.height;
+	desc.mipmaps	= texture.mipmaps;
+
+	return GL_ImageSize(&desc);
+}
+
+int GL_GetTextureIndex(const char * identifier, unsigned int checksum) {
 	// Out of textures?
-	if (numgltextures == MAX_GLTEXTURES)
+	if (gltextures_numfree == 0 && !GL_EvictTexture(false))
 	{
 		Sys_Error("Out of gl textures");
 	}
 
 	numgltextures++;
-	int texture_index = -1;
+	int texture_index = gltextures_free[--gltextures_numfree];
 
-	for (int i = 0; i < MAX_GLTEXTURES; ++i)
-	{
-		if (gltextures_used[i] == false)
-		{
-			texture_index = i;
-			break;
-		}
-	}
+	gltextures_used[texture_index] = true;
+	gltextures_refcount[texture_index] = 1;
+	gltextures_checksum[texture_index] = checksum;
 
-	if (texture_index < 0) {
-		Sys_Error("Could not find a free gl texture!\n");
-	}
+	strcpy(gltextures[texture_index].identifier, identifier);
 
-	gltextures_used[texture_index] = true;
+	int h = GL_TextureHash(identifier);
+	gltextures_hashnext[texture_index] = gltextures_hash[h];
+	gltextures_hash[h] = texture_index;
 
 	return texture_index;
 }
@@ -2780,17 +2855,17 @@ GL_LoadTexture
 */
 int GL_LoadTexture (const char *identifier, int width, int height, const byte *data, qboolean stretch_to_power_of_two, int filter, int mipmap_level)
 {
-	int texture_index = GL_TextureForName(identifier);
-	if (texture_index >= 0) return texture_index;
+	unsigned int checksum = GL_TextureChecksum(data, width * height);
+	int texture_index = GL_FindTexture(identifier, checksum);
+	if (texture_index >= 0) return GL_ReferenceTexture(texture_index);
 
 	tex_scale_down = r_tex_scale_down.value == qtrue;
 	
-	texture_index = GL_GetTextureIndex();
+	texture_index = GL_GetTextureIndex(identifier, checksum);
 
 	gltexture_t& texture = gltextures[texture_index];
 
 	// Fill in the source data.
-	strcpy(texture.identifier, identifier);
 	texture.original_width			= width;
 	texture.original_height			= height;
 	texture.stretch_to_power_of_two	= stretch_to_power_of_two != qfalse;
@@ -2853,7 +2928,7 @@ int GL_LoadTexture (const char *identifier, int width, int height, const byte *d
 	}
 
 	// Allocate the VRAM.
-	texture.vram = static_cast<texel*>(vramalloc(buffer_size));
+	texture.vram = GL_AllocVRAM(buffer_size);
 
 	// Upload the texture.
 	GL_Upload8(texture_index, data, width, height);
@@ -2874,17 +2949,17 @@ GL_LoadPalTex
 */
 int GL_LoadPalTex (const char *identifier, int width, int height, const byte *data, qboolean stretch_to_power_of_two, int filter, int mipmap_level, byte *palette, int paltype)
 {
-	int texture_index = GL_TextureForName(identifier);
-	if (texture_index >= 0) return texture_index;
+	unsigned int checksum = GL_TextureChecksum(data, width * height);
+	int texture_index = GL_FindTexture(identifier, checksum);
+	if (texture_index >= 0) return GL_ReferenceTexture(texture_index);
 
 	tex_scale_down = r_tex_scale_down.value == qtrue;
 	
-	texture_index = GL_GetTextureIndex();
+	texture_index = GL_GetTextureIndex(identifier, checksum);
 
 	gltexture_t& texture = gltextures[texture_index];
 
 	// Fill in the source data.
-	strcpy(texture.identifier, identifier);
 	texture.original_width			= width;
 	texture.original_height			= height;
 	texture.stretch_to_power_of_two	= stretch_to_power_of_two != qfalse;
@@ -3004,7 +3079,7 @@ int GL_LoadPalTex (const char *identifier, int width, int height, const byte *da
 	}
 
 	// Allocate the VRAM.
-	texture.vram = static_cast<texel*>(vramalloc(buffer_size));
+	texture.vram = GL_AllocVRAM(buffer_size);
 
 	// Upload the texture.
 	GL_Upload8(texture_index, data, width, height);
@@ -3029,17 +3104,15 @@ int GL_LoadTextureLM (const char *identifier, int width, int height, const byte
 	tex_scale_down = r_tex_scale_down.value == qtrue;
 	int texture_index = GL_TextureForName(identifier);
 	if (texture_index >= 0 && update == qfalse) {
-		return texture_index;
+		return GL_ReferenceTexture(texture_index);
 	}
 
 	if (update == qfalse || texture_index == -1)
 	{
-		texture_index = GL_GetTextureIndex();
+		texture_index = GL_GetTextureIndex(identifier, 0);
 		gltexture_t& texture = gltextures[texture_index];
-		gltextures_used[texture_index] = true;
 
 		// Fill in the source data.
-		strcpy(texture.identifier, identifier);
 		texture.original_width			= width;
 		texture.original_height			= height;
 		texture.stretch_to_power_of_two	= false;
@@ -3101,7 +3174,7 @@ int GL_LoadTextureLM (const char *identifier, int width, int height, const byte
 		}
 
 		// Allocate the VRAM.
-		texture.vram = static_cast<texel*>(vramalloc(buffer_size));
+		texture.vram = GL_AllocVRAM(buffer_size);
 
 	    // Upload the texture.
 		if(!texture.swizzle)
@@ -3210,24 +3283,57 @@ int GL_LoadTextureLM (const char *identifier, int width, int height, const byte
 	return texture_index;
 }
 
+int total_overbudget_texturemem;
+
+/*
+================
+GL_ImageOptions
+================
+*/
+static void GL_ImageOptions(gutexopts_t *opts)
+{
+	opts->texcompr		= (int)r_texcompr.value;
+	opts->scale_down	= r_tex_scale_down.value == qtrue;
+	opts->phat			= psp_system_model == PSP_MODEL_PHAT;
+	opts->resample		= int(r_restexf.value);
+}
+
+/*
+================
+GL_ReleaseImageRAM
+
+Once the image is in VRAM the RAM copy goes
+================
+*/
+static void GL_ReleaseImageRAM(gltexture_t& texture, std::size_t buffer_size)
+{
+	//FIXME: this isn't completely clearing out the normal ram stuff :s
+	if (texture.vram && texture.ram)
+	{
+		free(texture.ram);
+		texture.ram = NULL;
+	} else {
+		Con_Printf("Couldn't fit %s into VRAM (%dkB)\n", texture.identifier, buffer_size/1024);
+		total_overbudget_texturemem += buffer_size/1024;
+		Con_Printf("OVERFLOWN VRAM: %d\n", total_overbudget_texturemem);
+	}
+}
+
 /*
 ================
 GL_LoadImages
 ================
 */
-int total_overbudget_texturemem;
 int GL_LoadImages (const char *identifier, int width, int height, const byte *data, qboolean stretch_to_power_of_two, int filter, int mipmap_level, int bpp)
 {
-	int texture_index = GL_TextureForName(identifier);
-	if (texture_index >= 0) return texture_index;
+	unsigned int checksum = GL_TextureChecksum(data, width * height * bpp);
+	int texture_index = GL_FindTexture(identifier, checksum);
+	if (texture_index >= 0) return GL_ReferenceTexture(texture_index);
 
-	tex_scale_down = r_tex_scale_down.value == qtrue;
-	
-	texture_index = GL_GetTextureIndex();
+	texture_index = GL_GetTextureIndex(identifier, checksum);
 
 	gltexture_t& texture = gltextures[texture_index];
 	// Fill in the source data.
-	strcpy(texture.identifier, identifier);
 	texture.original_width			= width;
 	texture.original_height			= height;
 	texture.stretch_to_power_of_two	= stretch_to_power_of_two != qfalse;
@@ -3238,103 +3344,18 @@ int GL_LoadImages (const char *identifier, int width, int height, const byte *da
 	texture.palette_active          = qfalse;
 
 	// Fill in the texture description.
-	switch(texture.bpp)
-	{
-		case 1:
-			texture.format = GU_PSM_T8;
-			break;
-		case 2:
-			texture.format = GU_PSM_4444; //5650, 5551, T16(pal)
-			break;
-		case 4:
-			switch((int)r_texcompr.value)
-			{
-				// case 32:
-				case 0:
-					texture.format		= GU_PSM_8888; //T32(pal)
-					break;
-				case 1:
-					texture.format		= GU_PSM_DXT1;
-					break;
-				case 3:
-					texture.format		= GU_PSM_DXT3;
-					break;
-				case 16:
-					texture.format		= GU_PSM_4444;
-					break;
-				case 5:
-				default:
-					texture.format		= GU_PSM_DXT5;
-					break;
-		}
-		break;
-	}
-	
-	// HACK HACK: Force use of DXT5 for the mbox glow
-	char specChar = identifier[strlen(identifier) - 7];
-	if (specChar == '$')
-		texture.format = GU_PSM_DXT5;
-
-	// Sprite textures also get special treatment :)
-	if (identifier[strlen(identifier) - 5] == 's' && 
-	identifier[strlen(identifier) - 4] == 'p' && 
-	identifier[strlen(identifier) - 3] == 'r') {
-		texture.format = GU_PSM_DXT5;
-	}
-
-	texture.filter = filter;
-	texture.mipmaps = 0; 		// sacrifice some beauty for vram.
-
-	switch(texture.format)
-	{
-		case GU_PSM_T8:
-		case GU_PSM_4444:
-		case GU_PSM_8888:
-			texture.swizzle	= GU_TRUE;
-			break;
-		case GU_PSM_DXT1:
-		case GU_PSM_DXT3:
-		case GU_PSM_DXT5:
-			texture.swizzle	= GU_FALSE;
-			break;
-	}
-
-	if (tex_scale_down == true && texture.stretch_to_power_of_two == true)
-	{
-		texture.width			= std::max(round_down(width), 32U);
-		texture.height			= std::max(round_down(height),32U);
-	}
-	else
-	{
-		texture.width			= std::max(round_up(width), 32U);
-		texture.height			= std::max(round_up(height),32U);
-	}
-
-	if (psp_system_model == PSP_MODEL_PHAT) {
-		if (texture.width > 128)
-			texture.width = 128;
-		if (texture.height > 128)
-			texture.height = 128;
-	}
-
-	if(texture.format < GU_PSM_DXT1)
-	{
-		for (int i=0; i <= mipmap_level;i++)
-		{
-			int div = (int) powf(2,i);
-			if((texture.width / div) > 16 && (texture.height / div) > 16 ) 
-			{
-				texture.mipmaps = i;
-			}
-		}
-	}
-
-	// Do we really need to resize the texture?
-	if (texture.stretch_to_power_of_two)
-	{
-		// Not if the size hasn't changed.
-		texture.stretch_to_power_of_two = (texture.width != width) || (texture.height != height);
-	}
+	gutexopts_t opts;
+	gutexdesc_t desc;
+	GL_ImageOptions(&opts);
+	GL_DescribeImage(&desc, &opts, identifier, width, height, texture.stretch_to_power_of_two, mipmap_level, bpp);
+
+	texture.format					= desc.format;
+	texture.filter					= filter;
+	texture.width					= desc.width;
+	texture.height					= desc.height;
+	texture.mipmaps					= desc.mipmaps;
+	texture.swizzle					= desc.swizzle;
+	texture.stretch_to_power_of_two	= desc.stretch;
 
 	// Allocate the RAM.
 	std::size_t buffer_size = GL_GetTexSize(texture.format, texture.width, texture.height, 0);
@@ -3349,7 +3370,7 @@ int GL_LoadImages (const char *identifier, int width, int height, const byte *da
 	}
 
 	// Allocate the VRAM.
-	texture.vram = static_cast<texel*>(vramalloc(buffer_size));
+	texture.vram = GL_AllocVRAM(buffer_size);
 
 	// Upload the texture.
 	switch(texture.format)
@@ -3370,18 +3391,80 @@ int GL_LoadImages (const char *identifier, int width, int height, const byte *da
 			break;
 	}
 
-	//FIXME: this isn't completely clearing out the normal ram stuff :s
-	if (texture.vram && texture.ram)
+	GL_ReleaseImageRAM(texture, buffer_size);
+
+	// Done.
+	return texture_index;
+}
+
+/*
+================
+GL_LoadCookedImage
+
+Takes what GL_LoadImages would have made of the image from texcook, or
+returns -1 if it was cooked for other settings
+================
+*/
+int GL_LoadCookedImage (const char *identifier, const texcookhdr_t *cooked, int matchwidth, int matchheight, int filter)
+{
+	int texture_index = GL_TextureForName(identifier);
+	if (texture_index >= 0) return GL_ReferenceTexture(texture_index);
+
+	if ((matchwidth && cooked->width != matchwidth) || (matchheight && cooked->height != matchheight))
+		return -1;
+
+	gutexopts_t opts;
+	gutexdesc_t desc;
+	GL_ImageOptions(&opts);
+	GL_DescribeImage(&desc, &opts, identifier, cooked->width, cooked->height, true, 0, 4);
+
+	if (desc.format != cooked->format || desc.width != cooked->scaled_width || desc.height != cooked->scaled_height
+		|| desc.mipmaps != cooked->mipmaps || desc.swizzle != cooked->swizzle
+		|| (desc.stretch && cooked->resample != opts.resample)
+		|| GL_ImageSize(&desc) != cooked->datasize)
 	{
-		free(texture.ram);
-		texture.ram = NULL;
-	} else {
-		Con_Printf("Couldn't fit %s into VRAM (%dkB)\n", identifier, buffer_size/1024);
-		total_overbudget_texturemem += buffer_size/1024;
-		Con_Printf("OVERFLOWN VRAM: %d\n", total_overbudget_texturemem);
+		Con_DPrintf("%s was cooked for other texture settings\n", identifier);
+		return -1;
 	}
 
-	// Done.
+	texture_index = GL_GetTextureIndex(identifier, 0);
+
+	gltexture_t& texture = gltextures[texture_index];
+	// Fill in the source data.
+	texture.original_width			= cooked->width;
+	texture.original_height			= cooked->height;
+	texture.bpp                     = 4;
+	texture.palette_active          = qfalse;
+
+	// Fill in the texture description.
+	texture.format					= desc.format;
+	texture.filter					= filter;
+	texture.width					= desc.width;
+	texture.height					= desc.height;
+	texture.mipmaps					= desc.mipmaps;
+	texture.swizzle					= desc.swizzle;
+	texture.stretch_to_power_of_two	= desc.stretch;
+
+	std::size_t buffer_size = cooked->datasize;
+
+	Con_DPrintf("Loading: %s [%dx%d](%0.2f KB) cooked\n",texture.identifier,texture.width,texture.height, (float) buffer_size/1024);
+
+	texture.ram	= static_cast<texel*>(memalign(16, buffer_size));
+
+	if (!texture.ram)
+	{
+		Sys_Error("Out of RAM for images.");
+	}
+
+	texture.vram = GL_AllocVRAM(buffer_size);
+
+	// Already in the layout the GU reads, straight to where it is drawn from.
+	texel* dst = texture.vram ? texture.vram : texture.ram;
+	memcpy(dst, cooked + 1, buffer_size);
+	sceKernelDcacheWritebackRange(dst, buffer_size);
+
+	GL_ReleaseImageRAM(texture, buffer_size);
+
 	return texture_index;
 }
 
@@ -3466,14 +3549,14 @@ void GL_Upload4(int texture_index, const byte *data, int width, int height)
 
 int GL_LoadTexture4(const char *identifier, unsigned int width, unsigned int height, const byte *data, int filter, qboolean swizzled)
 {
-	int texture_index = GL_TextureForName(identifier);
-	if (texture_index >= 0) return texture_index;
+	unsigned int checksum = GL_TextureChecksum(data, (width * height) / 2);
+	int texture_index = GL_FindTexture(identifier, checksum);
+	if (texture_index >= 0) return GL_ReferenceTexture(texture_index);
 
-	texture_index = GL_GetTextureIndex();
+	texture_index = GL_GetTextureIndex(identifier, checksum);
 	gltexture_t& texture = gltextures[texture_index];
 
 	// Fill in the source data.
-	strcpy(texture.identifier, identifier);
 	texture.original_width = texture.width = width;
 	texture.original_height = texture.height = height;
 	texture.stretch_to_power_of_two = qfalse;
@@ -3498,7 +3581,7 @@ int GL_LoadTexture4(const char *identifier, unsigned int width, unsigned int hei
 		Sys_Error("Out of RAM for textures.");
 	}
 
-	texture.vram = static_cast<texel*>(vramalloc(buffer_size));
+	texture.vram = GL_AllocVRAM(buffer_size);
 
 	// Upload the texture.
 	GL_Upload4(texture_index, data, width, height);
@@ -3514,6 +3597,11 @@ int GL_LoadTexture4(const char *identifier, unsigned int width, unsigned int hei
 
 int GL_LoadTexture8to4(const char *identifier, unsigned int width, unsigned int height, const byte *data, const byte *pal, int filter)
 {
+	// Known by the 8 bit source, not by what GL_LoadTexture4 is given.
+	unsigned int checksum = GL_TextureChecksum(data, width * height);
+	int texture_index = GL_FindTexture(identifier, checksum);
+	if (texture_index >= 0) return GL_ReferenceTexture(texture_index);
+
 	tex_scale_down = r_tex_scale_down.value == qtrue;
 	int new_width = width;
 	int new_height = height;
@@ -3548,6 +3636,7 @@ int GL_LoadTexture8to4(const char *identifier, unsigned int width, unsigned int
 	free(unswizzled_data);
 
 	int id = GL_LoadTexture4(identifier, new_width, new_height, clut4data, filter, qtrue);
+	gltextures_checksum[id] = checksum;
 
 	free(clut4data);
 	free(resamp_data);
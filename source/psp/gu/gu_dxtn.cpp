@@ -31,7 +31,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 
-#include <pspgu.h>
+#include "gu_texconv.h"
 
 #include "gu_dxtn.h"
 
@@ -23,6 +23,9 @@ extern "C"
 {
 #include <jpeglib.h>
 #include "../../quakedef.h"
+#include "../../fs_index.h"
+#include "../../texcook.h"
+#include "../../loadtrace.h"
 }
 
 #include <pspgu.h>
@@ -989,12 +992,18 @@ byte *LoadBMP (FILE *fin, int matchwidth, int matchheight)
 loadimagepixels
 =============
 */
-										// HACK HACK HACK
-byte* loadimagepixels (char* filename, qboolean complain, int matchwidth, int matchheight)
+static const char *image_exts[] = TEXCOOK_PSP_EXTS;
+
+/*
+=============
+imagebasename
+
+The name the image is looked for under, without an extension
+=============
+*/
+static void imagebasename (char* filename, qboolean complain, char* basename)
 {
-	FILE	*f;
-	char	basename[128], name[128];
-	byte	 *c;
+	byte	*c;
 
 	if (complain == qfalse)
 		COM_StripExtension(filename, basename); // strip the extension to allow TGA and PCX
@@ -1009,6 +1018,15 @@ byte* loadimagepixels (char* filename, qboolean complain, int matchwidth, int ma
 			*c = '+';
 		c++;
 	}
+}
+
+										// HACK HACK HACK
+byte* loadimagepixels (char* filename, qboolean complain, int matchwidth, int matchheight)
+{
+	FILE	*f;
+	char	basename[128], name[128];
+
+	imagebasename (filename, complain, basename);
 
 	com_netpath[0] = 0;
 /*
@@ -1017,31 +1035,40 @@ byte* loadimagepixels (char* filename, qboolean complain, int matchwidth, int ma
 		return data;
 */
 
-	sprintf (name, "%s.tga", basename);
-	FS_FOpenFile (name, &f);
-	if (f)
-		return LoadTGA (f, matchwidth, matchheight);
-		
-	sprintf (name, "%s.pcx", basename);
-	FS_FOpenFile (name, &f);
-	if (f)
-		return LoadPCX (f, matchwidth, matchheight);
-	
-	sprintf (name, "%s.jpg", basename);
-	FS_FOpenFile (name, &f);
-	if (f)
+	// one index probe finds the preferred format that exists
+	switch (FS_FindExtension (basename, (char **)image_exts, NULL))
 	{
-		return LoadJPG (f, matchwidth, matchheight);
+	case 0:
+		sprintf (name, "%s.tga", basename);
+		FS_FOpenFile (name, &f);
+		if (f)
+			return LoadTGA (f, matchwidth, matchheight);
+		break;
+	case 1:
+		sprintf (name, "%s.pcx", basename);
+		FS_FOpenFile (name, &f);
+		if (f)
+			return LoadPCX (f, matchwidth, matchheight);
+		break;
+	case 2:
+		sprintf (name, "%s.jpg", basename);
+		FS_FOpenFile (name, &f);
+		if (f)
+			return LoadJPG (f, matchwidth, matchheight);
+		break;
+	case 3:
+		sprintf (name, "%s.png", basename);
+		FS_FOpenFile (name, &f);
+		if (f)
+			return LoadPNG (f, matchwidth, matchheight);
+		break;
+	case 4:
+		sprintf (name, "%s.bmp", basename);
+		FS_FOpenFile (name, &f);
+		if (f)
+			return LoadBMP (f, matchwidth, matchheight);
+		break;
 	}
-	sprintf (name, "%s.png", basename);
-	FS_FOpenFile (name, &f);
-	if (f)
-		return LoadPNG (f, matchwidth, matchheight);
-	
-	sprintf (name, "%s.bmp", basename);
-	FS_FOpenFile (name, &f);
-	if (f)
-		return LoadBMP (f, matchwidth, matchheight);
 	//if (complain)
 	//	Con_Printf ("Couldn't load %s .tga .jpg .bmp .png \n", filename);
 	
@@ -1058,6 +1085,29 @@ int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean
 {
 	int texture_index;
 	byte *data;
+	char basename[128];
+	texcookhdr_t *cooked;
+
+	// still loaded, perhaps from the last map
+	texture_index = GL_ReuseTexture (filename);
+	if (texture_index >= 0)
+		return texture_index;
+
+	LoadTrace_Begin ("loadtextureimage", filename);
+
+	// a cooked copy skips the decode and the conversion
+	imagebasename (filename, complain, basename);
+	cooked = TexCook_Load (basename, TEXCOOK_PSP, (char **)image_exts);
+	if (cooked)
+	{
+		texture_index = GL_LoadCookedImage (filename, cooked, matchwidth, matchheight, filter);
+		free (cooked);
+		if (texture_index >= 0)
+		{
+			LoadTrace_End ();
+			return texture_index;
+		}
+	}
 
 	int hunk_start = Hunk_LowMark();
 	data = loadimagepixels (filename, complain, matchwidth, matchheight);
@@ -1065,6 +1115,7 @@ int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean
 
 	if(!data)
 	{
+		LoadTrace_End ();
 		return 0;
 	}
 	
@@ -1085,6 +1136,7 @@ int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean
 	else
 		free(data);
 
+	LoadTrace_End ();
 	return texture_index;
 }
 
@@ -23,6 +23,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 extern "C"
 {
 #include "../../quakedef.h"
+#include "../../prof.h"
 float TraceLine (vec3_t start, vec3_t end, vec3_t impact, vec3_t normal);
 }
 
@@ -3264,6 +3265,8 @@ void R_DrawEntitiesOnList (void)
 	if (!r_drawentities.value)
 		return;
 
+	PROF_BEGIN (R_DrawEntitiesOnList);
+
 	//t1 = 0;
 	//t2 = 0;
 	//t3 = 0;
@@ -3375,6 +3378,8 @@ void R_DrawEntitiesOnList (void)
 		default: break;
 		}
 	}
+
+	PROF_END (R_DrawEntitiesOnList);
 }
 
 /*
@@ -3940,6 +3945,8 @@ r_refdef must be set before the first call
 */
 void R_RenderView (void)
 {
+	PROF_BEGIN (R_RenderView);
+
 	c_brush_polys = 0;
 	c_alias_polys = 0;
     c_md3_polys = 0;
@@ -3965,4 +3972,6 @@ void R_RenderView (void)
 		Con_Printf ("%4i world poly\n",  c_brush_polys);
 		Con_Printf ("%4i entity poly\n",  c_alias_polys);
 	}
+
+	PROF_END (R_RenderView);
 }
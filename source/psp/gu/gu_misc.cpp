@@ -27,6 +27,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 extern "C"
 {
 #include "../../quakedef.h"
+#include "../../texcook.h"
+#include "../../loadtrace.h"
 void CL_CopyPlayerInfo (entity_t *ent, entity_t *player);
 }
 
@@ -296,6 +298,7 @@ void R_Init (void)
     Cvar_RegisterVariable (&r_partalpha);
 	Cvar_RegisterVariable (&r_restexf);
 	Cvar_RegisterVariable (&r_texcompr);
+	TexCook_Init ();
 	Cvar_RegisterVariable (&r_skyfog);
     Cvar_RegisterVariable (&r_skydis);
     Cvar_RegisterVariable (&r_caustics);
@@ -406,7 +409,12 @@ void R_NewMap (void)
 	R_ClearParticles ();
     R_ClearDecals();
 
+	// the models are in, drop the textures none of them took over
+	GL_PurgeTextures ();
+
+	LoadTrace_Begin ("GL_BuildLightmaps", NULL);
 	GL_BuildLightmaps ();
+	LoadTrace_End ();
 
 	Sky_NewMap (); //johnfitz -- skybox in worldspawn
     Fog_NewMap (); //johnfitz -- global fog in worldspawn
@@ -27,6 +27,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 extern "C"
 {
 #include "../../quakedef.h"
+#include "../../bspcache.h"
+#include "../../loadtrace.h"
 }
 #include <malloc.h>
 #include <pspgu.h>
@@ -74,6 +76,7 @@ Mod_Init
 void Mod_Init (void)
 {
 	Cvar_RegisterVariable (&gl_subdivide_size);
+	BspCache_Init ();
 	memset (mod_novis, 0xff, sizeof(mod_novis));
 }
 
@@ -137,11 +140,13 @@ Mod_DecompressVis
 */
 byte *Mod_DecompressVis (byte *in, model_t *model)
 {
-	static byte	decompressed[MAX_MAP_LEAFS/8];
+	static byte	buffers[2][MAX_MAP_LEAFS/8];	// a pipelined server tick gets its own
+	byte	*decompressed;
 	int		c;
 	byte	*out;
 	int		row;
 
+	decompressed = buffers[!Sys_MainThread ()];
 	row = (model->numleafs+7)>>3;
 	out = decompressed;
 
@@ -222,7 +227,7 @@ void Mod_ClearAll (void)
 
 	ent_file = NULL; //~~~~
 
-	GL_UnloadAllTextures();
+	GL_ReleaseTextures();
 
 	solidskytexture	= -1;
 	alphaskytexture	= -1;
@@ -297,6 +302,31 @@ void Mod_TouchModel (char *name)
 
 }
 
+/*
+==================
+Mod_IsLoaded
+
+Unlike Mod_FindName, doesn't add the model when it isn't known
+==================
+*/
+qboolean Mod_IsLoaded (char *name)
+{
+	int		i;
+	model_t	*mod;
+
+	for (i=0 , mod=mod_known ; i<mod_numknown ; i++, mod++)
+		if (!strcmp (mod->name, name) )
+			break;
+
+	if (i == mod_numknown || mod->needload)
+		return qfalse;
+
+	if (mod->type == mod_alias || mod->type == mod_md3 || mod->type == mod_halflife)
+		return Cache_Check (&mod->cache) ? qtrue : qfalse;
+
+	return qtrue;
+}
+
 /*
 ==================
 Mod_LoadModel
@@ -311,6 +341,7 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 	byte	stackbuf[1024];		// avoid dirtying the cache heap
     char		strip[128];
 	char		md3name[128];
+	double	start;
 
 	if (!mod->needload)
 	{
@@ -325,6 +356,8 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 	}
 
 
+	start = Sys_FloatTime ();
+
 //
 // because the world is so huge, load it one piece at a time
 //
@@ -419,6 +452,9 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 		break;
 	}
 
+	if (mod->type == mod_alias || mod->type == mod_md3 || mod->type == mod_halflife)
+		Cache_Loaded (&mod->cache, Sys_FloatTime () - start);
+
 	return mod;
 }
 
@@ -729,6 +765,8 @@ void Mod_LoadTextures (lump_t *l)
 Mod_LoadLighting
 =================
 */
+static	int		mod_lightsize;		// for the bsp cache
+
 void Mod_LoadLighting (lump_t *l)
 {
 	if (COM_CheckParm ("-lm_1"))
@@ -741,6 +779,7 @@ void Mod_LoadLighting (lump_t *l)
         LIGHTMAP_BYTES = 4;
 
 	loadmodel->lightdata = NULL;
+	mod_lightsize = 0;
 	
 	if (loadmodel->bspversion == HL_BSPVERSION)
 	{
@@ -750,6 +789,7 @@ void Mod_LoadLighting (lump_t *l)
 		}
 		loadmodel->lightdata = static_cast<byte*>(Hunk_AllocName ( l->filelen, loadname));
 		memcpy_vfpu(loadmodel->lightdata, mod_base + l->fileofs, l->filelen);
+		mod_lightsize = l->filelen;
 		return;
 	}
 
@@ -772,6 +812,7 @@ void Mod_LoadLighting (lump_t *l)
 			{
 				Con_DPrintf("%s loaded", litfilename);
 				loadmodel->lightdata = data + 8;
+				mod_lightsize = com_filesize - 8;
 				return;
 			}
 			else
@@ -787,6 +828,7 @@ void Mod_LoadLighting (lump_t *l)
   		return;
 	}
         loadmodel->lightdata = static_cast<byte*>(Hunk_AllocName ( l->filelen*3, litfilename));
+        mod_lightsize = l->filelen*3;
         in = loadmodel->lightdata + l->filelen*2; // place the file at the end, so it will not be overwritten until the very last write
         out = loadmodel->lightdata;
         memcpy_vfpu(in, mod_base + l->fileofs, l->filelen);
@@ -819,6 +861,7 @@ void Mod_HL_LoadLighting (lump_t *l)
 	else
     LIGHTMAP_BYTES = 4;
 
+	mod_lightsize = 0;
 	if (!l->filelen)
 	{
 		loadmodel->lightdata = NULL;
@@ -827,6 +870,7 @@ void Mod_HL_LoadLighting (lump_t *l)
 
 	loadmodel->lightdata = static_cast<byte*>(Hunk_AllocName ( l->filelen, loadname));
 	memcpy_vfpu(loadmodel->lightdata, mod_base + l->fileofs, l->filelen);
+	mod_lightsize = l->filelen;
 }
 
 /*
@@ -1628,6 +1672,200 @@ float RadiusFromBounds (vec3_t mins, vec3_t maxs)
 	return Length (corner);
 }
 
+/*
+==============================================================================
+
+BSP CACHE
+
+==============================================================================
+*/
+
+#define	FIX(p)	fix (c, (void **)&(p))
+
+/*
+=================
+Mod_WalkBrush
+
+Passes every pointer in the processed model through fix, once
+=================
+*/
+static void Mod_WalkBrush (void *model, bspcache_t *c, bspfix_t fix)
+{
+	model_t		*m;
+	mleaf_t		*leafs;
+	mnode_t		*nodes;
+	mtexinfo_t	*texinfo;
+	msurface_t	*surfaces, **marksurfaces;
+	glpoly_t	*p, *next;
+	int			i, j;
+
+	m = static_cast<model_t*>(model);
+
+	FIX(m->submodels);
+	FIX(m->planes);
+	leafs = static_cast<mleaf_t*>(FIX(m->leafs));
+	FIX(m->vertexes);
+	FIX(m->edges);
+	nodes = static_cast<mnode_t*>(FIX(m->nodes));
+	texinfo = static_cast<mtexinfo_t*>(FIX(m->texinfo));
+	surfaces = static_cast<msurface_t*>(FIX(m->surfaces));
+	FIX(m->surfedges);
+	FIX(m->clipnodes);
+	marksurfaces = static_cast<msurface_t**>(FIX(m->marksurfaces));
+	FIX(m->visdata);
+	for (i=0 ; i<MAX_MAP_HULLS ; i++)
+	{
+		FIX(m->hulls[i].clipnodes);
+		FIX(m->hulls[i].planes);
+	}
+
+	for (i=0 ; texinfo && i<m->numtexinfo ; i++)
+		FIX(texinfo[i].texture);
+
+	for (i=0 ; surfaces && i<m->numsurfaces ; i++)
+	{
+		FIX(surfaces[i].plane);
+		FIX(surfaces[i].texinfo);
+		FIX(surfaces[i].samples);
+		FIX(surfaces[i].texturechain);
+		for (p = static_cast<glpoly_t*>(FIX(surfaces[i].polys)) ; p ; p = next)
+		{
+			next = static_cast<glpoly_t*>(FIX(p->next));
+			FIX(p->chain);
+			FIX(p->display_list_verts);
+		}
+	}
+
+	for (i=0 ; nodes && i<m->numnodes ; i++)
+	{
+		FIX(nodes[i].parent);
+		FIX(nodes[i].plane);
+		for (j=0 ; j<2 ; j++)
+			FIX(nodes[i].children[j]);
+	}
+
+	for (i=0 ; leafs && i<m->numleafs ; i++)
+	{
+		FIX(leafs[i].parent);
+		FIX(leafs[i].compressed_vis);
+		FIX(leafs[i].efrags);
+		FIX(leafs[i].firstmarksurface);
+	}
+
+	for (i=0 ; marksurfaces && i<m->nummarksurfaces ; i++)
+		FIX(marksurfaces[i]);
+}
+
+/*
+=================
+Mod_BrushCacheKey
+=================
+*/
+static void Mod_BrushCacheKey (bspkey_t *key, void *buffer, int size)
+{
+	int		sizes[] = {sizeof(void *), sizeof(model_t), sizeof(mplane_t), sizeof(mleaf_t),
+		sizeof(mnode_t), sizeof(mtexinfo_t), sizeof(msurface_t), sizeof(glpoly_t),
+		sizeof(medge_t), sizeof(dclipnode_t), sizeof(texture_t), sizeof(glvert_t)};
+
+	BspCache_MakeKey (key, static_cast<byte*>(buffer), size, sizes, sizeof(sizes) / sizeof(sizes[0]));
+}
+
+/*
+=================
+Mod_AddBrushExternals
+
+What the image points at but is loaded from the bsp every time
+=================
+*/
+static void Mod_AddBrushExternals (model_t *mod, bspcache_t *c)
+{
+	int		i;
+
+	BspCache_AddExternal (c, mod->lightdata, mod_lightsize);
+	BspCache_AddExternal (c, r_notexture_mip, sizeof(texture_t));
+	for (i=0 ; i<mod->numtextures ; i++)
+		BspCache_AddExternal (c, mod->textures[i], sizeof(texture_t));
+}
+
+/*
+=================
+Mod_LoadBrushImage
+=================
+*/
+static qboolean Mod_LoadBrushImage (model_t *mod, bspkey_t *key)
+{
+	bspcache_t	*c;
+	model_t		image;
+	qboolean	ok;
+
+	if (!mod_bspcache.value)
+		return qfalse;
+
+	c = BspCache_Create ();
+	Mod_AddBrushExternals (mod, c);
+	ok = BspCache_Read (c, mod->name, key, &image, sizeof(image), Mod_WalkBrush);
+	BspCache_Free (c);
+
+	if (!ok)
+		return qfalse;
+
+	image.textures = mod->textures;
+	image.lightdata = mod->lightdata;
+	image.entities = mod->entities;
+	*mod = image;
+
+	return qtrue;
+}
+
+/*
+=================
+Mod_SaveBrushImage
+=================
+*/
+static void Mod_SaveBrushImage (model_t *mod, dheader_t *header, bspkey_t *key)
+{
+	bspcache_t	*c;
+	model_t		image;
+	msurface_t	*s;
+	glpoly_t	*p;
+	int			i;
+
+	if (!mod_bspcache.value)
+		return;
+
+	c = BspCache_Create ();
+
+	BspCache_AddBlock (c, mod->submodels, mod->numsubmodels * sizeof(dmodel_t));
+	BspCache_AddBlock (c, mod->planes, mod->numplanes * sizeof(mplane_t));
+	BspCache_AddBlock (c, mod->leafs, mod->numleafs * sizeof(mleaf_t));
+	BspCache_AddBlock (c, mod->vertexes, mod->numvertexes * sizeof(mvertex_t));
+	BspCache_AddBlock (c, mod->edges, (mod->numedges + 1) * sizeof(medge_t));
+	BspCache_AddBlock (c, mod->nodes, mod->numnodes * sizeof(mnode_t));
+	BspCache_AddBlock (c, mod->texinfo, mod->numtexinfo * sizeof(mtexinfo_t));
+	BspCache_AddBlock (c, mod->surfaces, mod->numsurfaces * sizeof(msurface_t));
+	BspCache_AddBlock (c, mod->surfedges, mod->numsurfedges * sizeof(int));
+	BspCache_AddBlock (c, mod->clipnodes, mod->numclipnodes * sizeof(dclipnode_t));
+	BspCache_AddBlock (c, mod->hulls[0].clipnodes, mod->numnodes * sizeof(dclipnode_t));
+	BspCache_AddBlock (c, mod->marksurfaces, mod->nummarksurfaces * sizeof(msurface_t *));
+	BspCache_AddBlock (c, mod->visdata, header->lumps[LUMP_VISIBILITY].filelen);
+
+	// the sky and water polygons GL_Surface made
+	for (i=0, s=mod->surfaces ; i<mod->numsurfaces ; i++, s++)
+		for (p = s->polys ; p ; p = p->next)
+			BspCache_AddBlock (c, p, sizeof(glpoly_t) + (p->numverts - 1) * sizeof(glvert_t));
+
+	Mod_AddBrushExternals (mod, c);
+
+	// the loaded parts are found again next time
+	image = *mod;
+	image.textures = NULL;
+	image.lightdata = NULL;
+	image.entities = NULL;
+
+	BspCache_Write (c, mod->name, key, &image, sizeof(image), Mod_WalkBrush);
+	BspCache_Free (c);
+}
+
 /*
 =================
 Mod_LoadBrushModel
@@ -1639,6 +1877,8 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
 	int			i, j;
 	dheader_t	*header;
     dmodel_t 	*bm;
+	bspkey_t	key;
+	qboolean	cached;
 	loadmodel->type = mod_brush;
 
 	header = (dheader_t *)buffer;
@@ -1655,6 +1895,8 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
 	if (mod->bspversion == BSPVERSION && r_hlbsponly.value && !developer.value)
 		Host_Error ("Mod_LoadBrushModel: Normal quake maps are disabled. Please use half life bsp. ");
 
+	// before the lumps are swapped, so it matches the file
+	Mod_BrushCacheKey (&key, buffer, com_filesize);
 
 // swap all the lumps
 	mod_base = (byte *)header;
@@ -1666,34 +1908,20 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
     loading_num_step = loading_num_step + 16;
 	loading_step = 2;
 
-	strcpy(loading_name, "Vertexes");
-	SCR_UpdateScreen ();
-
-	Mod_LoadVertexes (&header->lumps[LUMP_VERTEXES]);
-
-    loading_cur_step++;
-	strcpy(loading_name, "Edges");
-	SCR_UpdateScreen ();
-
-	Mod_LoadEdges (&header->lumps[LUMP_EDGES]);
-
-    loading_cur_step++;
-	strcpy(loading_name, "Surfedges");
-	SCR_UpdateScreen ();
-
-	Mod_LoadSurfedges (&header->lumps[LUMP_SURFEDGES]);
-
-    loading_cur_step++;
 	strcpy(loading_name, "Entities");
 	SCR_UpdateScreen ();
 
+	LoadTrace_Begin ("Mod_LoadEntities", NULL);
 	Mod_LoadEntities (&header->lumps[LUMP_ENTITIES]);
+	LoadTrace_End ();
 
     loading_cur_step++;
 	strcpy(loading_name, "Textures");
 	SCR_UpdateScreen ();
 
+	LoadTrace_Begin ("Mod_LoadTextures", NULL);
 	Mod_LoadTextures (&header->lumps[LUMP_TEXTURES]);
+	LoadTrace_End ();
 
 
 	if(mod->bspversion == HL_BSPVERSION) // dr_mabuse1981
@@ -1702,68 +1930,130 @@ void Mod_LoadBrushModel (model_t *mod, void *buffer)
 	}
 	else
 	{
+		LoadTrace_Begin ("Mod_LoadLighting", NULL);
 		Mod_LoadLighting (&header->lumps[LUMP_LIGHTING]);
+		LoadTrace_End ();
 	}
 
-    loading_cur_step++;
-	SCR_UpdateScreen ();
+	// the rest comes from the cache when the bsp hasn't changed since
+	LoadTrace_Begin ("Mod_LoadBrushImage", NULL);
+	cached = Mod_LoadBrushImage (mod, &key);
+	LoadTrace_End ();
+	if (cached)
+	{
+		loading_cur_step += 14;
+		SCR_UpdateScreen ();
+	}
+	else
+	{
+		loading_cur_step++;
+		strcpy(loading_name, "Vertexes");
+		SCR_UpdateScreen ();
 
-	Mod_LoadPlanes (&header->lumps[LUMP_PLANES]);
+		LoadTrace_Begin ("Mod_LoadVertexes", NULL);
+		Mod_LoadVertexes (&header->lumps[LUMP_VERTEXES]);
+		LoadTrace_End ();
 
-    loading_cur_step++;
-	strcpy(loading_name, "Texinfo");
-	SCR_UpdateScreen ();
+		loading_cur_step++;
+		strcpy(loading_name, "Edges");
+		SCR_UpdateScreen ();
 
-	Mod_LoadTexinfo (&header->lumps[LUMP_TEXINFO]);
+		LoadTrace_Begin ("Mod_LoadEdges", NULL);
+		Mod_LoadEdges (&header->lumps[LUMP_EDGES]);
+		LoadTrace_End ();
 
-    loading_cur_step++;
-	strcpy(loading_name, "Faces");
-	SCR_UpdateScreen ();
+		loading_cur_step++;
+		strcpy(loading_name, "Surfedges");
+		SCR_UpdateScreen ();
 
-	Mod_LoadFaces (&header->lumps[LUMP_FACES]);
+		LoadTrace_Begin ("Mod_LoadSurfedges", NULL);
+		Mod_LoadSurfedges (&header->lumps[LUMP_SURFEDGES]);
+		LoadTrace_End ();
 
-    loading_cur_step++;
-	strcpy(loading_name, "Marksurfaces");
-	SCR_UpdateScreen ();
+		loading_cur_step++;
+		SCR_UpdateScreen ();
 
-	Mod_LoadMarksurfaces (&header->lumps[LUMP_MARKSURFACES]);
+		LoadTrace_Begin ("Mod_LoadPlanes", NULL);
+		Mod_LoadPlanes (&header->lumps[LUMP_PLANES]);
+		LoadTrace_End ();
 
-    loading_cur_step++;
-	strcpy(loading_name, "Visibility");
-	SCR_UpdateScreen ();
+		loading_cur_step++;
+		strcpy(loading_name, "Texinfo");
+		SCR_UpdateScreen ();
 
-	Mod_LoadVisibility (&header->lumps[LUMP_VISIBILITY]);
+		LoadTrace_Begin ("Mod_LoadTexinfo", NULL);
+		Mod_LoadTexinfo (&header->lumps[LUMP_TEXINFO]);
+		LoadTrace_End ();
 
-    loading_cur_step++;
-	strcpy(loading_name, "Leafs");
-	SCR_UpdateScreen ();
+		loading_cur_step++;
+		strcpy(loading_name, "Faces");
+		SCR_UpdateScreen ();
 
-	Mod_LoadLeafs (&header->lumps[LUMP_LEAFS]);
+		LoadTrace_Begin ("Mod_LoadFaces", NULL);
+		Mod_LoadFaces (&header->lumps[LUMP_FACES]);
+		LoadTrace_End ();
 
-    loading_cur_step++;
-	strcpy(loading_name, "Nodes");
-	SCR_UpdateScreen ();
+		loading_cur_step++;
+		strcpy(loading_name, "Marksurfaces");
+		SCR_UpdateScreen ();
 
-	Mod_LoadNodes (&header->lumps[LUMP_NODES]);
+		LoadTrace_Begin ("Mod_LoadMarksurfaces", NULL);
+		Mod_LoadMarksurfaces (&header->lumps[LUMP_MARKSURFACES]);
+		LoadTrace_End ();
 
-    loading_cur_step++;
-	strcpy(loading_name, "Clipnodes");
-	SCR_UpdateScreen ();
+		loading_cur_step++;
+		strcpy(loading_name, "Visibility");
+		SCR_UpdateScreen ();
 
-	Mod_LoadClipnodes (&header->lumps[LUMP_CLIPNODES]);
+		LoadTrace_Begin ("Mod_LoadVisibility", NULL);
+		Mod_LoadVisibility (&header->lumps[LUMP_VISIBILITY]);
+		LoadTrace_End ();
 
-    loading_cur_step++;
-	strcpy(loading_name, "Submodels");
-	SCR_UpdateScreen ();
+		loading_cur_step++;
+		strcpy(loading_name, "Leafs");
+		SCR_UpdateScreen ();
 
-	Mod_LoadSubmodels (&header->lumps[LUMP_MODELS]);
+		LoadTrace_Begin ("Mod_LoadLeafs", NULL);
+		Mod_LoadLeafs (&header->lumps[LUMP_LEAFS]);
+		LoadTrace_End ();
 
-    loading_cur_step++;
-	strcpy(loading_name, "Hull");
-	SCR_UpdateScreen ();
+		loading_cur_step++;
+		strcpy(loading_name, "Nodes");
+		SCR_UpdateScreen ();
 
-	Mod_MakeHull0 ();
-	loading_cur_step++;
+		LoadTrace_Begin ("Mod_LoadNodes", NULL);
+		Mod_LoadNodes (&header->lumps[LUMP_NODES]);
+		LoadTrace_End ();
+
+		loading_cur_step++;
+		strcpy(loading_name, "Clipnodes");
+		SCR_UpdateScreen ();
+
+		LoadTrace_Begin ("Mod_LoadClipnodes", NULL);
+		Mod_LoadClipnodes (&header->lumps[LUMP_CLIPNODES]);
+		LoadTrace_End ();
+
+		loading_cur_step++;
+		strcpy(loading_name, "Submodels");
+		SCR_UpdateScreen ();
+
+		LoadTrace_Begin ("Mod_LoadSubmodels", NULL);
+		Mod_LoadSubmodels (&header->lumps[LUMP_MODELS]);
+		LoadTrace_End ();
+
+		loading_cur_step++;
+		strcpy(loading_name, "Hull");
+		SCR_UpdateScreen ();
+
+		LoadTrace_Begin ("Mod_MakeHull0", NULL);
+		Mod_MakeHull0 ();
+		LoadTrace_End ();
+		loading_cur_step++;
+
+		LoadTrace_Begin ("Mod_SaveBrushImage", NULL);
+		Mod_SaveBrushImage (mod, header, &key);
+		LoadTrace_End ();
+	}
 
 	loading_step = 3;
 
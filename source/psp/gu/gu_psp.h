@@ -34,6 +34,7 @@ int GL_LoadTexture8to4(const char *identifier, unsigned int width, unsigned int
 
 int GL_LoadTextureLM (const char *identifier, int width, int height, const byte *data, int bpp, int filter, qboolean update, int forcopy);
 int GL_LoadImages (const char *identifier, int width, int height, const byte *data, qboolean stretch_to_power_of_two, int filter, int mipmap_level, int bpp);
+int GL_LoadCookedImage (const char *identifier, const struct texcookhdr_s *cooked, int matchwidth, int matchheight, int filter);
 int GL_LoadTexturePixels (byte *data, char *identifier, int width, int height, int mode);
 int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean complain, int filter);
 int loadskyboxsideimage (char* filename, int matchwidth, int matchheight, qboolean complain, int filter);
@@ -58,6 +59,10 @@ int GL_LoadPalletedTexture (byte *in, char *identifier, int width, int height, i
 
 void GL_UnloadTexture (const int texture_index);
 void GL_UnloadAllTextures ();
+void GL_ReleaseTextures (void);
+void GL_PurgeTextures (void);
+int GL_ReuseTexture (const char *identifier);
+int GL_TextureBytes (int texture_index);
 void GL_MarkTextureAsPermanent (const int texture_index);
 
 extern	int glx, gly, glwidth, glheight;
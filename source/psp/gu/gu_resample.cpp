@@ -1,9 +1,13 @@
+#ifdef PSP
 #include <pspgu.h>
 
 extern "C"
 {
 #include "../../quakedef.h"
 }
+#else
+#include "../../linux/texcook_host.h"
+#endif
 
 #define LERPBYTE(i) r = row1[i]; out[i] = (byte) ((((row2[i] - r) * lerp) >> 16) + r)
 #define NOLERPBYTE(i) *out++ = inrow[f + i]
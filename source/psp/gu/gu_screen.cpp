@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 extern "C"
 {
 #include "../../quakedef.h"
+#include "../../prof.h"
 }
 
 #include <pspdisplay.h>
@@ -435,12 +436,12 @@ void SCR_UsePrint (int type, int cost, int weapon)
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
 		case 3://ammo
-			strcpy(s, va("Hold  %s  to buy Ammo for %s\n", GetUseButtonL(), pr_strings+sv_player->v.Weapon_Name_Touch));
+			strcpy(s, va("Hold  %s  to buy Ammo for %s\n", GetUseButtonL(), cl.touchname));
 			strcpy(c, va("[Cost: %i]\n", cost));
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
 		case 4://weapon
-			strcpy(s, va("Hold  %s  to buy %s\n", GetUseButtonL(), pr_strings+sv_player->v.Weapon_Name_Touch));
+			strcpy(s, va("Hold  %s  to buy %s\n", GetUseButtonL(), cl.touchname));
 			strcpy(c, va("[Cost: %i]\n", cost));
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
@@ -455,7 +456,7 @@ void SCR_UsePrint (int type, int cost, int weapon)
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
 		case 7://box take
-			strcpy(s, va("Hold  %s  for %s\n", GetUseButtonL(), pr_strings+sv_player->v.Weapon_Name_Touch));
+			strcpy(s, va("Hold  %s  for %s\n", GetUseButtonL(), cl.touchname));
 			strcpy(c, "");
 			button_pic_x = getTextWidth("Hold ", 1);
 			break;
@@ -1558,6 +1559,8 @@ void SCR_UpdateScreen (void)
 
 	V_RenderView ();
 
+	PROF_BEGIN (SCR_2D);
+
 	GL_Set2D ();
 
 	if (v_gamma.value < 1)
@@ -1567,6 +1570,7 @@ void SCR_UpdateScreen (void)
 
 	//muff - to show FPS on screen
 	SCR_DrawFPS ();
+	PROF_DRAWGRAPH ();
 	SCR_DrawBAT ();
 	SCR_DrawPause ();
 	SCR_CheckDrawCenterString ();
@@ -1580,6 +1584,8 @@ void SCR_UpdateScreen (void)
 
 	Draw_LoadingFill();
 
+	PROF_END (SCR_2D);
+
 	V_UpdatePalette ();
 
 	GL_EndRendering ();
@@ -26,6 +26,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 extern "C"
 {
 #include "../../quakedef.h"
+#include "../../prof.h"
 }
 
 #ifdef PSP_VFPU
@@ -1576,6 +1577,8 @@ void R_DrawWorld (void)
 {
 	entity_t	ent;
 
+	PROF_BEGIN (R_DrawWorld);
+
 	memset (&ent, 0, sizeof(ent));
 	ent.model = cl.worldmodel;
 
@@ -1606,6 +1609,8 @@ void R_DrawWorld (void)
 	//dr_mabuse1981: commented out, this was the one who caused the epic lag
     //DrawFullBrightTextures (cl.worldmodel->surfaces, cl.worldmodel->numsurfaces);
 	//dr_mabuse1981: commented out, this was the one who caused the epic lag
+
+	PROF_END (R_DrawWorld);
 }
 
 
@@ -0,0 +1,330 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+Copyright (C) 2007 Peter Mackay and Chris Swindle.
+Copyright (C) 2008-2009 Crow_bar.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// gu_texconv.cpp -- the texture conversions the renderer shares with texcook
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#ifdef PSP
+#include <pspgu.h>
+
+extern "C"
+{
+#include "../../quakedef.h"
+}
+#else
+#include "../../linux/texcook_host.h"
+#endif
+
+#include "gu_texconv.h"
+#include "gu_dxtn.h"
+#include "gu_resample.h"
+
+//Crow_bar.
+int GL_GetTexSize(int format, int w, int h, int bpp)
+{
+	int size = 0;
+	if(bpp == 0 && (format != -1))
+	{
+		switch(format)
+		{
+			case GU_PSM_T4:
+			case GU_PSM_DXT1:
+				size = w*h/2;
+				break;
+			case GU_PSM_T8:
+			case GU_PSM_DXT3:
+			case GU_PSM_DXT5:
+				size = w*h;
+				break;
+			case GU_PSM_5650:
+			case GU_PSM_5551:
+			case GU_PSM_4444:
+				size = w*h*2;
+				break;
+			case GU_PSM_8888:
+				size = w*h*4;
+				break;
+		}
+	}
+	else
+	{
+		size = w*h*bpp;
+	}
+	return size;
+}
+
+std::size_t round_up(std::size_t size)
+{
+	static const float	denom	= 1.0f / logf(2.0f);
+	const float			logged	= logf(size) * denom;
+	const float			ceiling	= ceilf(logged);
+	return 1 << static_cast<int>(ceiling);
+}
+
+
+std::size_t round_down(std::size_t size)
+{
+	static const float	denom	= 1.0f / logf(2.0f);
+	const float			logged	= logf(size) * denom;
+	const float			floor	= floorf(logged);
+	return 1 << static_cast<int>(floor);
+}
+
+/*
+================
+swizzle_fast
+================
+*/
+void swizzle_fast(unsigned char* out, const unsigned char* in, unsigned int width, unsigned int height)
+{
+	unsigned int blockx, blocky;
+	unsigned int j;
+
+	unsigned int width_blocks = (width / 16);
+	unsigned int height_blocks = (height / 8);
+
+	unsigned int src_pitch = (width-16)/4;
+	unsigned int src_row = width * 8;
+
+	const unsigned char* ysrc = in;
+	unsigned int* dst = (unsigned int*)out;
+
+	for (blocky = 0; blocky < height_blocks; ++blocky)
+	{
+		const unsigned char* xsrc = ysrc;
+		for (blockx = 0; blockx < width_blocks; ++blockx)
+		{
+			const unsigned int* src = (unsigned int*)xsrc;
+			for (j = 0; j < 8; ++j)
+			{
+				*(dst++) = *(src++);
+				*(dst++) = *(src++);
+				*(dst++) = *(src++);
+				*(dst++) = *(src++);
+				src += src_pitch;
+			}
+			xsrc += 16;
+		}
+		ysrc += src_row;
+	}
+}
+
+/*
+================
+GL_DescribeImage
+
+The format, size and mipmaps GL_LoadImages gives an image
+================
+*/
+void GL_DescribeImage (gutexdesc_t *desc, const gutexopts_t *opts, const char *identifier,
+	int width, int height, bool stretch_to_power_of_two, int mipmap_level, int bpp)
+{
+	desc->format = -1;
+
+	switch(bpp)
+	{
+		case 1:
+			desc->format = GU_PSM_T8;
+			break;
+		case 2:
+			desc->format = GU_PSM_4444; //5650, 5551, T16(pal)
+			break;
+		case 4:
+			switch(opts->texcompr)
+			{
+				// case 32:
+				case 0:
+					desc->format		= GU_PSM_8888; //T32(pal)
+					break;
+				case 1:
+					desc->format		= GU_PSM_DXT1;
+					break;
+				case 3:
+					desc->format		= GU_PSM_DXT3;
+					break;
+				case 16:
+					desc->format		= GU_PSM_4444;
+					break;
+				case 5:
+				default:
+					desc->format		= GU_PSM_DXT5;
+					break;
+		}
+		break;
+	}
+
+	// HACK HACK: Force use of DXT5 for the mbox glow
+	char specChar = identifier[strlen(identifier) - 7];
+	if (specChar == '$')
+		desc->format = GU_PSM_DXT5;
+
+	// Sprite textures also get special treatment :)
+	if (identifier[strlen(identifier) - 5] == 's' &&
+	identifier[strlen(identifier) - 4] == 'p' &&
+	identifier[strlen(identifier) - 3] == 'r') {
+		desc->format = GU_PSM_DXT5;
+	}
+
+	desc->mipmaps = 0; 		// sacrifice some beauty for vram.
+
+	switch(desc->format)
+	{
+		case GU_PSM_T8:
+		case GU_PSM_4444:
+		case GU_PSM_8888:
+			desc->swizzle	= GU_TRUE;
+			break;
+		case GU_PSM_DXT1:
+		case GU_PSM_DXT3:
+		case GU_PSM_DXT5:
+			desc->swizzle	= GU_FALSE;
+			break;
+	}
+
+	if (opts->scale_down && stretch_to_power_of_two)
+	{
+		desc->width			= std::max(round_down(width), std::size_t(32));
+		desc->height		= std::max(round_down(height), std::size_t(32));
+	}
+	else
+	{
+		desc->width			= std::max(round_up(width), std::size_t(32));
+		desc->height		= std::max(round_up(height), std::size_t(32));
+	}
+
+	if (opts->phat) {
+		if (desc->width > 128)
+			desc->width = 128;
+		if (desc->height > 128)
+			desc->height = 128;
+	}
+
+	if(desc->format < GU_PSM_DXT1)
+	{
+		for (int i=0; i <= mipmap_level;i++)
+		{
+			int div = (int) powf(2,i);
+			if((desc->width / div) > 16 && (desc->height / div) > 16 )
+			{
+				desc->mipmaps = i;
+			}
+		}
+	}
+
+	// Do we really need to resize the texture?
+	// Not if the size hasn't changed.
+	desc->stretch = stretch_to_power_of_two &&
+		((desc->width != width) || (desc->height != height));
+}
+
+/*
+================
+GL_ImageSize
+================
+*/
+int GL_ImageSize (const gutexdesc_t *desc)
+{
+	int size = GL_GetTexSize(desc->format, desc->width, desc->height, 0);
+	int size_incr = size/4;
+
+	for (int i = 1; i <= desc->mipmaps; i++)
+	{
+		size += size_incr;
+		size_incr = size_incr/4;
+	}
+
+	return size;
+}
+
+/*
+================
+GL_FillScratch
+
+The top level at the stored size, unswizzled
+================
+*/
+static void GL_FillScratch (const gutexdesc_t *desc, int bpp, int resample, const byte *data,
+	int width, int height, byte *scratch)
+{
+	// Do we need to resize?
+	if (desc->stretch)
+	{
+		// Resize.
+		Image_Resample ((void*)data, width, height, scratch, desc->width, desc->height, bpp, resample);
+	}
+	else
+	{
+		// Straight copy.
+		for (int y = 0; y < height; ++y)
+		{
+			const byte* const	src	= data + (y * width * bpp);
+			byte* const			dst = &scratch[y * desc->width * bpp];
+			memcpy(dst, src, width * bpp);
+		}
+	}
+}
+
+/*
+================
+GL_ConvertSwizzled
+================
+*/
+void GL_ConvertSwizzled (const gutexdesc_t *desc, int bpp, int resample, const byte *data,
+	int width, int height, byte *out, byte *scratch)
+{
+	//32BIT resize and swizzler by Crow_bar PSP port
+	GL_FillScratch(desc, bpp, resample, data, width, height, scratch);
+
+	// Swizzle to system RAM.
+	swizzle_fast(out, scratch, desc->width * bpp, desc->height);
+
+	if (desc->mipmaps > 0)
+	{
+		int size = GL_GetTexSize(desc->format, desc->width, desc->height, 0);
+		int offset = size;
+		int div = 2;
+
+		for (int i = 1; i <= desc->mipmaps;i++)
+		{
+			Image_Resample((void*)data, width, height, scratch,
+			desc->width/div, desc->height/div, bpp, resample);
+			swizzle_fast(out+offset, scratch, (desc->width/div) * bpp, desc->height/div);
+			offset += size/(div*div);
+			div *=2;
+		}
+	}
+}
+
+/*
+================
+GL_ConvertDXT
+================
+*/
+void GL_ConvertDXT (const gutexdesc_t *desc, int bpp, int resample, const byte *data,
+	int width, int height, byte *out, byte *scratch)
+{
+	GL_FillScratch(desc, bpp, resample, data, width, height, scratch);
+
+	tx_compress_dxtn(bpp, desc->width, desc->height, scratch, desc->format, out);
+}
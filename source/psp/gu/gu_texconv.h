@@ -0,0 +1,91 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// gu_texconv.h -- the texture conversions the renderer shares with texcook
+//
+// Everything here is plain cpu work with no GU state, so the texture cooker
+// can build the same code on the host and store exactly what the upload
+// would have produced.
+
+#ifndef __GU_TEXCONV_H__
+#define __GU_TEXCONV_H__
+
+#include <cstddef>
+
+// on the PSP quakedef.h comes first, texcook has its own stand-in
+#ifdef PSP
+#include <pspgu.h>
+#else
+#include "../../linux/texcook_host.h"
+
+// texcook: the GU's values for the formats it can store
+#define GU_PSM_5650		0
+#define GU_PSM_5551		1
+#define GU_PSM_4444		2
+#define GU_PSM_8888		3
+#define GU_PSM_T4		4
+#define GU_PSM_T8		5
+#define GU_PSM_T16		6
+#define GU_PSM_T32		7
+#define GU_PSM_DXT1		8
+#define GU_PSM_DXT3		9
+#define GU_PSM_DXT5		10
+
+#define GU_FALSE		0
+#define GU_TRUE			1
+
+#endif
+
+// what GL_LoadImages makes of an image
+typedef struct
+{
+	int		format;
+	int		width, height;		// as stored, a power of two
+	int		mipmaps;
+	int		swizzle;
+	bool	stretch;			// the image has to be resampled to width x height
+} gutexdesc_t;
+
+// the settings that change it
+typedef struct
+{
+	int		texcompr;			// r_texcompr
+	bool	scale_down;			// r_tex_scale_down
+	bool	phat;				// the first model PSP, which caps the size
+	int		resample;			// r_restexf
+} gutexopts_t;
+
+int GL_GetTexSize (int format, int w, int h, int bpp);
+std::size_t round_up (std::size_t size);
+std::size_t round_down (std::size_t size);
+void swizzle_fast (unsigned char *out, const unsigned char *in, unsigned int width, unsigned int height);
+
+void GL_DescribeImage (gutexdesc_t *desc, const gutexopts_t *opts, const char *identifier,
+	int width, int height, bool stretch_to_power_of_two, int mipmap_level, int bpp);
+
+// the bytes the texture holds, mipmaps included
+int GL_ImageSize (const gutexdesc_t *desc);
+
+// scratch must hold the top level at bpp bytes a texel
+void GL_ConvertSwizzled (const gutexdesc_t *desc, int bpp, int resample, const unsigned char *data,
+	int width, int height, unsigned char *out, unsigned char *scratch);
+void GL_ConvertDXT (const gutexdesc_t *desc, int bpp, int resample, const unsigned char *data,
+	int width, int height, unsigned char *out, unsigned char *scratch);
+
+#endif	// __GU_TEXCONV_H__
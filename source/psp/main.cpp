@@ -55,7 +55,6 @@ qboolean depthfl = qfalse;
 
 extern	int  com_argc;
 extern	char **com_argv;
-
 int psp_system_model;
 
 void Sys_ReadCommandLineFile (char* netpath);
@@ -626,6 +625,7 @@ int user_main(SceSize argc, void* argp)
 		parms.basedir	= gameDirectory;
 		parms.memsize	= heap.size();
 		parms.membase	= &heap.at(0);
+		Sys_Init();
 		Host_Init(&parms);
 
 		// Precalculate the tick rate.
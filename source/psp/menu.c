@@ -101,6 +101,8 @@ SceIoStat custom_thumbnail_size;
 #define MAX_CUSTOM_MAPS 50
 usermap_t custom_maps[MAX_CUSTOM_MAPS];
 
+void M_Map_ForgetThumbnails (void);
+
 enum
 {
 m_none,
@@ -428,11 +430,10 @@ void M_Load_Menu_Pics ()
 	//menu_wn 	= Draw_CacheImg("gfx/menu/wahnsinn");
 	menu_ch 	= loadtextureimage("gfx/menu/christmas_special", 0, 0, false, GU_LINEAR);
 	menu_custom = loadtextureimage("gfx/menu/custom", 0, 0, false, GU_LINEAR);
-	for (int i = 0; i < MAX_CUSTOM_MAPS; i++) {
-		if (custom_maps[i].occupied == false) continue;
-		if (custom_maps[i].map_use_thumbnail == false) continue;
-		custom_maps[i].thumbnail_index = loadtextureimage(custom_maps[i].map_thumbnail_path, 0, 0, false, GU_LINEAR);
-	}
+
+	// Custom map thumbnails load when their page is shown; a game in
+	// between has let go of any that were loaded before.
+	M_Map_ForgetThumbnails();
 }
 
 
@@ -871,6 +872,98 @@ void M_Menu_Map_f (void)
 }
 
 
+//
+// Thumbnails are loaded for the page on screen only, the cursor's first and
+// the rest one a frame while they fit.  The least recently shown give way
+// once they take up more than MAP_THUMBNAIL_BUDGET of texture memory.
+//
+#define MAP_THUMBNAIL_BUDGET	(512*1024)
+
+int	map_thumbnail_lru[MAX_CUSTOM_MAPS];		// most recently shown first
+int	map_thumbnail_num;
+int	map_thumbnail_bytes;
+int	map_thumbnail_last;						// size of the last one loaded
+
+void M_Map_ForgetThumbnails (void)
+{
+	for (int i = 0; i < MAX_CUSTOM_MAPS; i++)
+		custom_maps[i].thumbnail_index = -1;
+
+	map_thumbnail_num = 0;
+	map_thumbnail_bytes = 0;
+	map_thumbnail_last = 0;
+}
+
+// moves a loaded thumbnail to the front, or loads it; true if it loaded
+static qboolean M_Map_Thumbnail (int map)
+{
+	usermap_t	*m = &custom_maps[map];
+	int			i;
+
+	if (m->thumbnail_index >= 0)
+	{
+		for (i = 0; map_thumbnail_lru[i] != map; i++)
+			;
+		for ( ; i > 0; i--)
+			map_thumbnail_lru[i] = map_thumbnail_lru[i - 1];
+		map_thumbnail_lru[0] = map;
+		return false;
+	}
+
+	m->thumbnail_index = loadtextureimage(m->map_thumbnail_path, 0, 0, false, GU_LINEAR);
+	if (m->thumbnail_index <= 0)
+	{
+		// don't try again every frame
+		m->thumbnail_index = -1;
+		m->map_use_thumbnail = false;
+		return true;
+	}
+
+	for (i = map_thumbnail_num; i > 0; i--)
+		map_thumbnail_lru[i] = map_thumbnail_lru[i - 1];
+	map_thumbnail_lru[0] = map;
+	map_thumbnail_num++;
+	map_thumbnail_last = GL_TextureBytes(m->thumbnail_index);
+	map_thumbnail_bytes += map_thumbnail_last;
+
+	while (map_thumbnail_bytes > MAP_THUMBNAIL_BUDGET && map_thumbnail_num > 1)
+	{
+		usermap_t *old = &custom_maps[map_thumbnail_lru[--map_thumbnail_num]];
+
+		map_thumbnail_bytes -= GL_TextureBytes(old->thumbnail_index);
+		GL_UnloadTexture(old->thumbnail_index);
+		old->thumbnail_index = -1;
+	}
+
+	return true;
+}
+
+static void M_Map_PageThumbnails (void)
+{
+	int			i;
+	usermap_t	*m;
+
+	if (m_map_cursor < 15 && m_map_cursor + multiplier < MAX_CUSTOM_MAPS)
+	{
+		m = &custom_maps[m_map_cursor + multiplier];
+		if (m->occupied && m->map_use_thumbnail && M_Map_Thumbnail(m_map_cursor + multiplier))
+			return;
+	}
+
+	if (map_thumbnail_bytes + map_thumbnail_last > MAP_THUMBNAIL_BUDGET)
+		return;
+
+	for (i = 0; i < 15 && i + multiplier < MAX_CUSTOM_MAPS; i++)
+	{
+		m = &custom_maps[i + multiplier];
+		if (m->occupied && m->map_use_thumbnail && m->thumbnail_index < 0)
+		{
+			M_Map_Thumbnail(i + multiplier);
+			return;
+		}
+	}
+}
+
 void M_Map_Draw (void)
 {
 	// Background
@@ -891,13 +984,15 @@ void M_Map_Draw (void)
 	else
 		multiplier = 0;
 
+	M_Map_PageThumbnails();
+
 	for (int i = 0; i < 15; i++) {
 		if (custom_maps[i + multiplier].occupied == false)
 			continue;
 
 		if (m_map_cursor == i) {
 
-			if (custom_maps[i + multiplier].map_use_thumbnail == 1) {
+			if (custom_maps[i + multiplier].map_use_thumbnail == 1 && custom_maps[i + multiplier].thumbnail_index >= 0) {
 				Draw_PicIndex(246, 45, 175, 100, custom_maps[i + multiplier].thumbnail_index);
 			}
 			
@@ -4787,114 +4882,257 @@ char* remove_windows_newlines(char* line)
 }
 
 
+//
+// The catalog remembers what the settings file of every custom map said,
+// keyed by the sizes and times of the .bsp and the .txt, so opening the
+// game only reads the settings of maps that are new or changed.
+//
+#define IDMAPCATHEADER	(('C'<<24)+('M'<<16)+('Z'<<8)+'N')	// little-endian "NZMC"
+#define MAPCAT_VERSION	1
+
+typedef struct
+{
+	char			name[32];
+	SceOff			bspsize;
+	ScePspDateTime	bsptime;
+	SceOff			txtsize;			// -1 without a settings file
+	ScePspDateTime	txttime;
+	int				use_thumbnail;
+	int				allow_game_settings;
+	char			name_pretty[32];
+	char			desc[8][40];
+	char			author[40];
+	char			thumbnail_path[64];
+} mapcatentry_t;
+
+static mapcatentry_t	map_catalog[MAX_CUSTOM_MAPS];
+
+typedef struct
+{
+	char			name[32];
+	SceIoStat		stat;
+} mapfile_t;
+
+static void Map_ReadSettings (mapcatentry_t *e, char *path, int size)
+{
+	int		file, state, value;
+	char	*buffer, *line;
+
+	file = sceIoOpen(path, PSP_O_RDONLY, 0);
+	if (file < 0)
+	{
+		e->txtsize = -1;
+		return;
+	}
+
+	buffer = (char*)calloc(size+1, sizeof(char));
+	sceIoRead(file, buffer, size);
+	sceIoClose(file);
+
+	state = 0;
+	for (line = strtok(buffer, "\n"); line != NULL; line = strtok(NULL, "\n"), state++)
+	{
+		remove_windows_newlines(line);
+		switch(state) {
+			case 0: Q_strncpyz(e->name_pretty, line, sizeof(e->name_pretty)); break;
+			case 1: case 2: case 3: case 4: case 5: case 6: case 7: case 8:
+				Q_strncpyz(e->desc[state - 1], line, sizeof(e->desc[0])); break;
+			case 9: Q_strncpyz(e->author, line, sizeof(e->author)); break;
+			case 10: value = 0; sscanf(line, "%d", &value); e->use_thumbnail = value; break;
+			case 11: value = 0; sscanf(line, "%d", &value); e->allow_game_settings = value; break;
+			default: break;
+		}
+	}
+
+	free(buffer);
+}
+
 void Map_Finder(void)
 {
+	char			maps_dir[MAX_OSPATH], catalog_path[MAX_OSPATH], path[MAX_OSPATH];
+	mapcatentry_t	*old_catalog, *e, *o;
+	mapfile_t		*bsps, *txts;
+	int				num_old, num_bsps, num_txts, max_txts;
+	int				i, j, file, header[3];
+	qboolean		changed;
 
 #ifdef KERNEL_MODE
-	SceUID dir = sceIoDopen(va("%s/maps", com_gamedir));
+	snprintf(maps_dir, sizeof(maps_dir), "%s/maps", com_gamedir);
+	snprintf(catalog_path, sizeof(catalog_path), "%s/mapcat.dat", com_gamedir);
 #else
-	SceUID dir = sceIoDopen(va("nzp/maps"));
+	strcpy(maps_dir, "nzp/maps");
+	strcpy(catalog_path, "nzp/mapcat.dat");
 #endif // KERNEL_MODE
 
+	SceUID dir = sceIoDopen(maps_dir);
+
 	if(dir < 0)
 	{
 		Sys_Error ("Map_Finder");
 		return;
 	}
 
+	// the last catalog, if it is one
+	old_catalog = Q_malloc(sizeof(map_catalog));
+	num_old = 0;
+	file = sceIoOpen(catalog_path, PSP_O_RDONLY, 0);
+	if (file >= 0)
+	{
+		if (sceIoRead(file, header, sizeof(header)) == sizeof(header)
+			&& header[0] == IDMAPCATHEADER && header[1] == MAPCAT_VERSION
+			&& header[2] >= 0 && header[2] <= MAX_CUSTOM_MAPS
+			&& sceIoRead(file, old_catalog, header[2] * sizeof(mapcatentry_t)) == header[2] * sizeof(mapcatentry_t))
+			num_old = header[2];
+		sceIoClose(file);
+	}
+
+	// one pass over the directory: the maps and the settings files beside them
+	bsps = Q_malloc(MAX_CUSTOM_MAPS * sizeof(mapfile_t));
+	num_bsps = 0;
+	max_txts = 64;
+	txts = Q_malloc(max_txts * sizeof(mapfile_t));
+	num_txts = 0;
+
 	SceIoDirent dirent;
 
     memset(&dirent, 0, sizeof(SceIoDirent));
 
-	for (int i = 0; i < 50; i++) {
-		custom_maps[i].occupied = false;
-	}
-
 	while(sceIoDread(dir, &dirent) > 0)
 	{
-		if(dirent.d_name[0] == '.')
+		if(dirent.d_name[0] == '.' || strlen(dirent.d_name) >= sizeof(bsps[0].name) + 4)
 		{
+		    memset(&dirent, 0, sizeof(SceIoDirent));
 			continue;
 		}
 
-		if(!strcmp(COM_FileExtension(dirent.d_name),"bsp")|| !strcmp(COM_FileExtension(dirent.d_name),"BSP"))
+		if(!Q_strcasecmp(COM_FileExtension(dirent.d_name),"bsp"))
 	    {
-			char ntype[32];
-
-			COM_StripExtension(dirent.d_name, ntype);
-			custom_maps[user_maps_num].occupied = true;
-			custom_maps[user_maps_num].map_name = Q_malloc(sizeof(char)*32);
-			sprintf(custom_maps[user_maps_num].map_name, "%s", ntype);
-
-			char* 		setting_path;
-			int 		setting_file;
-			SceIoStat	setting_info;
-
-			setting_path 								  	= Q_malloc(sizeof(char)*64);
-			custom_maps[user_maps_num].map_thumbnail_path 	= Q_malloc(sizeof(char)*64);
-#ifdef KERNEL_MODE
-			strcpy(setting_path, 									va("%s/maps/", com_gamedir));
-#else
-			strcpy(setting_path, 									va("nzp/maps/"));
-#endif // KERNEL_MODE
-			strcpy(custom_maps[user_maps_num].map_thumbnail_path, 	"gfx/menu/custom/");
-			strcat(setting_path, 									custom_maps[user_maps_num].map_name);
-			strcat(custom_maps[user_maps_num].map_thumbnail_path, 	custom_maps[user_maps_num].map_name);
-			strcat(setting_path, ".txt");
-
-			sceIoGetstat(setting_path, &setting_info);
-			setting_file = sceIoOpen(setting_path, PSP_O_RDONLY, 0);
-
-			if (setting_file >= 0) {
-
-				int state;
-				state = 0;
-				int value;
-
-				custom_maps[user_maps_num].map_name_pretty = Q_malloc(sizeof(char)*32);
-				custom_maps[user_maps_num].map_desc_1 = Q_malloc(sizeof(char)*40);
-				custom_maps[user_maps_num].map_desc_2 = Q_malloc(sizeof(char)*40);
-				custom_maps[user_maps_num].map_desc_3 = Q_malloc(sizeof(char)*40);
-				custom_maps[user_maps_num].map_desc_4 = Q_malloc(sizeof(char)*40);
-				custom_maps[user_maps_num].map_desc_5 = Q_malloc(sizeof(char)*40);
-				custom_maps[user_maps_num].map_desc_6 = Q_malloc(sizeof(char)*40);
-				custom_maps[user_maps_num].map_desc_7 = Q_malloc(sizeof(char)*40);
-				custom_maps[user_maps_num].map_desc_8 = Q_malloc(sizeof(char)*40);
-				custom_maps[user_maps_num].map_author = Q_malloc(sizeof(char)*40);
-
-				char* buffer = (char*)calloc(setting_info.st_size+1, sizeof(char));
-				sceIoRead(setting_file, buffer, setting_info.st_size);
-
-				strtok(buffer, "\n");
-				while(buffer != NULL) {
-					switch(state) {
-						case 0: strcpy(custom_maps[user_maps_num].map_name_pretty, remove_windows_newlines(buffer)); break;
-						case 1: strcpy(custom_maps[user_maps_num].map_desc_1, remove_windows_newlines(buffer)); break;
-						case 2: strcpy(custom_maps[user_maps_num].map_desc_2, remove_windows_newlines(buffer)); break;
-						case 3: strcpy(custom_maps[user_maps_num].map_desc_3, remove_windows_newlines(buffer)); break;
-						case 4: strcpy(custom_maps[user_maps_num].map_desc_4, remove_windows_newlines(buffer)); break;
-						case 5: strcpy(custom_maps[user_maps_num].map_desc_5, remove_windows_newlines(buffer)); break;
-						case 6: strcpy(custom_maps[user_maps_num].map_desc_6, remove_windows_newlines(buffer)); break;
-						case 7: strcpy(custom_maps[user_maps_num].map_desc_7, remove_windows_newlines(buffer)); break;
-						case 8: strcpy(custom_maps[user_maps_num].map_desc_8, remove_windows_newlines(buffer)); break;
-						case 9: strcpy(custom_maps[user_maps_num].map_author, remove_windows_newlines(buffer)); break;
-						case 10: value = 0; sscanf(remove_windows_newlines(buffer), "%d", &value); custom_maps[user_maps_num].map_use_thumbnail = value; break;
-						case 11: value = 0; sscanf(remove_windows_newlines(buffer), "%d", &value); custom_maps[user_maps_num].map_allow_game_settings = value; break;
-						default: break;
-					}
-					state++;
-					buffer = strtok(NULL, "\n");
-				}
-				free(buffer);
-				buffer = 0;
-				sceIoClose(setting_file);
+			if (num_bsps == MAX_CUSTOM_MAPS)
+			{
+				Con_Printf("Map_Finder: more than %d custom maps\n", MAX_CUSTOM_MAPS);
+			}
+			else
+			{
+				COM_StripExtension(dirent.d_name, bsps[num_bsps].name);
+				bsps[num_bsps].stat = dirent.d_stat;
+				num_bsps++;
+			}
+		}
+		else if(!Q_strcasecmp(COM_FileExtension(dirent.d_name),"txt"))
+		{
+			if (num_txts == max_txts)
+			{
+				max_txts *= 2;
+				txts = realloc(txts, max_txts * sizeof(mapfile_t));
 			}
-			user_maps_num++;
+			COM_StripExtension(dirent.d_name, txts[num_txts].name);
+			txts[num_txts].stat = dirent.d_stat;
+			num_txts++;
 		}
 	    memset(&dirent, 0, sizeof(SceIoDirent));
 	}
     sceIoDclose(dir);
 
+	changed = num_bsps != num_old;
+	for (i = 0; i < num_bsps; i++)
+	{
+		mapfile_t	*txt = NULL;
+
+		for (j = 0; j < num_txts; j++)
+		{
+			if (!strcmp(txts[j].name, bsps[i].name))
+			{
+				txt = &txts[j];
+				break;
+			}
+		}
+
+		for (j = 0, o = old_catalog; j < num_old; j++, o++)
+		{
+			if (!strcmp(o->name, bsps[i].name))
+				break;
+		}
+
+		e = &map_catalog[i];
+
+		if (j < num_old && o->bspsize == bsps[i].stat.st_size
+			&& !memcmp(&o->bsptime, &bsps[i].stat.st_mtime, sizeof(ScePspDateTime))
+			&& (txt ? (o->txtsize == txt->stat.st_size
+				&& !memcmp(&o->txttime, &txt->stat.st_mtime, sizeof(ScePspDateTime)))
+				: o->txtsize == -1))
+		{
+			*e = *o;
+			if (j != i)
+				changed = true;		// the order changed
+			continue;
+		}
+
+		// new or changed, read its settings
+		memset(e, 0, sizeof(*e));
+		strcpy(e->name, bsps[i].name);
+		e->bspsize = bsps[i].stat.st_size;
+		e->bsptime = bsps[i].stat.st_mtime;
+		e->txtsize = -1;
+		snprintf(e->thumbnail_path, sizeof(e->thumbnail_path), "gfx/menu/custom/%s", e->name);
+		if (txt)
+		{
+			e->txtsize = txt->stat.st_size;
+			e->txttime = txt->stat.st_mtime;
+			snprintf(path, sizeof(path), "%s/%s.txt", maps_dir, e->name);
+			Map_ReadSettings(e, path, txt->stat.st_size);
+		}
+		changed = true;
+	}
+
+	free(old_catalog);
+	free(bsps);
+	free(txts);
+
+	if (changed)
+	{
+		file = sceIoOpen(catalog_path, PSP_O_WRONLY | PSP_O_CREAT | PSP_O_TRUNC, 0777);
+		if (file >= 0)
+		{
+			header[0] = IDMAPCATHEADER;
+			header[1] = MAPCAT_VERSION;
+			header[2] = num_bsps;
+			sceIoWrite(file, header, sizeof(header));
+			sceIoWrite(file, map_catalog, num_bsps * sizeof(mapcatentry_t));
+			sceIoClose(file);
+		}
+	}
+
+	for (i = 0; i < MAX_CUSTOM_MAPS; i++) {
+		custom_maps[i].occupied = false;
+	}
+
+	for (i = 0, e = map_catalog; i < num_bsps; i++, e++)
+	{
+		usermap_t *m = &custom_maps[user_maps_num];
+
+		m->occupied = true;
+		m->map_name = e->name;
+		m->map_thumbnail_path = e->thumbnail_path;
+		m->thumbnail_index = -1;
+
+		if (e->txtsize >= 0)
+		{
+			m->map_name_pretty = e->name_pretty;
+			m->map_desc_1 = e->desc[0];
+			m->map_desc_2 = e->desc[1];
+			m->map_desc_3 = e->desc[2];
+			m->map_desc_4 = e->desc[3];
+			m->map_desc_5 = e->desc[4];
+			m->map_desc_6 = e->desc[5];
+			m->map_desc_7 = e->desc[6];
+			m->map_desc_8 = e->desc[7];
+			m->map_author = e->author;
+			m->map_use_thumbnail = e->use_thumbnail;
+			m->map_allow_game_settings = e->allow_game_settings;
+		}
+		user_maps_num++;
+	}
+
 	custom_map_pages = (int)ceil((double)(user_maps_num + 1)/15);
 }
 //==============================================================================
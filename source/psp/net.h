@@ -47,6 +47,11 @@ struct qsockaddr
 
 #define NET_PROTOCOL_VERSION	3
 
+// client_caps in CCREQ_CONNECT, and server_caps in CCREP_ACCEPT for the
+// ones both ends have
+#define NETCAP_COMPRESS		1		// understands svc_compressed
+#define NETCAP_MOVESEQ		2		// clc_move ends in a sequence, answered by svc_moveack
+
 // This is the network info/connection protocol.  It is used to find Quake
 // servers, get info about them, and connect to them.  Once connected, the
 // Quake game protocol (documented elsewhere) is used.
@@ -59,6 +64,7 @@ struct qsockaddr
 // CCREQ_CONNECT
 //		string	game_name				"QUAKE"
 //		byte	net_protocol_version	NET_PROTOCOL_VERSION
+//		byte	client_caps				NETCAP_* flags, absent from older clients
 //
 // CCREQ_SERVER_INFO
 //		string	game_name				"QUAKE"
@@ -74,6 +80,7 @@ struct qsockaddr
 //
 // CCREP_ACCEPT
 //		long	port
+//		byte	server_caps				NETCAP_* flags, absent from older servers
 //
 // CCREP_REJECT
 //		string	reason
@@ -134,6 +141,8 @@ typedef struct qsocket_s
 	int				landriver;
 	int				socket;
 	void			*driverdata;
+	int				clientcaps;		// NETCAP_* flags the client connected with
+	int				servercaps;		// NETCAP_* flags the server accepted with
 
 	unsigned int	ackSequence;
 	unsigned int	sendSequence;
@@ -128,6 +128,8 @@ qsocket_t *NET_NewQSocket (void)
 	sock->driver = net_driverlevel;
 	sock->socket = 0;
 	sock->driverdata = NULL;
+	sock->clientcaps = 0;
+	sock->servercaps = 0;
 	sock->canSend = true;
 	sock->sendNext = false;
 	sock->lastMessageTime = net_time;
@@ -452,13 +454,6 @@ NET_CheckNewConnections
 ===================
 */
 
-struct
-{
-	double	time;
-	int		op;
-	long	session;
-} vcrConnect;
-
 qsocket_t *NET_CheckNewConnections (void)
 {
 	qsocket_t	*ret;
@@ -476,10 +471,7 @@ qsocket_t *NET_CheckNewConnections (void)
 		{
 			if (recording)
 			{
-				vcrConnect.time = host_time;
-				vcrConnect.op = VCR_OP_CONNECT;
-				vcrConnect.session = (long)ret;
-				Sys_FileWrite (vcrFile, &vcrConnect, sizeof(vcrConnect));
+				VCR_WriteOp (VCR_OP_CONNECT, ret);
 				Sys_FileWrite (vcrFile, ret->address, NET_NAMELEN);
 			}
 			return ret;
@@ -488,10 +480,7 @@ qsocket_t *NET_CheckNewConnections (void)
 
 	if (recording)
 	{
-		vcrConnect.time = host_time;
-		vcrConnect.op = VCR_OP_CONNECT;
-		vcrConnect.session = 0;
-		Sys_FileWrite (vcrFile, &vcrConnect, sizeof(vcrConnect));
+		VCR_WriteOp (VCR_OP_CONNECT, NULL);
 	}
 
 	return NULL;
@@ -531,15 +520,6 @@ returns -1 if connection is invalid
 =================
 */
 
-struct
-{
-	double	time;
-	int		op;
-	long	session;
-	int		ret;
-	int		len;
-} vcrGetMessage;
-
 extern void PrintStats(qsocket_t *s);
 
 int	NET_GetMessage (qsocket_t *sock)
@@ -565,7 +545,7 @@ int	NET_GetMessage (qsocket_t *sock)
 		if (net_time - sock->lastMessageTime > net_messagetimeout.value)
 		{
 			NET_Close(sock);
-			return -1;
+			ret = -1;
 		}
 	}
 
@@ -580,29 +560,19 @@ int	NET_GetMessage (qsocket_t *sock)
 			else if (ret == 2)
 				unreliableMessagesReceived++;
 		}
-
-		if (recording)
-		{
-			vcrGetMessage.time = host_time;
-			vcrGetMessage.op = VCR_OP_GETMESSAGE;
-			vcrGetMessage.session = (long)sock;
-			vcrGetMessage.ret = ret;
-			vcrGetMessage.len = net_message.cursize;
-			Sys_FileWrite (vcrFile, &vcrGetMessage, 24);
-			Sys_FileWrite (vcrFile, net_message.data, net_message.cursize);
-		}
 	}
-	else
+
+	if (recording)
 	{
-		if (recording)
+		VCR_WriteOp (VCR_OP_GETMESSAGE, sock);
+		Sys_FileWrite (vcrFile, &ret, sizeof(int));
+		if (ret > 0)
 		{
-			vcrGetMessage.time = host_time;
-			vcrGetMessage.op = VCR_OP_GETMESSAGE;
-			vcrGetMessage.session = (long)sock;
-			vcrGetMessage.ret = ret;
-			Sys_FileWrite (vcrFile, &vcrGetMessage, 20);
+			Sys_FileWrite (vcrFile, &net_message.cursize, sizeof(int));
+			Sys_FileWrite (vcrFile, net_message.data, net_message.cursize);
 		}
 	}
+
 	return ret;
 }
 
@@ -618,14 +588,6 @@ returns 1 if the message was sent properly
 returns -1 if the connection died
 ==================
 */
-struct
-{
-	double	time;
-	int		op;
-	long	session;
-	int		r;
-} vcrSendMessage;
-
 int NET_SendMessage (qsocket_t *sock, sizebuf_t *data)
 {
 	int		r;
@@ -646,11 +608,8 @@ int NET_SendMessage (qsocket_t *sock, sizebuf_t *data)
 
 	if (recording)
 	{
-		vcrSendMessage.time = host_time;
-		vcrSendMessage.op = VCR_OP_SENDMESSAGE;
-		vcrSendMessage.session = (long)sock;
-		vcrSendMessage.r = r;
-		Sys_FileWrite (vcrFile, &vcrSendMessage, 20);
+		VCR_WriteOp (VCR_OP_SENDMESSAGE, sock);
+		Sys_FileWrite (vcrFile, &r, sizeof(int));
 	}
 
 	return r;
@@ -677,11 +636,8 @@ int NET_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 
 	if (recording)
 	{
-		vcrSendMessage.time = host_time;
-		vcrSendMessage.op = VCR_OP_SENDMESSAGE;
-		vcrSendMessage.session = (long)sock;
-		vcrSendMessage.r = r;
-		Sys_FileWrite (vcrFile, &vcrSendMessage, 20);
+		VCR_WriteOp (VCR_OP_SENDMESSAGE, sock);
+		Sys_FileWrite (vcrFile, &r, sizeof(int));
 	}
 
 	return r;
@@ -712,11 +668,8 @@ qboolean NET_CanSendMessage (qsocket_t *sock)
 
 	if (recording)
 	{
-		vcrSendMessage.time = host_time;
-		vcrSendMessage.op = VCR_OP_CANSENDMESSAGE;
-		vcrSendMessage.session = (long)sock;
-		vcrSendMessage.r = r;
-		Sys_FileWrite (vcrFile, &vcrSendMessage, 20);
+		VCR_WriteOp (VCR_OP_CANSENDMESSAGE, sock);
+		Sys_FileWrite (vcrFile, &r, sizeof(int));
 	}
 	//Con_Printf("Cansend = %i \n",r);//blubs : this is why it doesn't send the next signonreply
 	//return r; //blubs, not sure if this will fuck us up later
@@ -34,6 +34,47 @@ void Sys_FileSeek (int handle, int position);
 int Sys_FileRead (int handle, void *dest, int count);
 int Sys_FileWrite (int handle, void *data, int count);
 int	Sys_FileTime (char *path);
+
+// reads from position without moving the handle's file position, so any
+// number of readers can share one open pak
+int Sys_FileReadAt (int handle, int position, void *dest, int count);
+
+// a private view of part of an open file that stays valid after the
+// handle is closed; returns NULL where the platform can't map files
+void *Sys_FileMap (int handle, int position, int length);
+void Sys_FileUnmap (void *data, int position, int length);
+
+// every byte the reads above have returned and every mapped byte, for
+// measuring what a stretch of loading read by the difference
+extern int sys_bytesread;
+
+//
+// threads
+//
+
+// returns NULL where threads aren't available, callers then do the work
+// in line; threads run until the program exits
+void *Sys_CreateThread (void (*func) (void *), void *arg);
+
+void *Sys_CreateSemaphore (int count);
+void Sys_SemaphoreWait (void *sem);
+void Sys_SemaphorePost (void *sem);
+
+// cpu bound threads for the job system and the pipelined server tick,
+// below the main thread and on a core of their own where there is one to
+// give them, with stack enough for a server frame
+void *Sys_CreateWorker (void (*func) (void *), void *arg);
+int Sys_NumCores (void);
+
+// the thread that called main, before any other is started
+int Sys_MainThread (void);
+
+// tells the calling thread from the others
+unsigned long Sys_ThreadId (void);
+
+// first thing in main, before any other thread is started
+void Sys_Init (void);
+
 void Sys_mkdir (char *path);
 
 //
@@ -58,6 +99,10 @@ void M_Exit_f (void);
 
 double Sys_FloatTime (void);
 
+// the fastest counter there is, Sys_TickRate of them a second
+unsigned long long Sys_Ticks (void);
+double Sys_TickRate (void);
+
 char *Sys_ConsoleInput (void);
 
 void Sys_Sleep (void);
@@ -285,14 +285,20 @@ void Sys_FileSeek (int handle, int position)
 #endif
 }
 
+int sys_bytesread;
+
 int Sys_FileRead (int handle, void *dest, int count)
 {
 	file& file = files[handle];
+	int result;
 #if 0
-	return fread(dest, 1, count, file.handle);
+	result = fread(dest, 1, count, file.handle);
 #else
-    return sceIoRead(file.handle, dest, count);
+    result = sceIoRead(file.handle, dest, count);
 #endif
+	if (result > 0)
+		sys_bytesread += result;
+	return result;
 }
 
 int Sys_FileWrite (int handle, void *data, int count)
@@ -305,6 +311,137 @@ int Sys_FileWrite (int handle, void *data, int count)
 #endif
 }
 
+// sceIo has no positional read, so the seek and read are done under a lock
+static SceUID file_sema;	// made by Sys_Init
+
+int Sys_FileReadAt (int handle, int position, void *dest, int count)
+{
+	file& file = files[handle];
+	int result;
+
+	sceKernelWaitSema(file_sema, 1, 0);
+	sceIoLseek(file.handle, position, SEEK_SET);
+	result = sceIoRead(file.handle, dest, count);
+	if (result > 0)
+		sys_bytesread += result;
+	sceKernelSignalSema(file_sema, 1);
+
+	return result;
+}
+
+void *Sys_FileMap (int handle, int position, int length)
+{
+	return NULL;
+}
+
+void Sys_FileUnmap (void *data, int position, int length)
+{
+}
+
+struct thread_start
+{
+	void (*func) (void *);
+	void *arg;
+};
+
+static int Sys_ThreadStart (SceSize args, void *argp)
+{
+	// the kernel copied the start block onto this thread's stack
+	thread_start* start = static_cast<thread_start*>(argp);
+
+	start->func(start->arg);
+	return 0;
+}
+
+void *Sys_CreateThread (void (*func) (void *), void *arg)
+{
+	thread_start start;
+
+	start.func = func;
+	start.arg = arg;
+
+	// above the main thread, so it gets to issue its next read as soon as
+	// the last one completes
+	SceUID thread = sceKernelCreateThread("sys_thread", Sys_ThreadStart, 0x11, 0x10000, PSP_THREAD_ATTR_USER, NULL);
+	if (thread < 0)
+	{
+		return NULL;
+	}
+	if (sceKernelStartThread(thread, sizeof(start), &start) < 0)
+	{
+		sceKernelDeleteThread(thread);
+		return NULL;
+	}
+
+	return reinterpret_cast<void*>(thread);
+}
+
+void *Sys_CreateSemaphore (int count)
+{
+	SceUID sem = sceKernelCreateSema("sys_sema", 0, count, 0x7fffffff, NULL);
+	if (sem < 0)
+	{
+		Sys_Error("Sys_CreateSemaphore: failed");
+	}
+
+	return reinterpret_cast<void*>(sem);
+}
+
+void Sys_SemaphoreWait (void *sem)
+{
+	sceKernelWaitSema(reinterpret_cast<SceUID>(sem), 1, NULL);
+}
+
+void Sys_SemaphorePost (void *sem)
+{
+	sceKernelSignalSema(reinterpret_cast<SceUID>(sem), 1);
+}
+
+void *Sys_CreateWorker (void (*func) (void *), void *arg)
+{
+	thread_start start;
+
+	start.func = func;
+	start.arg = arg;
+
+	// below the main thread, it only runs while the main thread waits
+	SceUID thread = sceKernelCreateThread("job_worker", Sys_ThreadStart, sceKernelGetThreadCurrentPriority() + 1, 0x40000, PSP_THREAD_ATTR_USER, NULL);
+	if (thread < 0)
+	{
+		return NULL;
+	}
+	if (sceKernelStartThread(thread, sizeof(start), &start) < 0)
+	{
+		sceKernelDeleteThread(thread);
+		return NULL;
+	}
+
+	return reinterpret_cast<void*>(thread);
+}
+
+int Sys_NumCores (void)
+{
+	return 1;
+}
+
+static SceUID sys_mainthread;
+
+void Sys_Init (void)
+{
+	sys_mainthread = sceKernelGetThreadId();
+	file_sema = sceKernelCreateSema("file_sema", 0, 1, 1, NULL);
+}
+
+int Sys_MainThread (void)
+{
+	return sceKernelGetThreadId() == sys_mainthread;
+}
+
+unsigned long Sys_ThreadId (void)
+{
+	return sceKernelGetThreadId();
+}
+
 int	Sys_FileTime (char *path)
 {
 	/*
@@ -425,6 +562,18 @@ double Sys_FloatTime (void)
 	return ticks * 0.000001;
 }
 
+unsigned long long Sys_Ticks (void)
+{
+	u64 ticks;
+	sceRtcGetCurrentTick(&ticks);
+	return ticks;
+}
+
+double Sys_TickRate (void)
+{
+	return sceRtcGetTickResolution();
+}
+
 char *Sys_ConsoleInput (void)
 {
 	return 0;
@@ -36,6 +36,8 @@ extern int psp_system_model;
 
 #define	QUAKE_GAME			// as opposed to utilities
 
+#define	PROF_ZONES			// the hot path profiler in prof.h, comment out to compile it away
+
 #define	VERSION				2.0
 #define	GLQUAKE_VERSION		1.00
 #define	D3DQUAKE_VERSION	0.01
@@ -208,7 +210,7 @@ extern int psp_system_model;
 #define	SOUND_CHANNELS		8
 
 
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #include "ctr/common.h"
 #include "ctr/vid.h"
 #include "ctr/sys.h"
@@ -223,6 +225,11 @@ extern int psp_system_model;
 #include "wii/sys.h"
 extern u32 MALLOC_MEM2;
 #endif // _3DS, __PSP__, __WII__
+#ifdef __linux__
+#include "ctr/strl_fn.h"	// glibc has no strlcpy/strlcat
+#define strlcpy q_strlcpy
+#define strlcat q_strlcat
+#endif // __linux__
 #include "zone.h"
 #include "mathlib.h"
 #include "bspfile.h"
@@ -247,7 +254,7 @@ typedef struct
 #include "wad.h"
 #include "draw.h"
 #include "cvar.h"
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #include "ctr/screen.h"
 #include "ctr/net.h"
 #elif __PSP__
@@ -259,14 +266,14 @@ typedef struct
 #endif // _3DS
 #include "protocol.h"
 #include "cmd.h"
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #include "ctr/sbar.h"
 #elif __WII__
 #include "wii/sbar.h"
 #endif // _3DS
 #include "cl_hud.h"
 #include "sound.h"
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #include "ctr/render.h"
 #include "ctr/client.h"
 #elif __PSP__
@@ -277,7 +284,7 @@ typedef struct
 #include "wii/client.h"
 #endif // _3DS
 #include "progs.h"
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #include "ctr/server.h"
 #elif __PSP__
 #include "psp/server.h"
@@ -285,7 +292,7 @@ typedef struct
 #include "wii/server.h"
 #endif // _3DS
 
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #include "ctr/gl/gl_model.h"
 #include "ctr/gl/gl_decal.h"
 #elif __WII__
@@ -296,7 +303,7 @@ typedef struct
 
 #include "input.h"
 #include "world.h"
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #include "ctr/keys.h"
 #elif __PSP__
 #include "psp/keys.h"
@@ -305,7 +312,7 @@ typedef struct
 #endif
 #include "console.h"
 #include "view.h"
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #include "ctr/menu.h"
 #elif __PSP__
 #include "psp/menu.h"
@@ -315,7 +322,7 @@ typedef struct
 #include "crc.h"
 #include "cdaudio.h"
 
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #include "ctr/glquake.h"
 #elif __WII__
 #include "wii/gx/gxquake.h"
@@ -379,6 +386,8 @@ void Host_Frame (float time);
 void Host_Quit_f (void);
 void Host_ClientCommands (char *fmt, ...);
 void Host_ShutdownServer (qboolean crash);
+void Host_WaitServerFrame (void);		// for a pipelined tick to end
+void Host_MainCall (void (*func) (void));	// run func on the main thread
 
 extern qboolean		msg_suppress_1;		// suppresses resolution and cache size console output
 										//  an fullscreen DIB focus gain/loss
@@ -466,7 +475,7 @@ extern int argsort_comparator(const void *lhs, const void *rhs);
 extern func_t	EndFrame;
 
 
-#ifdef _3DS
+#if defined(_3DS) || defined(__linux__)
 #define VERTEXARRAYSIZE 18360
 extern float gVertexBuffer[VERTEXARRAYSIZE];
 extern float gColorBuffer[VERTEXARRAYSIZE];
@@ -20,6 +20,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // snd_dma.c -- main control for any streaming sound output device
 
 #include "quakedef.h"
+#include "loadtrace.h"
+#include "prof.h"
 
 
 
@@ -74,6 +76,8 @@ cvar_t volume = {"volume", "0.7", true};
 cvar_t nosound = {"nosound", "0"};
 cvar_t precache = {"precache", "1"};
 cvar_t loadas8bit = {"loadas8bit", "0"};
+cvar_t snd_adpcm = {"snd_adpcm", "0"};
+cvar_t snd_cache = {"snd_cache", "1"};
 cvar_t bgmbuffer = {"bgmbuffer", "4096"};
 cvar_t ambient_level = {"ambient_level", "0.3", true}; // Baker 3.60 - Save to config
 cvar_t ambient_fade = {"ambient_fade", "100"};
@@ -179,6 +183,8 @@ void S_Init (void)
 	Cvar_RegisterVariable(&volume);
 	Cvar_RegisterVariable(&precache);
 	Cvar_RegisterVariable(&loadas8bit);
+	Cvar_RegisterVariable(&snd_adpcm);
+	Cvar_RegisterVariable(&snd_cache);
 	Cvar_RegisterVariable(&bgmvolume);
 	Cvar_RegisterVariable(&bgmbuffer);
 	Cvar_RegisterVariable(&ambient_level);
@@ -323,11 +329,55 @@ sfx_t *S_PrecacheSound (char *name)
 
 // cache it in
 	if (precache.value)
+	{
+		LoadTrace_Begin ("S_PrecacheSound", name);
 		S_LoadSound (sfx);
+		LoadTrace_End ();
+	}
 
 	return sfx;
 }
 
+/*
+==================
+S_PrewarmSound
+
+Loads a sound back in if the cache has it pinned but threw its data out
+==================
+*/
+void S_PrewarmSound (char *name)
+{
+	sfx_t	*sfx;
+
+	if (!sound_started || nosound.value)
+		return;
+
+	sfx = S_FindName (name);
+	if (!sfx->cache.data && Cache_IsPinned (&sfx->cache))
+		S_LoadSound (sfx);
+}
+
+/*
+==================
+S_IsLoaded
+
+True when S_PrecacheSound wouldn't read the file
+==================
+*/
+qboolean S_IsLoaded (char *name)
+{
+	int		i;
+
+	if (!sound_started || nosound.value || !precache.value)
+		return true;
+
+	for (i=0 ; i < num_sfx ; i++)
+		if (!strcmp(known_sfx[i].name, name))
+			return Cache_Check (&known_sfx[i].cache) != NULL;
+
+	return false;
+}
+
 
 //=============================================================================
 
@@ -721,6 +771,31 @@ void S_UpdateAmbientSounds (void)
 }
 
 
+/*
+============
+S_FetchSounds
+
+The mixer only plays what is already resident, anything the cache has let
+go of is read back here, before mixing, instead of stalling the mixer
+============
+*/
+static void S_FetchSounds (void)
+{
+	int			i;
+	channel_t	*ch;
+
+	ch = channels;
+	for (i=0 ; i<total_channels; i++, ch++)
+	{
+		if (!ch->sfx || (!ch->leftvol && !ch->rightvol))
+			continue;
+		if (Cache_Check (&ch->sfx->cache))
+			continue;
+		if (!S_LoadSound (ch->sfx))
+			ch->sfx = NULL;
+	}
+}
+
 /*
 ============
 S_Update
@@ -738,6 +813,8 @@ void S_Update(vec3_t origin, vec3_t forward, vec3_t right, vec3_t up)
 	if (!sound_started || (snd_blocked > 0))
 		return;
 
+	PROF_BEGIN (S_Update);
+
 	VectorCopy(origin, listener_origin);
 	VectorCopy(forward, listener_forward);
 	VectorCopy(right, listener_right);
@@ -809,8 +886,12 @@ void S_Update(vec3_t origin, vec3_t forward, vec3_t right, vec3_t up)
 		Con_Printf ("----(%i)----\n", total);
 	}
 
+	S_FetchSounds ();
+
 // mix some sound
 	S_Update_();
+
+	PROF_END (S_Update);
 }
 
 void GetSoundtime(void)
@@ -956,13 +1037,19 @@ void S_SoundList_f(void)
 	{
 		if (!(sc = Cache_Check (&sfx->cache)))
 			continue;
-		size = sc->length*sc->width*(sc->stereo+1);
+		if (sc->format == SFX_ADPCM)
+			size = SND_AdpcmSize (sc->length);
+		else
+			size = sc->length*sc->width*(sc->stereo+1);
 		total += size;
 		if (sc->loopstart >= 0)
 			Con_Printf ("L");
 		else
 			Con_Printf (" ");
-		Con_Printf("(%2db) %6i : %s\n",sc->width*8,  size, sfx->name);
+		if (sc->format == SFX_ADPCM)
+			Con_Printf("(adp) %6i : %s\n", size, sfx->name);
+		else
+			Con_Printf("(%2db) %6i : %s\n",sc->width*8,  size, sfx->name);
 	}
 	Con_Printf ("Total resident: %i\n", total);
 }
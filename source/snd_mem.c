@@ -20,6 +20,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // snd_mem.c: sound caching
 
 #include "quakedef.h"
+#include "fs_index.h"
 
 int			cache_full_cycle;
 
@@ -28,34 +29,21 @@ byte *S_Alloc (int size);
 /*
 ================
 ResampleSfx
+
+sc has the length and width wanted, data is at inrate and inwidth
 ================
 */
-void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
+void ResampleSfx (sfxcache_t *sc, int inrate, int inwidth, byte *data)
 {
 	int		outcount;
 	int		srcsample;
 	float	stepscale;
 	int		i;
 	int		sample, samplefrac, fracstep;
-	sfxcache_t	*sc;
-
-	sc = Cache_Check (&sfx->cache);
-	if (!sc)
-		return;
 
 	stepscale = (float)inrate / shm->speed;	// this is usually 0.5, 1, or 2
 
-	outcount = sc->length / stepscale;
-	sc->length = outcount;
-	if (sc->loopstart != -1)
-		sc->loopstart = sc->loopstart / stepscale;
-
-	sc->speed = shm->speed;
-	if (loadas8bit.value)
-		sc->width = 1;
-	else
-		sc->width = inwidth;
-	sc->stereo = 0;
+	outcount = sc->length;
 
 // resample / decimate to the current source rate
 
@@ -87,6 +75,291 @@ void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
 	}
 }
 
+/*
+================
+EncodeAdpcm
+
+Mirrors SND_AdpcmDecode step for step, so the mixer ends every sample on
+exactly the state the encoder predicted from
+================
+*/
+void EncodeAdpcm (short *in, int length, byte *out)
+{
+	int		i, sample, delta, step, diff, nibble;
+	int		pred, index;
+	byte	*block;
+
+	pred = length ? in[0] : 0;
+	index = 0;
+	block = out;
+
+	for (i=0 ; i<length ; i++)
+	{
+		if (!(i & (ADPCM_BLOCK-1)))
+		{
+			block = out + (i / ADPCM_BLOCK) * ADPCM_BLOCKSIZE;
+			memset (block, 0, ADPCM_BLOCKSIZE);
+			block[0] = pred & 255;
+			block[1] = (pred >> 8) & 255;
+			block[2] = index;
+		}
+
+		sample = in[i];
+		delta = sample - pred;
+		nibble = 0;
+		if (delta < 0)
+		{
+			nibble = 8;
+			delta = -delta;
+		}
+
+		step = snd_adpcmsteps[index];
+		diff = step >> 3;
+		if (delta >= step)
+		{
+			nibble |= 4;
+			delta -= step;
+			diff += step;
+		}
+		step >>= 1;
+		if (delta >= step)
+		{
+			nibble |= 2;
+			delta -= step;
+			diff += step;
+		}
+		step >>= 1;
+		if (delta >= step)
+		{
+			nibble |= 1;
+			diff += step;
+		}
+
+		if (nibble & 8)
+			pred -= diff;
+		else
+			pred += diff;
+		if (pred > 32767)
+			pred = 32767;
+		else if (pred < -32768)
+			pred = -32768;
+
+		index += snd_adpcmindex[nibble];
+		if (index < 0)
+			index = 0;
+		else if (index > 88)
+			index = 88;
+
+		if (i & 1)
+			block[4 + ((i & (ADPCM_BLOCK-1)) >> 1)] |= nibble << 4;
+		else
+			block[4 + ((i & (ADPCM_BLOCK-1)) >> 1)] |= nibble;
+	}
+}
+
+/*
+===============================================================================
+
+Resampled sound cache
+
+Resampling (and encoding) is redone every time the zone cache lets a sound
+go.  The result is kept under cache/ in the game directory at the mixer's
+rate, so reading a sound back is a single straight read into the cache.
+A file made from a wav of a different size, for another mixer rate or with
+other load settings is ignored and replaced.
+
+===============================================================================
+*/
+
+#define	SFXCACHE_VERSION	1
+
+#define	SFXC_8BIT			1		// loadas8bit
+#define	SFXC_ADPCM			2		// snd_adpcm
+
+typedef struct
+{
+	char	id[4];				// "SFXC"
+	int		version;
+	int		options;			// SFXC_*
+	int		srcsize;			// the wav's length, to notice it was changed
+	int		speed;
+	int		width;
+	int		format;
+	int		length;
+	int		loopstart;
+	int		datasize;
+} sfxcachehdr_t;
+
+/*
+================
+S_CachedOptions
+================
+*/
+static int S_CachedOptions (void)
+{
+	int		options;
+
+	options = 0;
+	if (loadas8bit.value)
+		options |= SFXC_8BIT;
+	if (snd_adpcm.value)
+		options |= SFXC_ADPCM;
+
+	return options;
+}
+
+/*
+================
+S_CachedPath
+================
+*/
+static void S_CachedPath (char *sfxname, char *path, int size)
+{
+	char	name[MAX_QPATH];
+
+	COM_StripExtension (sfxname, name);
+	snprintf (path, size, "%s/cache/%s.sfxc", com_gamedir, name);
+}
+
+/*
+================
+S_SwapSamples
+
+16 bit samples are little endian on disk
+================
+*/
+static void S_SwapSamples (sfxcache_t *sc)
+{
+	int		i;
+	short	*data;
+
+	if (!bigendien || sc->format != SFX_PCM || sc->width != 2)
+		return;
+
+	data = (short *)sc->data;
+	for (i=0 ; i<sc->length ; i++)
+		data[i] = LittleShort (data[i]);
+}
+
+/*
+================
+S_ReadCachedSound
+================
+*/
+static sfxcache_t *S_ReadCachedSound (sfx_t *s)
+{
+	char			path[MAX_OSPATH];
+	sfxcachehdr_t	header;
+	fsentry_t		*src;
+	sfxcache_t		*sc;
+	int				h, len, i;
+	qboolean		ok;
+
+	if (!snd_cache.value)
+		return NULL;
+
+	S_CachedPath (s->name, path, sizeof(path));
+	len = Sys_FileOpenRead (path, &h);
+	if (h == -1)
+		return NULL;
+
+	ok = Sys_FileRead (h, &header, sizeof(header)) == sizeof(header);
+	for (i=1 ; i<sizeof(header)/4 ; i++)
+		((int *)&header)[i] = LittleLong (((int *)&header)[i]);
+
+	// with the wav gone the cached copy stands in for it
+	src = FS_FindEntry (s->name, NULL);
+
+	ok = ok && !memcmp (header.id, "SFXC", 4)
+		&& header.version == SFXCACHE_VERSION
+		&& header.options == S_CachedOptions ()
+		&& (!src || header.srcsize == src->filelen)
+		&& header.speed == shm->speed
+		&& header.length > 0
+		&& header.datasize == len - sizeof(header);
+	if (!ok)
+	{
+		Sys_FileClose (h);
+		Con_DPrintf ("%s: cached sound is stale\n", s->name);
+		return NULL;
+	}
+
+	sc = Cache_Alloc (&s->cache, header.datasize + sizeof(sfxcache_t), s->name);
+	if (!sc)
+	{
+		Sys_FileClose (h);
+		return NULL;
+	}
+
+	ok = Sys_FileRead (h, sc->data, header.datasize) == header.datasize;
+	Sys_FileClose (h);
+	if (!ok)
+	{
+		Cache_Free (&s->cache);
+		return NULL;
+	}
+
+	sc->length = header.length;
+	sc->loopstart = header.loopstart;
+	sc->speed = header.speed;
+	sc->width = header.width;
+	sc->stereo = 0;
+	sc->format = header.format;
+	S_SwapSamples (sc);
+
+	return sc;
+}
+
+/*
+================
+S_WriteCachedSound
+================
+*/
+static void S_WriteCachedSound (sfx_t *s, sfxcache_t *sc, int srcsize, int datasize)
+{
+	char			path[MAX_OSPATH];
+	sfxcachehdr_t	header;
+	FILE			*f;
+	int				i;
+	qboolean		ok;
+
+	if (!snd_cache.value)
+		return;
+
+	S_CachedPath (s->name, path, sizeof(path));
+	COM_CreatePath (path);
+	f = fopen (path, "wb");
+	if (!f)
+		return;
+
+	memcpy (header.id, "SFXC", 4);
+	header.version = SFXCACHE_VERSION;
+	header.options = S_CachedOptions ();
+	header.srcsize = srcsize;
+	header.speed = sc->speed;
+	header.width = sc->width;
+	header.format = sc->format;
+	header.length = sc->length;
+	header.loopstart = sc->loopstart;
+	header.datasize = datasize;
+	for (i=1 ; i<sizeof(header)/4 ; i++)
+		((int *)&header)[i] = LittleLong (((int *)&header)[i]);
+
+	S_SwapSamples (sc);
+	ok = fwrite (&header, sizeof(header), 1, f) == 1
+		&& fwrite (sc->data, datasize, 1, f) == 1;
+	S_SwapSamples (sc);
+	fclose (f);
+
+	if (!ok)
+	{
+		Con_DPrintf ("Couldn't write %s\n", path);
+		remove (path);
+		return;
+	}
+	COM_FileWritten (path + strlen(com_gamedir) + 1);
+}
+
 //=============================================================================
 
 /*
@@ -96,54 +369,101 @@ S_LoadSound
 */
 sfxcache_t *S_LoadSound (sfx_t *s)
 {
-    char	namebuffer[256];
-	byte	*data;
+	filemap_t	map;
 	wavinfo_t	info;
-	int		len;
+	int		length, width, datasize;
 	float	stepscale;
-	sfxcache_t	*sc;
-	byte	stackbuf[1*1024];		// avoid dirtying the cache heap
+	sfxcache_t	*sc, *pcm;
+	double	start;
 
 // see if still in memory
 	if ((sc = Cache_Check (&s->cache)))
 		return sc;
 
-//Con_Printf ("S_LoadSound: %x\n", (int)stackbuf);
-// load it in
-    Q_strcpy(namebuffer, "");
-    Q_strcat(namebuffer, s->name);
+	start = Sys_FloatTime ();
 
-//	Con_Printf ("loading %s\n",namebuffer);
+// resampled on an earlier run
+	if ((sc = S_ReadCachedSound (s)))
+	{
+		Cache_Loaded (&s->cache, Sys_FloatTime () - start);
+		return sc;
+	}
 
-	if (!(data = COM_LoadStackFile(namebuffer, stackbuf, sizeof(stackbuf))))
+// load it in
+//	Con_Printf ("loading %s\n",s->name);
+
+	// resampled straight out of the file, the cache only gets the result
+	if (!COM_MapTempFile (s->name, &map))
 	{
-		Con_Printf ("Couldn't load %s\n", namebuffer);
+		Con_Printf ("Couldn't load %s\n", s->name);
 		return NULL;
 	}
 
-	info = GetWavinfo (s->name, data, com_filesize);
+	info = GetWavinfo (s->name, map.data, map.len);
 	if (info.channels != 1)
 	{
 		Con_Printf ("%s is a stereo sample\n",s->name);
+		COM_UnmapFile (&map);
 		return NULL;
 	}
 
 	stepscale = (float)info.rate / shm->speed;
-	len = info.samples / stepscale;
-
-	len = len * info.width * info.channels;
+	length = info.samples / stepscale;
 
-	sc = Cache_Alloc ( &s->cache, len + sizeof(sfxcache_t), s->name);
-	if (!sc)
-		return NULL;
+	if (snd_adpcm.value)
+	{
+		// encoded from full 16 bit samples, whatever loadas8bit says
+		pcm = malloc (sizeof(sfxcache_t) + length * 2);
+		if (!pcm)
+		{
+			COM_UnmapFile (&map);
+			return NULL;
+		}
+		pcm->length = length;
+		pcm->width = 2;
+		ResampleSfx (pcm, info.rate, info.width, map.data + info.dataofs);
+		COM_UnmapFile (&map);
+
+		width = 0;
+		datasize = SND_AdpcmSize (length);
+		sc = Cache_Alloc (&s->cache, datasize + sizeof(sfxcache_t), s->name);
+		if (sc)
+			EncodeAdpcm ((short *)pcm->data, length, sc->data);
+		free (pcm);
+		if (!sc)
+			return NULL;
+	}
+	else
+	{
+		if (loadas8bit.value)
+			width = 1;
+		else
+			width = info.width;
+		datasize = length * width;
+
+		sc = Cache_Alloc (&s->cache, datasize + sizeof(sfxcache_t), s->name);
+		if (!sc)
+		{
+			COM_UnmapFile (&map);
+			return NULL;
+		}
+		sc->length = length;
+		sc->width = width;
+		ResampleSfx (sc, info.rate, info.width, map.data + info.dataofs);
+		COM_UnmapFile (&map);
+	}
 
-	sc->length = info.samples;
+	sc->length = length;
 	sc->loopstart = info.loopstart;
-	sc->speed = info.rate;
-	sc->width = info.width;
-	sc->stereo = info.channels;
+	if (sc->loopstart != -1)
+		sc->loopstart = sc->loopstart / stepscale;
+	sc->speed = shm->speed;
+	sc->width = width;
+	sc->stereo = 0;
+	sc->format = width ? SFX_PCM : SFX_ADPCM;
 
-	ResampleSfx (s, sc->speed, sc->width, data + info.dataofs);
+	S_WriteCachedSound (s, sc, map.len, datasize);
+	Cache_Loaded (&s->cache, Sys_FloatTime () - start);
 
 	return sc;
 }
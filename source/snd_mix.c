@@ -159,6 +159,7 @@ CHANNEL MIXING
 
 void SND_PaintChannelFrom8 (channel_t *ch, sfxcache_t *sc, int endtime);
 void SND_PaintChannelFrom16 (channel_t *ch, sfxcache_t *sc, int endtime);
+void SND_PaintChannelFromADPCM (channel_t *ch, sfxcache_t *sc, int endtime);
 
 void S_PaintChannels(int endtime)
 {
@@ -184,7 +185,9 @@ void S_PaintChannels(int endtime)
 				continue;
 			if (!ch->leftvol && !ch->rightvol)
 				continue;
-			if (!(sc = S_LoadSound (ch->sfx)))
+			// S_Update reads back anything that isn't resident, loading
+			// here would stall the mix
+			if (!(sc = Cache_Check (&ch->sfx->cache)))
 				continue;
 
 			ltime = paintedtime;
@@ -198,7 +201,9 @@ void S_PaintChannels(int endtime)
 
 				if (count > 0)
 				{
-					if (sc->width == 1)
+					if (sc->format == SFX_ADPCM)
+						SND_PaintChannelFromADPCM(ch, sc, count);
+					else if (sc->width == 1)
 						SND_PaintChannelFrom8(ch, sc, count);
 					else
 						SND_PaintChannelFrom16(ch, sc, count);
@@ -291,3 +296,149 @@ void SND_PaintChannelFrom16 (channel_t *ch, sfxcache_t *sc, int count)
 	ch->pos += count;
 }
 
+
+
+/*
+===============================================================================
+
+IMA ADPCM
+
+===============================================================================
+*/
+
+int snd_adpcmindex[16] =
+{
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+int snd_adpcmsteps[89] =
+{
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+	19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+	130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+	337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+	876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+	5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+	15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/*
+================
+SND_AdpcmSize
+================
+*/
+int SND_AdpcmSize (int length)
+{
+	return (length + ADPCM_BLOCK - 1) / ADPCM_BLOCK * ADPCM_BLOCKSIZE;
+}
+
+/*
+================
+SND_AdpcmBlock
+
+Starts the decoder on the block holding sample pos
+================
+*/
+static byte *SND_AdpcmBlock (sfxcache_t *sc, int pos, int *pred, int *index)
+{
+	byte	*block;
+
+	block = sc->data + (pos / ADPCM_BLOCK) * ADPCM_BLOCKSIZE;
+	*pred = (short)(block[0] | (block[1] << 8));
+	*index = block[2];
+
+	return block + 4;
+}
+
+/*
+================
+SND_AdpcmDecode
+================
+*/
+static int SND_AdpcmDecode (int nibble, int *pred, int *index)
+{
+	int		step, diff, p, i;
+
+	step = snd_adpcmsteps[*index];
+	diff = step >> 3;
+	if (nibble & 4)
+		diff += step;
+	if (nibble & 2)
+		diff += step >> 1;
+	if (nibble & 1)
+		diff += step >> 2;
+
+	p = *pred;
+	if (nibble & 8)
+		p -= diff;
+	else
+		p += diff;
+	if (p > 32767)
+		p = 32767;
+	else if (p < -32768)
+		p = -32768;
+	*pred = p;
+
+	i = *index + snd_adpcmindex[nibble];
+	if (i < 0)
+		i = 0;
+	else if (i > 88)
+		i = 88;
+	*index = i;
+
+	return p;
+}
+
+/*
+================
+SND_PaintChannelFromADPCM
+
+The decoder state is kept in the channel, so a sound played straight
+through decodes every sample once; a jump (a loop, a skipped start) goes
+back to the start of the block and decodes up to the new position
+================
+*/
+void SND_PaintChannelFromADPCM (channel_t *ch, sfxcache_t *sc, int count)
+{
+	int		data, leftvol, rightvol;
+	int		i, pos, pred, index, nibble;
+	byte	*nibbles;
+
+	leftvol = ch->leftvol;
+	rightvol = ch->rightvol;
+	pos = ch->pos;
+
+	nibbles = SND_AdpcmBlock (sc, pos, &pred, &index);
+	if (pos == ch->adpcmpos && (pos & (ADPCM_BLOCK-1)))
+	{
+		pred = ch->adpcmpred;
+		index = ch->adpcmindex;
+	}
+	else
+	{
+		for (i=0 ; i<(pos & (ADPCM_BLOCK-1)) ; i++)
+		{
+			nibble = nibbles[i >> 1];
+			SND_AdpcmDecode ((i & 1) ? nibble >> 4 : nibble & 15, &pred, &index);
+		}
+	}
+
+	for (i=0 ; i<count ; i++, pos++)
+	{
+		if (!(pos & (ADPCM_BLOCK-1)))
+			nibbles = SND_AdpcmBlock (sc, pos, &pred, &index);
+
+		nibble = nibbles[(pos & (ADPCM_BLOCK-1)) >> 1];
+		data = SND_AdpcmDecode ((pos & 1) ? nibble >> 4 : nibble & 15, &pred, &index);
+		paintbuffer[i].left += (data * leftvol) >> 8;
+		paintbuffer[i].right += (data * rightvol) >> 8;
+	}
+
+	ch->pos = pos;
+	ch->adpcmpos = pos;
+	ch->adpcmpred = pred;
+	ch->adpcmindex = index;
+}
@@ -44,9 +44,19 @@ typedef struct
 	int 	speed;
 	int 	width;
 	int 	stereo;
+	int		format;			// SFX_PCM or SFX_ADPCM
 	byte	data[1];		// variable sized
 } sfxcache_t;
 
+#define	SFX_PCM			0
+#define	SFX_ADPCM		1		// ima adpcm, 4 bits a sample
+
+// adpcm data is split in blocks that each start with the decoder state,
+// a short predictor and a byte step index, so any sample can be reached
+// without decoding from the start of the sound
+#define	ADPCM_BLOCK		256
+#define	ADPCM_BLOCKSIZE	(4 + ADPCM_BLOCK/2)
+
 typedef struct
 {
 	qboolean		gamealive;
@@ -74,6 +84,9 @@ typedef struct
 	vec3_t	origin;			// origin of sound effect
 	vec_t	dist_mult;		// distance multiplier (attenuation/clipK)
 	int		master_vol;		// 0-255 master volume
+	int		adpcmpos;		// the sample the decoder state below is for
+	int		adpcmpred;
+	int		adpcmindex;
 } channel_t;
 
 typedef struct
@@ -98,6 +111,8 @@ void S_Update (vec3_t origin, vec3_t v_forward, vec3_t v_right, vec3_t v_up);
 void S_ExtraUpdate (void);
 
 sfx_t *S_PrecacheSound (char *sample);
+qboolean S_IsLoaded (char *sample);
+void S_PrewarmSound (char *sample);
 void S_TouchSound (char *sample);
 void S_ClearPrecache (void);
 void S_BeginPrecaching (void);
@@ -155,6 +170,8 @@ extern volatile dma_t sn;
 extern vec_t sound_nominal_clip_dist;
 
 extern	cvar_t loadas8bit;
+extern	cvar_t snd_adpcm;
+extern	cvar_t snd_cache;
 extern	cvar_t bgmvolume;
 extern	cvar_t bgmtype; 
 extern	cvar_t volume;
@@ -168,6 +185,11 @@ sfxcache_t *S_LoadSound (sfx_t *s);
 
 wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength);
 
+extern	int snd_adpcmsteps[89];
+extern	int snd_adpcmindex[16];
+
+int SND_AdpcmSize (int length);
+
 void SND_InitScaletable (void);
 void SNDDMA_Submit(void);
 
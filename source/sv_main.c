@@ -20,6 +20,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // sv_main.c -- server main program
 
 #include "quakedef.h"
+#include "lz.h"
+#include "prefetch.h"
+#include "loadtrace.h"
+#include "prof.h"
 #ifdef __WII__
 #include <ctype.h>
 void SV_SendNop (client_t *client);
@@ -33,6 +37,10 @@ char	localmodels[MAX_MODELS][5];			// inline model names for precache
 //============================================================================
 cvar_t	r_hlbsponly = {"r_hlbsponly","0",true};
 
+cvar_t	sv_compress = {"sv_compress","1"};			// lz reliable messages to clients that can take them
+cvar_t	sv_compress_min = {"sv_compress_min","256"};	// smaller messages aren't worth it
+cvar_t	sv_prewarm = {"sv_prewarm","1"};			// keep what a round used cached for the next
+
 /*
 ===============
 SV_Init
@@ -62,6 +70,9 @@ void SV_Init (void)
 	Cvar_RegisterVariable (&sv_idealpitchscale);
 	Cvar_RegisterVariable (&sv_aim);
 	Cvar_RegisterVariable (&sv_nostep);
+	Cvar_RegisterVariable (&sv_compress);
+	Cvar_RegisterVariable (&sv_compress_min);
+	Cvar_RegisterVariable (&sv_prewarm);
 
 	for (i=0 ; i<MAX_MODELS ; i++)
 		sprintf (localmodels[i], "*%i", i);
@@ -807,6 +818,12 @@ qboolean SV_SendClientDatagram (client_t *client)
 	MSG_WriteByte (&msg, svc_time);
 	MSG_WriteFloat (&msg, sv.time);
 
+	if (client->netconnection->clientcaps & NETCAP_MOVESEQ)
+	{
+		MSG_WriteByte (&msg, svc_moveack);
+		MSG_WriteLong (&msg, client->lastmove);
+	}
+
 // add the client specific data to the datagram
 	SV_WriteClientdataToMessage (client->edict, &msg);//This should be good now
 
@@ -906,6 +923,47 @@ void SV_SendNop (client_t *client)
 	client->last_message = realtime;
 }
 
+/*
+=======================
+SV_CompressMessage
+
+Replaces a large reliable message with an svc_compressed that expands to it,
+the signon precache lists and baselines are mostly repeated path names
+=======================
+*/
+void SV_CompressMessage (client_t *client)
+{
+	static byte	*packed;		// the first compressed message allocates it
+	sizebuf_t	*msg;
+	int			size, len;
+
+	msg = &client->message;
+	size = msg->cursize;
+
+	if (!sv_compress.value || size < sv_compress_min.value)
+		return;
+	if (!(client->netconnection->clientcaps & NETCAP_COMPRESS))
+		return;
+
+	if (!packed)
+	{
+		packed = malloc (NET_MAXMESSAGE);
+		if (!packed)
+			return;
+	}
+
+	len = LZ_Compress (msg->data, size, packed, NET_MAXMESSAGE - 5);
+	if (!len)
+		return;
+
+	Con_DPrintf ("SV_CompressMessage: %i bytes to %i for %s\n", size, len + 5, client->name);
+
+	SZ_Clear (msg);
+	MSG_WriteByte (msg, svc_compressed);
+	MSG_WriteLong (msg, size);
+	SZ_Write (msg, packed, len);
+}
+
 /*
 =======================
 SV_SendClientMessages
@@ -915,6 +973,8 @@ void SV_SendClientMessages (void)
 {
 	int			i;
 
+	PROF_BEGIN (SV_SendClientMessages);
+
 // update points, names, etc
 	SV_UpdateToReliableMessages ();
 
@@ -966,6 +1026,7 @@ void SV_SendClientMessages (void)
 				SV_DropClient (false);	// went to another level
 			else
 			{
+				SV_CompressMessage (host_client);
 				if (NET_SendMessage (host_client->netconnection
 				, &host_client->message) == -1)
 					SV_DropClient (true);	// if the message couldn't send, kick off
@@ -979,6 +1040,8 @@ void SV_SendClientMessages (void)
 
 // clear muzzle flashes
 	SV_CleanupEnts ();
+
+	PROF_END (SV_SendClientMessages);
 }
 
 
@@ -990,6 +1053,20 @@ SERVER SPAWNING
 ==============================================================================
 */
 
+static	int		sv_lateslot;
+
+/*
+================
+SV_LoadLateModel
+
+A model the progs didn't precache, loaded on the main thread
+================
+*/
+static void SV_LoadLateModel (void)
+{
+	sv.models[sv_lateslot] = Mod_ForName (sv.model_precache[sv_lateslot], true);
+}
+
 /*
 ================
 SV_ModelIndex
@@ -1009,7 +1086,8 @@ int SV_ModelIndex (char *name)
 		{
 			Con_Printf ("Model (%s) was not precached, precaching\n", name);
 			sv.model_precache[i] = name;
-			sv.models[i] = Mod_ForName (name, true);
+			sv_lateslot = i;
+			Host_MainCall (SV_LoadLateModel);
 			return i;
 		}
 		if (!strcmp(sv.model_precache[i], name))
@@ -1104,6 +1182,83 @@ void SV_SendReconnect (void)
 }
 
 
+/*
+================
+SV_PinModel
+================
+*/
+static void SV_PinModel (string_t name)
+{
+	model_t	*mod;
+
+	if (!name || !pr_strings[name])
+		return;
+
+	mod = Mod_ForName (pr_strings + name, false);
+	if (mod)
+		Cache_Pin (&mod->cache);
+}
+
+/*
+================
+SV_PrewarmCache
+
+Pins what the last round used, and the weapons the players hold, and loads
+back any of it the cache has already thrown out, so the models and sounds
+a round comes back to are there when it starts instead of in the middle
+================
+*/
+static void SV_PrewarmCache (void)
+{
+	client_t	*client;
+	model_t		*mod;
+	int			i;
+
+	Cache_NewPinSet ();
+
+	for (i=0, client = svs.clients ; i<svs.maxclients ; i++, client++)
+	{
+		if (!client->active)
+			continue;
+		SV_PinModel (client->edict->v.weaponmodel);
+		SV_PinModel (client->edict->v.weapon2model);
+	}
+
+	for (i=1 ; i<MAX_MODELS && sv.model_precache[i] ; i++)
+	{
+		mod = sv.models[i];
+		if (mod && !mod->cache.data && Cache_IsPinned (&mod->cache))
+			Mod_ForName (sv.model_precache[i], false);
+	}
+
+	for (i=1 ; i<MAX_SOUNDS && sv.sound_precache[i] ; i++)
+		S_PrewarmSound (sv.sound_precache[i]);
+}
+
+/*
+================
+SV_CheckRound
+
+Prewarms the cache when the progs start a new round
+================
+*/
+void SV_CheckRound (void)
+{
+	int		round;
+
+	round = (int)pr_global_struct->rounds;
+	if (round == sv.round)
+		return;
+	sv.round = round;
+
+	if (sv_prewarm.value && sv.state == ss_active)
+	{
+		LoadTrace_Begin ("SV_PrewarmCache", NULL);
+		SV_PrewarmCache ();
+		LoadTrace_End ();
+	}
+}
+
 /*
 ================
 SV_SaveSpawnparms
@@ -1142,10 +1297,63 @@ This is called at the start of each level
 extern float		scr_centertime_off;
 void Load_Waypoint ();
 
+static	char	sv_lastmap[MAX_QPATH];
+static	char	sv_lastmodels[MAX_MODELS][MAX_QPATH];
+static	int		sv_numlastmodels;
+
+/*
+================
+SV_PrefetchModels
+
+The precache list is only complete once the progs have spawned every
+entity, so the one this map built the last time it was spawned is read
+ahead along with the world
+================
+*/
+static void SV_PrefetchModels (char *server)
+{
+	char	name[MAX_QPATH];
+	int		i;
+
+	Prefetch_Begin ();
+
+	sprintf (name, "maps/%s.bsp", server);
+	if (!Mod_IsLoaded (name))
+		Prefetch_Add (name);
+
+	if (strcmp (sv_lastmap, server))
+		return;
+
+	for (i=0 ; i<sv_numlastmodels ; i++)
+		if (!Mod_IsLoaded (sv_lastmodels[i]))
+			Prefetch_Add (sv_lastmodels[i]);
+}
+
+/*
+================
+SV_RememberModels
+================
+*/
+static void SV_RememberModels (void)
+{
+	int		i;
+
+	Q_strncpyz (sv_lastmap, sv.name, sizeof(sv_lastmap));
+
+	sv_numlastmodels = 0;
+	for (i=2 ; i<MAX_MODELS && sv.model_precache[i] ; i++)
+	{
+		if (sv.model_precache[i][0] == '*' || strlen (sv.model_precache[i]) >= MAX_QPATH)
+			continue;	// inline models are in the world
+		strcpy (sv_lastmodels[sv_numlastmodels++], sv.model_precache[i]);
+	}
+}
+
 void SV_SpawnServer (char *server)
 {
 	edict_t		*ent;
 	int			i;
+	double		start;
 
 	// let's not have any servers with no name
 	if (hostname.string[0] == 0)
@@ -1155,6 +1363,8 @@ void SV_SpawnServer (char *server)
 	Con_DPrintf ("SpawnServer: %s\n",server);
 	svs.changelevel_issued = false;		// now safe to issue another
 
+	LoadTrace_Begin ("SV_SpawnServer", server);
+
 //
 // tell all connected clients that we are going to a new level
 //
@@ -1185,8 +1395,13 @@ void SV_SpawnServer (char *server)
 
 	strcpy (sv.name, server);
 
+// the map and its models are read while the progs load and spawn
+	SV_PrefetchModels (server);
+
 // load progs to get entity field count
+	LoadTrace_Begin ("PR_LoadProgs", NULL);
 	PR_LoadProgs ();
+	LoadTrace_End ();
 
 // allocate server memory
 	sv.max_edicts = MAX_EDICTS;
@@ -1220,11 +1435,17 @@ void SV_SpawnServer (char *server)
 
 	strcpy (sv.name, server);
 	sprintf (sv.modelname,"maps/%s.bsp", server);
+	start = Sys_FloatTime ();
+	LoadTrace_Begin ("Mod_ForName", sv.modelname);
 	sv.worldmodel = Mod_ForName (sv.modelname, false);
+	LoadTrace_End ();
+	Prefetch_Loaded (sv.modelname, Sys_FloatTime () - start);
 	if (!sv.worldmodel)
 	{
 		Con_Printf ("Couldn't spawn server %s\n", sv.modelname);
 		sv.active = false;
+		Prefetch_End ();
+		LoadTrace_End ();
 		return;
 	}
 	sv.models[1] = sv.worldmodel;
@@ -1266,7 +1487,12 @@ void SV_SpawnServer (char *server)
 // serverflags are for cross level information (sigils)
 	pr_global_struct->serverflags = svs.serverflags;
 
+	LoadTrace_Begin ("ED_LoadFromFile", NULL);
 	ED_LoadFromFile (sv.worldmodel->entities);
+	LoadTrace_End ();
+
+	Prefetch_End ();
+	SV_RememberModels ();
 
 	sv.active = true;
 
@@ -1286,8 +1512,12 @@ void SV_SpawnServer (char *server)
 		if (host_client->active)
 			SV_SendServerinfo (host_client);
 
+	LoadTrace_Begin ("Load_Waypoint", NULL);
 	Load_Waypoint ();
+	LoadTrace_End ();
 	Con_DPrintf ("Server spawned.\n");
+
+	LoadTrace_End ();
 }
 
 
@@ -1295,73 +1525,59 @@ void SV_SpawnServer (char *server)
 //ZOMBIE AI THINGS BELOVE THIS!!!
 #define W_MAX_TEMPSTRING 2048
 char	*w_string_temp;
-int W_fopen (void)
-{
-	int h = 0;
 
-	Sys_FileOpenRead (va("%s/maps/%s.way",com_gamedir, sv.name), &h);
-#ifdef __WII__
-	if (h > 0)
-		return h;
-	else 
+// the waypoint file being read is viewed in place and walked with a cursor
+static	filemap_t	w_map;
+static	int			w_pos;
+
+static int W_open (char *netpath)
+{
+	if (!COM_MapOSFile (netpath, &w_map))
 		return -1;
-#else
-	return h;
-#endif
+
+	w_pos = 0;
+	return 0;
 }
 
-int W_fopenbeta(void)
+int W_fopen (void)
 {
-	int h = 0;
+	return W_open (va("%s/maps/%s.way",com_gamedir, sv.name));
+}
 
-	Sys_FileOpenRead (va("%s/data/%s",com_gamedir, sv.name), &h);
-#ifdef __WII__
-	if (h > 0)
-		return h;
-	else 
-		return -1;
-#else
-	return h;
-#endif
+int W_fopenbeta(void)
+{
+	return W_open (va("%s/data/%s",com_gamedir, sv.name));
 }
 
 void W_fclose (int h)
 {
-	Sys_FileClose(h);
+	COM_UnmapFile (&w_map);
 }
 
 char *W_fgets (int h)
 {
-	// reads one line (up to a \n) into a string
+	// reads one line (up to a \n) into a string, dropping carriage returns
 	int		i;
-	int		count;
-	char	buffer;
+	int		c;
 
-	count = Sys_FileRead(h, &buffer, 1);
-	if (count && buffer == '\r')	// carriage return
-	{
-		count = Sys_FileRead(h, &buffer, 1);	// skip
-	}
-	if (!count)	// EndOfFile
+	if (w_pos >= w_map.len)	// EndOfFile
 	{
 		return "";
 	}
 
 	i = 0;
-	while (count && buffer != '\n')
+	while (w_pos < w_map.len)
 	{
+		c = w_map.data[w_pos++];
+		if (c == '\n')
+			break;
+		if (c == '\r')
+			continue;
 		if (i < 128-1)	// no place for character in temp string
 		{
-			w_string_temp[i++] = buffer;
+			w_string_temp[i++] = c;
 		}
-
-		// read next character
-		count = Sys_FileRead(h, &buffer, 1);
-		if (count && buffer == '\r')	// carriage return
-		{
-			count = Sys_FileRead(h, &buffer, 1);	// skip
-		}
-	};
+	}
 	w_string_temp[i] = 0;
 
 	return (w_string_temp);
@@ -20,6 +20,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // sv_phys.c
 
 #include "quakedef.h"
+#include "arena.h"
+#include "prof.h"
 
 /*
 
@@ -1705,6 +1707,8 @@ void SV_Physics (void)
 	int		i;
 	edict_t	*ent;
 
+	PROF_BEGIN (SV_Physics);
+
 // let the progs know that a new frame has started
 	pr_global_struct->self = EDICT_TO_PROG(sv.edicts);
 	pr_global_struct->other = EDICT_TO_PROG(sv.edicts);
@@ -1764,23 +1768,27 @@ void SV_Physics (void)
 		pr_global_struct->force_retouch--;
 
 	sv.time += host_frametime;
+
+	PROF_END (SV_Physics);
 }
 
 trace_t SV_Trace_Toss (edict_t *ent, edict_t *ignore)
 {
 	double	save_frametime;
 	vec3_t	move, end;
-	edict_t	tempent, *tent;
+	edict_t	*tent;
 	trace_t	trace;
+	int		mark;
 
 	save_frametime = host_frametime;
 	host_frametime = 0.05;
+	mark = Arena_Mark (&sv_arena);
+	tent = Arena_Alloc (&sv_arena, sizeof(edict_t));
 #ifdef __PSP__
-	memcpy_vfpu(&tempent, ent, sizeof(edict_t));
+	memcpy_vfpu(tent, ent, sizeof(edict_t));
 #else
-	memcpy(&tempent, ent, sizeof(edict_t));
+	memcpy(tent, ent, sizeof(edict_t));
 #endif
-	tent = &tempent;
 
 	while (1)
 	{
@@ -1797,6 +1805,7 @@ trace_t SV_Trace_Toss (edict_t *ent, edict_t *ignore)
 				break;
 	}
 	host_frametime = save_frametime;
+	Arena_Release (&sv_arena, mark);
 
 	return trace;
 }
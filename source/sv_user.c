@@ -475,6 +475,10 @@ void SV_ReadClientMove (usercmd_t *move)
 	i = MSG_ReadByte ();
 	if (i)
 		host_client->edict->v.impulse = i;
+
+// read the sequence, acknowledged in the next datagram
+	if (host_client->netconnection->clientcaps & NETCAP_MOVESEQ)
+		host_client->lastmove = MSG_ReadLong ();
 }
 
 /*
@@ -0,0 +1,100 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// texcook.c -- textures converted ahead of time into what the gpu reads
+//
+// Loading a tga or png costs a decode, a resample and then a swizzle or a
+// dxt encode on the console, every time the texture is loaded.  The
+// nzportable-texcook tool runs the same conversions on the host and stores
+// the result under cooked/<platform>/ in the game directory; the loaders
+// look there first and copy the data straight into texture memory.
+//
+// A cooked file names the source it was made from by extension and size.
+// If the loader would now pick a different file, or the file has changed
+// size, the cooked one is ignored.  When no source is present at all the
+// cooked file stands in for it, so a release can ship without the sources.
+
+#include "quakedef.h"
+#include "texcook.h"
+#include "fs_index.h"
+
+static char	*texcook_platforms[] = {NULL, "psp", "wii"};
+
+cvar_t	r_cooked = {"r_cooked", "1"};
+
+/*
+=================
+TexCook_Init
+=================
+*/
+void TexCook_Init (void)
+{
+	Cvar_RegisterVariable (&r_cooked);
+}
+
+/*
+=================
+TexCook_Load
+=================
+*/
+texcookhdr_t *TexCook_Load (char *basename, int platform, char **exts)
+{
+	char			path[MAX_OSPATH];
+	texcookhdr_t	*hdr;
+	fsentry_t		*src;
+	int				i, srcext, len;
+
+	if (!r_cooked.value)
+		return NULL;
+
+	snprintf (path, sizeof(path), "cooked/%s/%s.ctx", texcook_platforms[platform], basename);
+	if (!FS_FindEntry (path, NULL))
+		return NULL;
+
+	hdr = (texcookhdr_t *)COM_LoadMallocFile (path, &len);
+	if (!hdr)
+		return NULL;
+	if (len < sizeof(texcookhdr_t))
+	{
+		free (hdr);
+		return NULL;
+	}
+
+	for (i=1 ; i<sizeof(texcookhdr_t)/4 ; i++)
+		((int *)hdr)[i] = LittleLong (((int *)hdr)[i]);
+
+	if (memcmp (hdr->id, "NZTC", 4)
+		|| hdr->version != TEXCOOK_VERSION || hdr->platform != platform
+		|| hdr->datasize != len - sizeof(texcookhdr_t))
+	{
+		Con_DPrintf ("%s is not a cooked texture for this version\n", path);
+		free (hdr);
+		return NULL;
+	}
+
+	srcext = FS_FindExtension (basename, exts, &src);
+	if (srcext >= 0 && (srcext != hdr->srcext || src->filelen != hdr->srcsize))
+	{
+		Con_DPrintf ("%s is older than its source\n", path);
+		free (hdr);
+		return NULL;
+	}
+
+	return hdr;
+}
@@ -0,0 +1,55 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// texcook.h -- textures converted ahead of time into what the gpu reads
+
+#define	TEXCOOK_VERSION		1
+
+#define	TEXCOOK_PSP			1
+#define	TEXCOOK_WII			2
+
+// the image sources each port's loadtextureimage tries, in its order
+#define	TEXCOOK_PSP_EXTS	{"tga", "pcx", "jpg", "png", "bmp", NULL}
+#define	TEXCOOK_WII_EXTS	{"pcx", "tga", "png", "jpeg", "jpg", NULL}
+
+// every field is little endian on disk, the data follows in the gpu's own
+// layout and byte order
+typedef struct texcookhdr_s
+{
+	char	id[4];				// "NZTC"
+	int		version;
+	int		platform;
+	int		srcext;				// which of the port's extensions it was made from
+	int		srcsize;			// the source's length, to notice it was changed
+	int		width, height;		// of the source
+	int		format;				// GU_PSM_* or GX_TF_*
+	int		scaled_width, scaled_height;
+	int		mipmaps;
+	int		swizzle;
+	int		resample;			// psp r_restexf
+	int		checksum;			// wii lhcsum of the source pixels
+	int		datasize;
+} texcookhdr_t;
+
+void TexCook_Init (void);
+
+// cooked/<platform>/<basename>.ctx with its header in host order, or NULL
+// if there isn't one, it is disabled or it was made from a source that
+// isn't the one the loader would now pick; the caller frees it
+texcookhdr_t *TexCook_Load (char *basename, int platform, char **exts);
@@ -999,7 +999,7 @@ void DropRecoilKick (void)
 {
 	float	len;
 
-	if (crosshair_spread_time > sv.time)
+	if (crosshair_spread_time > cl.svtime)
 		return;
 	len = VectorNormalize (cl.gun_kick);
 
@@ -1119,9 +1119,9 @@ void V_CalcRefdef (void)
 	vec3_t ADSOffset;
 	if(cl.stats[STAT_ZOOM] == 1 || cl.stats[STAT_ZOOM] == 2)
 	{
-		ADSOffset[0] = sv_player->v.ADS_Offset[0];
-		ADSOffset[1] = sv_player->v.ADS_Offset[1];
-		ADSOffset[2] = sv_player->v.ADS_Offset[2];
+		ADSOffset[0] = cl.adsoffset[0];
+		ADSOffset[1] = cl.adsoffset[1];
+		ADSOffset[2] = cl.adsoffset[2];
 		
 		ADSOffset[0] = ADSOffset[0]/1000;
 		ADSOffset[1] = ADSOffset[1]/1000;
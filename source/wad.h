@@ -83,4 +83,6 @@ int ConvertWad3ToRGBA(miptex_t *tex);
 void W_LoadTextureWadFileHL (char *filename, int complain);
 byte *W_ConvertWAD3TextureHL(miptex_t *tex);
 byte *W_GetTextureHL(char *name);
+#else
+byte *WAD3_LoadTexture(miptex_t *mt);
 #endif // __PSP__
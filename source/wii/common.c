@@ -20,6 +20,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // common.c -- misc functions used in client and server
 
 #include "../quakedef.h"
+#include "../fs_index.h"
+#include "../zip.h"
+#include "../prefetch.h"
 
 #define NUM_SAFE_ARGVS  7
 
@@ -1047,6 +1050,8 @@ void COM_CheckRegistered (void)
 
 
 void COM_Path_f (void);
+void COM_Rescan_f (void);
+void COM_RebuildIndex (void);
 
 
 /*
@@ -1151,6 +1156,7 @@ void COM_Init (char *basedir)
 	Cvar_RegisterVariable (&registered);
 	Cvar_RegisterVariable (&cmdline);
 	Cmd_AddCommand ("path", COM_Path_f);
+	Cmd_AddCommand ("fs_rescan", COM_Rescan_f);
 
 	COM_InitFilesystem ();
 	COM_CheckRegistered ();
@@ -1169,8 +1175,10 @@ FIXME: make this buffer size safe someday
 char    *va(char *format, ...)
 {
 	va_list         argptr;
-	static char             string[1024];
+	static char             buffers[2][1024];	// a pipelined server tick gets its own
+	char			*string;
 	
+	string = buffers[!Sys_MainThread ()];
 	va_start (argptr, format);
 	vsprintf (string, format,argptr);
 	va_end (argptr);
@@ -1199,6 +1207,11 @@ QUAKE FILESYSTEM
 */
 
 int     com_filesize;
+int     com_filepos;
+
+// set by COM_FindFile when the file is in a zip
+static	zipfile_t	*com_zip;
+static	int			com_zipindex;
 
 
 //
@@ -1244,6 +1257,7 @@ typedef struct searchpath_s
 {
 	char    filename[MAX_OSPATH];
 	pack_t  *pack;          // only one of filename / pack will be used
+	zipfile_t	*zip;
 	struct searchpath_s *next;
 } searchpath_t;
 
@@ -1258,6 +1272,7 @@ COM_Path_f
 void COM_Path_f (void)
 {
 	searchpath_t    *s;
+	zipfile_t		*z;
 	
 	Con_Printf ("Current search path:\n");
 	for (s=com_searchpaths ; s ; s=s->next)
@@ -1266,9 +1281,102 @@ void COM_Path_f (void)
 		{
 			Con_Printf ("%s (%i files)\n", s->pack->filename, s->pack->numfiles);
 		}
+		else if (s->zip)
+		{
+			z = s->zip;
+			Con_Printf ("%s (%i files)\n", z->filename, z->numfiles);
+			if (z->reads)
+				Con_Printf ("  %i reads, %iK in %.1f ms, %iK inflated in %.1f ms\n", z->reads,
+					z->bytesread / 1024, z->readtime * 1000, z->bytesinflated / 1024, z->inflatetime * 1000);
+		}
 		else
 			Con_Printf ("%s\n", s->filename);
 	}
+	Con_Printf ("%i files indexed\n", FS_IndexCount ());
+}
+
+/*
+============
+COM_IndexSearchPath
+
+Older elements go in first so the ones in front of them shadow their files
+============
+*/
+static void COM_IndexSearchPath (searchpath_t *search)
+{
+	pack_t	*pak;
+	zipfile_t	*zip;
+	int		i;
+
+	if (!search)
+		return;
+
+	COM_IndexSearchPath (search->next);
+
+	if (search->pack)
+	{
+		pak = search->pack;
+		for (i=0 ; i<pak->numfiles ; i++)
+			FS_IndexFile (search, pak->files[i].name, pak->files[i].filepos, pak->files[i].filelen);
+	}
+	else if (search->zip)
+	{
+		// zip entries are indexed by their number in the archive
+		zip = search->zip;
+		for (i=0 ; i<zip->numfiles ; i++)
+			FS_IndexFile (search, zip->files[i].name, i, zip->files[i].size);
+	}
+	else
+		FS_IndexDirectory (search, search->filename);
+}
+
+/*
+============
+COM_RebuildIndex
+============
+*/
+void COM_RebuildIndex (void)
+{
+	FS_ClearIndex ();
+	COM_IndexSearchPath (com_searchpaths);
+	Con_Printf ("Indexed %i files\n", FS_IndexCount ());
+}
+
+/*
+============
+COM_Rescan_f
+
+Picks up files copied into the game directories while running
+============
+*/
+void COM_Rescan_f (void)
+{
+	COM_RebuildIndex ();
+}
+
+/*
+============
+COM_FileWritten
+
+Adds a file just written below com_gamedir to the index
+============
+*/
+void COM_FileWritten (char *filename)
+{
+	searchpath_t    *search;
+	fsentry_t		*entry;
+
+	for (search = com_searchpaths ; search ; search = search->next)
+		if (!search->pack && !strcmp (search->filename, com_gamedir))
+			break;
+	if (!search)
+		return;
+
+	for (entry = FS_FindEntry (filename, NULL) ; entry ; entry = FS_FindEntry (filename, entry))
+		if (entry->source == search)
+			return;		// loose files are sized when they are opened
+
+	FS_IndexFile (search, filename, 0, 0);
 }
 
 /*
@@ -1295,6 +1403,7 @@ void COM_WriteFile (char *filename, void *data, int len)
 	Sys_Printf ("COM_WriteFile: %s\n", name);
 	Sys_FileWrite (handle, data, len);
 	Sys_FileClose (handle);
+	COM_FileWritten (filename);
 }
 
 
@@ -1365,9 +1474,11 @@ Sets com_filesize and one of handle or file
 int COM_FindFile (char *filename, int *handle, int *file)
 {
 	searchpath_t    *search;
+	fsentry_t       *entry;
 	char            netpath[MAX_OSPATH];
 	char            cachepath[MAX_OSPATH];
 	pack_t          *pak;
+	zipfile_t       *zip;
 	int                     i;
 	int                     findtime, cachetime;
 
@@ -1375,74 +1486,109 @@ int COM_FindFile (char *filename, int *handle, int *file)
 		Sys_Error ("COM_FindFile: both handle and file set");
 	if (!file && !handle)
 		Sys_Error ("COM_FindFile: neither handle or file set");
-		
+
+	com_zip = NULL;
+
 //
-// search through the path, one element at a time
+// one probe of the index instead of a walk of the search path, and the
+// next entry if a loose file was removed since it was indexed
 //
-	search = com_searchpaths;
-	if (proghack)
+	entry = FS_FindEntry (filename, NULL);
+	if (proghack && !strcmp(filename, "progs.dat"))
 	{	// gross hack to use quake 1 progs with quake 2 maps
-		if (!strcmp(filename, "progs.dat"))
-			search = search->next;
+		while (entry && entry->source == com_searchpaths)
+			entry = FS_FindEntry (filename, entry);
 	}
-
-	for ( ; search ; search = search->next)
+	for ( ; entry ; entry = FS_FindEntry (filename, entry))
 	{
+		search = entry->source;
+
+	// if not a registered version, don't ever go beyond base
+		if (!search->pack && !search->zip && !static_registered
+			&& (strchr (filename, '/') || strchr (filename,'\\')))
+			continue;
+
 	// is the element a pak file?
 		if (search->pack)
 		{
-		// look through all the pak file elements
 			pak = search->pack;
-			for (i=0 ; i<pak->numfiles ; i++)
-				if (!strcmp (pak->files[i].name, filename))
-				{       // found it!
-					Sys_Printf ("PackFile: %s : %s\n",pak->filename, filename);
-					if (handle)
-					{
-						*handle = pak->handle;
-						Sys_FileSeek (pak->handle, pak->files[i].filepos);
-					}
-					else
-					{       // open a new file on the pakfile
-						Sys_FileOpenRead(pak->filename, file);
-						if ((*file) >= 0)
-							Sys_FileSeek(*file, pak->files[i].filepos);
-					}
-					com_filesize = pak->files[i].filelen;
-					return com_filesize;
-				}
-		}
-		else
-		{       
-			// check a file in the directory tree
-			if (!static_registered)
-			{       // if not a registered version, don't ever go beyond base
-				if ( strchr (filename, '/') || strchr (filename,'\\'))
-					continue;
+			Sys_Printf ("PackFile: %s : %s\n", pak->filename, filename);
+
+			if (handle)
+			{
+				*handle = pak->handle;
+				Sys_FileSeek (pak->handle, entry->filepos);
 			}
-		
-			sprintf (netpath, "%s/%s",search->filename, filename);
-			
-			findtime = Sys_FileTime (netpath);
-			if (findtime == -1)
+			else
+			{       // open a new file on the pakfile
+				Sys_FileOpenRead(pak->filename, file);
+				if ((*file) >= 0)
+					Sys_FileSeek(*file, entry->filepos);
+			}
+			com_filepos = entry->filepos;
+			com_filesize = entry->filelen;
+			return com_filesize;
+		}
+
+	// is the element a zip file?
+		if (search->zip)
+		{
+			zip = search->zip;
+			com_zip = zip;
+			com_zipindex = entry->filepos;
+			com_filepos = Zip_DataOffset (zip, com_zipindex);
+			if (com_filepos < 0)
+			{
+				com_zip = NULL;
 				continue;
-				
-		// see if the file needs to be updated in the cache
-			if (!com_cachedir[0])
-				strcpy (cachepath, netpath);
+			}
+			Sys_Printf ("ZipFile: %s : %s\n", zip->filename, filename);
+			if (handle)
+			{
+				*handle = zip->handle;
+				Sys_FileSeek (zip->handle, com_filepos);
+			}
+			else if (Zip_IsStored (zip, com_zipindex))
+			{       // open a new file on the zipfile
+				Sys_FileOpenRead(zip->filename, file);
+				if ((*file) >= 0)
+					Sys_FileSeek(*file, com_filepos);
+			}
 			else
 			{
-				sprintf (cachepath,"%s%s", com_cachedir, netpath);
+				Con_Printf ("%s is compressed in %s, it can't be read by handle\n", filename, zip->filename);
+				*file = -1;
+				com_filesize = -1;
+				return -1;
+			}
+			com_filesize = entry->filelen;
+			return com_filesize;
+		}
 
-				cachetime = Sys_FileTime (cachepath);
-			
-				if (cachetime < findtime)
-					COM_CopyFile (netpath, cachepath);
-				strcpy (netpath, cachepath);
-			}	
+	// a file in the directory tree, by the name it has on disk
+		sprintf (netpath, "%s/%s",search->filename, entry->name);
 
+	// see if the file needs to be updated in the cache
+		if (!com_cachedir[0])
+			strcpy (cachepath, netpath);
+		else
+		{
+			findtime = Sys_FileTime (netpath);
+			sprintf (cachepath,"%s%s", com_cachedir, netpath);
+
+			cachetime = Sys_FileTime (cachepath);
+
+			if (cachetime < findtime)
+				COM_CopyFile (netpath, cachepath);
+			strcpy (netpath, cachepath);
+		}
+
+		com_filepos = 0;
+		com_filesize = Sys_FileOpenRead (netpath, &i);
+		if (com_filesize != -1)		// removed since it was indexed
+		{
 			Sys_Printf ("FindFile: %s\n",netpath);
-			com_filesize = Sys_FileOpenRead (netpath, &i);
+
 			if (handle)
 				*handle = i;
 			else
@@ -1452,11 +1598,10 @@ int COM_FindFile (char *filename, int *handle, int *file)
 			}
 			return com_filesize;
 		}
-		
 	}
-	
+
 	Sys_Printf ("FindFile: can't find %s\n", filename);
-	
+
 	if (handle)
 		*handle = -1;
 	else
@@ -1477,7 +1622,18 @@ it may actually be inside a pak file
 */
 int COM_OpenFile (char *filename, int *handle)
 {
-	return COM_FindFile (filename, handle, NULL);
+	int		len;
+
+	len = COM_FindFile (filename, handle, NULL);
+	if (com_zip && !Zip_IsStored (com_zip, com_zipindex))
+	{	// the handle would read the deflated bytes
+		Con_Printf ("%s is compressed in %s, it can't be read by handle\n", filename, com_zip->filename);
+		*handle = -1;
+		com_filesize = -1;
+		return -1;
+	}
+
+	return len;
 }
 
 /*
@@ -1505,13 +1661,73 @@ void COM_CloseFile (int h)
 	searchpath_t    *s;
 	
 	for (s = com_searchpaths ; s ; s=s->next)
-		if (s->pack && s->pack->handle == h)
+		if ((s->pack && s->pack->handle == h) || (s->zip && s->zip->handle == h))
 			return;
 			
 	Sys_FileClose (h);
 }
 
 
+/*
+============
+COM_LoadMallocFile
+
+For threads other than the main one, the file is found and read without
+touching the com_ globals, the handle table or the hunk.  The index must
+not change while it runs.  The caller frees the result.
+============
+*/
+byte *COM_LoadMallocFile (char *path, int *len)
+{
+	fsentry_t	*entry;
+	searchpath_t	*search;
+	char	netpath[MAX_OSPATH];
+	byte	*buf;
+	FILE	*f;
+	int		n;
+
+	for (entry = FS_FindEntry (path, NULL) ; entry ; entry = FS_FindEntry (path, entry))
+	{
+		search = entry->source;
+
+		if (!search->pack && !search->zip && !static_registered && (strchr (path, '/') || strchr (path, '\\')))
+			continue;	// COM_FindFile wouldn't take it either
+
+		buf = malloc (entry->filelen + 1);
+		if (!buf)
+			return NULL;
+		buf[entry->filelen] = 0;
+
+		if (search->pack)
+			n = Sys_FileReadAt (search->pack->handle, entry->filepos, buf, entry->filelen);
+		else if (search->zip)
+			n = Zip_ReadFile (search->zip, entry->filepos, buf) ? entry->filelen : -1;
+		else
+		{
+			snprintf (netpath, sizeof(netpath), "%s/%s", search->filename, entry->name);
+			f = fopen (netpath, "rb");
+			if (!f)
+			{	// removed since it was indexed, try the next one
+				free (buf);
+				continue;
+			}
+			n = fread (buf, 1, entry->filelen, f);
+			fclose (f);
+		}
+
+		if (n != entry->filelen)
+		{	// changed since it was indexed, leave it to COM_FindFile
+			free (buf);
+			return NULL;
+		}
+
+		*len = n;
+		return buf;
+	}
+
+	return NULL;
+}
+
 /*
 ============
 COM_LoadFile
@@ -1529,13 +1745,30 @@ byte *COM_LoadFile (char *path, int usehunk)
 	byte    *buf;
 	char    base[32];
 	int             len;
+	zipfile_t       *zip;
+	int             zipindex;
+	byte    *staged;
 
 	buf = NULL;     // quiet compiler warning
 
-// look for it in the filesystem or pack files
-	len = COM_OpenFile (path, &h);
-	if (h == -1)
-		return NULL;
+// the prefetch thread may have read it already
+	staged = Prefetch_Take (path, &len);
+	if (staged)
+	{
+		h = -1;
+		zip = NULL;
+		zipindex = 0;
+		com_filesize = len;
+	}
+	else
+	{
+	// look for it in the filesystem or pack files
+		len = COM_FindFile (path, &h, NULL);
+		if (h == -1)
+			return NULL;
+		zip = com_zip;
+		zipindex = com_zipindex;
+	}
 	
 // extract the filename base name for hunk tag
 	COM_FileBase (path, base);
@@ -1567,7 +1800,17 @@ byte *COM_LoadFile (char *path, int usehunk)
 		
 	((byte *)buf)[len] = 0;
 
-	Sys_FileRead (h, buf, len);                     
+	if (staged)
+	{
+		memcpy (buf, staged, len);
+		free (staged);
+		return buf;
+	}
+
+	if (zip)
+		Zip_ReadFile (zip, zipindex, buf);	// inflated straight into place
+	else
+		Sys_FileReadAt (h, com_filepos, buf, len);
 	COM_CloseFile (h);
 
 	return buf;
@@ -1601,6 +1844,159 @@ byte *COM_LoadStackFile (char *path, void *buffer, int bufsize)
 	return buf;
 }
 
+/*
+============
+COM_MapCopy
+
+Room for a copy of a file that can't be viewed in place
+============
+*/
+static byte *COM_MapCopy (filemap_t *map, int len)
+{
+	if (map->temp)
+		return Hunk_TempAlloc (len + 1);
+	return malloc (len + 1);
+}
+
+static void COM_FreeCopy (filemap_t *map)
+{
+	if (!map->temp)
+		free (map->data);
+	map->data = NULL;
+}
+
+/*
+============
+COM_MapHandle
+============
+*/
+static qboolean COM_MapHandle (int h, int position, int len, filemap_t *map)
+{
+	map->filepos = position;
+	map->len = len;
+	map->data = Sys_FileMap (h, position, len);
+	map->mapped = (map->data != NULL);
+
+	if (!map->mapped)
+	{
+		map->data = COM_MapCopy (map, len);
+		if (!map->data || Sys_FileReadAt (h, position, map->data, len) != len)
+		{
+			COM_FreeCopy (map);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+============
+COM_MapPath
+============
+*/
+static qboolean COM_MapPath (char *path, filemap_t *map, qboolean temp)
+{
+	int		h, len;
+	qboolean	ok;
+
+	memset (map, 0, sizeof(*map));
+
+	// a staged buffer is handed over, unmapping frees it
+	map->data = Prefetch_Take (path, &map->len);
+	if (map->data)
+	{
+		com_filesize = map->len;
+		return true;
+	}
+
+	len = COM_FindFile (path, &h, NULL);
+	if (h == -1)
+		return false;
+
+	map->temp = temp;
+	if (com_zip && !Zip_IsStored (com_zip, com_zipindex))
+	{	// deflated, so there is nothing to view in place
+		map->len = len;
+		map->data = COM_MapCopy (map, len);
+		ok = map->data && Zip_ReadFile (com_zip, com_zipindex, map->data);
+		if (!ok)
+			COM_FreeCopy (map);
+	}
+	else
+		ok = COM_MapHandle (h, com_filepos, len, map);
+	COM_CloseFile (h);
+
+	return ok;
+}
+
+/*
+============
+COM_MapFile
+
+Zero copy counterpart to COM_LoadFile for loaders that only parse the file
+============
+*/
+qboolean COM_MapFile (char *path, filemap_t *map)
+{
+	return COM_MapPath (path, map, false);
+}
+
+/*
+============
+COM_MapTempFile
+
+Counterpart to COM_LoadStackFile, for ports that can't map files
+============
+*/
+qboolean COM_MapTempFile (char *path, filemap_t *map)
+{
+	return COM_MapPath (path, map, true);
+}
+
+/*
+============
+COM_MapOSFile
+
+Same as COM_MapFile for a file outside the search path
+============
+*/
+qboolean COM_MapOSFile (char *netpath, filemap_t *map)
+{
+	int		h, len;
+	qboolean	ok;
+
+	memset (map, 0, sizeof(*map));
+
+	len = Sys_FileOpenRead (netpath, &h);
+	if (len == -1 || h == -1)
+		return false;
+
+	ok = COM_MapHandle (h, 0, len, map);
+	Sys_FileClose (h);
+
+	return ok;
+}
+
+/*
+============
+COM_UnmapFile
+============
+*/
+void COM_UnmapFile (filemap_t *map)
+{
+	if (!map->data)
+		return;
+
+	if (map->mapped)
+	{
+		Sys_FileUnmap (map->data, map->filepos, map->len);
+		map->data = NULL;
+	}
+	else
+		COM_FreeCopy (map);
+}
+
 /*
 =================
 COM_LoadPackFile
@@ -1674,6 +2070,36 @@ pack_t *COM_LoadPackFile (char *packfile)
 }
 
 
+/*
+================
+COM_AddZipFiles
+
+Adds the .pk3 files in a game directory in name order, so later names take
+precedence, and after the paks so they take precedence over those
+================
+*/
+static void COM_AddZipFiles (char *dir)
+{
+	char			names[MAX_ZIPS_IN_DIR][MAX_QPATH];
+	char			zipfile[MAX_OSPATH];
+	searchpath_t	*search;
+	zipfile_t		*zip;
+	int				i, count;
+
+	count = Zip_FindArchives (dir, names, MAX_ZIPS_IN_DIR);
+	for (i=0 ; i<count ; i++)
+	{
+		sprintf (zipfile, "%s/%s", dir, names[i]);
+		zip = Zip_Open (zipfile);
+		if (!zip)
+			continue;
+		search = Hunk_Alloc (sizeof(searchpath_t));
+		search->zip = zip;
+		search->next = com_searchpaths;
+		com_searchpaths = search;
+	}
+}
+
 /*
 ================
 COM_AddGameDirectory
@@ -1723,6 +2149,9 @@ void COM_AddGameDirectory (char *dir)
 		com_searchpaths = search;
 	}
 	*/
+
+	COM_AddZipFiles (dir);
+
 //
 // add the contents of the parms.txt file to the end of the command line
 //
@@ -1818,6 +2247,12 @@ void COM_InitFilesystem (void)
 				if (!search->pack)
 					Sys_Error ("Couldn't load packfile: %s", com_argv[i]);
 			}
+			else if ( !Q_strcasecmp(COM_FileExtension(com_argv[i]), "pk3") )
+			{
+				search->zip = Zip_Open (com_argv[i]);
+				if (!search->zip)
+					Sys_Error ("Couldn't load zipfile: %s", com_argv[i]);
+			}
 			else
 				strcpy (search->filename, com_argv[i]);
 			search->next = com_searchpaths;
@@ -1827,6 +2262,8 @@ void COM_InitFilesystem (void)
 
 	if (COM_CheckParm ("-proghack"))
 		proghack = true;
+
+	COM_RebuildIndex ();
 }
 
 void Q_strncpyz (char *dest, char *src, size_t size)
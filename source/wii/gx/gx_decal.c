@@ -1,4 +1,5 @@
 #include "../../quakedef.h"
+#include "../../arena.h"
 
 #define DEFAULT_NUM_DECALS      1024 //*4
 #define ABSOLUTE_MIN_DECALS		256
@@ -46,7 +47,11 @@ float RandomMinMax (float min, float max)
 
 int DecalClipPolygon (int vertexCount, vec3_t *vertices, vec3_t *newVertex)
 {
-	vec3_t	tempVertex[64];
+	vec3_t	*tempVertex;
+	int		mark;
+
+	mark = Arena_Mark (&cl_arena);
+	tempVertex = (vec3_t *) Arena_Alloc (&cl_arena, (vertexCount + 6) * sizeof(vec3_t));
 
 	// Clip against all six planes
 	int count = DecalClipPolygonAgainstPlane (&leftPlane, vertexCount, vertices, tempVertex);
@@ -71,6 +76,7 @@ int DecalClipPolygon (int vertexCount, vec3_t *vertices, vec3_t *newVertex)
 		}
 	}
 
+	Arena_Release (&cl_arena, mark);
 	return count;
 }
 
@@ -78,8 +84,12 @@ int DecalClipPolygonAgainstPlane (plane_t *plane, int vertexCount, vec3_t *verte
 {
 	int		a, b, c, count, negativeCount = 0;
 	float	t;
-	qboolean negative[65];
+	qboolean *negative;
 	vec3_t	v1, v2;
+	int		mark;
+
+	mark = Arena_Mark (&cl_arena);
+	negative = (qboolean *) Arena_Alloc (&cl_arena, vertexCount * sizeof(qboolean));
 
 	// Classify vertices
 	for (a = 0 ; a < vertexCount ; a++)
@@ -91,7 +101,10 @@ int DecalClipPolygonAgainstPlane (plane_t *plane, int vertexCount, vec3_t *verte
 
 	// Discard this polygon if it's completely culled
 	if (negativeCount == vertexCount)
+	{
+		Arena_Release (&cl_arena, mark);
 		return 0;
+	}
 
 	count = 0;
 	for (b = 0 ; b < vertexCount ; b++)
@@ -143,6 +156,8 @@ int DecalClipPolygonAgainstPlane (plane_t *plane, int vertexCount, vec3_t *verte
 		}
 	}
 
+	Arena_Release (&cl_arena, mark);
+
 	// Return number of vertices in clipped polygon
 	return count;
 }
@@ -188,8 +203,9 @@ const double decalEpsilon = 0.001;
 void DecalClipLeaf (decal_t *dec, mleaf_t *leaf)
 {
  	int			c;
-	vec3_t		newVertex[64], t3;
+	vec3_t		*newVertex, t3;
 	msurface_t	**surf;
+	int			mark;
 
 	c = leaf->nummarksurfaces;
 	surf = leaf->firstmarksurface;
@@ -201,6 +217,10 @@ void DecalClipLeaf (decal_t *dec, mleaf_t *leaf)
 		glpoly_t *poly;
 
 		poly = (*surf)->polys;
+
+		// each of the six clip planes can add a vertex
+		mark = Arena_Mark (&cl_arena);
+		newVertex = (vec3_t *) Arena_Alloc (&cl_arena, (poly->numverts + 6) * sizeof(vec3_t));
 		for (i = 0 ; i < poly->numverts ; i++)
 		{
 			newVertex[i][0] = poly->verts[i][0];
@@ -218,8 +238,12 @@ void DecalClipLeaf (decal_t *dec, mleaf_t *leaf)
 		{
 			count = DecalClipPolygon (poly->numverts, newVertex, newVertex);
 			if (count != 0 && !DecalAddPolygon(dec, count, newVertex))
+			{
+				Arena_Release (&cl_arena, mark);
 				break;
+			}
 		}
+		Arena_Release (&cl_arena, mark);
 	}
 }
 
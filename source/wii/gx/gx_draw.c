@@ -1213,7 +1213,7 @@ void Draw_Crosshair (void)
 		}
 	}
 	
-   	if (Hitmark_Time > sv.time) {
+   	if (Hitmark_Time > cl.svtime) {
 		
 		if ((cl.stats[STAT_ZOOM] == 1 && ads_center.value) || (cl.stats[STAT_ZOOM] == 2 && sniper_center.value)) {
 			Draw_ColoredStretchPic ((vid.width - 12)/2, (vid.height - 12)/2, hitmark, 24, 24, 255, 255, 255, 225);
@@ -1231,14 +1231,14 @@ void Draw_Crosshair (void)
 	
 	float col;
 
-	if (sv_player->v.facingenemy == 1) {
+	if (cl.facingenemy == 1) {
 		col = 0;
 	} else {
 		col = 255;
 	}
 
 	// crosshair moving
-	if ((crosshair_spread_time > sv.time && crosshair_spread_time) || croshhairmoving == true)
+	if ((crosshair_spread_time > cl.svtime && crosshair_spread_time) || croshhairmoving == true)
     {
         cur_spread = cur_spread + 4;
 		if (cur_spread >= CrossHairMaxSpread())
@@ -1249,7 +1249,7 @@ void Draw_Crosshair (void)
 			crosshair_opacity = 155;
     }
 	// crosshair not moving
-    else if ((crosshair_spread_time < sv.time && crosshair_spread_time) || croshhairmoving == false)
+    else if ((crosshair_spread_time < cl.svtime && crosshair_spread_time) || croshhairmoving == false)
     {
         cur_spread = cur_spread - 2;
 		if (cur_spread <= 0) {
@@ -1281,9 +1281,9 @@ void Draw_Crosshair (void)
 		if (CrossHairMaxSpread() < crosshair_offset)
 			crosshair_offset = CrossHairMaxSpread()*1.5f;
 
-		if (sv_player->v.view_ofs[2] == 8) {
+		if (cl.viewofs == 8) {
 			crosshair_offset *= 0.80;
-		} else if (sv_player->v.view_ofs[2] == -10) {
+		} else if (cl.viewofs == -10) {
 			crosshair_offset *= 0.65;
 		}
 		
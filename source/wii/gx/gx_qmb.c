@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // gx_qmb.c
 
 #include "../../quakedef.h"
+#include "../../prof.h"
 //#define	DEFAULT_NUM_PARTICLES		8192
 #define	ABSOLUTE_MIN_PARTICLES      512
 #define	ABSOLUTE_MAX_PARTICLES      6144
@@ -1473,6 +1474,8 @@ void QMB_DrawParticles (void)
 	if (!qmb_initialized)
 		return;
 
+	PROF_BEGIN (QMB_DrawParticles);
+
 	particle_time = cl.time;
 
 	if (!cl.paused && key_dest == key_game)
@@ -1835,6 +1838,8 @@ void QMB_DrawParticles (void)
 	//glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
 	GX_SetTevOp(GX_TEVSTAGE0, GX_REPLACE);
 	//glShadeModel (GL_SMOOTH);
+
+	PROF_END (QMB_DrawParticles);
 }
 
 void QMB_Shockwave_Splash(vec3_t org, int radius)
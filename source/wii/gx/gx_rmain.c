@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_main.c
 
 #include "../../quakedef.h"
+#include "../../prof.h"
 
 extern vec3_t lightcolor; // LordHavoc: .lit support to the definitions at the top
 
@@ -1355,6 +1356,8 @@ void R_DrawEntitiesOnList (void)
 
 	if (!r_drawentities.value)
 		return;
+
+	PROF_BEGIN (R_DrawEntitiesOnList);
 	
 	int zHackCount = 0;
 	doZHack = 0;
@@ -1435,6 +1438,8 @@ void R_DrawEntitiesOnList (void)
 				break;
 		}
 	}
+
+	PROF_END (R_DrawEntitiesOnList);
 }
 
 /*
@@ -2028,6 +2033,8 @@ void R_RenderView (void)
 	if (r_norefresh.value)
 		return;
 
+	PROF_BEGIN (R_RenderView);
+
 	if (!r_worldentity.model || !cl.worldmodel)
 		Sys_Error ("R_RenderView: NULL worldmodel");
 
@@ -2069,4 +2076,6 @@ void R_RenderView (void)
 		time2 = Sys_FloatTime ();
 		Con_Printf ("%3i ms  %4i wpoly %4i epoly\n", (int)((time2-time1)*1000), c_brush_polys, c_alias_polys); 
 	}
+
+	PROF_END (R_RenderView);
 }
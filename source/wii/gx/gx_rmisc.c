@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // r_misc.c
 
 #include "../../quakedef.h"
+#include "../../loadtrace.h"
 
 cvar_t		gl_cshiftpercent = {"gl_cshiftpercent", "100", false};
 
@@ -366,7 +367,12 @@ void R_NewMap (void)
 	R_ClearParticles ();
 	R_ClearDecals();
 
+	// the models are in, drop the textures none of them took over
+	GL_PurgeTextures ();
+
+	LoadTrace_Begin ("GL_BuildLightmaps", NULL);
 	GL_BuildLightmaps ();
+	LoadTrace_End ();
 	
 	Sky_NewMap (); //johnfitz -- skybox in worldspawn
 	Fog_NewMap (); // johnfitz -- global fog in worldspawn
@@ -22,6 +22,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // screen.c -- master for refresh, status bar, console, chat, notify, etc
 
 #include "../../quakedef.h"
+#include "../../prof.h"
 #include <limits.h>
 
 /*
@@ -428,12 +429,12 @@ void SCR_UsePrint (int type, int cost, int weapon)
 			button_pic_x = getTextWidth("Hold", 1.5);
 			break;
 		case 3://ammo
-			strcpy(s, va("Hold %s to buy Ammo for %s\n", GetUseButtonL(), pr_strings+sv_player->v.Weapon_Name_Touch));
+			strcpy(s, va("Hold %s to buy Ammo for %s\n", GetUseButtonL(), cl.touchname));
 			strcpy(c, va("[Cost: %i]\n", cost));
 			button_pic_x = getTextWidth("Hold", 1.5);
 			break;
 		case 4://weapon
-			strcpy(s, va("Hold %s to buy %s\n", GetUseButtonL(), pr_strings+sv_player->v.Weapon_Name_Touch));
+			strcpy(s, va("Hold %s to buy %s\n", GetUseButtonL(), cl.touchname));
 			strcpy(c, va("[Cost: %i]\n", cost));
 			button_pic_x = getTextWidth("Hold", 1.5);
 			break;
@@ -448,7 +449,7 @@ void SCR_UsePrint (int type, int cost, int weapon)
 			button_pic_x = getTextWidth("Hold", 1.5);
 			break;
 		case 7://box take
-			strcpy(s, va("Hold %s for %s\n", GetUseButtonL(), pr_strings+sv_player->v.Weapon_Name_Touch));
+			strcpy(s, va("Hold %s for %s\n", GetUseButtonL(), cl.touchname));
 			strcpy(c, "");
 			button_pic_x = getTextWidth("Hold", 1.5);
 			break;
@@ -1759,6 +1760,8 @@ void SCR_UpdateScreen (void)
 	
 	Fog_DisableGFog ();
 
+	PROF_BEGIN (SCR_2D);
+
 	GL_Set2D ();
 	
 	Draw_Crosshair ();
@@ -1776,6 +1779,7 @@ void SCR_UpdateScreen (void)
 	
 	//muff - to show FPS on screen
 	SCR_DrawFPS ();
+	PROF_DRAWGRAPH ();
 	SCR_DrawPause ();
 	SCR_CheckDrawCenterString ();
 	SCR_CheckDrawUseString ();
@@ -1789,6 +1793,8 @@ void SCR_UpdateScreen (void)
 	}
 	
 	Draw_LoadingFill();
+
+	PROF_END (SCR_2D);
 	
 	V_UpdatePalette ();
 
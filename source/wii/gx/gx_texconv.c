@@ -0,0 +1,202 @@
+/*
+Copyright (C) 2008 Eluan Costa Miranda
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// gx_texconv.c -- the texture conversions the renderer shares with texcook
+//
+// Plain cpu work with no GX state, so texcook can build the same code on
+// the host and store what GL_Upload32 would have put in texture memory.
+
+#ifdef __WII__
+#include "../../quakedef.h"
+#endif
+
+#include "gx_texconv.h"
+
+/*
+================
+GL_ResampleTexture
+================
+*/
+void GL_ResampleTexture (unsigned *in, int inwidth, int inheight, unsigned *out,  int outwidth, int outheight)
+{
+	int		i, j;
+	unsigned	*inrow;
+	unsigned	frac, fracstep;
+
+	fracstep = inwidth*0x10000/outwidth;
+	for (i=0 ; i<outheight ; i++, out += outwidth)
+	{
+		inrow = in + inwidth*(i*inheight/outheight);
+		frac = fracstep >> 1;
+		for (j=0 ; j<outwidth ; j+=4)
+		{
+			out[j] = inrow[frac>>16];
+			frac += fracstep;
+			out[j+1] = inrow[frac>>16];
+			frac += fracstep;
+			out[j+2] = inrow[frac>>16];
+			frac += fracstep;
+			out[j+3] = inrow[frac>>16];
+			frac += fracstep;
+		}
+	}
+}
+
+int GX_RGBA_To_RGB5A3(u32 srccolor, qboolean flip)
+{
+	u16 color;
+
+	u32 r, g, b, a;
+	if (flip){
+		r = srccolor & 0xFF;
+		srccolor >>= 8;
+		g = srccolor & 0xFF;
+		srccolor >>= 8;
+		b = srccolor & 0xFF;
+		srccolor >>= 8;
+		a = srccolor & 0xFF;
+	} else {
+		a = srccolor & 0xFF;
+		srccolor >>= 8;
+		b = srccolor & 0xFF;
+		srccolor >>= 8;
+		g = srccolor & 0xFF;
+		srccolor >>= 8;
+		r = srccolor & 0xFF;
+	}
+	
+	if (a > 0xe0)
+	{
+		r = r >> 3;
+		g = g >> 3;
+		b = b >> 3;
+
+		color = (r << 10) | (g << 5) | b;
+		color |= 0x8000;
+	}
+	else
+	{
+		r = r >> 4;
+		g = g >> 4;
+		b = b >> 4;
+		a = a >> 5;
+
+		color = (a << 12) | (r << 8) | (g << 4) | b;
+	}
+
+	return color;
+}
+
+int GX_LinearToTiled(int x, int y, int width)
+{
+	int x0, x1, y0, y1;
+	int offset;
+
+	x0 = x & 3;
+	x1 = x >> 2;
+	y0 = y & 3;
+	y1 = y >> 2;
+	offset = x0 + 4 * y0 + 16 * x1 + 4 * width * y1;
+
+	return offset;
+}
+
+
+/*
+===============
+GL_CopyRGB5A3
+
+Converts from linear to tiled during copy
+===============
+*/
+void GX_CopyRGB5A3(u16 *dest, u32 *src, int x1, int y1, int x2, int y2, int src_width)
+{
+	int i, j;
+
+	for (i = y1; i < y2; i++)
+		for (j = x1; j < x2; j++)
+			dest[GX_LinearToTiled(j, i, src_width)] = src[j + i * src_width];
+}
+
+/*
+===============
+GL_CopyRGB5A3
+
+Converts from linear RGBA8 to tiled RGB5A3 during copy
+===============
+*/
+void GX_CopyRGBA8_To_RGB5A3(u16 *dest, u32 *src, int x1, int y1, int x2, int y2, int src_width, qboolean flip)
+{
+	int i, j;
+
+	for (i = y1; i < y2; i++)
+		for (j = x1; j < x2; j++)
+			dest[GX_LinearToTiled(j, i, src_width)] = GX_RGBA_To_RGB5A3(src[j + i * src_width], flip);
+}
+
+/*
+================
+GL_MipMap
+
+Operates in place, quartering the size of the texture
+================
+*/
+void GX_MipMap (byte *in, int width, int height)
+{
+	int		i, j;
+	byte	*out;
+
+	width <<=2;
+	height >>= 1;
+	out = in;
+	for (i=0 ; i<height ; i++, in+=width)
+	{
+		for (j=0 ; j<width ; j+=8, out+=4, in+=8)
+		{
+			out[0] = (in[0] + in[4] + in[width+0] + in[width+4])>>2;
+			out[1] = (in[1] + in[5] + in[width+1] + in[width+5])>>2;
+			out[2] = (in[2] + in[6] + in[width+2] + in[width+6])>>2;
+			out[3] = (in[3] + in[7] + in[width+3] + in[width+7])>>2;
+		}
+	}
+}
+
+
+/*
+================
+GX_ScaledSize
+================
+*/
+void GX_ScaledSize (int width, int height, int maxsize, int *scaled_width, int *scaled_height)
+{
+	int	sw, sh;
+
+	for (sw = 1 << 5 ; sw < width ; sw<<=1)
+		;
+	for (sh = 1 << 5 ; sh < height ; sh<<=1)
+		;
+
+	if (sw > maxsize)
+		sw = maxsize;
+	if (sh > maxsize)
+		sh = maxsize;
+
+	*scaled_width = sw;
+	*scaled_height = sh;
+}
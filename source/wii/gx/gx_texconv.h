@@ -0,0 +1,54 @@
+/*
+Copyright (C) 2008 Eluan Costa Miranda
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// gx_texconv.h -- the texture conversions the renderer shares with texcook
+
+#ifndef __GX_TEXCONV_H__
+#define __GX_TEXCONV_H__
+
+// on the Wii quakedef.h comes first, texcook has its own stand-in
+#ifdef __WII__
+#include <gccore.h>
+#else
+#include "../../linux/texcook_host.h"
+
+#define GX_TF_RGB5A3	0x5
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+void GL_ResampleTexture (unsigned *in, int inwidth, int inheight, unsigned *out,  int outwidth, int outheight);
+
+// the power of two GL_Upload32 stores an image at
+void GX_ScaledSize (int width, int height, int maxsize, int *scaled_width, int *scaled_height);
+
+int GX_RGBA_To_RGB5A3(u32 srccolor, qboolean flip);
+int GX_LinearToTiled(int x, int y, int width);
+void GX_CopyRGB5A3(u16 *dest, u32 *src, int x1, int y1, int x2, int y2, int src_width);
+void GX_CopyRGBA8_To_RGB5A3(u16 *dest, u32 *src, int x1, int y1, int x2, int y2, int src_width, qboolean flip);
+void GX_MipMap (byte *in, int width, int height);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif	// __GX_TEXCONV_H__
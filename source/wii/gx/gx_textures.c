@@ -24,6 +24,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <ogc/lwp_mutex.h>
 
 #include "../../quakedef.h"
+#include "../../texcook.h"
+#include "../../loadtrace.h"
+#include "gx_texconv.h"
 
 #include <gccore.h>
 #include <malloc.h>
@@ -36,6 +39,15 @@ cvar_t 		vid_retromode = {"vid_retromode", "1", false};
 gltexture_t	gltextures[MAX_GLTEXTURES];
 int			numgltextures;
 
+// Identifiers hash to their slots.  Below numgltextures an unused slot
+// waits on the free stack; the lightmaps always go on the end, in one run.
+// A texture the last map loaded stays until the next one has, which takes
+// over those it loads again (same name, same lhcsum).
+#define	TEXTURE_HASH_SIZE	256
+static int	gltextures_hash[TEXTURE_HASH_SIZE];
+static int	gltextures_free[MAX_GLTEXTURES];
+static int	gltextures_numfree;
+
 heap_cntrl texture_heap;
 void *texture_heap_ptr;
 u32 texture_heap_size;
@@ -79,8 +91,12 @@ void	R_InitTextures (void)
 	R_InitTextureHeap();
 
 	Cvar_RegisterVariable (&gl_max_size);
+	TexCook_Init ();
 
 	numgltextures = 0;
+	gltextures_numfree = 0;
+	for (x=0 ; x<TEXTURE_HASH_SIZE ; x++)
+		gltextures_hash[x] = -1;
 	
 // create a simple checkerboard texture for the default
 	r_notexture_mip = Hunk_AllocName (sizeof(texture_t) + 16*16+8*8+4*4+2*2, "notexture");
@@ -169,173 +185,195 @@ void QGX_BlendMap(qboolean state)
 
 //====================================================================
 
+static unsigned GL_TextureHash (char *identifier)
+{
+	unsigned	h;
+
+	for (h = 0 ; *identifier ; identifier++)
+		h = h * 31 + *identifier;
+
+	return h & (TEXTURE_HASH_SIZE - 1);
+}
+
+static void GL_LinkTexture (gltexture_t *glt)
+{
+	unsigned	h = GL_TextureHash (glt->identifier);
+
+	glt->hashnext = gltextures_hash[h];
+	gltextures_hash[h] = glt->texnum;
+}
+
 /*
 ================
-GL_FindTexture
+GL_FreeTexture
 ================
 */
-int GL_FindTexture (char *identifier)
+static void GL_FreeTexture (gltexture_t *glt)
+{
+	int		*link;
+
+	for (link = &gltextures_hash[GL_TextureHash (glt->identifier)] ; *link != glt->texnum ; link = &gltextures[*link].hashnext)
+		;
+	*link = glt->hashnext;
+
+	if (!__lwp_heap_free(&texture_heap, glt->data))
+		Sys_Error("GL_FreeTexture: Error freeing data.");
+
+	glt->data = NULL;
+	glt->used = false;
+	glt->refcount = 0;
+	gltextures_free[gltextures_numfree++] = glt->texnum;
+}
+
+/*
+================
+GL_TrimTextures
+
+Gives the unused slots at the end back and restacks the rest
+================
+*/
+static void GL_TrimTextures (void)
 {
 	int		i;
-	gltexture_t	*glt;
 
-	for (i=0, glt=gltextures ; i<numgltextures ; i++, glt++)
-	{
-		if (gltextures[i].used)
-			if (!strcmp (identifier, glt->identifier))
-				return gltextures[i].texnum;
-	}
+	while (numgltextures > 0 && !gltextures[numgltextures - 1].used)
+		numgltextures--;
 
-	return -1;
+	gltextures_numfree = 0;
+	for (i = numgltextures - 1 ; i >= 0 ; i--)
+		if (!gltextures[i].used)
+			gltextures_free[gltextures_numfree++] = i;
 }
 
 /*
 ================
-GL_ResampleTexture
+GL_EvictTexture
+
+Frees a texture nothing holds any more, false if there is none
 ================
 */
-void GL_ResampleTexture (unsigned *in, int inwidth, int inheight, unsigned *out,  int outwidth, int outheight)
+static qboolean GL_EvictTexture (void)
 {
-	int		i, j;
-	unsigned	*inrow;
-	unsigned	frac, fracstep;
+	int			i;
+	gltexture_t	*glt;
 
-	fracstep = inwidth*0x10000/outwidth;
-	for (i=0 ; i<outheight ; i++, out += outwidth)
+	for (i=0, glt=gltextures ; i<numgltextures ; i++, glt++)
 	{
-		inrow = in + inwidth*(i*inheight/outheight);
-		frac = fracstep >> 1;
-		for (j=0 ; j<outwidth ; j+=4)
+		if (glt->used && !glt->keep && !glt->refcount)
 		{
-			out[j] = inrow[frac>>16];
-			frac += fracstep;
-			out[j+1] = inrow[frac>>16];
-			frac += fracstep;
-			out[j+2] = inrow[frac>>16];
-			frac += fracstep;
-			out[j+3] = inrow[frac>>16];
-			frac += fracstep;
+			GL_FreeTexture (glt);
+			return true;
 		}
 	}
+
+	return false;
 }
 
-int GX_RGBA_To_RGB5A3(u32 srccolor, qboolean flip)
-{
-	u16 color;
-
-	u32 r, g, b, a;
-	if (flip){
-		r = srccolor & 0xFF;
-		srccolor >>= 8;
-		g = srccolor & 0xFF;
-		srccolor >>= 8;
-		b = srccolor & 0xFF;
-		srccolor >>= 8;
-		a = srccolor & 0xFF;
-	} else {
-		a = srccolor & 0xFF;
-		srccolor >>= 8;
-		b = srccolor & 0xFF;
-		srccolor >>= 8;
-		g = srccolor & 0xFF;
-		srccolor >>= 8;
-		r = srccolor & 0xFF;
-	}
-	
-	if (a > 0xe0)
-	{
-		r = r >> 3;
-		g = g >> 3;
-		b = b >> 3;
+/*
+================
+GL_AllocTextureData
 
-		color = (r << 10) | (g << 5) | b;
-		color |= 0x8000;
-	}
-	else
-	{
-		r = r >> 4;
-		g = g >> 4;
-		b = b >> 4;
-		a = a >> 5;
+What the last map left behind gives way to the textures of this one
+================
+*/
+static void *GL_AllocTextureData (u32 size)
+{
+	void	*data;
 
-		color = (a << 12) | (r << 8) | (g << 4) | b;
-	}
+	data = __lwp_heap_allocate (&texture_heap, size);
+	while (!data && GL_EvictTexture ())
+		data = __lwp_heap_allocate (&texture_heap, size);
 
-	return color;
+	return data;
 }
 
-int GX_LinearToTiled(int x, int y, int width)
-{
-	int x0, x1, y0, y1;
-	int offset;
+/*
+================
+GL_ReleaseTextures
 
-	x0 = x & 3;
-	x1 = x >> 2;
-	y0 = y & 3;
-	y1 = y >> 2;
-	offset = x0 + 4 * y0 + 16 * x1 + 4 * width * y1;
+Mod_ClearAll: the models let go of everything they loaded.  The textures
+stay until GL_PurgeTextures in case the next map loads them again
+================
+*/
+void GL_ReleaseTextures (void)
+{
+	int		i;
 
-	return offset;
+	for (i=0 ; i<numgltextures ; i++)
+		gltextures[i].refcount = 0;
 }
 
-
 /*
-===============
-GL_CopyRGB5A3
+================
+GL_PurgeTextures
 
-Converts from linear to tiled during copy
-===============
+Frees what the new map did not take over, before its lightmaps go on
+================
 */
-void GX_CopyRGB5A3(u16 *dest, u32 *src, int x1, int y1, int x2, int y2, int src_width)
+void GL_PurgeTextures (void)
 {
-	int i, j;
+	int			i, freed;
+	gltexture_t	*glt;
 
-	for (i = y1; i < y2; i++)
-		for (j = x1; j < x2; j++)
-			dest[GX_LinearToTiled(j, i, src_width)] = src[j + i * src_width];
+	freed = 0;
+	for (i=0, glt=gltextures ; i<numgltextures ; i++, glt++)
+	{
+		if (glt->used && !glt->keep && !glt->refcount)
+		{
+			GL_FreeTexture (glt);
+			freed++;
+		}
+	}
+
+	GL_TrimTextures ();
+	GX_InvalidateTexAll ();
+
+	Con_DPrintf ("Textures: %i freed, %i kept\n", freed, numgltextures - gltextures_numfree);
 }
 
 /*
-===============
-GL_CopyRGB5A3
-
-Converts from linear RGBA8 to tiled RGB5A3 during copy
-===============
+================
+GL_FindTexture
+================
 */
-void GX_CopyRGBA8_To_RGB5A3(u16 *dest, u32 *src, int x1, int y1, int x2, int y2, int src_width, qboolean flip)
+int GL_FindTexture (char *identifier)
 {
-	int i, j;
+	int		i;
+
+	if (!identifier[0])
+		return -1;
+
+	for (i = gltextures_hash[GL_TextureHash (identifier)] ; i >= 0 ; i = gltextures[i].hashnext)
+		if (!strcmp (identifier, gltextures[i].identifier))
+			return i;
+
+	return -1;
+}
 
-	for (i = y1; i < y2; i++)
-		for (j = x1; j < x2; j++)
-			dest[GX_LinearToTiled(j, i, src_width)] = GX_RGBA_To_RGB5A3(src[j + i * src_width], flip);
+static void GL_ReferenceTexture (gltexture_t *glt, qboolean keep)
+{
+	glt->refcount++;
+	if (keep)
+		glt->keep = true;
 }
 
 /*
 ================
-GL_MipMap
+GL_ReuseTexture
 
-Operates in place, quartering the size of the texture
+The texture loaded under the identifier with one more reference, or -1,
+so a loader can skip decoding an image it already has
 ================
 */
-void GX_MipMap (byte *in, int width, int height)
+int GL_ReuseTexture (char *identifier, qboolean keep)
 {
-	int		i, j;
-	byte	*out;
+	int		texnum;
 
-	width <<=2;
-	height >>= 1;
-	out = in;
-	for (i=0 ; i<height ; i++, in+=width)
-	{
-		for (j=0 ; j<width ; j+=8, out+=4, in+=8)
-		{
-			out[0] = (in[0] + in[4] + in[width+0] + in[width+4])>>2;
-			out[1] = (in[1] + in[5] + in[width+1] + in[width+5])>>2;
-			out[2] = (in[2] + in[6] + in[width+2] + in[width+6])>>2;
-			out[3] = (in[3] + in[7] + in[width+3] + in[width+7])>>2;
-		}
-	}
+	texnum = GL_FindTexture (identifier);
+	if (texnum >= 0)
+		GL_ReferenceTexture (&gltextures[texnum], keep);
+
+	return texnum;
 }
 
 // Given w,h,level,and bpp, returns the offset to the mipmap at level "level"
@@ -353,6 +391,25 @@ static int _calc_mipmap_offset(int level, int w, int h, int b) {
 	return size;
 }
 
+/*
+===============
+GL_InitTexObj
+
+Flushes a texture without mipmaps out to memory and points its texture
+object at it
+===============
+*/
+static void GL_InitTexObj (gltexture_t *destination, u32 texbuffs)
+{
+	DCFlushRange(destination->data, texbuffs/*scaled_width * scaled_height * 2*/);
+	GX_InvalidateTexAll();
+	GX_InitTexObj(&destination->gx_tex, destination->data, destination->scaled_width, destination->scaled_height, GX_TF_RGB5A3, GX_REPEAT, GX_REPEAT, /*mipmap ? GX_TRUE :*/ GX_FALSE);
+	// do not init mipmaps for lightmaps
+	if (destination->type != 1) {
+		GX_InitTexObjLOD(&destination->gx_tex, GX_LIN_MIP_LIN, GX_LIN_MIP_LIN, 0, 0, 0, GX_ENABLE, GX_ENABLE, GX_ANISO_2);
+	}
+}
+
 // FIXME, temporary
 static	unsigned	scaled[640*480];
 static	unsigned	trans[640*480];
@@ -372,15 +429,7 @@ void GL_Upload32 (gltexture_t *destination, unsigned *data, int width, int heigh
 	int max_mip_level;
 	//heap_iblock info;
 
-	for (scaled_width = 1 << 5 ; scaled_width < width ; scaled_width<<=1)
-		;
-	for (scaled_height = 1 << 5 ; scaled_height < height ; scaled_height<<=1)
-		;
-
-	if (scaled_width > gl_max_size.value)
-		scaled_width = gl_max_size.value;
-	if (scaled_height > gl_max_size.value)
-		scaled_height = gl_max_size.value;
+	GX_ScaledSize (width, height, (int)gl_max_size.value, &scaled_width, &scaled_height);
 	
 	if (scaled_width * scaled_height > sizeof(scaled)/4)
 		Sys_Error ("GL_Upload32: too big");
@@ -414,7 +463,7 @@ void GL_Upload32 (gltexture_t *destination, unsigned *data, int width, int heigh
 	
 	//get exact buffer size of memory aligned on a 32byte boundery
 	texbuffs = GX_GetTexBufferSize (scaled_width, scaled_height, GX_TF_RGB5A3, mipmap ? GX_TRUE : GX_FALSE, max_mip_level);
-	destination->data = __lwp_heap_allocate(&texture_heap, texbuffs/*scaled_width * scaled_height * 2*/);	
+	destination->data = GL_AllocTextureData (texbuffs/*scaled_width * scaled_height * 2*/);	
 	//__lwp_heap_getinfo(&texture_heap, &info);
 	//Con_Printf ("tex buff size %d\n", texbuffs);
 	//Con_Printf("Used Heap: %dM\n", info.used_size / (1024*1024));
@@ -458,7 +507,7 @@ void GL_Upload32 (gltexture_t *destination, unsigned *data, int width, int heigh
 				Sys_Error ("Failed to free texture mem for mipmap");
 			
 			// reallocate in a section of memory big enough for mipmaps and copy in the OG texture buffer
-			destination->data = __lwp_heap_allocate (&texture_heap, texbuffs_mip);
+			destination->data = GL_AllocTextureData (texbuffs_mip);
 			memcpy(destination->data,tempbuf,texbuffs);
 			free (tempbuf);
 		}
@@ -518,13 +567,7 @@ void GL_Upload32 (gltexture_t *destination, unsigned *data, int width, int heigh
 		
 	} else {
 		GX_CopyRGBA8_To_RGB5A3((u16 *)destination->data, scaled, 0, 0, scaled_width, scaled_height, scaled_width, flipRGBA);	
-		DCFlushRange(destination->data, texbuffs/*scaled_width * scaled_height * 2*/);
-		GX_InvalidateTexAll();
-		GX_InitTexObj(&destination->gx_tex, destination->data, scaled_width, scaled_height, GX_TF_RGB5A3, GX_REPEAT, GX_REPEAT, /*mipmap ? GX_TRUE :*/ GX_FALSE);
-		// do not init mipmaps for lightmaps
-		if (destination->type != 1) {
-			GX_InitTexObjLOD(&destination->gx_tex, GX_LIN_MIP_LIN, GX_LIN_MIP_LIN, 0, max_mip_level, 0, GX_ENABLE, GX_ENABLE, GX_ANISO_2);
-		}
+		GL_InitTexObj (destination, texbuffs);
 	}
 }
 
@@ -607,65 +650,92 @@ GL_LoadTexture
 
 //Diabolickal TGA Begin
 
-int lhcsumtable[256];
-int GL_LoadTexture (char *identifier, int width, int height, byte *data, qboolean mipmap, qboolean alpha, qboolean keep, int bytesperpixel)
+/*
+================
+GL_TextureSlot
+
+The texture already loaded under the identifier, or a slot filled in for
+a new upload; loaded says which
+================
+*/
+static gltexture_t *GL_TextureSlot (char *identifier, int width, int height, int lhcsum, qboolean mipmap, qboolean keep, qboolean *loaded)
 {
-	int			i, s, lhcsum;
+	int			i;
 	gltexture_t	*glt;
-	// occurances. well this isn't exactly a checksum, it's better than that but
-	// not following any standards.
-	lhcsum = 0;
-	s = width*height*bytesperpixel;
-	
-	for (i = 0;i < 256;i++) lhcsumtable[i] = i + 1;
-	for (i = 0;i < s;i++) lhcsum += (lhcsumtable[data[i] & 255]++);
+
+	*loaded = false;
 
 	// see if the texture is allready present
-	if (identifier[0])
+	// ELUTODO: causes problems if we compare to a texture with NO name?
+	// sBTODO we definitely have issues with identifier strings. will investigate later..
+	i = GL_FindTexture (identifier);
+	if (i >= 0)
 	{
-		for (i=0, glt=gltextures ; i<numgltextures ; i++, glt++)
+		glt = &gltextures[i];
+		if (width != glt->width || height != glt->height)
 		{
-			if (glt->used)
-			{
-				// ELUTODO: causes problems if we compare to a texture with NO name?
-				// sBTODO we definitely have issues with identifier strings. will investigate later..
-				if (!strcmp (identifier, glt->identifier))
-				{
-					if (width != glt->width || height != glt->height)
-					{
-						Con_Printf ("GL_LoadTexture: cache mismatch, reloading");
-						if (!__lwp_heap_free(&texture_heap, glt->data))
-							Sys_Error("GL_ClearTextureCache: Error freeing data.");
-						goto reload; // best way to do it
-					}
-					return glt->texnum;
-				}
-			}
+			Con_Printf ("GL_LoadTexture: cache mismatch, reloading");
+			if (!__lwp_heap_free(&texture_heap, glt->data))
+				Sys_Error("GL_ClearTextureCache: Error freeing data.");
+			goto reload; // best way to do it
 		}
+		// one an earlier map left behind with other contents
+		if (lhcsum != glt->lhcsum && !glt->refcount && !glt->keep)
+		{
+			if (!__lwp_heap_free(&texture_heap, glt->data))
+				Sys_Error("GL_LoadTexture: Error freeing data.");
+			goto reload;
+		}
+		GL_ReferenceTexture (glt, keep);
+		*loaded = true;
+		return glt;
 	}
 
-	for (i = 0, glt = gltextures; i < numgltextures; i++, glt++)
-	{
-		if (!glt->used)
-			break;
-	}
-
-	if (i == MAX_GLTEXTURES)
+	if (!gltextures_numfree && numgltextures == MAX_GLTEXTURES && !GL_EvictTexture ())
 		Sys_Error ("GL_LoadTexture: numgltextures == MAX_GLTEXTURES\n");
 
-reload:
-	strcpy (glt->identifier, identifier);
-	
-	gltextures[glt->texnum].checksum = lhcsum;
-	gltextures[glt->texnum].lhcsum = lhcsum;
-	
+	if (gltextures_numfree)
+		i = gltextures_free[--gltextures_numfree];
+	else
+		i = numgltextures;
+
+	glt = &gltextures[i];
 	glt->texnum = i;
+	strcpy (glt->identifier, identifier);
+	GL_LinkTexture (glt);
+
+reload:
+	glt->checksum = lhcsum;
+	glt->lhcsum = lhcsum;
+
 	glt->width = width;
 	glt->height = height;
 	glt->mipmap = mipmap;
 	glt->type = 0;
 	glt->keep = keep;
 	glt->used = true;
+	glt->refcount = 1;
+
+	return glt;
+}
+
+int lhcsumtable[256];
+int GL_LoadTexture (char *identifier, int width, int height, byte *data, qboolean mipmap, qboolean alpha, qboolean keep, int bytesperpixel)
+{
+	int			i, s, lhcsum;
+	gltexture_t	*glt;
+	qboolean	loaded;
+	// occurances. well this isn't exactly a checksum, it's better than that but
+	// not following any standards.
+	lhcsum = 0;
+	s = width*height*bytesperpixel;
+	
+	for (i = 0;i < 256;i++) lhcsumtable[i] = i + 1;
+	for (i = 0;i < s;i++) lhcsum += (lhcsumtable[data[i] & 255]++);
+
+	glt = GL_TextureSlot (identifier, width, height, lhcsum, mipmap, keep, &loaded);
+	if (loaded)
+		return glt->texnum;
 	
 	GL_Bind0 (glt->texnum);
 	
@@ -686,6 +756,55 @@ reload:
 	return glt->texnum;
 }
 
+/*
+================
+GL_LoadCookedTexture
+
+Takes what GL_LoadTexture would have made of an image from texcook, or
+returns -1 if it was cooked for another gl_max_size
+================
+*/
+static int GL_LoadCookedTexture (char *identifier, texcookhdr_t *cooked, qboolean keep)
+{
+	int			scaled_width, scaled_height;
+	u32			texbuffs;
+	gltexture_t	*glt;
+	qboolean	loaded;
+
+	GX_ScaledSize (cooked->width, cooked->height, (int)gl_max_size.value, &scaled_width, &scaled_height);
+	texbuffs = GX_GetTexBufferSize (scaled_width, scaled_height, GX_TF_RGB5A3, GX_FALSE, 0);
+
+	if (cooked->format != GX_TF_RGB5A3 || cooked->mipmaps
+		|| cooked->scaled_width != scaled_width || cooked->scaled_height != scaled_height
+		|| cooked->datasize != texbuffs)
+	{
+		Con_DPrintf ("%s was cooked for other texture settings\n", identifier);
+		return -1;
+	}
+
+	glt = GL_TextureSlot (identifier, cooked->width, cooked->height, cooked->checksum, false, keep, &loaded);
+	if (loaded)
+		return glt->texnum;
+
+	GL_Bind0 (glt->texnum);
+
+	glt->data = GL_AllocTextureData (texbuffs);
+	if (!glt->data)
+		Sys_Error("GL_LoadCookedTexture: Out of memory.");
+
+	glt->scaled_width = scaled_width;
+	glt->scaled_height = scaled_height;
+
+	// already tiled RGB5A3 in the console's byte order
+	memcpy (glt->data, cooked + 1, texbuffs);
+	GL_InitTexObj (glt, texbuffs);
+
+	if (glt->texnum == numgltextures)
+		numgltextures++;
+
+	return glt->texnum;
+}
+
 /*
 ======================
 GL_LoadLightmapTexture
@@ -710,6 +829,8 @@ int GL_LoadLightmapTexture (char *identifier, int width, int height, byte *data)
 	glt->type = 1;
 	glt->keep = false;
 	glt->used = true;
+	glt->refcount = 1;
+	GL_LinkTexture (glt);
 
 	GL_Upload32 (glt, (unsigned *)data, width, height, false /*mipmap?*/, false, false);
 
@@ -860,13 +981,12 @@ void GL_ClearTextureCache(void)
 			}
 			else
 			{
-				gltextures[i].used = false;
-				if (!__lwp_heap_free(&texture_heap, gltextures[i].data))
-					Sys_Error("GL_ClearTextureCache: Error freeing data.");
+				GL_FreeTexture (&gltextures[i]);
 			}
 		}
 	}
 
+	GL_TrimTextures ();
 	GX_InvalidateTexAll();
 }
 /*
@@ -1038,7 +1158,9 @@ byte* loadimagepixels (char* filename, qboolean complain, int matchwidth, int ma
 	return image;
 }
 
-int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean complain, qboolean mipmap, qboolean keep)
+static char *image_exts[] = TEXCOOK_WII_EXTS;
+
+static int R_LoadTextureImage (char* filename, int matchwidth, int matchheight, qboolean complain, qboolean mipmap, qboolean keep)
 {
 	int	f = 0;
 	int texnum;
@@ -1046,6 +1168,7 @@ int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean
 	char *texname = malloc(32);
 	byte *data;
 	byte *c;
+	texcookhdr_t *cooked;
 	
 	if (complain == false)
 		COM_StripExtension(filename, basename); // strip the extension to allow TGA
@@ -1062,6 +1185,21 @@ int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean
 	
 	int len = strlen(basename);
 	texname = basename + len - 20;
+
+	// still loaded, perhaps from the last map
+	texnum = GL_ReuseTexture (texname, keep);
+	if (texnum >= 0)
+		return texnum;
+
+	// a cooked copy skips the decode and the conversion
+	cooked = TexCook_Load (basename, TEXCOOK_WII, image_exts);
+	if (cooked)
+	{
+		texnum = GL_LoadCookedTexture (texname, cooked, keep);
+		free (cooked);
+		if (texnum >= 0)
+			return texnum;
+	}
 	
 	//Try PCX	
 	sprintf (name, "%s.pcx", basename);
@@ -1135,6 +1273,17 @@ int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean
 	return 0;
 }
 
+int loadtextureimage (char* filename, int matchwidth, int matchheight, qboolean complain, qboolean mipmap, qboolean keep)
+{
+	int texnum;
+
+	LoadTrace_Begin ("loadtextureimage", filename);
+	texnum = R_LoadTextureImage (filename, matchwidth, matchheight, complain, mipmap, keep);
+	LoadTrace_End ();
+
+	return texnum;
+}
+
 extern char	skybox_name[32];
 extern char skytexname[32];
 int loadskyboximage (char* filename, int matchwidth, int matchheight, qboolean complain, qboolean mipmap)
@@ -1148,6 +1297,7 @@ int loadskyboximage (char* filename, int matchwidth, int matchheight, qboolean c
 	
 	byte* data = (byte*)malloc(image_size * 4);
 	byte *c;
+	texcookhdr_t *cooked;
 	
 	if (complain == false)
 		COM_StripExtension(filename, basename); // strip the extension to allow TGA
@@ -1168,6 +1318,16 @@ int loadskyboximage (char* filename, int matchwidth, int matchheight, qboolean c
 
 	int len = strlen(basename);
 	texname = basename + len - 20;
+
+	// a cooked copy skips the decode and the conversion
+	cooked = TexCook_Load (basename, TEXCOOK_WII, image_exts);
+	if (cooked)
+	{
+		texnum = GL_LoadCookedTexture (texname, cooked, true);
+		free (cooked);
+		if (texnum >= 0)
+			return texnum;
+	}
 	
 	sprintf (name, "%s.pcx", basename);
 	COM_FOpenFile (name, &f);
@@ -284,6 +284,8 @@ typedef struct
 	qboolean	keep;
 
 	qboolean	used;
+	int			refcount;	// models holding it, kept ones are never freed
+	int			hashnext;	// next slot in the identifier's hash chain
 	
 	qboolean	islmp;
 	
@@ -309,6 +311,9 @@ int GL_LoadLightmapTexture (char *identifier, int width, int height, byte *data)
 void GL_UpdateTexture (int pic_id, char *identifier, int width, int height, byte *data, qboolean mipmap, qboolean alpha);
 void GL_UpdateLightmapTextureRegion (int pic_id, int width, int height, int xoffset, int yoffset, byte *data);
 int GL_FindTexture (char *identifier);
+int GL_ReuseTexture (char *identifier, qboolean keep);
+void GL_ReleaseTextures (void);
+void GL_PurgeTextures (void);
 void GL_SubdivideSurface (msurface_t *fa);
 void GL_MakeAliasModelDisplayLists (model_t *m, aliashdr_t *hdr);
 int R_LightPoint (vec3_t p);
@@ -175,6 +175,7 @@ static void init()
 		Sys_Error("Heap allocation failed");
 	}
 	memset(parms.membase, 0, parms.memsize);
+	Sys_Init();
 	Host_Init(&parms);
 
 #if TEST_CONNECTION
@@ -131,6 +131,8 @@ qsocket_t *NET_NewQSocket (void)
 	sock->driver = net_driverlevel;
 	sock->socket = 0;
 	sock->driverdata = NULL;
+	sock->clientcaps = 0;
+	sock->servercaps = 0;
 	sock->canSend = true;
 	sock->sendNext = false;
 	sock->lastMessageTime = net_time;
@@ -447,13 +449,6 @@ NET_CheckNewConnections
 ===================
 */
 
-struct
-{
-	double	time;
-	int		op;
-	long	session;
-} vcrConnect;
-
 qsocket_t *NET_CheckNewConnections (void)
 {
 	qsocket_t	*ret;
@@ -471,10 +466,7 @@ qsocket_t *NET_CheckNewConnections (void)
 		{
 			if (recording)
 			{
-				vcrConnect.time = host_time;
-				vcrConnect.op = VCR_OP_CONNECT;
-				vcrConnect.session = (long)ret;
-				Sys_FileWrite (vcrFile, &vcrConnect, sizeof(vcrConnect));
+				VCR_WriteOp (VCR_OP_CONNECT, ret);
 				Sys_FileWrite (vcrFile, ret->address, NET_NAMELEN);
 			}
 			return ret;
@@ -483,10 +475,7 @@ qsocket_t *NET_CheckNewConnections (void)
 	
 	if (recording)
 	{
-		vcrConnect.time = host_time;
-		vcrConnect.op = VCR_OP_CONNECT;
-		vcrConnect.session = 0;
-		Sys_FileWrite (vcrFile, &vcrConnect, sizeof(vcrConnect));
+		VCR_WriteOp (VCR_OP_CONNECT, NULL);
 	}
 
 	return NULL;
@@ -526,15 +515,6 @@ returns -1 if connection is invalid
 =================
 */
 
-struct
-{
-	double	time;
-	int		op;
-	long	session;
-	int		ret;
-	int		len;
-} vcrGetMessage;
-
 extern void PrintStats(qsocket_t *s);
 
 int	NET_GetMessage (qsocket_t *sock)
@@ -560,7 +540,7 @@ int	NET_GetMessage (qsocket_t *sock)
 		if (net_time - sock->lastMessageTime > net_messagetimeout.value)
 		{
 			NET_Close(sock);
-			return -1;
+			ret = -1;
 		}
 	}
 
@@ -575,27 +555,16 @@ int	NET_GetMessage (qsocket_t *sock)
 			else if (ret == 2)
 				unreliableMessagesReceived++;
 		}
-
-		if (recording)
-		{
-			vcrGetMessage.time = host_time;
-			vcrGetMessage.op = VCR_OP_GETMESSAGE;
-			vcrGetMessage.session = (long)sock;
-			vcrGetMessage.ret = ret;
-			vcrGetMessage.len = net_message.cursize;
-			Sys_FileWrite (vcrFile, &vcrGetMessage, 24);
-			Sys_FileWrite (vcrFile, net_message.data, net_message.cursize);
-		}
 	}
-	else
+
+	if (recording)
 	{
-		if (recording)
+		VCR_WriteOp (VCR_OP_GETMESSAGE, sock);
+		Sys_FileWrite (vcrFile, &ret, sizeof(int));
+		if (ret > 0)
 		{
-			vcrGetMessage.time = host_time;
-			vcrGetMessage.op = VCR_OP_GETMESSAGE;
-			vcrGetMessage.session = (long)sock;
-			vcrGetMessage.ret = ret;
-			Sys_FileWrite (vcrFile, &vcrGetMessage, 20);
+			Sys_FileWrite (vcrFile, &net_message.cursize, sizeof(int));
+			Sys_FileWrite (vcrFile, net_message.data, net_message.cursize);
 		}
 	}
 
@@ -614,14 +583,6 @@ returns 1 if the message was sent properly
 returns -1 if the connection died
 ==================
 */
-struct
-{
-	double	time;
-	int		op;
-	long	session;
-	int		r;
-} vcrSendMessage;
-
 int NET_SendMessage (qsocket_t *sock, sizebuf_t *data)
 {
 	int		r;
@@ -642,11 +603,8 @@ int NET_SendMessage (qsocket_t *sock, sizebuf_t *data)
 
 	if (recording)
 	{
-		vcrSendMessage.time = host_time;
-		vcrSendMessage.op = VCR_OP_SENDMESSAGE;
-		vcrSendMessage.session = (long)sock;
-		vcrSendMessage.r = r;
-		Sys_FileWrite (vcrFile, &vcrSendMessage, 20);
+		VCR_WriteOp (VCR_OP_SENDMESSAGE, sock);
+		Sys_FileWrite (vcrFile, &r, sizeof(int));
 	}
 	
 	return r;
@@ -673,11 +631,8 @@ int NET_SendUnreliableMessage (qsocket_t *sock, sizebuf_t *data)
 
 	if (recording)
 	{
-		vcrSendMessage.time = host_time;
-		vcrSendMessage.op = VCR_OP_SENDMESSAGE;
-		vcrSendMessage.session = (long)sock;
-		vcrSendMessage.r = r;
-		Sys_FileWrite (vcrFile, &vcrSendMessage, 20);
+		VCR_WriteOp (VCR_OP_SENDMESSAGE, sock);
+		Sys_FileWrite (vcrFile, &r, sizeof(int));
 	}
 	
 	return r;
@@ -708,11 +663,8 @@ qboolean NET_CanSendMessage (qsocket_t *sock)
 	
 	if (recording)
 	{
-		vcrSendMessage.time = host_time;
-		vcrSendMessage.op = VCR_OP_CANSENDMESSAGE;
-		vcrSendMessage.session = (long)sock;
-		vcrSendMessage.r = r;
-		Sys_FileWrite (vcrFile, &vcrSendMessage, 20);
+		VCR_WriteOp (VCR_OP_CANSENDMESSAGE, sock);
+		Sys_FileWrite (vcrFile, &r, sizeof(int));
 	}
 	
 	return r;
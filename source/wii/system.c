@@ -26,6 +26,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include <ogc/system.h>
 #include <ogc/video.h>
 #include <ogc/lwp_watchdog.h>
+#include <ogc/mutex.h>
+#include <ogc/semaphore.h>
+#include <ogc/lwp.h>
 #include <sys/stat.h>
 #include <wiiuse/wpad.h>
 #include <errno.h>
@@ -181,6 +184,16 @@ double Sys_FloatTime (void)
 	return ((double)(ms - base)) / 1000.0;
 }
 
+unsigned long long Sys_Ticks (void)
+{
+	return gettime ();
+}
+
+double Sys_TickRate (void)
+{
+	return TB_TIMER_CLOCK * 1000.0;
+}
+
 char *Sys_ConsoleInput (void)
 {
 	return 0;
@@ -278,9 +291,16 @@ void Sys_FileSeekCur (int handle, int offset)
 	fseek (sys_handles[handle], offset, SEEK_CUR);
 }
 
+int sys_bytesread;
+
 int Sys_FileRead (int handle, void *dest, int count)
 {
-	return fread (dest, 1, count, sys_handles[handle]);
+	int		r;
+
+	r = fread (dest, 1, count, sys_handles[handle]);
+	sys_bytesread += r;
+
+	return r;
 }
 
 int Sys_FileWrite (int handle, void *data, int count)
@@ -288,6 +308,154 @@ int Sys_FileWrite (int handle, void *data, int count)
 	return fwrite (data, 1, count, sys_handles[handle]);
 }
 
+/*
+================
+Sys_FileReadAt
+
+There is no pread here, so the seek and read are done under a lock
+================
+*/
+static mutex_t	sys_filelock;	// made by Sys_Init
+
+int Sys_FileReadAt (int handle, int position, void *dest, int count)
+{
+	int		r;
+
+	LWP_MutexLock (sys_filelock);
+	fseek (sys_handles[handle], position, SEEK_SET);
+	r = fread (dest, 1, count, sys_handles[handle]);
+	sys_bytesread += r;
+	LWP_MutexUnlock (sys_filelock);
+
+	return r;
+}
+
+void *Sys_FileMap (int handle, int position, int length)
+{
+	return NULL;
+}
+
+void Sys_FileUnmap (void *data, int position, int length)
+{
+}
+
+/*
+===============================================================================
+
+THREADS
+
+===============================================================================
+*/
+
+typedef struct
+{
+	void	(*func) (void *);
+	void	*arg;
+} threadstart_t;
+
+static void *Sys_ThreadStart (void *data)
+{
+	threadstart_t	start;
+
+	start = *(threadstart_t *)data;
+	free (data);
+	start.func (start.arg);
+
+	return NULL;
+}
+
+void *Sys_CreateThread (void (*func) (void *), void *arg)
+{
+	threadstart_t	*start;
+	lwp_t			thread;
+
+	start = malloc (sizeof(*start));
+	if (!start)
+		return NULL;
+	start->func = func;
+	start->arg = arg;
+
+	// above the main thread (64), so it gets to issue its next read as soon
+	// as the last one completes
+	if (LWP_CreateThread (&thread, Sys_ThreadStart, start, NULL, 64 * 1024, 65) < 0)
+	{
+		free (start);
+		return NULL;
+	}
+
+	return (void *)thread;
+}
+
+void *Sys_CreateSemaphore (int count)
+{
+	sem_t	*sem;
+
+	sem = malloc (sizeof(*sem));
+	if (!sem || LWP_SemInit (sem, count, 0x7fffffff) < 0)
+		Sys_Error ("Sys_CreateSemaphore: failed");
+
+	return sem;
+}
+
+void Sys_SemaphoreWait (void *sem)
+{
+	LWP_SemWait (*(sem_t *)sem);
+}
+
+void Sys_SemaphorePost (void *sem)
+{
+	LWP_SemPost (*(sem_t *)sem);
+}
+
+void *Sys_CreateWorker (void (*func) (void *), void *arg)
+{
+	threadstart_t	*start;
+	lwp_t			thread;
+
+	start = malloc (sizeof(*start));
+	if (!start)
+		return NULL;
+	start->func = func;
+	start->arg = arg;
+
+	// below the main thread, it only runs while the main thread waits
+	if (LWP_CreateThread (&thread, Sys_ThreadStart, start, NULL, 256 * 1024, 63) < 0)
+	{
+		free (start);
+		return NULL;
+	}
+
+	return (void *)thread;
+}
+
+int Sys_NumCores (void)
+{
+	return 1;
+}
+
+static lwp_t	sys_mainthread;
+
+/*
+================
+Sys_Init
+================
+*/
+void Sys_Init (void)
+{
+	sys_mainthread = LWP_GetSelf ();
+	LWP_MutexInit (&sys_filelock, false);
+}
+
+qboolean Sys_MainThread (void)
+{
+	return LWP_GetSelf () == sys_mainthread;
+}
+
+unsigned long Sys_ThreadId (void)
+{
+	return LWP_GetSelf ();
+}
+
 int     Sys_FileTime (char *path)
 {
 	FILE    *f;
@@ -0,0 +1,982 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// zip.c -- .pk3 (zip) archives in the search path
+//
+// Only the central directory is read when an archive is added; the local
+// header of an entry is read the first time the entry is opened.  Entries
+// may be stored or deflated.  Inflating is done here rather than through a
+// library so every port gets it, and it pulls compressed bytes from the
+// archive as it needs them, so loading a file never holds more than the
+// file itself and a small input buffer.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE		// fopencookie
+#endif
+
+#include "quakedef.h"
+#include "zip.h"
+
+#include <dirent.h>
+
+#define	ZIP_EOCDSIZE	22
+#define	ZIP_MAXCOMMENT	65535
+
+#define	ZIP_INBUF		16384
+#define	ZIP_WINDOW		65536		// stream ring, twice the longest distance
+#define	ZIP_STEP		32768		// most a stream inflates between copies
+#define	ZIP_FASTBITS	9
+
+/*
+=============================================================================
+
+INFLATE
+
+=============================================================================
+*/
+
+typedef struct
+{
+	unsigned short	fast[1 << ZIP_FASTBITS];	// symbol | length << 12, 0 if longer
+	short			count[16];					// number of codes of each length
+	short			symbol[288];				// in canonical order
+} huffman_t;
+
+enum {INF_HEADER, INF_STORED, INF_CODES, INF_DONE};
+
+typedef struct
+{
+	zipfile_t	*zip;
+	int			inpos, inend;		// compressed bytes still in the archive
+	int			inhead, incount;
+	int			overrun;			// zero bytes made up past the end
+	unsigned	bitbuf;
+	int			bitcnt;
+
+	byte		*window;			// the destination, or a ring for streams
+	int			wsize, wpos;
+	int			total;				// bytes produced so far
+
+	int			state;
+	qboolean	last;
+	int			stored;				// left in a stored block
+	int			copylen, copydist;	// left of a match
+	huffman_t	*lencode, *distcode;
+	huffman_t	dynlen, dyndist;
+
+	byte		inbuf[ZIP_INBUF];
+} inflate_t;
+
+static const short len_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const byte len_extra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const unsigned short dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+	8193, 12289, 16385, 24577};
+static const byte dist_extra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+static huffman_t	fixedlen, fixeddist;
+static qboolean		fixedbuilt;
+
+static void Inflate_Fill (inflate_t *inf)
+{
+	double	start;
+	int		n;
+
+	inf->inhead = 0;
+	inf->incount = 0;
+
+	n = inf->inend - inf->inpos;
+	if (n > ZIP_INBUF)
+		n = ZIP_INBUF;
+	if (n <= 0)
+		return;
+
+	start = Sys_FloatTime ();
+	n = Sys_FileReadAt (inf->zip->handle, inf->inpos, inf->inbuf, n);
+	inf->zip->readtime += Sys_FloatTime () - start;
+	inf->zip->reads++;
+
+	if (n > 0)
+	{
+		inf->incount = n;
+		inf->inpos += n;
+		inf->zip->bytesread += n;
+	}
+}
+
+static int Inflate_Byte (inflate_t *inf)
+{
+	if (inf->inhead == inf->incount)
+	{
+		Inflate_Fill (inf);
+		if (!inf->incount)
+		{
+			// the bit buffer reads ahead, so running out is only an
+			// error once more than it could hold has been made up
+			inf->overrun++;
+			return 0;
+		}
+	}
+
+	return inf->inbuf[inf->inhead++];
+}
+
+static int Inflate_Bits (inflate_t *inf, int n)
+{
+	int		v;
+
+	while (inf->bitcnt < n)
+	{
+		inf->bitbuf |= Inflate_Byte (inf) << inf->bitcnt;
+		inf->bitcnt += 8;
+	}
+
+	v = inf->bitbuf & ((1 << n) - 1);
+	inf->bitbuf >>= n;
+	inf->bitcnt -= n;
+
+	return v;
+}
+
+/*
+==================
+Inflate_Build
+
+Canonical code from a list of code lengths, with a table for the codes
+short enough to decode in one lookup
+==================
+*/
+static qboolean Inflate_Build (huffman_t *h, const byte *lengths, int n)
+{
+	short	offs[16];
+	int		len, sym, left, code, reversed, fill, i, k;
+
+	memset (h->count, 0, sizeof(h->count));
+	for (sym = 0 ; sym < n ; sym++)
+		h->count[lengths[sym]]++;
+
+	left = 1;
+	for (len = 1 ; len < 16 ; len++)
+	{
+		left <<= 1;
+		left -= h->count[len];
+		if (left < 0)
+			return false;		// over-subscribed
+	}
+
+	offs[1] = 0;
+	for (len = 1 ; len < 15 ; len++)
+		offs[len + 1] = offs[len] + h->count[len];
+	for (sym = 0 ; sym < n ; sym++)
+		if (lengths[sym])
+			h->symbol[offs[lengths[sym]]++] = sym;
+
+	// deflate sends codes high bit first, so the table is indexed by
+	// the code reversed
+	memset (h->fast, 0, sizeof(h->fast));
+	code = 0;
+	i = 0;
+	for (len = 1 ; len <= ZIP_FASTBITS ; len++)
+	{
+		for (k = 0 ; k < h->count[len] ; k++, i++, code++)
+		{
+			for (reversed = 0, fill = 0 ; fill < len ; fill++)
+				reversed |= ((code >> fill) & 1) << (len - 1 - fill);
+			for (fill = reversed ; fill < (1 << ZIP_FASTBITS) ; fill += 1 << len)
+				h->fast[fill] = h->symbol[i] | (len << 12);
+		}
+		code <<= 1;
+	}
+
+	return true;
+}
+
+static int Inflate_Decode (inflate_t *inf, huffman_t *h)
+{
+	int		e, len, code, first, index, count;
+
+	while (inf->bitcnt < ZIP_FASTBITS)
+	{
+		inf->bitbuf |= Inflate_Byte (inf) << inf->bitcnt;
+		inf->bitcnt += 8;
+	}
+
+	e = h->fast[inf->bitbuf & ((1 << ZIP_FASTBITS) - 1)];
+	if (e)
+	{
+		len = e >> 12;
+		inf->bitbuf >>= len;
+		inf->bitcnt -= len;
+		return e & 0xfff;
+	}
+
+	// a longer code, walked a bit at a time
+	code = first = index = 0;
+	for (len = 1 ; len < 16 ; len++)
+	{
+		code |= Inflate_Bits (inf, 1);
+		count = h->count[len];
+		if (code - count < first)
+			return h->symbol[index + (code - first)];
+		index += count;
+		first += count;
+		first <<= 1;
+		code <<= 1;
+	}
+
+	return -1;
+}
+
+static void Inflate_BuildFixed (void)
+{
+	byte	lengths[288];
+	int		i;
+
+	if (fixedbuilt)
+		return;
+
+	for (i = 0 ; i < 144 ; i++)
+		lengths[i] = 8;
+	for ( ; i < 256 ; i++)
+		lengths[i] = 9;
+	for ( ; i < 280 ; i++)
+		lengths[i] = 7;
+	for ( ; i < 288 ; i++)
+		lengths[i] = 8;
+	Inflate_Build (&fixedlen, lengths, 288);
+
+	for (i = 0 ; i < 30 ; i++)
+		lengths[i] = 5;
+	Inflate_Build (&fixeddist, lengths, 30);
+
+	fixedbuilt = true;
+}
+
+static qboolean Inflate_Dynamic (inflate_t *inf)
+{
+	static const byte order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+	byte	lengths[286 + 30];
+	int		nlen, ndist, ncode;
+	int		index, sym, len;
+
+	nlen = Inflate_Bits (inf, 5) + 257;
+	ndist = Inflate_Bits (inf, 5) + 1;
+	ncode = Inflate_Bits (inf, 4) + 4;
+	if (nlen > 286 || ndist > 30)
+		return false;
+
+	// the code length code goes in the distance table until it's needed
+	memset (lengths, 0, 19);
+	for (index = 0 ; index < ncode ; index++)
+		lengths[order[index]] = Inflate_Bits (inf, 3);
+	if (!Inflate_Build (&inf->dyndist, lengths, 19))
+		return false;
+
+	index = 0;
+	while (index < nlen + ndist)
+	{
+		sym = Inflate_Decode (inf, &inf->dyndist);
+		if (sym < 0)
+			return false;
+
+		if (sym < 16)
+		{
+			lengths[index++] = sym;
+			continue;
+		}
+
+		len = 0;
+		if (sym == 16)
+		{
+			if (!index)
+				return false;
+			len = lengths[index - 1];
+			sym = 3 + Inflate_Bits (inf, 2);
+		}
+		else if (sym == 17)
+			sym = 3 + Inflate_Bits (inf, 3);
+		else
+			sym = 11 + Inflate_Bits (inf, 7);
+
+		if (index + sym > nlen + ndist)
+			return false;
+		while (sym--)
+			lengths[index++] = len;
+	}
+
+	if (!lengths[256])
+		return false;		// no end of block code
+
+	if (!Inflate_Build (&inf->dynlen, lengths, nlen))
+		return false;
+	if (!Inflate_Build (&inf->dyndist, lengths + nlen, ndist))
+		return false;
+
+	inf->lencode = &inf->dynlen;
+	inf->distcode = &inf->dyndist;
+
+	return true;
+}
+
+static void Inflate_Init (inflate_t *inf, zipfile_t *zip, int dataofs, int csize, byte *window, int wsize)
+{
+	inf->zip = zip;
+	inf->inpos = dataofs;
+	inf->inend = dataofs + csize;
+	inf->inhead = inf->incount = 0;
+	inf->overrun = 0;
+	inf->bitbuf = 0;
+	inf->bitcnt = 0;
+
+	inf->window = window;
+	inf->wsize = wsize;
+	inf->wpos = 0;
+	inf->total = 0;
+
+	inf->state = INF_HEADER;
+	inf->last = false;
+	inf->stored = 0;
+	inf->copylen = inf->copydist = 0;
+}
+
+#define	INFLATE_OUT(c)	{ inf->window[inf->wpos] = (c); if (++inf->wpos == inf->wsize) inf->wpos = 0; }
+
+/*
+==================
+Inflate_Run
+
+Produces up to limit more bytes into the window, returns how many or -1
+==================
+*/
+static int Inflate_Run (inflate_t *inf, int limit)
+{
+	int		produced, sym, len, dist, src, n;
+	byte	c;
+
+	produced = 0;
+
+	while (produced < limit)
+	{
+		if (inf->overrun > 4)
+			return -1;
+
+		if (inf->copylen)
+		{
+			n = inf->copylen;
+			if (n > limit - produced)
+				n = limit - produced;
+			inf->copylen -= n;
+			produced += n;
+			inf->total += n;
+
+			// byte at a time, matches may overlap their own output
+			src = inf->wpos - inf->copydist;
+			if (src < 0)
+				src += inf->wsize;
+			while (n--)
+			{
+				c = inf->window[src];
+				if (++src == inf->wsize)
+					src = 0;
+				INFLATE_OUT(c);
+			}
+			continue;
+		}
+
+		switch (inf->state)
+		{
+		case INF_HEADER:
+			if (inf->last)
+			{
+				inf->state = INF_DONE;
+				break;
+			}
+			inf->last = Inflate_Bits (inf, 1);
+			switch (Inflate_Bits (inf, 2))
+			{
+			case 0:
+				// stored blocks start on a byte boundary
+				inf->bitbuf >>= inf->bitcnt & 7;
+				inf->bitcnt &= ~7;
+				len = Inflate_Bits (inf, 16);
+				if (Inflate_Bits (inf, 16) != (~len & 0xffff))
+					return -1;
+				inf->stored = len;
+				inf->state = INF_STORED;
+				break;
+			case 1:
+				inf->lencode = &fixedlen;
+				inf->distcode = &fixeddist;
+				inf->state = INF_CODES;
+				break;
+			case 2:
+				if (!Inflate_Dynamic (inf))
+					return -1;
+				inf->state = INF_CODES;
+				break;
+			default:
+				return -1;
+			}
+			break;
+
+		case INF_STORED:
+			if (!inf->stored)
+			{
+				inf->state = INF_HEADER;
+				break;
+			}
+			n = inf->stored;
+			if (n > limit - produced)
+				n = limit - produced;
+			inf->stored -= n;
+			produced += n;
+			inf->total += n;
+			while (n--)
+				INFLATE_OUT(Inflate_Bits (inf, 8));
+			break;
+
+		case INF_CODES:
+			sym = Inflate_Decode (inf, inf->lencode);
+			if (sym < 256)
+			{
+				if (sym < 0)
+					return -1;
+				INFLATE_OUT(sym);
+				produced++;
+				inf->total++;
+				break;
+			}
+			if (sym == 256)
+			{
+				inf->state = INF_HEADER;
+				break;
+			}
+
+			sym -= 257;
+			if (sym >= 29)
+				return -1;
+			len = len_base[sym] + Inflate_Bits (inf, len_extra[sym]);
+
+			sym = Inflate_Decode (inf, inf->distcode);
+			if (sym < 0 || sym >= 30)
+				return -1;
+			dist = dist_base[sym] + Inflate_Bits (inf, dist_extra[sym]);
+			if (dist > inf->total || dist > inf->wsize)
+				return -1;
+
+			inf->copylen = len;
+			inf->copydist = dist;
+			break;
+
+		case INF_DONE:
+			return produced;
+		}
+	}
+
+	return produced;
+}
+
+/*
+=============================================================================
+
+ARCHIVES
+
+=============================================================================
+*/
+
+static int Zip_Short (byte *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static int Zip_Long (byte *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+}
+
+/*
+==================
+Zip_Open
+==================
+*/
+zipfile_t *Zip_Open (char *filename)
+{
+	zipfile_t	*zip;
+	zipentry_t	*files, *e;
+	byte		*buf, *p, *next, *end;
+	int			handle, filelen, tail, pos;
+	int			count, cdofs, cdsize, numfiles;
+	int			namelen, method, flags, i;
+
+	filelen = Sys_FileOpenRead (filename, &handle);
+	if (filelen == -1)
+		return NULL;
+
+	Inflate_BuildFixed ();
+
+// the end of central directory record is within the last 64K
+	tail = filelen;
+	if (tail > ZIP_EOCDSIZE + ZIP_MAXCOMMENT)
+		tail = ZIP_EOCDSIZE + ZIP_MAXCOMMENT;
+
+	buf = malloc (tail);
+	if (!buf || tail < ZIP_EOCDSIZE || Sys_FileReadAt (handle, filelen - tail, buf, tail) != tail)
+	{
+		free (buf);
+		Sys_FileClose (handle);
+		Con_Printf ("%s is not a zip file\n", filename);
+		return NULL;
+	}
+
+	for (pos = tail - ZIP_EOCDSIZE ; pos >= 0 ; pos--)
+		if (Zip_Long (buf + pos) == 0x06054b50)
+			break;
+
+	if (pos < 0)
+	{
+		free (buf);
+		Sys_FileClose (handle);
+		Con_Printf ("%s is not a zip file\n", filename);
+		return NULL;
+	}
+
+	count = Zip_Short (buf + pos + 10);
+	cdsize = Zip_Long (buf + pos + 12);
+	cdofs = Zip_Long (buf + pos + 16);
+	free (buf);
+
+	// zip64 archives mark these with all bits set
+	if (cdofs < 0 || cdsize <= 0 || cdofs + cdsize > filelen)
+	{
+		Sys_FileClose (handle);
+		Con_Printf ("%s: unsupported zip file\n", filename);
+		return NULL;
+	}
+
+// read the central directory
+	buf = malloc (cdsize);
+	if (!buf || Sys_FileReadAt (handle, cdofs, buf, cdsize) != cdsize)
+	{
+		free (buf);
+		Sys_FileClose (handle);
+		Con_Printf ("Couldn't read %s\n", filename);
+		return NULL;
+	}
+
+	files = Hunk_AllocName (count * sizeof(zipentry_t), "zipfile");
+	numfiles = 0;
+	end = buf + cdsize;
+
+	for (i=0, p=buf ; i<count ; i++, p=next)
+	{
+		if (p + 46 > end || Zip_Long (p) != 0x02014b50)
+		{
+			Con_Printf ("%s: central directory is damaged\n", filename);
+			break;
+		}
+
+		namelen = Zip_Short (p + 28);
+		next = p + 46 + namelen + Zip_Short (p + 30) + Zip_Short (p + 32);
+		if (next > end)
+		{
+			Con_Printf ("%s: central directory is damaged\n", filename);
+			break;
+		}
+
+		if (!namelen || p[46 + namelen - 1] == '/')
+			continue;		// directory
+
+		flags = Zip_Short (p + 8);
+		method = Zip_Short (p + 10);
+		if (namelen >= MAX_QPATH || (flags & 1) || (method != ZIP_STORED && method != ZIP_DEFLATED))
+		{
+			Con_DPrintf ("%s: can't read %.*s\n", filename, namelen, p + 46);
+			continue;
+		}
+
+		e = &files[numfiles];
+		memcpy (e->name, p + 46, namelen);
+		e->name[namelen] = 0;
+		e->method = method;
+		e->csize = Zip_Long (p + 20);
+		e->size = Zip_Long (p + 24);
+		e->localofs = Zip_Long (p + 42);
+		e->dataofs = -1;
+
+		if (e->csize < 0 || e->size < 0 || e->localofs < 0)
+			continue;		// zip64
+
+		numfiles++;
+	}
+
+	free (buf);
+
+	zip = Hunk_AllocName (sizeof(zipfile_t), "zipfile");
+	strcpy (zip->filename, filename);
+	zip->handle = handle;
+	zip->numfiles = numfiles;
+	zip->files = files;
+
+	Con_Printf ("Added zipfile %s (%i files)\n", filename, numfiles);
+	return zip;
+}
+
+static int Zip_CompareNames (const void *a, const void *b)
+{
+	return Q_strcasecmp ((char *)a, (char *)b);
+}
+
+/*
+==================
+Zip_FindArchives
+==================
+*/
+int Zip_FindArchives (char *dir, char names[][MAX_QPATH], int maxnames)
+{
+	DIR				*d;
+	struct dirent	*de;
+	int				count, len;
+
+	d = opendir (dir);
+	if (!d)
+		return 0;
+
+	count = 0;
+	while ((de = readdir (d)) != NULL && count < maxnames)
+	{
+		len = strlen (de->d_name);
+		if (len <= 4 || len >= MAX_QPATH || Q_strcasecmp (de->d_name + len - 4, ".pk3"))
+			continue;
+		strcpy (names[count++], de->d_name);
+	}
+
+	closedir (d);
+
+	// later names are added later, so they override earlier ones
+	qsort (names, count, MAX_QPATH, Zip_CompareNames);
+
+	return count;
+}
+
+/*
+==================
+Zip_DataOffset
+==================
+*/
+int Zip_DataOffset (zipfile_t *zip, int index)
+{
+	zipentry_t	*e;
+	byte		local[30];
+
+	e = &zip->files[index];
+	if (e->dataofs >= 0)
+		return e->dataofs;
+
+	if (Sys_FileReadAt (zip->handle, e->localofs, local, 30) != 30 || Zip_Long (local) != 0x04034b50)
+	{
+		Con_Printf ("%s: bad local header for %s\n", zip->filename, e->name);
+		return -1;
+	}
+
+	e->dataofs = e->localofs + 30 + Zip_Short (local + 26) + Zip_Short (local + 28);
+
+	return e->dataofs;
+}
+
+qboolean Zip_IsStored (zipfile_t *zip, int index)
+{
+	return zip->files[index].method == ZIP_STORED;
+}
+
+/*
+==================
+Zip_ReadFile
+==================
+*/
+qboolean Zip_ReadFile (zipfile_t *zip, int index, byte *dest)
+{
+	zipentry_t	*e;
+	inflate_t	*inf;
+	double		start, readtime;
+	int			dataofs, n;
+
+	e = &zip->files[index];
+	dataofs = Zip_DataOffset (zip, index);
+	if (dataofs < 0)
+		return false;
+
+	if (!e->size)
+		return true;
+
+	if (e->method == ZIP_STORED)
+	{
+		start = Sys_FloatTime ();
+		n = Sys_FileReadAt (zip->handle, dataofs, dest, e->size);
+		zip->readtime += Sys_FloatTime () - start;
+		zip->reads++;
+		zip->bytesread += n > 0 ? n : 0;
+		return n == e->size;
+	}
+
+	inf = malloc (sizeof(inflate_t));
+	if (!inf)
+		return false;
+
+	// the destination is the whole window, so nothing is copied twice
+	Inflate_Init (inf, zip, dataofs, e->csize, dest, e->size);
+
+	start = Sys_FloatTime ();
+	readtime = zip->readtime;
+	n = Inflate_Run (inf, e->size);
+	zip->inflatetime += (Sys_FloatTime () - start) - (zip->readtime - readtime);
+	zip->bytesinflated += n > 0 ? n : 0;
+
+	free (inf);
+
+	if (n != e->size)
+	{
+		Con_Printf ("%s: %s is corrupt\n", zip->filename, e->name);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+=============================================================================
+
+STREAMS
+
+=============================================================================
+*/
+
+struct zipstream_s
+{
+	zipfile_t	*zip;
+	zipentry_t	*entry;
+	int			dataofs;
+	int			position;
+	inflate_t	*inf;			// NULL for stored entries
+	byte		*ring;
+};
+
+zipstream_t *Zip_OpenStream (zipfile_t *zip, int index)
+{
+	zipstream_t	*s;
+	int			dataofs;
+
+	dataofs = Zip_DataOffset (zip, index);
+	if (dataofs < 0)
+		return NULL;
+
+	s = malloc (sizeof(zipstream_t));
+	if (!s)
+		return NULL;
+
+	s->zip = zip;
+	s->entry = &zip->files[index];
+	s->dataofs = dataofs;
+	s->position = 0;
+	s->inf = NULL;
+	s->ring = NULL;
+
+	if (s->entry->method == ZIP_DEFLATED)
+	{
+		s->inf = malloc (sizeof(inflate_t));
+		s->ring = malloc (ZIP_WINDOW);
+		if (!s->inf || !s->ring)
+		{
+			Zip_CloseStream (s);
+			return NULL;
+		}
+		Inflate_Init (s->inf, zip, dataofs, s->entry->csize, s->ring, ZIP_WINDOW);
+	}
+
+	return s;
+}
+
+// dest may be NULL to skip forward
+static int Zip_StreamInflate (zipstream_t *s, byte *dest, int count)
+{
+	inflate_t	*inf;
+	double		start, readtime;
+	int			done, step, n, first, from;
+
+	inf = s->inf;
+	start = Sys_FloatTime ();
+	readtime = s->zip->readtime;
+
+	for (done = 0 ; done < count ; done += n)
+	{
+		step = count - done;
+		if (step > ZIP_STEP)
+			step = ZIP_STEP;
+
+		n = Inflate_Run (inf, step);
+		if (n <= 0)
+			break;
+
+		if (dest)
+		{
+			from = inf->wpos - n;
+			if (from < 0)
+				from += inf->wsize;
+			first = inf->wsize - from;
+			if (first > n)
+				first = n;
+			memcpy (dest + done, s->ring + from, first);
+			memcpy (dest + done + first, s->ring, n - first);
+		}
+	}
+
+	s->zip->inflatetime += (Sys_FloatTime () - start) - (s->zip->readtime - readtime);
+	s->zip->bytesinflated += done;
+
+	return done;
+}
+
+int Zip_StreamRead (zipstream_t *s, void *dest, int count)
+{
+	double	start;
+	int		n;
+
+	if (count > s->entry->size - s->position)
+		count = s->entry->size - s->position;
+	if (count <= 0)
+		return 0;
+
+	if (s->inf)
+		n = Zip_StreamInflate (s, dest, count);
+	else
+	{
+		start = Sys_FloatTime ();
+		n = Sys_FileReadAt (s->zip->handle, s->dataofs + s->position, dest, count);
+		s->zip->readtime += Sys_FloatTime () - start;
+		s->zip->reads++;
+		if (n < 0)
+			n = 0;
+		s->zip->bytesread += n;
+	}
+
+	s->position += n;
+	return n;
+}
+
+qboolean Zip_StreamSeek (zipstream_t *s, int position)
+{
+	if (position < 0 || position > s->entry->size)
+		return false;
+
+	if (!s->inf)
+	{
+		s->position = position;
+		return true;
+	}
+
+	if (position < s->position)
+	{
+		Inflate_Init (s->inf, s->zip, s->dataofs, s->entry->csize, s->ring, ZIP_WINDOW);
+		s->position = 0;
+	}
+
+	s->position += Zip_StreamInflate (s, NULL, position - s->position);
+
+	return s->position == position;
+}
+
+void Zip_CloseStream (zipstream_t *s)
+{
+	free (s->inf);
+	free (s->ring);
+	free (s);
+}
+
+static ssize_t Zip_CookieRead (void *cookie, char *buf, size_t size)
+{
+	return Zip_StreamRead (cookie, buf, size);
+}
+
+static int Zip_CookieSeek (void *cookie, long long *offset, int whence)
+{
+	zipstream_t	*s;
+	long long	pos;
+
+	s = cookie;
+	switch (whence)
+	{
+	case SEEK_SET:
+		pos = *offset;
+		break;
+	case SEEK_CUR:
+		pos = s->position + *offset;
+		break;
+	case SEEK_END:
+		pos = s->entry->size + *offset;
+		break;
+	default:
+		return -1;
+	}
+
+	if (pos < 0 || pos > s->entry->size || !Zip_StreamSeek (s, pos))
+		return -1;
+
+	*offset = s->position;
+	return 0;
+}
+
+static int Zip_CookieClose (void *cookie)
+{
+	Zip_CloseStream (cookie);
+	return 0;
+}
+
+/*
+==================
+Zip_FOpen
+==================
+*/
+FILE *Zip_FOpen (zipfile_t *zip, int index)
+{
+	cookie_io_functions_t	io;
+	zipstream_t				*s;
+	FILE					*f;
+
+	s = Zip_OpenStream (zip, index);
+	if (!s)
+		return NULL;
+
+	// the 64 bit offset type has a different name in each libc
+	io.read = (cookie_read_function_t *)Zip_CookieRead;
+	io.write = NULL;
+	io.seek = (cookie_seek_function_t *)Zip_CookieSeek;
+	io.close = (cookie_close_function_t *)Zip_CookieClose;
+
+	f = fopencookie (s, "rb", io);
+	if (!f)
+		Zip_CloseStream (s);
+
+	return f;
+}
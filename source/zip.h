@@ -0,0 +1,75 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// zip.h -- .pk3 (zip) archives in the search path
+
+#define	ZIP_STORED		0
+#define	ZIP_DEFLATED	8
+
+#define	MAX_ZIPS_IN_DIR	32
+
+typedef struct
+{
+	char	name[MAX_QPATH];
+	int		localofs;		// local header, the data follows it
+	int		dataofs;		// -1 until the local header has been read
+	int		csize;			// bytes in the archive
+	int		size;			// bytes once inflated
+	int		method;
+} zipentry_t;
+
+typedef struct zipfile_s
+{
+	char		filename[MAX_OSPATH];
+	int			handle;
+	int			numfiles;
+	zipentry_t	*files;
+
+// for the path command
+	int			reads;
+	int			bytesread;		// compressed bytes taken from the archive
+	int			bytesinflated;
+	double		readtime;
+	double		inflatetime;	// not counting the reads it waited on
+} zipfile_t;
+
+typedef struct zipstream_s zipstream_t;
+
+// reads the central directory once, the entries are then found through
+// the filesystem index; returns NULL if the file isn't a usable zip
+zipfile_t *Zip_Open (char *filename);
+
+// sorted names of the .pk3 files in dir, returns the count
+int Zip_FindArchives (char *dir, char names[][MAX_QPATH], int maxnames);
+
+int Zip_DataOffset (zipfile_t *zip, int index);
+qboolean Zip_IsStored (zipfile_t *zip, int index);
+
+// inflates the whole entry straight into dest, which must hold size bytes
+qboolean Zip_ReadFile (zipfile_t *zip, int index, byte *dest);
+
+// sequential access with seeking, for readers that don't want the whole
+// file in memory; seeking backwards in a deflated entry starts over
+zipstream_t *Zip_OpenStream (zipfile_t *zip, int index);
+int Zip_StreamRead (zipstream_t *s, void *dest, int count);
+qboolean Zip_StreamSeek (zipstream_t *s, int position);
+void Zip_CloseStream (zipstream_t *s);
+
+// a stdio stream over Zip_OpenStream for the FILE based loaders
+FILE *Zip_FOpen (zipfile_t *zip, int index);
@@ -29,25 +29,59 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define	ZONEID	0x1d4a11
 #define MINFRAGMENT	64
 
+// blocks this big (header included) come from the system heap while it
+// holds less than the zone's own size, a file or a long string would
+// otherwise split the small zone for everything else
+#define	ZONE_LARGEBLOCK	4096
+
+// free blocks are kept in lists by size class: below 128 bytes in steps of
+// 32, above in four classes per power of two
+#define	ZONE_FLSHIFT	7
+#define	ZONE_SLBITS		2
+#define	ZONE_SLCOUNT	(1<<ZONE_SLBITS)
+#define	ZONE_FLCOUNT	(32 - ZONE_FLSHIFT + 1)
+
 typedef struct memblock_s
 {
 	int	size;		// including the header and possibly tiny fragments
 	int	tag;		// a tag of 0 is a free block
 	int	id;		// should be ZONEID
-	int	pad;		// pad to 64 bit boundary
+	int	large;		// in the large blocks' zone
 	struct	memblock_s	*next, *prev;
 } memblock_t;
 
+// a free block's class list links are kept where its data would be
+typedef struct
+{
+	memblock_t	*next, *prev;
+} memfree_t;
+
+#define	FREELINKS(b)	((memfree_t *)((byte *)(b) + sizeof(memblock_t)))
+
+// a block must be able to hold its free links once it is freed
+#define	ZONE_MINBLOCK	((int)(sizeof(memblock_t) + sizeof(memfree_t) + 7) & ~7)
+
 typedef struct
 {
 	int		size;		// total bytes malloced, including header
 	memblock_t	blocklist;	// start / end cap for linked list
-	memblock_t	*rover;
+	unsigned int	flbitmap;	// a bit for each first level with a free block
+	unsigned int	slbitmap[ZONE_FLCOUNT];
+	memblock_t	*free[ZONE_FLCOUNT][ZONE_SLCOUNT];
 } memzone_t;
 
 void Cache_FreeLow (int new_low_hunk);
 void Cache_FreeHigh (int new_high_hunk);
 
+// memory telemetry, at the end of the file
+static void Mem_CountZone (int tag, int size, void *site);
+static void Mem_UncountZone (int tag, int size);
+static void Mem_CountHunk (char *name, int size, void *site);
+static void Mem_UncountHunk (byte *start, byte *end);
+static void Mem_CountCache (int size, void *site);
+static void Mem_UncountCache (int size);
+static void Mem_PrintLine (void);
+
 #ifdef PSP_VFPU
 void* memcpy_vfpu( void* dst, void* src, unsigned int size )
 {
@@ -456,7 +490,17 @@ void *Q_strdup (const char *str)
 There is never any space between memblocks, and there will never be two
 contiguous free memblocks.
 
-The rover can be left pointing at a non-empty block
+Free blocks are kept in segregated lists by size class, with a bitmap of
+the lists that aren't empty, so finding a block and freeing one take the
+same few steps however many blocks the zone has been split into.  A
+request is rounded up to the next class before the search, so the first
+block of any class found is big enough.
+
+Blocks of ZONE_LARGEBLOCK or more are split from a second zone at the top
+of the first one's hunk block, so the few big ones don't leave holes among
+the many small ones.  -zonelarge sets its size in KB, out of the -zone
+total rather than on top of it, and 0 leaves one zone as before.  When
+either zone is full a block is split from the other.
 
 The zone calls are pretty much only used for small strings and structures,
 all big things are allocated on the hunk.
@@ -464,7 +508,167 @@ all big things are allocated on the hunk.
 */
 
 static memzone_t	*mainzone;
+static memzone_t	*largezone;		// NULL with -zonelarge 0
+static int			zone_size;		// the two together
+static void			*zone_lock;		// NULL until another thread allocates too
+
+allocstats_t	alloc_stats;
+
+/*
+========================
+Z_Log2
+========================
+*/
+static int Z_Log2 (unsigned int x)
+{
+	return 31 - __builtin_clz (x);
+}
+
+/*
+========================
+Z_Class
+
+The list a block of size belongs in
+========================
+*/
+static void Z_Class (int size, int *fl, int *sl)
+{
+	int		f;
+
+	if (size < (1 << ZONE_FLSHIFT))
+	{
+		*fl = 0;
+		*sl = size >> (ZONE_FLSHIFT - ZONE_SLBITS);
+		return;
+	}
+
+	f = Z_Log2 (size);
+	*fl = f - ZONE_FLSHIFT + 1;
+	*sl = (size >> (f - ZONE_SLBITS)) & (ZONE_SLCOUNT - 1);
+}
+
+/*
+========================
+Z_LinkFree
+========================
+*/
+static void Z_LinkFree (memzone_t *zone, memblock_t *block)
+{
+	memblock_t	*head;
+	int			fl, sl;
+
+	Z_Class (block->size, &fl, &sl);
+	head = zone->free[fl][sl];
+
+	FREELINKS(block)->prev = NULL;
+	FREELINKS(block)->next = head;
+	if (head)
+		FREELINKS(head)->prev = block;
+	zone->free[fl][sl] = block;
+
+	zone->flbitmap |= 1u << fl;
+	zone->slbitmap[fl] |= 1u << sl;
+}
+
+/*
+========================
+Z_UnlinkFree
+========================
+*/
+static void Z_UnlinkFree (memzone_t *zone, memblock_t *block)
+{
+	memfree_t	*links;
+	int			fl, sl;
+
+	Z_Class (block->size, &fl, &sl);
+	links = FREELINKS(block);
+
+	if (links->next)
+		FREELINKS(links->next)->prev = links->prev;
+	if (links->prev)
+		FREELINKS(links->prev)->next = links->next;
+	else
+	{
+		zone->free[fl][sl] = links->next;
+		if (!links->next)
+		{
+			zone->slbitmap[fl] &= ~(1u << sl);
+			if (!zone->slbitmap[fl])
+				zone->flbitmap &= ~(1u << fl);
+		}
+	}
+}
+
+/*
+========================
+Z_FindFree
+
+A free block of at least size bytes, or NULL
+========================
+*/
+static memblock_t *Z_FindFree (memzone_t *zone, int size)
+{
+	memblock_t	*block;
+	unsigned int	bits;
+	int			fl, sl;
+
+	// the block at the head of size's own class often fits as it is
+	Z_Class (size, &fl, &sl);
+	block = zone->free[fl][sl];
+	if (block && block->size >= size)
+		return block;
+
+	// otherwise any block of the next class up does
+	if (size < (1 << ZONE_FLSHIFT))
+		size += (1 << (ZONE_FLSHIFT - ZONE_SLBITS)) - 1;
+	else
+		size += (1 << (Z_Log2 (size) - ZONE_SLBITS)) - 1;
+	Z_Class (size, &fl, &sl);
+	if (fl >= ZONE_FLCOUNT)
+		return NULL;
+
+	bits = zone->slbitmap[fl] & (~0u << sl);
+	if (!bits)
+	{
+		if (fl + 1 >= ZONE_FLCOUNT)
+			return NULL;
+		bits = zone->flbitmap & (~0u << (fl + 1));
+		if (!bits)
+			return NULL;
+		fl = __builtin_ctz (bits);
+		bits = zone->slbitmap[fl];
+	}
+	sl = __builtin_ctz (bits);
+
+	return zone->free[fl][sl];
+}
+
+/*
+========================
+Z_EnableLocking
+
+The zone is taken under a lock from here on, for a second thread that
+allocates next to the main one.  The hunk and the cache stay the main
+thread's.
+========================
+*/
+void Z_EnableLocking (void)
+{
+	if (!zone_lock)
+		zone_lock = Sys_CreateSemaphore (1);
+}
+
+static void Z_Lock (void)
+{
+	if (zone_lock)
+		Sys_SemaphoreWait (zone_lock);
+}
 
+static void Z_Unlock (void)
+{
+	if (zone_lock)
+		Sys_SemaphorePost (zone_lock);
+}
 
 /*
 ========================
@@ -474,6 +678,7 @@ Z_Free
 void Z_Free (void *ptr)
 {
 	memblock_t	*block, *other;
+	memzone_t	*zone;
 
 	if (!ptr)
 		Sys_Error ("Z_Free: NULL pointer");
@@ -484,101 +689,149 @@ void Z_Free (void *ptr)
 	if (block->tag == 0)
 		Sys_Error ("Z_Free: freed a freed pointer");
 
+	Z_Lock ();
+
+	alloc_stats.zonefrees++;
+	Mem_UncountZone (block->tag, block->size);
+
 	block->tag = 0;		// mark as free
+	zone = block->large ? largezone : mainzone;
 
 	other = block->prev;
 	if (!other->tag)
 	{	// merge with previous free block
+		Z_UnlinkFree (zone, other);
 		other->size += block->size;
 		other->next = block->next;
 		other->next->prev = other;
-		if (block == mainzone->rover)
-			mainzone->rover = other;
 		block = other;
 	}
 
 	other = block->next;
 	if (!other->tag)
 	{	// merge the next free block onto the end
+		Z_UnlinkFree (zone, other);
 		block->size += other->size;
 		block->next = other->next;
 		block->next->prev = block;
-		if (other == mainzone->rover)
-			mainzone->rover = block;
 	}
+
+	Z_LinkFree (zone, block);
+
+	Z_Unlock ();
 }
 
+/*
+========================
+Z_SplitFree
 
-void *Z_TagMalloc (int size, int tag)
+A free block of size bytes taken from zone, or NULL
+========================
+*/
+static memblock_t *Z_SplitFree (memzone_t *zone, int size)
 {
 	int		extra;
-	memblock_t	*start, *rover, *newblock, *base;
-
-	if (!tag)
-		Sys_Error ("Z_TagMalloc: tried to use a 0 tag");
-
-//
-// scan through the block list looking for the first free block
-// of sufficient size
-//
-	size += sizeof(memblock_t);	// account for size of block header
-	size += 4;					// space for memory trash tester
-	size = (size + 7) & ~7;		// align to 8-byte boundary
+	memblock_t	*newblock, *base;
 
-	base = rover = mainzone->rover;
-	start = base->prev;
-
-	do
-	{
-		if (rover == start)	// scaned all the way around the list
-			return NULL;
-		if (rover->tag)
-			base = rover = rover->next;
-		else
-			rover = rover->next;
-	} while (base->tag || base->size < size);
+	base = Z_FindFree (zone, size);
+	if (!base)
+		return NULL;
+	Z_UnlinkFree (zone, base);
 
-//
-// found a block big enough
-//
 	extra = base->size - size;
 	if (extra >  MINFRAGMENT)
 	{	// there will be a free fragment after the allocated block
 		newblock = (memblock_t *) ((byte *)base + size );
 		newblock->size = extra;
 		newblock->tag = 0;			// free block
+		newblock->large = base->large;
 		newblock->prev = base;
 		newblock->id = ZONEID;
 		newblock->next = base->next;
 		newblock->next->prev = newblock;
 		base->next = newblock;
 		base->size = size;
+		Z_LinkFree (zone, newblock);
 	}
 
-	base->tag = tag;				// no longer a free block
+	return base;
+}
+
+/*
+========================
+Z_TagMallocSite
+
+site is the caller's address, for -memsites
+========================
+*/
+static void *Z_TagMallocSite (int size, int tag, void *site)
+{
+	memzone_t	*first, *second;
+	memblock_t	*base;
+
+	if (!tag)
+		Sys_Error ("Z_TagMalloc: tried to use a 0 tag");
+
+	size += sizeof(memblock_t);	// account for size of block header
+	size += 4;					// space for memory trash tester
+	size = (size + 7) & ~7;		// align to 8-byte boundary
+	if (size < ZONE_MINBLOCK)
+		size = ZONE_MINBLOCK;
+
+	Z_Lock ();
+
+	first = mainzone;
+	second = largezone;
+	if (size >= ZONE_LARGEBLOCK && largezone)
+	{
+		first = largezone;
+		second = mainzone;
+	}
+
+	base = Z_SplitFree (first, size);
+	if (!base && second)
+		base = Z_SplitFree (second, size);
+	if (!base)
+	{
+		Z_Unlock ();
+		return NULL;
+	}
 
-	mainzone->rover = base->next;	// next allocation will start looking here
+	base->tag = tag;				// no longer a free block
+	alloc_stats.zone += base->size;
+	alloc_stats.zoneallocs++;
+	Mem_CountZone (tag, base->size, site);
 
 	base->id = ZONEID;
 
 // marker for memory trash testing
 	*(int *)((byte *)base + base->size - 4) = ZONEID;
 
+	Z_Unlock ();
+
 	return (void *) ((byte *)base + sizeof(memblock_t));
 }
 
+void *Z_TagMalloc (int size, int tag)
+{
+	return Z_TagMallocSite (size, tag, __builtin_return_address (0));
+}
+
 /*
 ========================
-Z_CheckHeap
+Z_CheckZone
 ========================
 */
-void Z_CheckHeap (void)
+static void Z_CheckZone (memzone_t *zone)
 {
 	memblock_t	*block;
+	int			fl, sl, f, s;
 
-	for (block = mainzone->blocklist.next ; ; block = block->next)
+	for (block = zone->blocklist.next ; ; block = block->next)
 	{
-		if (block->next == &mainzone->blocklist)
+		if (block->large != (zone == largezone))
+			Sys_Error ("Z_CheckHeap: block in the wrong zone");
+		if (block->next == &zone->blocklist)
 			break;			// all blocks have been hit
 		if ( (byte *)block + block->size != (byte *)block->next)
 			Sys_Error ("Z_CheckHeap: block size does not touch the next block");
@@ -586,21 +839,52 @@ void Z_CheckHeap (void)
 			Sys_Error ("Z_CheckHeap: next block doesn't have proper back link");
 		if (!block->tag && !block->next->tag)
 			Sys_Error ("Z_CheckHeap: two consecutive free blocks");
+		if (block->tag && *(int *)((byte *)block + block->size - 4) != ZONEID)
+			Sys_Error ("Z_CheckHeap: memory trashed past the end of a block");
+	}
+
+	for (fl=0 ; fl<ZONE_FLCOUNT ; fl++)
+	{
+		for (sl=0 ; sl<ZONE_SLCOUNT ; sl++)
+		{
+			if (!zone->free[fl][sl] != !(zone->slbitmap[fl] & (1u << sl)))
+				Sys_Error ("Z_CheckHeap: free list bitmap is wrong");
+			for (block = zone->free[fl][sl] ; block ; block = FREELINKS(block)->next)
+			{
+				Z_Class (block->size, &f, &s);
+				if (block->tag || f != fl || s != sl || block->large != (zone == largezone))
+					Sys_Error ("Z_CheckHeap: block in the wrong free list");
+			}
+		}
 	}
 }
 
+/*
+========================
+Z_CheckHeap
+========================
+*/
+void Z_CheckHeap (void)
+{
+	Z_CheckZone (mainzone);
+	if (largezone)
+		Z_CheckZone (largezone);
+}
+
 
 /*
 ========================
-Z_Malloc
+Z_MallocSite
 ========================
 */
-void *Z_Malloc (int size)
+static void *Z_MallocSite (int size, void *site)
 {
 	void	*buf;
 
-	Z_CheckHeap ();	// DEBUG
-	buf = Z_TagMalloc (size, 1);
+#ifdef PARANOID
+	Z_CheckHeap ();
+#endif
+	buf = Z_TagMallocSite (size, 1, site);
 	if (!buf)
 		Sys_Error ("Z_Malloc: failed on allocation of %i bytes",size);
 	Q_memset (buf, 0, size);
@@ -608,6 +892,16 @@ void *Z_Malloc (int size)
 	return buf;
 }
 
+/*
+========================
+Z_Malloc
+========================
+*/
+void *Z_Malloc (int size)
+{
+	return Z_MallocSite (size, __builtin_return_address (0));
+}
+
 /*
 ========================
 Z_Realloc
@@ -616,11 +910,11 @@ Z_Realloc
 void *Z_Realloc(void *ptr, int size)
 {
 	int old_size;
-	void *old_ptr;
+	void *new_ptr;
 	memblock_t *block;
 
 	if (!ptr)
-		return Z_Malloc (size);
+		return Z_MallocSite (size, __builtin_return_address (0));
 
 	block = (memblock_t *) ((byte *) ptr - sizeof (memblock_t));
 	if (block->id != ZONEID)
@@ -630,25 +924,27 @@ void *Z_Realloc(void *ptr, int size)
 
 	old_size = block->size;
 	old_size -= (4 + (int)sizeof(memblock_t));	/* see Z_TagMalloc() */
-	old_ptr = ptr;
 
-	Z_Free (ptr);
-	ptr = Z_TagMalloc (size, 1);
-	if (!ptr)
+	// still fits where it is
+	if (size <= old_size)
+		return ptr;
+
+	new_ptr = Z_TagMallocSite (size, block->tag, __builtin_return_address (0));
+	if (!new_ptr)
 		Sys_Error ("Z_Realloc: failed on allocation of %i bytes", size);
 
-	if (ptr != old_ptr)
-		memmove (ptr, old_ptr, MIN(old_size, size));
+	memcpy (new_ptr, ptr, MIN(old_size, size));
 	if (old_size < size)
-		memset ((byte *)ptr + old_size, 0, size - old_size);
+		memset ((byte *)new_ptr + old_size, 0, size - old_size);
+	Z_Free (ptr);
 
-	return ptr;
+	return new_ptr;
 }
 
 char *Z_Strdup (char *s)
 {
 	size_t sz = strlen(s) + 1;
-	char *ptr = (char *) Z_Malloc (sz);
+	char *ptr = (char *) Z_MallocSite (sz, __builtin_return_address (0));
 	memcpy (ptr, s, sz);
 	return ptr;
 }
@@ -657,21 +953,45 @@ char *Z_Strdup (char *s)
 /*
 ========================
 Z_Print
+
+How the zone is split up; all lists every block as well
 ========================
 */
-void Z_Print (memzone_t *zone)
+void Z_Print (memzone_t *zone, qboolean all)
 {
 	memblock_t	*block;
+	int			used, usedblocks, freebytes, freeblocks, largest;
+	int			classcount[ZONE_FLCOUNT][ZONE_SLCOUNT];
+	int			fl, sl;
 
-	Con_Printf ("zone size: %i  location: %p\n",mainzone->size,mainzone);
+	Con_Printf ("zone size: %i  location: %p\n",zone->size,zone);
 
-	for (block = zone->blocklist.next ; ; block = block->next)
+	used = usedblocks = freebytes = freeblocks = largest = 0;
+	memset (classcount, 0, sizeof(classcount));
+
+	for (block = zone->blocklist.next ; block != &zone->blocklist ; block = block->next)
 	{
-		Con_Printf ("block:%p    size:%7i    tag:%3i\n",
-			block, block->size, block->tag);
+		if (all)
+			Con_Printf ("block:%p    size:%7i    tag:%3i\n",
+				block, block->size, block->tag);
+
+		if (block->tag)
+		{
+			used += block->size;
+			usedblocks++;
+		}
+		else
+		{
+			freebytes += block->size;
+			freeblocks++;
+			if (block->size > largest)
+				largest = block->size;
+			Z_Class (block->size, &fl, &sl);
+			classcount[fl][sl]++;
+		}
 
 		if (block->next == &zone->blocklist)
-			break;			// all blocks have been hit
+			continue;
 		if ( (byte *)block + block->size != (byte *)block->next)
 			Con_Printf ("ERROR: block size does not touch the next block\n");
 		if ( block->next->prev != block)
@@ -679,6 +999,43 @@ void Z_Print (memzone_t *zone)
 		if (!block->tag && !block->next->tag)
 			Con_Printf ("ERROR: two consecutive free blocks\n");
 	}
+
+	Con_Printf ("%7i bytes in %i used blocks\n", used, usedblocks);
+	Con_Printf ("%7i bytes in %i free blocks, the largest %i\n", freebytes, freeblocks, largest);
+	if (freebytes)
+		Con_Printf ("%7.1f%% fragmented\n", 100.0 - 100.0 * largest / freebytes);
+
+	Con_Printf ("free blocks by class:\n");
+	for (fl=0 ; fl<ZONE_FLCOUNT ; fl++)
+	{
+		for (sl=0 ; sl<ZONE_SLCOUNT ; sl++)
+		{
+			if (!classcount[fl][sl])
+				continue;
+			if (fl)
+				Con_Printf ("%7i+ %i\n", (1 << (fl + ZONE_FLSHIFT - 1)) + sl * (1 << (fl + ZONE_FLSHIFT - 1 - ZONE_SLBITS)), classcount[fl][sl]);
+			else
+				Con_Printf ("%7i+ %i\n", sl << (ZONE_FLSHIFT - ZONE_SLBITS), classcount[fl][sl]);
+		}
+	}
+}
+
+/*
+========================
+Z_Print_f
+========================
+*/
+void Z_Print_f (void)
+{
+	qboolean	all;
+
+	all = Cmd_Argc () > 1 && !Q_strcasecmp (Cmd_Argv (1), "all");
+	Z_Print (mainzone, all);
+	if (largezone)
+	{
+		Con_Printf ("blocks of %i or more:\n", ZONE_LARGEBLOCK);
+		Z_Print (largezone, all);
+	}
 }
 
 
@@ -822,10 +1179,10 @@ void Hunk_Print_f (void)
 
 /*
 ===================
-Hunk_AllocName
+Hunk_AllocSite
 ===================
 */
-void *Hunk_AllocName (int size, char *name)
+static void *Hunk_AllocSite (int size, char *name, void *site)
 {
 	hunk_t	*h;
 
@@ -839,10 +1196,15 @@ void *Hunk_AllocName (int size, char *name)
 	size = sizeof(hunk_t) + ((size+15)&~15);
 
 	if (hunk_size - hunk_low_used - hunk_high_used < size)
+	{
+		Mem_PrintLine ();
 		Sys_Error ("Hunk_Alloc: failed on %i bytes",size);
+	}
 
 	h = (hunk_t *)(hunk_base + hunk_low_used);
 	hunk_low_used += size;
+	alloc_stats.hunk += size;
+	alloc_stats.hunkallocs++;
 
 	Cache_FreeLow (hunk_low_used);
 
@@ -851,10 +1213,21 @@ void *Hunk_AllocName (int size, char *name)
 	h->size = size;
 	h->sentinel = HUNK_SENTINEL;
 	strlcpy(h->name, name, HUNKNAME_LEN);
+	Mem_CountHunk (h->name, size, site);
 
 	return (void *)(h+1);
 }
 
+/*
+===================
+Hunk_AllocName
+===================
+*/
+void *Hunk_AllocName (int size, char *name)
+{
+	return Hunk_AllocSite (size, name, __builtin_return_address (0));
+}
+
 /*
 ===================
 Hunk_Alloc
@@ -862,7 +1235,7 @@ Hunk_Alloc
 */
 void *Hunk_Alloc (int size)
 {
-	return Hunk_AllocName (size, "unknown");
+	return Hunk_AllocSite (size, "unknown", __builtin_return_address (0));
 }
 
 int	Hunk_LowMark (void)
@@ -874,6 +1247,7 @@ void Hunk_FreeToLowMark (int mark)
 {
 	if (mark < 0 || mark > hunk_low_used)
 		Sys_Error ("Hunk_FreeToLowMark: bad mark %i", mark);
+	Mem_UncountHunk (hunk_base + mark, hunk_base + hunk_low_used);
 	memset (hunk_base + mark, 0, hunk_low_used - mark);
 	hunk_low_used = mark;
 }
@@ -898,6 +1272,7 @@ void Hunk_FreeToHighMark (int mark)
 	}
 	if (mark < 0 || mark > hunk_high_used)
 		Sys_Error ("Hunk_FreeToHighMark: bad mark %i", mark);
+	Mem_UncountHunk (hunk_base + hunk_size - hunk_high_used, hunk_base + hunk_size - mark);
 	memset (hunk_base + hunk_size - hunk_high_used, 0, hunk_high_used - mark);
 	hunk_high_used = mark;
 }
@@ -905,10 +1280,10 @@ void Hunk_FreeToHighMark (int mark)
 
 /*
 ===================
-Hunk_HighAllocName
+Hunk_HighAllocSite
 ===================
 */
-void *Hunk_HighAllocName (int size, char *name)
+static void *Hunk_HighAllocSite (int size, char *name, void *site)
 {
 	hunk_t	*h;
 
@@ -935,6 +1310,8 @@ void *Hunk_HighAllocName (int size, char *name)
 
 	hunk_high_used += size;
 	Cache_FreeHigh (hunk_high_used);
+	alloc_stats.hunk += size;
+	alloc_stats.hunkallocs++;
 
 	h = (hunk_t *)(hunk_base + hunk_size - hunk_high_used);
 
@@ -942,10 +1319,21 @@ void *Hunk_HighAllocName (int size, char *name)
 	h->size = size;
 	h->sentinel = HUNK_SENTINEL;
 	strlcpy (h->name, name, HUNKNAME_LEN);
+	Mem_CountHunk (h->name, size, site);
 
 	return (void *)(h+1);
 }
 
+/*
+===================
+Hunk_HighAllocName
+===================
+*/
+void *Hunk_HighAllocName (int size, char *name)
+{
+	return Hunk_HighAllocSite (size, name, __builtin_return_address (0));
+}
+
 
 /*
 =================
@@ -968,7 +1356,7 @@ void *Hunk_TempAlloc (int size)
 
 	hunk_tempmark = Hunk_HighMark ();
 
-	buf = Hunk_HighAllocName (size, "temp");
+	buf = Hunk_HighAllocSite (size, "temp", __builtin_return_address (0));
 
 	hunk_tempactive = true;
 
@@ -978,7 +1366,7 @@ void *Hunk_TempAlloc (int size)
 char *Hunk_Strdup (char *s, char *name)
 {
 	size_t sz = strlen(s) + 1;
-	char *ptr = (char *) Hunk_AllocName (sz, name);
+	char *ptr = (char *) Hunk_AllocSite (sz, name, __builtin_return_address (0));
 	memcpy (ptr, s, sz);
 	return ptr;
 }
@@ -1005,6 +1393,82 @@ cache_system_t *Cache_TryAlloc (int size, qboolean nobottom);
 
 cache_system_t	cache_head;
 
+#define	MAX_CACHESTATS	512		// a power of two
+#define	CACHE_READRATE	(4*1024*1024)	// bytes a second, the cost of a load never timed
+
+// what the cache knows about a name, kept while its data comes and goes
+typedef struct cachestat_s
+{
+	char	name[CACHENAME_LEN];
+	int		size;			// of the last allocation
+	float	loadtime;		// seconds the last load took, from Cache_Loaded
+	int		hits, misses, loads, evictions;
+	int		roundhits;		// hits since the last Cache_NewPinSet
+	int		pinset;			// pinned while this is cache_pinset
+} cachestat_t;
+
+cvar_t	cache_evictwindow = {"cache_evictwindow", "8"};	// least recently used blocks weighed for eviction, 1 is plain LRU
+cvar_t	cache_pinlimit = {"cache_pinlimit", "0.5"};		// share of the free hunk a pin set may hold
+
+static	cachestat_t	cache_stats[MAX_CACHESTATS];
+static	cachestat_t	cache_otherstat;		// once cache_stats is full
+static	int			cache_numstats;
+static	int			cache_pinset = 1;
+
+static void Cache_Stats_f (void);
+
+/*
+============
+Cache_Stat
+============
+*/
+static cachestat_t *Cache_Stat (char *name)
+{
+	cachestat_t	*st;
+	unsigned	h;
+	int			i;
+
+	h = 0;
+	for (i=0 ; name[i] && i<CACHENAME_LEN-1 ; i++)
+		h = h * 31 + (byte)name[i];
+
+	for (i=0 ; i<MAX_CACHESTATS ; i++)
+	{
+		st = &cache_stats[(h + i) & (MAX_CACHESTATS - 1)];
+		if (!st->name[0])
+		{
+			if (cache_numstats >= MAX_CACHESTATS * 3 / 4 || !name[0])
+				break;
+			strlcpy (st->name, name, CACHENAME_LEN);
+			cache_numstats++;
+			return st;
+		}
+		if (!strncmp (st->name, name, CACHENAME_LEN - 1))
+			return st;
+	}
+
+	return &cache_otherstat;
+}
+
+static qboolean Cache_Pinned (cache_system_t *cs)
+{
+	return cs->user->stat && cs->user->stat->pinset == cache_pinset;
+}
+
+/*
+============
+Cache_Evict
+
+Throws out a block the cache wants the space of
+============
+*/
+static void Cache_Evict (cache_system_t *cs)
+{
+	if (cs->user->stat)
+		cs->user->stat->evictions++;
+	Cache_Free (cs->user);
+}
+
 /*
 ===========
 Cache_Move
@@ -1023,6 +1487,8 @@ void Cache_Move ( cache_system_t *c)
 		Q_memcpy ( new_cs+1, c+1, c->size - sizeof(cache_system_t) );
 		new_cs->user = c->user;
 		Q_memcpy (new_cs->name, c->name, sizeof(new_cs->name));
+		alloc_stats.cacheallocs++;
+		Mem_CountCache (new_cs->size, NULL);
 		Cache_Free (c->user);
 		new_cs->user->data = (void *)(new_cs+1);
 	}
@@ -1030,7 +1496,7 @@ void Cache_Move ( cache_system_t *c)
 	{
 //		Con_Printf ("cache_move failed\n");
 
-		Cache_Free (c->user); // tough luck...
+		Cache_Evict (c); // tough luck...
 	}
 }
 
@@ -1076,7 +1542,7 @@ void Cache_FreeHigh (int new_high_hunk)
 		if ( (byte *)c + c->size <= hunk_base + hunk_size - new_high_hunk)
 			return;		// there is space to grow the hunk
 		if (c == prev)
-			Cache_Free (c->user);	// didn't move out of the way
+			Cache_Evict (c);	// didn't move out of the way
 		else
 		{
 			Cache_Move (c);	// try to move it
@@ -1239,6 +1705,9 @@ void Cache_Init (void)
 	cache_head.lru_next = cache_head.lru_prev = &cache_head;
 
 	Cmd_AddCommand ("flush", Cache_Flush);
+	Cmd_AddCommand ("cachestats", Cache_Stats_f);
+
+	strlcpy (cache_otherstat.name, "(other)", CACHENAME_LEN);
 }
 
 /*
@@ -1257,6 +1726,9 @@ void Cache_Free (cache_user_t *c)
 
 	cs = ((cache_system_t *)c->data) - 1;
 
+	alloc_stats.cachefrees++;
+	Mem_UncountCache (cs->size);
+
 	cs->prev->next = cs->next;
 	cs->next->prev = cs->prev;
 	cs->next = cs->prev = NULL;
@@ -1278,10 +1750,20 @@ void *Cache_Check (cache_user_t *c)
 	cache_system_t	*cs;
 
 	if (!c->data)
+	{
+		if (c->stat)
+			c->stat->misses++;
 		return NULL;
+	}
 
 	cs = ((cache_system_t *)c->data) - 1;
 
+	if (c->stat)
+	{
+		c->stat->hits++;
+		c->stat->roundhits++;
+	}
+
 // move to head of LRU
 	Cache_UnlinkLRU (cs);
 	Cache_MakeLRU (cs);
@@ -1290,6 +1772,66 @@ void *Cache_Check (cache_user_t *c)
 }
 
 
+/*
+==============
+Cache_ReloadCost
+
+Seconds it would take to get a block back
+==============
+*/
+static float Cache_ReloadCost (cache_system_t *cs)
+{
+	float	cost;
+
+	cost = (float)cs->size / CACHE_READRATE;
+	if (cs->user->stat && cs->user->stat->loadtime > cost)
+		cost = cs->user->stat->loadtime;
+
+	return cost;
+}
+
+/*
+==============
+Cache_Victim
+
+Of the cache_evictwindow least recently used blocks that aren't pinned,
+the one that costs the least to load again for the space it gives back.
+Pinned blocks go, oldest first, only when there is nothing else.
+==============
+*/
+static cache_system_t *Cache_Victim (void)
+{
+	cache_system_t	*cs, *best;
+	float			cost, bestcost;
+	int				window;
+
+	window = (int)cache_evictwindow.value;
+	if (window < 1)
+		window = 1;
+
+	best = NULL;
+	bestcost = 0;
+	for (cs = cache_head.lru_prev ; cs != &cache_head && window ; cs = cs->lru_prev)
+	{
+		if (Cache_Pinned (cs))
+			continue;
+
+		cost = Cache_ReloadCost (cs) / cs->size;
+		if (!best || cost < bestcost)
+		{
+			best = cs;
+			bestcost = cost;
+		}
+		window--;
+	}
+	if (best)
+		return best;
+
+	if (cache_head.lru_prev != &cache_head)
+		return cache_head.lru_prev;
+	return NULL;
+}
+
 /*
 ==============
 Cache_Alloc
@@ -1315,18 +1857,750 @@ void *Cache_Alloc (cache_user_t *c, int size, char *name)
 		{
 			strlcpy (cs->name, name, CACHENAME_LEN);
 			c->data = (void *)(cs+1);
+			c->stat = Cache_Stat (name);
+			c->stat->size = size;
+			c->stat->loads++;
 			cs->user = c;
+			alloc_stats.cache += size;
+			alloc_stats.cacheallocs++;
+			Mem_CountCache (size, __builtin_return_address (0));
 			break;
 		}
 
-	// free the least recently used cahedat
-		if (cache_head.lru_prev == &cache_head)
+	// throw out what is cheapest to get back
+		cs = Cache_Victim ();
+		if (!cs)
 			Sys_Error ("Cache_Alloc: out of memory"); // not enough memory at all
 
-		Cache_Free (cache_head.lru_prev->user);
+		Cache_Evict (cs);
 	}
 
-	return Cache_Check (c);
+	return c->data;		// Cache_TryAlloc made it the most recently used
+}
+
+/*
+==============
+Cache_Loaded
+==============
+*/
+void Cache_Loaded (cache_user_t *c, double seconds)
+{
+	if (c->stat)
+		c->stat->loadtime = seconds;
+}
+
+/*
+==============
+Cache_Pin
+==============
+*/
+void Cache_Pin (cache_user_t *c)
+{
+	if (c->stat)
+		c->stat->pinset = cache_pinset;
+}
+
+qboolean Cache_IsPinned (cache_user_t *c)
+{
+	return c->stat && c->stat->pinset == cache_pinset;
+}
+
+static int Cache_CostCompare (const void *a, const void *b)
+{
+	const cachestat_t	*sa = *(const cachestat_t **)a;
+	const cachestat_t	*sb = *(const cachestat_t **)b;
+
+	if (sa->loadtime < sb->loadtime)
+		return 1;
+	if (sa->loadtime > sb->loadtime)
+		return -1;
+	return 0;
+}
+
+/*
+==============
+Cache_NewPinSet
+
+What was used since the last pin set is pinned, the slowest to load first,
+until the pins hold cache_pinlimit of the space the cache has
+==============
+*/
+void Cache_NewPinSet (void)
+{
+	static cachestat_t	*used[MAX_CACHESTATS];
+	int			i, count, limit, pinned;
+
+	cache_pinset++;
+
+	count = 0;
+	for (i=0 ; i<MAX_CACHESTATS ; i++)
+	{
+		if (cache_stats[i].roundhits)
+			used[count++] = &cache_stats[i];
+		cache_stats[i].roundhits = 0;
+	}
+	qsort (used, count, sizeof(*used), Cache_CostCompare);
+
+	limit = (hunk_size - hunk_low_used - hunk_high_used) * cache_pinlimit.value;
+	pinned = 0;
+	for (i=0 ; i<count ; i++)
+	{
+		if (pinned + used[i]->size > limit)
+			continue;
+		used[i]->pinset = cache_pinset;
+		pinned += used[i]->size;
+	}
+}
+
+static int Cache_StatCompare (const void *a, const void *b)
+{
+	const cachestat_t	*sa = *(const cachestat_t **)a;
+	const cachestat_t	*sb = *(const cachestat_t **)b;
+
+	if (sa->evictions != sb->evictions)
+		return sb->evictions - sa->evictions;
+	return sb->loads - sa->loads;
+}
+
+/*
+==============
+Cache_Stats_f
+
+cachestats [all], the names thrown out most first
+==============
+*/
+static void Cache_Stats_f (void)
+{
+	static cachestat_t	*sorted[MAX_CACHESTATS + 1];
+	cachestat_t	*st;
+	int			i, count, pins, pinbytes;
+	qboolean	all;
+
+	all = Cmd_Argc () > 1 && !Q_strcasecmp (Cmd_Argv (1), "all");
+
+	count = pins = pinbytes = 0;
+	for (i=0 ; i<MAX_CACHESTATS ; i++)
+	{
+		if (!cache_stats[i].name[0])
+			continue;
+		sorted[count++] = &cache_stats[i];
+		if (cache_stats[i].pinset == cache_pinset)
+		{
+			pins++;
+			pinbytes += cache_stats[i].size;
+		}
+	}
+	if (cache_otherstat.loads)
+		sorted[count++] = &cache_otherstat;
+	qsort (sorted, count, sizeof(*sorted), Cache_StatCompare);
+
+	Con_Printf ("%i names, %i pinned in %iK\n", count, pins, pinbytes / 1024);
+	Con_Printf ("     hits misses loads evict load ms    size name\n");
+	for (i=0 ; i<count && (all || i<24) ; i++)
+	{
+		st = sorted[i];
+		Con_Printf ("%9i %6i %5i %5i %7.1f %7i %s%s\n", st->hits, st->misses, st->loads, st->evictions,
+			st->loadtime * 1000, st->size, st->name, st->pinset == cache_pinset ? " (pinned)" : "");
+	}
+	if (i < count)
+		Con_Printf ("%i more, \"cachestats all\" lists them\n", count - i);
+}
+
+/*
+===============================================================================
+
+MEMORY TELEMETRY
+
+The live bytes and blocks of each zone tag, hunk name and the cache, the
+most each has held, what the allocators hand out per frame and the largest
+block each could still give.  "memstats" prints it, mem_log prints a line
+every so many seconds and "memdump" writes all of it as json.
+
+With -memsites [sites] the allocations are also added up by the address
+they were made from, for addr2line.
+===============================================================================
+*/
+
+#define	MAX_MEMTAGS		8		// higher zone tags are counted with the last
+#define	MAX_MEMNAMES	256		// a power of two
+#define	MEMSITES		1024
+
+typedef struct
+{
+	int		bytes;
+	int		count;
+	int		peak;		// the most bytes at once
+} memcount_t;
+
+typedef struct
+{
+	char		name[HUNKNAME_LEN];
+	memcount_t	c;
+} memname_t;
+
+typedef struct
+{
+	void	*addr;
+	int		kind;		// 'z'one, 'h'unk or 'c'ache
+	int		count;
+	int		bytes;		// everything allocated from here, frees aren't traced back
+} memsite_t;
+
+cvar_t	mem_log = {"mem_log", "0"};		// seconds between memory lines, 0 for none
+
+static	memcount_t	mem_tags[MAX_MEMTAGS];
+static	memcount_t	mem_zone;
+static	memcount_t	mem_cache;
+static	memname_t	mem_names[MAX_MEMNAMES];
+static	memname_t	mem_othername;		// once mem_names is full
+static	int			mem_numnames;
+static	int			mem_peaklow, mem_peakhigh, mem_peakhunk;
+
+static	allocstats_t	mem_lastframe;		// alloc_stats at the last Memory_Frame
+static	allocstats_t	mem_frame;			// what the last frame added
+static	allocstats_t	mem_framepeak;		// the most any frame added
+static	qboolean	mem_framestarted;
+static	double		mem_lastlog;
+
+static	memsite_t	*mem_sites;
+static	int			mem_maxsites;
+static	int			mem_numsites;
+static	int			mem_sitesdropped;
+
+static void Mem_Add (memcount_t *c, int size)
+{
+	c->bytes += size;
+	c->count++;
+	if (c->bytes > c->peak)
+		c->peak = c->bytes;
+}
+
+static void Mem_Sub (memcount_t *c, int size)
+{
+	c->bytes -= size;
+	c->count--;
+}
+
+/*
+===================
+Mem_CountSite
+===================
+*/
+static void Mem_CountSite (void *addr, int kind, int size)
+{
+	memsite_t	*site;
+	unsigned	h;
+	int			i;
+
+	if (!mem_sites || !addr)
+		return;
+
+	site = NULL;
+	h = (unsigned)((size_t)addr >> 2) * 2654435761u;
+	for (i=0 ; i<mem_maxsites ; i++)
+	{
+		site = &mem_sites[(h + i) & (mem_maxsites - 1)];
+		if (site->addr == addr && site->kind == kind)
+			break;
+		if (!site->addr)
+		{
+			if (mem_numsites >= mem_maxsites * 3 / 4)
+				i = mem_maxsites;
+			else
+			{
+				site->addr = addr;
+				site->kind = kind;
+				mem_numsites++;
+			}
+			break;
+		}
+	}
+	if (i == mem_maxsites)
+	{
+		mem_sitesdropped++;
+		return;
+	}
+
+	site->count++;
+	site->bytes += size;
+}
+
+/*
+===================
+Mem_HunkName
+
+The counts for a hunk name, shared by every name once the table is full
+===================
+*/
+static memname_t *Mem_HunkName (char *name)
+{
+	memname_t	*n;
+	unsigned	h;
+	int			i;
+
+	if (!name[0])
+		name = "unknown";
+
+	h = 0;
+	for (i=0 ; name[i] && i<HUNKNAME_LEN-1 ; i++)
+		h = h * 31 + (byte)name[i];
+
+	for (i=0 ; i<MAX_MEMNAMES ; i++)
+	{
+		n = &mem_names[(h + i) & (MAX_MEMNAMES - 1)];
+		if (!n->name[0])
+		{
+			if (mem_numnames >= MAX_MEMNAMES * 3 / 4)
+				break;
+			strlcpy (n->name, name, HUNKNAME_LEN);
+			mem_numnames++;
+			return n;
+		}
+		if (!strncmp (n->name, name, HUNKNAME_LEN - 1))
+			return n;
+	}
+
+	return &mem_othername;
+}
+
+static void Mem_CountZone (int tag, int size, void *site)
+{
+	Mem_Add (&mem_tags[tag < MAX_MEMTAGS ? tag : MAX_MEMTAGS - 1], size);
+	Mem_Add (&mem_zone, size);
+	Mem_CountSite (site, 'z', size);
+}
+
+static void Mem_UncountZone (int tag, int size)
+{
+	Mem_Sub (&mem_tags[tag < MAX_MEMTAGS ? tag : MAX_MEMTAGS - 1], size);
+	Mem_Sub (&mem_zone, size);
+}
+
+static void Mem_CountHunk (char *name, int size, void *site)
+{
+	Mem_Add (&Mem_HunkName (name)->c, size);
+	Z_Lock ();		// the site table is the zone's too
+	Mem_CountSite (site, 'h', size);
+	Z_Unlock ();
+
+	if (hunk_low_used > mem_peaklow)
+		mem_peaklow = hunk_low_used;
+	if (hunk_high_used > mem_peakhigh)
+		mem_peakhigh = hunk_high_used;
+	if (hunk_low_used + hunk_high_used > mem_peakhunk)
+		mem_peakhunk = hunk_low_used + hunk_high_used;
+}
+
+/*
+===================
+Mem_UncountHunk
+
+The blocks from start to end are being released
+===================
+*/
+static void Mem_UncountHunk (byte *start, byte *end)
+{
+	hunk_t	*h;
+
+	for (h = (hunk_t *)start ; (byte *)h < end ; h = (hunk_t *)((byte *)h + h->size))
+	{
+		if (h->sentinel != HUNK_SENTINEL || h->size < (int) sizeof(hunk_t))
+			break;
+		Mem_Sub (&Mem_HunkName (h->name)->c, h->size);
+	}
+}
+
+static void Mem_CountCache (int size, void *site)
+{
+	Mem_Add (&mem_cache, size);
+	Z_Lock ();
+	Mem_CountSite (site, 'c', size);
+	Z_Unlock ();
+}
+
+static void Mem_UncountCache (int size)
+{
+	Mem_Sub (&mem_cache, size);
+}
+
+/*
+===================
+Z_LargestFree
+===================
+*/
+static int Z_LargestFree (memzone_t *zone)
+{
+	memblock_t	*block;
+	int			fl, sl, largest;
+
+	if (!zone->flbitmap)
+		return 0;
+
+	fl = Z_Log2 (zone->flbitmap);
+	sl = Z_Log2 (zone->slbitmap[fl]);
+	largest = 0;
+	for (block = zone->free[fl][sl] ; block ; block = FREELINKS(block)->next)
+		if (block->size > largest)
+			largest = block->size;
+
+	return largest;
+}
+
+/*
+===================
+Cache_LargestFree
+
+The biggest gap between the cache blocks, what could be cached without
+throwing anything out
+===================
+*/
+static int Cache_LargestFree (void)
+{
+	cache_system_t	*cs;
+	byte			*start;
+	int				largest;
+
+	largest = 0;
+	start = hunk_base + hunk_low_used;
+	for (cs = cache_head.next ; cs != &cache_head ; cs = cs->next)
+	{
+		if ((byte *)cs - start > largest)
+			largest = (byte *)cs - start;
+		start = (byte *)cs + cs->size;
+	}
+	if (hunk_base + hunk_size - hunk_high_used - start > largest)
+		largest = hunk_base + hunk_size - hunk_high_used - start;
+
+	return largest;
+}
+
+/*
+===================
+Mem_PrintLine
+
+Everything on one line, for mem_log and before a hunk failure
+===================
+*/
+static void Mem_PrintLine (void)
+{
+	Con_Printf ("mem: hunk %iK+%iK free %iK least %iK, zone %iK/%iK largest %i, cache %iK in %i, frame %i/%i/%i allocs\n",
+		hunk_low_used / 1024, hunk_high_used / 1024,
+		(hunk_size - hunk_low_used - hunk_high_used) / 1024, (hunk_size - mem_peakhunk) / 1024,
+		mem_zone.bytes / 1024, zone_size / 1024, Z_LargestFree (mainzone),
+		mem_cache.bytes / 1024, mem_cache.count,
+		mem_frame.hunkallocs, mem_frame.zoneallocs, mem_frame.cacheallocs);
+}
+
+/*
+===================
+Memory_Frame
+===================
+*/
+void Memory_Frame (void)
+{
+	int		*now, *last, *frame, *peak;
+	int		i;
+
+	now = (int *)&alloc_stats;
+	last = (int *)&mem_lastframe;
+	frame = (int *)&mem_frame;
+	peak = (int *)&mem_framepeak;
+
+	// the first frame would count everything since startup
+	if (mem_framestarted)
+	{
+		for (i=0 ; i<(int)(sizeof(allocstats_t)/sizeof(int)) ; i++)
+		{
+			frame[i] = now[i] - last[i];
+			if (frame[i] > peak[i])
+				peak[i] = frame[i];
+		}
+	}
+	mem_lastframe = alloc_stats;
+	mem_framestarted = true;
+
+	if (mem_log.value > 0 && realtime - mem_lastlog >= mem_log.value)
+	{
+		mem_lastlog = realtime;
+		Mem_PrintLine ();
+	}
+}
+
+static int Mem_NameCompare (const void *a, const void *b)
+{
+	const memname_t	*na = *(const memname_t **)a;
+	const memname_t	*nb = *(const memname_t **)b;
+
+	if (na->c.bytes != nb->c.bytes)
+		return nb->c.bytes - na->c.bytes;
+	return nb->c.peak - na->c.peak;
+}
+
+static int Mem_SiteCompare (const void *a, const void *b)
+{
+	return ((const memsite_t *)b)->bytes - ((const memsite_t *)a)->bytes;
+}
+
+/*
+===================
+Mem_SortNames
+
+The hunk names that have been used, most bytes first
+===================
+*/
+static int Mem_SortNames (memname_t **sorted)
+{
+	int		i, count;
+
+	count = 0;
+	for (i=0 ; i<MAX_MEMNAMES ; i++)
+		if (mem_names[i].name[0])
+			sorted[count++] = &mem_names[i];
+	if (mem_othername.c.peak)
+		sorted[count++] = &mem_othername;
+
+	qsort (sorted, count, sizeof(*sorted), Mem_NameCompare);
+	return count;
+}
+
+/*
+===================
+Mem_SortSites
+
+A copy of the used sites, most bytes first, to be freed
+===================
+*/
+static memsite_t *Mem_SortSites (int *count)
+{
+	memsite_t	*sorted;
+	int			i;
+
+	*count = 0;
+	if (!mem_numsites)
+		return NULL;
+
+	sorted = malloc (mem_numsites * sizeof(*sorted));
+	if (!sorted)
+		return NULL;
+
+	for (i=0 ; i<mem_maxsites ; i++)
+		if (mem_sites[i].addr)
+			sorted[(*count)++] = mem_sites[i];
+
+	qsort (sorted, *count, sizeof(*sorted), Mem_SiteCompare);
+	return sorted;
+}
+
+/*
+===================
+Mem_PrintSites
+===================
+*/
+static void Mem_PrintSites (int max)
+{
+	memsite_t	*sorted;
+	int			i, count;
+
+	if (!mem_sites)
+	{
+		Con_Printf ("allocation sites aren't counted, see -memsites\n");
+		return;
+	}
+
+	sorted = Mem_SortSites (&count);
+	Con_Printf ("site               kind  count    bytes\n");
+	for (i=0 ; i<count && i<max ; i++)
+		Con_Printf ("%-18p %c %8i %8i\n", sorted[i].addr, sorted[i].kind, sorted[i].count, sorted[i].bytes);
+	if (mem_sitesdropped)
+		Con_Printf ("%i allocations from sites that didn't fit, -memsites %i is the limit\n",
+			mem_sitesdropped, mem_maxsites);
+	free (sorted);
+}
+
+/*
+===================
+Mem_Stats_f
+
+memstats [all | sites]
+===================
+*/
+static void Mem_Stats_f (void)
+{
+	memname_t	*sorted[MAX_MEMNAMES + 1];
+	qboolean	all;
+	int			i, count;
+
+	if (Cmd_Argc () > 1 && !Q_strcasecmp (Cmd_Argv (1), "sites"))
+	{
+		Mem_PrintSites (Cmd_Argc () > 2 ? Q_atoi (Cmd_Argv (2)) : 32);
+		return;
+	}
+	all = Cmd_Argc () > 1 && !Q_strcasecmp (Cmd_Argv (1), "all");
+
+	Con_Printf ("           bytes   blocks     peak\n");
+	Con_Printf ("hunk  %10i          %9i of %i, least free %i\n",
+		hunk_low_used + hunk_high_used, mem_peakhunk, hunk_size, hunk_size - mem_peakhunk);
+	Con_Printf (" low  %10i          %9i\n", hunk_low_used, mem_peaklow);
+	Con_Printf (" high %10i          %9i\n", hunk_high_used, mem_peakhigh);
+	Con_Printf ("zone  %10i %8i %9i of %i, largest free %i\n",
+		mem_zone.bytes, mem_zone.count, mem_zone.peak, zone_size, Z_LargestFree (mainzone));
+	for (i=1 ; i<MAX_MEMTAGS ; i++)
+		if (mem_tags[i].peak)
+			Con_Printf (" tag %-2i%9i %8i %9i\n", i, mem_tags[i].bytes, mem_tags[i].count, mem_tags[i].peak);
+	Con_Printf ("cache %10i %8i %9i, largest free %i\n",
+		mem_cache.bytes, mem_cache.count, mem_cache.peak, Cache_LargestFree ());
+
+	Con_Printf ("per frame   hunk    zone   frees   cache   frees\n");
+	Con_Printf ("allocs  %7i %7i %7i %7i %7i\n", mem_frame.hunkallocs, mem_frame.zoneallocs,
+		mem_frame.zonefrees, mem_frame.cacheallocs, mem_frame.cachefrees);
+	Con_Printf ("most    %7i %7i %7i %7i %7i\n", mem_framepeak.hunkallocs, mem_framepeak.zoneallocs,
+		mem_framepeak.zonefrees, mem_framepeak.cacheallocs, mem_framepeak.cachefrees);
+	Con_Printf ("bytes   %7i %7i         %7i\n", mem_frame.hunk, mem_frame.zone, mem_frame.cache);
+	Con_Printf ("most    %7i %7i         %7i\n", mem_framepeak.hunk, mem_framepeak.zone, mem_framepeak.cache);
+
+	count = Mem_SortNames (sorted);
+	Con_Printf ("hunk name                    bytes   blocks     peak\n");
+	for (i=0 ; i<count && (all || i<24) ; i++)
+		Con_Printf ("%-24s %9i %8i %8i\n", sorted[i]->name, sorted[i]->c.bytes, sorted[i]->c.count, sorted[i]->c.peak);
+	if (i < count)
+		Con_Printf ("%i more, \"memstats all\" lists them\n", count - i);
+}
+
+/*
+===================
+Mem_Escape
+
+Leaves nothing in a name that would end a json string early
+===================
+*/
+static char *Mem_Escape (char *s)
+{
+	static char	buf[64];
+	int			i;
+
+	for (i=0 ; s[i] && i<sizeof(buf)-1 ; i++)
+	{
+		if (s[i] == '"' || s[i] == '\\')
+			buf[i] = '/';
+		else if ((byte)s[i] < ' ')
+			buf[i] = ' ';
+		else
+			buf[i] = s[i];
+	}
+	buf[i] = 0;
+
+	return buf;
+}
+
+static void Mem_WriteStats (FILE *f, allocstats_t *a)
+{
+	fprintf (f, "{\"hunk\":%i,\"zone\":%i,\"cache\":%i,\"hunkallocs\":%i,\"zoneallocs\":%i,"
+		"\"zonefrees\":%i,\"cacheallocs\":%i,\"cachefrees\":%i}",
+		a->hunk, a->zone, a->cache, a->hunkallocs, a->zoneallocs, a->zonefrees, a->cacheallocs, a->cachefrees);
+}
+
+static void Mem_WriteCount (FILE *f, memcount_t *c)
+{
+	fprintf (f, "\"bytes\":%i,\"count\":%i,\"peak\":%i", c->bytes, c->count, c->peak);
+}
+
+/*
+===================
+Mem_Dump_f
+
+memdump [file], everything memstats knows as json in the game directory
+===================
+*/
+static void Mem_Dump_f (void)
+{
+	char			path[MAX_OSPATH];
+	memname_t		*sorted[MAX_MEMNAMES + 1];
+	memsite_t		*sites;
+	cache_system_t	*cs;
+	FILE			*f;
+	int				i, count;
+
+	snprintf (path, sizeof(path), "%s/%s", com_gamedir, Cmd_Argc () > 1 ? Cmd_Argv (1) : "memdump.json");
+	f = fopen (path, "w");
+	if (!f)
+	{
+		Con_Printf ("Couldn't write %s\n", path);
+		return;
+	}
+
+	fprintf (f, "{\"time\":%.3f,\"frame\":%i,\n", realtime, host_framecount);
+	fprintf (f, "\"hunk\":{\"size\":%i,\"low\":%i,\"high\":%i,\"peaklow\":%i,\"peakhigh\":%i,\"peak\":%i},\n",
+		hunk_size, hunk_low_used, hunk_high_used, mem_peaklow, mem_peakhigh, mem_peakhunk);
+	fprintf (f, "\"zone\":{\"size\":%i,", zone_size);
+	Mem_WriteCount (f, &mem_zone);
+	fprintf (f, ",\"largestfree\":%i,\"tags\":[", Z_LargestFree (mainzone));
+	for (i=1, count=0 ; i<MAX_MEMTAGS ; i++)
+	{
+		if (!mem_tags[i].peak)
+			continue;
+		fprintf (f, "%s{\"tag\":%i,", count++ ? "," : "", i);
+		Mem_WriteCount (f, &mem_tags[i]);
+		fprintf (f, "}");
+	}
+	fprintf (f, "]},\n\"cache\":{");
+	Mem_WriteCount (f, &mem_cache);
+	fprintf (f, ",\"largestfree\":%i,\"blocks\":[", Cache_LargestFree ());
+	for (cs = cache_head.next ; cs != &cache_head ; cs = cs->next)
+		fprintf (f, "%s\n{\"name\":\"%s\",\"size\":%i}", cs == cache_head.next ? "" : ",",
+			Mem_Escape (cs->name), cs->size);
+	fprintf (f, "]},\n\"perframe\":{\"last\":");
+	Mem_WriteStats (f, &mem_frame);
+	fprintf (f, ",\"most\":");
+	Mem_WriteStats (f, &mem_framepeak);
+	fprintf (f, ",\"total\":");
+	Mem_WriteStats (f, &alloc_stats);
+	fprintf (f, "},\n\"hunknames\":[");
+
+	count = Mem_SortNames (sorted);
+	for (i=0 ; i<count ; i++)
+	{
+		fprintf (f, "%s\n{\"name\":\"%s\",", i ? "," : "", Mem_Escape (sorted[i]->name));
+		Mem_WriteCount (f, &sorted[i]->c);
+		fprintf (f, "}");
+	}
+	fprintf (f, "],\n\"sites\":[");
+
+	sites = Mem_SortSites (&count);
+	for (i=0 ; i<count ; i++)
+		fprintf (f, "%s\n{\"addr\":\"%p\",\"kind\":\"%c\",\"count\":%i,\"bytes\":%i}", i ? "," : "",
+			sites[i].addr, sites[i].kind, sites[i].count, sites[i].bytes);
+	free (sites);
+	fprintf (f, "],\"sitesdropped\":%i}\n", mem_sitesdropped);
+
+	fclose (f);
+	Con_Printf ("Wrote %s\n", path);
+}
+
+/*
+===================
+Mem_InitStats
+===================
+*/
+static void Mem_InitStats (void)
+{
+	int		p;
+
+	strlcpy (mem_othername.name, "(other)", HUNKNAME_LEN);
+
+	p = COM_CheckParm ("-memsites");
+	if (!p)
+		return;
+
+	mem_maxsites = MEMSITES;
+	if (p < com_argc-1 && Q_atoi (com_argv[p+1]) > 0)
+		mem_maxsites = Q_atoi (com_argv[p+1]);
+	for (p=1 ; p<mem_maxsites ; p<<=1)
+		;
+	mem_maxsites = p;
+
+	mem_sites = calloc (mem_maxsites, sizeof(*mem_sites));
+	if (!mem_sites)
+		mem_maxsites = 0;
 }
 
 //============================================================================
@@ -1335,20 +2609,26 @@ void *Cache_Alloc (cache_user_t *c, int size, char *name)
 void Memory_InitZone (memzone_t *zone, int size)
 {
 	memblock_t	*block;
+	int			headsize;
+
+	memset (zone, 0, sizeof(*zone));
+	zone->size = size;
 
 // set the entire zone to one free block
 
+	headsize = (sizeof(memzone_t) + 15) & ~15;
 	zone->blocklist.next = zone->blocklist.prev = block =
-		(memblock_t *)( (byte *)zone + sizeof(memzone_t) );
+		(memblock_t *)( (byte *)zone + headsize );
 	zone->blocklist.tag = 1;	// in use block
 	zone->blocklist.id = 0;
 	zone->blocklist.size = 0;
-	zone->rover = block;
 
 	block->prev = block->next = &zone->blocklist;
 	block->tag = 0;			// free block
 	block->id = ZONEID;
-	block->size = size - sizeof(memzone_t);
+	block->large = false;
+	block->size = size - headsize;
+	Z_LinkFree (zone, block);
 }
 
 /*
@@ -1360,12 +2640,14 @@ void Memory_Init (void *buf, int size)
 {
 	int p;
 	int zonesize = DYNAMIC_SIZE;
+	int largesize;
 
 	hunk_base = (byte *) buf;
 	hunk_size = size;
 	hunk_low_used = 0;
 	hunk_high_used = 0;
 
+	Mem_InitStats ();
 	Cache_Init ();
 	p = COM_CheckParm ("-zone");
 	if (p)
@@ -1375,9 +2657,35 @@ void Memory_Init (void *buf, int size)
 		else
 			Sys_Error ("Memory_Init: you must specify a size in KB after -zone");
 	}
+	largesize = zonesize / 4;
+	p = COM_CheckParm ("-zonelarge");
+	if (p)
+	{
+		if (p < com_argc-1)
+			largesize = Q_atoi (com_argv[p+1]) * 1024;
+		else
+			Sys_Error ("Memory_Init: you must specify a size in KB after -zonelarge");
+	}
+	if (largesize < 0 || largesize > zonesize / 2)
+		Sys_Error ("Memory_Init: -zonelarge can be at most half the zone");
+	largesize &= ~15;
+
+	zone_size = zonesize;
 	mainzone = (memzone_t *) Hunk_AllocName (zonesize, "zone" );
-	Memory_InitZone (mainzone, zonesize);
+	Memory_InitZone (mainzone, zonesize - largesize);
+	if (largesize)
+	{
+		largezone = (memzone_t *) ((byte *)mainzone + zonesize - largesize);
+		Memory_InitZone (largezone, largesize);
+		largezone->blocklist.next->large = true;
+	}
 
 	Cmd_AddCommand ("hunk_print", Hunk_Print_f); //johnfitz
+	Cmd_AddCommand ("zone_print", Z_Print_f);
+	Cmd_AddCommand ("memstats", Mem_Stats_f);
+	Cmd_AddCommand ("memdump", Mem_Dump_f);
+	Cvar_RegisterVariable (&mem_log);
+	Cvar_RegisterVariable (&cache_evictwindow);
+	Cvar_RegisterVariable (&cache_pinlimit);
 }
 
@@ -43,7 +43,9 @@ server allocations when changing to a higher video mode.
 
 Z_??? Zone memory functions used for small, dynamic allocations like text
 strings from command input.  There is only about 48K for it, allocated at
-the very bottom of the hunk.
+the very bottom of the hunk.  Blocks of 4K or more are split from a
+quarter of it set aside for them, which -zonelarge changes.  "zone_print"
+shows how it is split up.
 
 Cache_??? Cache memory is for objects that can be dynamically loaded and
 can usefully stay persistant between levels.  The size of the cache
@@ -100,6 +102,9 @@ void Z_Free (void *ptr);
 void *Z_Malloc (int size);			// returns 0 filled memory
 void *Z_Realloc (void *ptr, int size);
 char *Z_Strdup (char *s);
+void Z_EnableLocking (void);		// before a second thread allocates
+void *Z_TagMalloc (int size, int tag);	// tag isn't 0, NULL when it won't fit
+void Z_CheckHeap (void);
 
 void *Hunk_Alloc (int size);		// returns 0 filled memory
 void *Hunk_AllocName (int size, char *name);
@@ -119,6 +124,7 @@ void Hunk_Check (void);
 typedef struct cache_user_s
 {
 	void	*data;
+	struct cachestat_s	*stat;	// set by Cache_Alloc, kept after the data goes
 } cache_user_t;
 
 void Cache_Flush (void);
@@ -135,6 +141,33 @@ void *Cache_Alloc (cache_user_t *c, int size, char *name);
 
 void Cache_Report (void);
 
+void Cache_Loaded (cache_user_t *c, double seconds);
+// how long the data took to load, weighed when choosing what to throw out
+
+void Cache_Pin (cache_user_t *c);
+qboolean Cache_IsPinned (cache_user_t *c);
+void Cache_NewPinSet (void);
+// pinned data is only thrown out when nothing else is left.  A new pin set
+// drops every pin, then pins what was used since the last one
+
+// running totals of what each allocator has handed out, never reduced by
+// frees, so a stretch of loading is measured by the difference.  All ints,
+// Memory_Frame takes the difference field by field
+typedef struct
+{
+	int		hunk;
+	int		zone;
+	int		cache;
+	int		hunkallocs;
+	int		zoneallocs, zonefrees;
+	int		cacheallocs, cachefrees;
+} allocstats_t;
+
+extern allocstats_t	alloc_stats;
+
+// the per frame rates and the periodic mem_log line
+void Memory_Frame (void);
+
 #ifdef PSP_VFPU
 void* memcpy_vfpu(void* dst, void* src, unsigned int size);
 #endif // PSP_VFPU